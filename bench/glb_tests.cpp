@@ -0,0 +1,139 @@
+// Glb 的二进制 STL 导出测试, 由 ctest 运行, 失败时返回非零
+// 覆盖文件大小, 面的法向和顶点, 退化的面, 16 位与 32 位索引, 以及经 loadFromStl 的往返
+#include "../glb.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace {
+	int g_checks = 0;
+	int g_failures = 0;
+
+	void Check(bool condition, std::string_view name, const char* what) {
+		g_checks++;
+		if(!condition) {
+			g_failures++;
+			printf("FAIL %.*s: %s\n", static_cast<int>(name.size()), name.data(), what);
+		}
+	}
+
+	struct Facet {
+		float normal[3];
+		float v[3][3];
+		uint16_t attribute;
+	};
+
+	Facet ReadFacet(const std::vector<char>& stl, size_t f) {
+		Facet facet;
+		const char* p = stl.data() + 84 + 50 * f;
+		std::memcpy(facet.normal, p, 12);
+		std::memcpy(facet.v, p + 12, 36);
+		std::memcpy(&facet.attribute, p + 48, 2);
+		return facet;
+	}
+
+	bool Near(const float* a, const float* b) {
+		return std::abs(a[0] - b[0]) + std::abs(a[1] - b[1]) + std::abs(a[2] - b[2]) < 1.0e-6f;
+	}
+
+	// 写出的面与网格的面一一对应
+	bool SameFaces(const std::vector<char>& stl, const std::vector<lxd::MyVec3f>& points, const std::vector<lxd::Face>& faces) {
+		for(size_t f = 0; f < faces.size(); f++) {
+			const Facet facet = ReadFacet(stl, f);
+			for(int k = 0; k < 3; k++) {
+				if(std::memcmp(facet.v[k], points[faces[f].vid[k]].v, 12) != 0)
+					return false;
+			}
+			if(facet.attribute != 0)
+				return false;
+		}
+		return true;
+	}
+
+	// 经 loadFromStl 读回后顶点被合并, 再次导出的字节不变
+	bool RoundTrip(const std::vector<char>& stl) {
+		lxd::Glb glb;
+		if(!glb.loadFromStl({stl.data(), stl.size()}))
+			return false;
+		return glb.toStl() == stl;
+	}
+
+	void CheckTetrahedron() {
+		const std::vector<lxd::MyVec3f> points{{{0, 0, 0}}, {{1, 0, 0}}, {{0, 1, 0}}, {{0, 0, 1}}};
+		const std::vector<lxd::Face> faces{{{0, 2, 1}}, {{0, 1, 3}}, {{0, 3, 2}}, {{1, 2, 3}}, {{0, 1, 1}}};
+		lxd::Glb glb;
+		Check(glb.create(points, faces, {}), "tetrahedron", "create failed");
+		const lxd::Glb& mesh = glb;
+		Check(mesh.stlSize() == 84 + 50 * faces.size(), "tetrahedron", "wrong STL size");
+		const std::vector<char> stl = mesh.toStl();
+		Check(stl.size() == mesh.stlSize(), "tetrahedron", "toStl size differs from stlSize");
+		if(stl.size() != 84 + 50 * faces.size())
+			return;
+		uint32_t count = 0;
+		std::memcpy(&count, stl.data() + 80, 4);
+		Check(count == faces.size() && std::memcmp(stl.data(), "binary stl", 10) == 0, "tetrahedron", "wrong header");
+
+		const float s = 1.0f / std::sqrt(3.0f);
+		const float normals[5][3] = {{0, 0, -1}, {0, -1, 0}, {-1, 0, 0}, {s, s, s}, {0, 0, 0}};
+		bool same = true;
+		for(size_t f = 0; f < faces.size(); f++)
+			same = same && Near(ReadFacet(stl, f).normal, normals[f]);
+		Check(same, "tetrahedron", "wrong facet normals");
+		Check(SameFaces(stl, points, faces), "tetrahedron", "wrong facet vertices");
+		Check(RoundTrip(stl), "tetrahedron", "round trip through loadFromStl changed the STL");
+
+		std::vector<char> small(stl.size() - 1);
+		Check(!mesh.writeStl(small.data(), small.size()), "tetrahedron", "wrote into a buffer that is too small");
+	}
+
+	void CheckGrid() {
+		// 3 * 面数超过 65535 时用 32 位索引, 面数超过 ParallelFor 的粒度
+		constexpr int n = 201;
+		std::vector<lxd::MyVec3f> points;
+		for(int y = 0; y < n; y++)
+			for(int x = 0; x < n; x++)
+				points.push_back({{static_cast<float>(x), static_cast<float>(y), 0.5f * static_cast<float>(x % 3)}});
+		std::vector<lxd::Face> faces;
+		for(int y = 0; y + 1 < n; y++) {
+			for(int x = 0; x + 1 < n; x++) {
+				const int v = y * n + x;
+				faces.push_back({{v, v + 1, v + n + 1}});
+				faces.push_back({{v, v + n + 1, v + n}});
+			}
+		}
+		lxd::Glb glb;
+		Check(glb.create(points, faces, {}), "grid", "create failed");
+		Check(std::holds_alternative<std::span<const uint32_t>>(std::as_const(glb).getIndices()), "grid", "indices are not 32 bit");
+		const std::vector<char> stl = glb.toStl();
+		Check(stl.size() == 84 + 50 * faces.size(), "grid", "wrong STL size");
+		if(stl.size() != 84 + 50 * faces.size())
+			return;
+		Check(SameFaces(stl, points, faces), "grid", "wrong facet vertices");
+		bool unit = true;
+		for(size_t f = 0; f < faces.size(); f++) {
+			const Facet facet = ReadFacet(stl, f);
+			const float* a = facet.v[0];
+			const float* b = facet.v[1];
+			const float* c = facet.v[2];
+			const float e1[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+			const float e2[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+			float cross[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+			const float len = std::sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+			for(float& x : cross)
+				x /= len;
+			unit = unit && Near(facet.normal, cross) && facet.normal[2] > 0;
+		}
+		Check(unit, "grid", "wrong facet normals");
+		Check(RoundTrip(stl), "grid", "round trip through loadFromStl changed the STL");
+	}
+}
+
+int main() {
+	CheckTetrahedron();
+	CheckGrid();
+	printf("%d checks, %d failures\n", g_checks, g_failures);
+	return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,286 @@
+// json.h 的解析与写出基准测试: 吞吐量(MB/s), 每个文档的分配次数, 堆内存峰值
+// json_bench [--reps N] [--write-corpus 目录] [文件.json | 文件.glb ...]
+// 不给文件时使用 MakeJsonCorpus() 生成的标准语料. json_bench_scalar 以 JSON_NO_SIMD 编译, 用于对比 SIMD 扫描
+
+// json.h 的依赖先全部包含, 之后 json.h 中的 malloc 系列调用被重定向到计数的版本
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <float.h>
+#include <assert.h>
+#include <string.h>
+#if !defined(__APPLE__)
+#include <malloc.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#endif
+#if defined(_WIN32)
+#if !defined(NOMINMAX)
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#endif
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../strings/numbers.h"
+#include "../nanoseconds.h"
+#include "json_corpus.h"
+
+namespace {
+	struct AllocationStats {
+		size_t count = 0; // malloc, calloc 和 realloc 的调用次数
+		size_t live = 0;  // 未释放的字节数
+		size_t peak = 0;
+	} g_allocations;
+
+	// 每块前 16 字节记录大小, 保持 malloc 的对齐
+	constexpr size_t kAllocationHeader = 16;
+
+	void* CountedRealloc(void* memory, size_t size) {
+		char* block = memory ? static_cast<char*>(memory) - kAllocationHeader : nullptr;
+		if(block)
+			g_allocations.live -= *reinterpret_cast<size_t*>(block);
+		block = static_cast<char*>(realloc(block, size + kAllocationHeader));
+		*reinterpret_cast<size_t*>(block) = size;
+		g_allocations.count++;
+		g_allocations.live += size;
+		g_allocations.peak = std::max(g_allocations.peak, g_allocations.live);
+		return block + kAllocationHeader;
+	}
+	void* CountedMalloc(size_t size) {
+		return CountedRealloc(nullptr, size);
+	}
+	void* CountedCalloc(size_t count, size_t size) {
+		return memset(CountedRealloc(nullptr, count * size), 0, count * size);
+	}
+	void CountedFree(void* memory) {
+		if(!memory)
+			return;
+		char* block = static_cast<char*>(memory) - kAllocationHeader;
+		g_allocations.live -= *reinterpret_cast<size_t*>(block);
+		free(block);
+	}
+}
+
+#define malloc(size) CountedMalloc(size)
+#define calloc(count, size) CountedCalloc(count, size)
+#define realloc(memory, size) CountedRealloc(memory, size)
+#define free(memory) CountedFree(memory)
+#include "../json.h"
+
+namespace {
+	struct Measurement {
+		double seconds = 1.0e30;  // 最快的一次
+		double allocations = 0.0; // 复用根节点时平均每次的分配次数
+		size_t coldAllocations = 0;
+		size_t peakBytes = 0;     // 首次运行时相对开始时的堆峰值
+	};
+
+	// 首次运行不计时, 只记录分配; prepare 在每次计时之外执行
+	template <typename Prepare, typename Run>
+	Measurement Measure(int reps, Prepare&& prepare, Run&& run) {
+		Measurement m;
+		prepare();
+		const size_t countBefore = g_allocations.count;
+		const size_t liveBefore = g_allocations.live;
+		g_allocations.peak = g_allocations.live;
+		run();
+		m.coldAllocations = g_allocations.count - countBefore;
+		m.peakBytes = g_allocations.peak - liveBefore;
+
+		size_t allocations = 0;
+		for(int i = 0; i < reps; i++) {
+			prepare();
+			const size_t count = g_allocations.count;
+			const ksNanoseconds start = GetTimeNanoseconds();
+			run();
+			m.seconds = std::min(m.seconds, (GetTimeNanoseconds() - start) * 1.0e-9);
+			allocations += g_allocations.count - count;
+		}
+		m.allocations = static_cast<double>(allocations) / reps;
+		return m;
+	}
+
+	void Report(const char* document, const char* operation, size_t bytes, const Measurement& m) {
+		printf("%-16s %-14s %9.1f MB/s %9zu %12.1f %10zu KB\n", document, operation,
+			   bytes / m.seconds / (1024.0 * 1024.0), m.coldAllocations, m.allocations, m.peakBytes / 1024);
+	}
+
+	const char* SimdPath() {
+#if defined(JSON_SIMD_AVX2)
+		return ksJson_CpuHasAvx2() ? "avx2" : "sse2";
+#elif defined(JSON_SIMD_SSE2)
+		return "sse2";
+#elif defined(JSON_SIMD_NEON)
+		return "neon";
+#else
+		return "scalar";
+#endif
+	}
+
+	size_t PeakResidentKB() {
+#if defined(_WIN32)
+		PROCESS_MEMORY_COUNTERS counters;
+		return GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) ? counters.PeakWorkingSetSize / 1024 : 0;
+#else
+		struct rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+		return usage.ru_maxrss / 1024;
+#else
+		return usage.ru_maxrss;
+#endif
+#endif
+	}
+
+	bool ReadWholeFile(const char* path, std::string& text) {
+		FILE* file = fopen(path, "rb");
+		if(!file)
+			return false;
+		char buffer[64 * 1024];
+		size_t count;
+		while((count = fread(buffer, 1, sizeof(buffer), file)) > 0)
+			text.append(buffer, count);
+		fclose(file);
+		return true;
+	}
+
+	void BenchDocument(const lxd::JsonCorpusDocument& doc, int reps) {
+		const char* name = doc.name.c_str();
+		const char* text = doc.text.c_str();
+		const size_t size = doc.text.size();
+		if(reps <= 0)
+			reps = std::clamp(static_cast<int>((256u << 20) / std::max<size_t>(size, 1)), 5, 2000);
+
+		const char* error = nullptr;
+		ksJson* heap = ksJson_Create();
+		if(!ksJson_ReadFromBuffer(heap, text, &error)) {
+			printf("%-16s parse error: %s\n", name, error);
+			ksJson_Destroy(heap);
+			return;
+		}
+
+		// 解析: 首次运行包括创建根节点, 之后复用同一个根节点
+		ksJson* root = nullptr;
+		const auto nothing = [] {};
+		Report(name, "parse heap", size, Measure(reps, nothing, [&] {
+			if(!root)
+				root = ksJson_Create();
+			ksJson_ReadFromBuffer(root, text, nullptr);
+		}));
+		ksJson_Destroy(root);
+		root = nullptr;
+		Report(name, "parse arena", size, Measure(reps, nothing, [&] {
+			if(!root)
+				root = ksJson_CreateWithArena(0);
+			ksJson_ReadFromBuffer(root, text, nullptr);
+		}));
+		ksJson_Destroy(root);
+		root = nullptr;
+		std::string copy;
+		Report(name, "parse in-situ", size, Measure(reps, [&] { copy = doc.text; }, [&] {
+			if(!root)
+				root = ksJson_CreateWithArena(0);
+			ksJson_ReadFromBufferInSitu(root, copy.data(), nullptr);
+		}));
+		ksJson_Destroy(root);
+
+		char* buffer = nullptr;
+		int length = 0;
+		ksJson_WriteToBuffer(heap, &buffer, &length);
+		free(buffer);
+		const size_t written = length;
+		Report(name, "write", written, Measure(reps, nothing, [&] {
+			ksJson_WriteToBuffer(heap, &buffer, &length);
+			free(buffer);
+		}));
+
+		// CBOR 的吞吐量按文本大小计算, 与文本解析直接可比
+		char* cbor = nullptr;
+		int cborLength = 0;
+		ksJson_WriteToCbor(heap, &cbor, &cborLength);
+		Report(name, "cbor encode", size, Measure(reps, nothing, [&] {
+			char* out = nullptr;
+			int outLength = 0;
+			ksJson_WriteToCbor(heap, &out, &outLength);
+			free(out);
+		}));
+		root = nullptr;
+		Report(name, "cbor decode", size, Measure(reps, nothing, [&] {
+			if(!root)
+				root = ksJson_CreateWithArena(0);
+			ksJson_ReadFromCbor(root, cbor, cborLength, nullptr);
+		}));
+		printf("%-16s %-14s %9.1f %% of text\n", name, "cbor size", 100.0 * cborLength / size);
+		ksJson_Destroy(root);
+		free(cbor);
+		ksJson_Destroy(heap);
+	}
+}
+
+int main(int argc, char* argv[]) {
+	int reps = 0;
+	const char* corpusDir = nullptr;
+	std::vector<lxd::JsonCorpusDocument> corpus;
+	for(int i = 1; i < argc; i++) {
+		const std::string_view arg = argv[i];
+		if(arg == "--reps" && i + 1 < argc) {
+			reps = atoi(argv[++i]);
+		} else if(arg == "--write-corpus" && i + 1 < argc) {
+			corpusDir = argv[++i];
+		} else {
+			lxd::JsonCorpusDocument doc;
+			const std::string_view base = arg.substr(arg.find_last_of("/\\") + 1);
+			doc.name = base.substr(0, base.find_last_of('.'));
+			if(!ReadWholeFile(argv[i], doc.text)) {
+				printf("failed to read %s\n", argv[i]);
+				return 1;
+			}
+			if(base.ends_with(".glb"))
+				doc.text = lxd::GlbJsonChunk(doc.text);
+			corpus.push_back(std::move(doc));
+		}
+	}
+	if(corpus.empty())
+		corpus = lxd::MakeJsonCorpus();
+
+	if(corpusDir) {
+		for(const auto& doc : corpus) {
+			const std::string path = std::string(corpusDir) + "/" + doc.name + ".json";
+			FILE* file = fopen(path.c_str(), "wb");
+			if(!file || fwrite(doc.text.data(), 1, doc.text.size(), file) != doc.text.size()) {
+				printf("failed to write %s\n", path.c_str());
+				return 1;
+			}
+			fclose(file);
+		}
+		return 0;
+	}
+
+	printf("simd: %s\n", SimdPath());
+	for(const auto& doc : corpus)
+		printf("%-16s %9.1f KB\n", doc.name.c_str(), doc.text.size() / 1024.0);
+	printf("\n%-16s %-14s %14s %9s %12s %13s\n", "document", "operation", "throughput", "allocs", "allocs/reuse", "peak heap");
+	for(const auto& doc : corpus)
+		BenchDocument(doc, reps);
+	printf("\npeak resident memory %zu KB\n", PeakResidentKB());
+	return 0;
+}
@@ -0,0 +1,622 @@
+// json.h 的一致性测试, 由 ctest 运行, 失败时返回非零
+// 用例取自 JSONTestSuite (y_ 必须接受, n_ 必须拒绝), 另外生成跨越 SIMD 向量边界和页尾的文本,
+// 保证 SIMD 扫描, 原地解析和 arena 与逐字节的路径结果一致. json_conformance_scalar 以 JSON_NO_SIMD 编译
+#include "../json.h"
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+	const char kLenientMark[] = "";
+	const char* const kReject = nullptr;
+	const char* const kLenient = kLenientMark; // 此实现宽松地接受的无效文本, 只要求各条路径结果相同
+
+	struct ConformanceCase {
+		const char* name;
+		const char* text;
+		const char* expected; // 紧凑写出的结果, 或 kReject, kLenient
+	};
+
+	const ConformanceCase kCases[] = {
+		{"y_array_arraysWithSpaces", "[[]   ]", "[[]]"},
+		{"y_array_empty", "[]", "[]"},
+		{"y_array_empty-string", "[\"\"]", "[\"\"]"},
+		{"y_array_false", "[false]", "[false]"},
+		{"y_array_heterogeneous", "[null, 1, \"1\", {}]", "[null,1,\"1\",{}]"},
+		{"y_array_null", "[null]", "[null]"},
+		{"y_array_with_1_and_newline", "[1\n]", "[1]"},
+		{"y_array_with_leading_space", " [1]", "[1]"},
+		{"y_array_with_several_null", "[1,null,null,null,2]", "[1,null,null,null,2]"},
+		{"y_array_with_trailing_space", "[2] ", "[2]"},
+		{"y_number", "[123e65]", "[1.23e+67]"},
+		{"y_number_0e+1", "[0e+1]", "[0]"},
+		{"y_number_0e1", "[0e1]", "[0]"},
+		{"y_number_after_space", "[ 4]", "[4]"},
+		{"y_number_double_close_to_zero", "[-0.000000000000000000000000000000000000000000000000000000000000000000000000000001]", "[-1e-78]"},
+		{"y_number_int_with_exp", "[20e1]", "[200]"},
+		{"y_number_minus_zero", "[-0]", "[0]"},
+		{"y_number_negative_int", "[-123]", "[-123]"},
+		{"y_number_negative_one", "[-1]", "[-1]"},
+		{"y_number_real_capital_e", "[1E22]", "[1e+22]"},
+		{"y_number_real_capital_e_neg_exp", "[1E-2]", "[0.01]"},
+		{"y_number_real_capital_e_pos_exp", "[1E+2]", "[100]"},
+		{"y_number_real_exponent", "[123e45]", "[1.23e+47]"},
+		{"y_number_real_fraction_exponent", "[123.456e78]", "[1.23456e+80]"},
+		{"y_number_real_neg_exp", "[1e-2]", "[0.01]"},
+		{"y_number_real_pos_exponent", "[1e+2]", "[100]"},
+		{"y_number_simple_int", "[123]", "[123]"},
+		{"y_number_simple_real", "[123.456789]", "[123.456789]"},
+		{"y_number_max_uint64", "[18446744073709551615]", "[18446744073709551615]"},
+		{"y_number_min_int64", "[-9223372036854775808]", "[-9223372036854775808]"},
+		{"y_number_double_max", "[1.7976931348623157e308]", "[1.7976931348623157e+308]"},
+		{"y_number_double_min_subnormal", "[5e-324]", "[5e-324]"},
+		{"y_number_many_digits", "[3.14159265358979323846264338327950288419716939937510]", "[3.141592653589793]"},
+		{"y_object", "{\"asd\":\"sdf\", \"dfg\":\"fgh\"}", "{\"asd\":\"sdf\",\"dfg\":\"fgh\"}"},
+		{"y_object_basic", "{\"asd\":\"sdf\"}", "{\"asd\":\"sdf\"}"},
+		{"y_object_duplicated_key", "{\"a\":\"b\",\"a\":\"c\"}", "{\"a\":\"b\",\"a\":\"c\"}"},
+		{"y_object_empty", "{}", "{}"},
+		{"y_object_empty_key", "{\"\":0}", "{\"\":0}"},
+		{"y_object_extreme_numbers", "{ \"min\": -1.0e+28, \"max\": 1.0e+28 }", "{\"min\":-1e+28,\"max\":1e+28}"},
+		{"y_object_simple", "{\"a\":[]}", "{\"a\":[]}"},
+		{"y_object_string_unicode", "{\"title\":\"\\u041f\\u043e\\u043b\\u0442\\u043e\\u0440\\u0430 \\u0417\\u0435\\u043c\\u043b\\u0435\\u043a\\u043e\\u043f\\u0430\" }", "{\"title\":\"\xd0\x9f\xd0\xbe\xd0\xbb\xd1\x82\xd0\xbe\xd1\x80\xd0\xb0 \xd0\x97\xd0\xb5\xd0\xbc\xd0\xbb\xd0\xb5\xd0\xba\xd0\xbe\xd0\xbf\xd0\xb0\"}"},
+		{"y_object_with_newlines", "{\n\"a\": \"b\"\n}", "{\"a\":\"b\"}"},
+		{"y_string_1_2_3_bytes_UTF-8_sequences", "[\"\\u0060\\u012a\\u12AB\"]", "[\"`\xc4\xaa\xe1\x8a\xab\"]"},
+		{"y_string_accepted_surrogate_pair", "[\"\\uD801\\udc37\"]", "[\"\xf0\x90\x90\xb7\"]"},
+		{"y_string_allowed_escapes", "[\"\\\"\\\\\\/\\b\\f\\n\\r\\t\"]", "[\"\\\"\\\\/\\b\\f\\n\\r\\t\"]"},
+		{"y_string_backslash_and_u_escaped_zero", "[\"\\\\u0000\"]", "[\"\\\\u0000\"]"},
+		{"y_string_comments", "[\"a/*b*/c/*d//e\"]", "[\"a/*b*/c/*d//e\"]"},
+		{"y_string_double_escape_a", "[\"\\\\a\"]", "[\"\\\\a\"]"},
+		{"y_string_escaped_control_character", "[\"\\u0012\"]", "[\"\\u0012\"]"},
+		{"y_string_in_array_with_leading_space", "[ \"asd\"]", "[\"asd\"]"},
+		{"y_string_nonCharacterInUTF-8_U+FFFF", "[\"\xef\xbf\xbf\"]", "[\"\xef\xbf\xbf\"]"},
+		{"y_string_pi", "[\"\xcf\x80\"]", "[\"\xcf\x80\"]"},
+		{"y_string_unicode_U+10FFFE_nonchar", "[\"\\uDBFF\\uDFFE\"]", "[\"\xf4\x8f\xbf\xbe\"]"},
+		{"y_string_utf8", "[\"\xe2\x82\xac\xf0\x9d\x84\x9e\"]", "[\"\xe2\x82\xac\xf0\x9d\x84\x9e\"]"},
+		{"y_string_with_del_character", "[\"a\x7f" "a\"]", "[\"a\x7f" "a\"]"},
+		{"y_structure_lonely_false", "false", "false"},
+		{"y_structure_lonely_int", "42", "42"},
+		{"y_structure_lonely_negative_real", "-0.1", "-0.1"},
+		{"y_structure_lonely_null", "null", "null"},
+		{"y_structure_lonely_string", "\"asd\"", "\"asd\""},
+		{"y_structure_lonely_true", "true", "true"},
+		{"y_structure_string_empty", "\"\"", "\"\""},
+		{"y_structure_trailing_newline", "[\"a\"]\n", "[\"a\"]"},
+		{"y_structure_true_in_array", "[true]", "[true]"},
+		{"y_structure_whitespace_array", " [] ", "[]"},
+		{"n_array_1_true_without_comma", "[1 true]", kReject},
+		{"n_array_colon_instead_of_comma", "[\"\": 1]", kReject},
+		{"n_array_comma_after_close", "[\"\"],", kLenient},
+		{"n_array_extra_close", "[\"x\"]]", kLenient},
+		{"n_array_incomplete", "[\"x\"", kReject},
+		{"n_array_inner_array_no_comma", "[3[4]]", kReject},
+		{"n_array_items_separated_by_semicolon", "[1:2]", kReject},
+		{"n_array_just_comma", "[,]", kLenient},
+		{"n_array_missing_value", "[   , \"\"]", kLenient},
+		{"n_array_extra_comma", "[\"\",]", kLenient},
+		{"n_array_unclosed", "[\"\"", kReject},
+		{"n_array_unclosed_with_new_lines", "[1,\n1\n,1", kReject},
+		{"n_incomplete_false", "[fals]", kReject},
+		{"n_incomplete_null", "[nul]", kReject},
+		{"n_incomplete_true", "[tru]", kReject},
+		{"n_number_infinity", "[Infinity]", kReject},
+		{"n_number_minus_infinity", "[-Infinity]", kReject},
+		{"n_number_NaN", "[NaN]", kReject},
+		{"n_number_hex_1_digit", "[0x1]", kReject},
+		{"n_number_1.0e+", "[1.0e+]", kLenient},
+		{"n_number_real_without_fractional_part", "[1.]", kLenient},
+		{"n_number_starting_with_dot", "[.123]", kLenient},
+		{"n_number_with_leading_zero", "[012]", kLenient},
+		{"n_number_plus_1", "[+1]", kLenient},
+		{"n_number_just_minus", "[-]", kLenient},
+		{"n_number_1.2.3", "[1.2.3]", kReject},
+		{"n_object_missing_colon", "{\"a\" b}", kReject},
+		{"n_object_missing_key", "{:\"b\"}", kReject},
+		{"n_object_missing_value", "{\"a\":", kReject},
+		{"n_object_non_string_key", "{1:1}", kReject},
+		{"n_object_single_quote", "{'a':0}", kReject},
+		{"n_object_trailing_comma", "{\"id\":0,}", kReject},
+		{"n_object_unquoted_key", "{a: \"b\"}", kReject},
+		{"n_object_two_commas_in_a_row", "{\"a\":\"b\",,\"c\":\"d\"}", kReject},
+		{"n_object_with_trailing_garbage", "{\"a\": true} \"x\"", kLenient},
+		{"n_string_single_quote", "['single quote']", kReject},
+		{"n_string_unescaped_newline", "[\"new\nline\"]", kLenient},
+		{"n_string_unescaped_tab", "[\"\t\"]", kLenient},
+		{"n_string_incomplete_escape", "[\"\\\"]", kReject},
+		{"n_string_invalid_backslash_esc", "[\"\\a\"]", kLenient},
+		{"n_string_incomplete_escaped_character", "[\"\\u00A\"]", kLenient},
+		{"n_string_invalid_unicode_escape", "[\"\\uqqqq\"]", kLenient},
+		{"n_string_lone_high_surrogate", "[\"\\uD800\"]", kLenient},
+		{"n_string_no_quotes_with_bad_escape", "[\\n]", kReject},
+		{"n_structure_unclosed_object", "{\"asd\":\"asd\"", kReject},
+		{"n_structure_open_array_object", "[{", kReject},
+		{"n_structure_open_object", "{", kReject},
+		{"n_structure_close_unopened_array", "1]", kLenient},
+		{"n_structure_no_data", "", kLenient},
+		{"n_structure_whitespace_only", "  ", kLenient},
+		{"n_structure_lone-invalid-utf-8", "\xe5", kLenient},
+		{"n_structure_unclosed_array_partial_null", "[ false, nul", kReject},
+		{"n_structure_comma_instead_of_closing_brace", "{\"x\": true,", kReject},
+		{"n_structure_angle_bracket", "<.>", kLenient},
+		{"n_single_space", " ", kLenient},
+	};
+
+	int g_checks = 0;
+	int g_failures = 0;
+
+	void Check(bool condition, std::string_view name, const char* what) {
+		g_checks++;
+		if(!condition) {
+			g_failures++;
+			printf("FAIL %.*s: %s\n", static_cast<int>(name.size()), name.data(), what);
+		}
+	}
+
+	// 拉取解析的事件序列, 文本在 splits 的位置切成多块送入. skip 为真时跳过 numbers 与 kAy 成员的值
+	std::string PullEvents(std::string_view text, const std::vector<size_t>& splits, int maxDepth = 0, bool skip = false);
+
+	std::string Write(const ksJson* node, int flags) {
+		ksJsonWriter writer;
+		ksJsonWriter_Init(&writer, nullptr, 0, nullptr, nullptr, flags);
+		writer.maxDepth = ksJson_GetMaxDepth(node);
+		ksJsonWriter_Node(&writer, node);
+		ksJsonWriter_Finish(&writer);
+		std::string text(writer.buffer, writer.length);
+		free(writer.buffer);
+		return text;
+	}
+
+	std::string PullEvents(std::string_view text, const std::vector<size_t>& splits, int maxDepth, bool skip) {
+		ksJsonPull parser;
+		ksJsonPull_Init(&parser);
+		if(maxDepth > 0)
+			ksJsonPull_SetMaxDepth(&parser, maxDepth);
+		std::string events;
+		size_t begin = 0;
+		bool done = false;
+		for(size_t chunk = 0; chunk <= splits.size() && !done; chunk++) {
+			const size_t end = chunk < splits.size() ? splits[chunk] : text.size();
+			ksJsonPull_Feed(&parser, text.data() + begin, end - begin, chunk == splits.size());
+			begin = end;
+			while(!done) {
+				const ksJsonPullEvent event = ksJsonPull_Next(&parser);
+				if(event == JSON_PULL_NEED_INPUT)
+					break;
+				switch(event) {
+					case JSON_PULL_BEGIN_OBJECT: events += '{'; break;
+					case JSON_PULL_END_OBJECT: events += '}'; break;
+					case JSON_PULL_BEGIN_ARRAY: events += '['; break;
+					case JSON_PULL_END_ARRAY: events += ']'; break;
+					case JSON_PULL_KEY: {
+						const std::string_view key = ksJsonPull_GetKey(&parser);
+						events += "k:";
+						events += key;
+						events += ';';
+						if(skip && (key == "numbers" || key == "kAy"))
+							ksJsonPull_Skip(&parser);
+						break;
+					}
+					case JSON_PULL_VALUE:
+						events += "v:";
+						events += Write(ksJsonPull_GetValue(&parser), JSON_WRITE_COMPACT);
+						events += ';';
+						break;
+					case JSON_PULL_END:
+						events += "end";
+						done = true;
+						break;
+					default:
+						events += "error:";
+						events += ksJsonPull_GetError(&parser);
+						done = true;
+						break;
+				}
+			}
+		}
+		ksJsonPull_Destroy(&parser);
+		return events;
+	}
+
+	// 解析的结果: 失败时为错误信息, 成功时为紧凑写出的文本
+	struct Outcome {
+		bool ok;
+		std::string text;
+		bool operator==(const Outcome&) const = default;
+	};
+
+	Outcome Parse(const char* text, bool arena, bool inSitu) {
+		ksJson* root = arena ? ksJson_CreateWithArena(256) : ksJson_Create();
+		std::string copy(text);
+		const char* error = nullptr;
+		const bool ok = inSitu ? ksJson_ReadFromBufferInSitu(root, copy.data(), &error) : ksJson_ReadFromBuffer(root, text, &error);
+		Outcome outcome{ok, ok ? Write(root, JSON_WRITE_COMPACT) : error};
+		ksJson_Destroy(root);
+		return outcome;
+	}
+
+	// 文本与结尾的 0 放在可读页的末尾, 之后的一页不可访问, 越过结尾的读取会立即崩溃
+	class GuardedPage {
+	public:
+		GuardedPage() {
+#if defined(_WIN32)
+			SYSTEM_INFO info;
+			GetSystemInfo(&info);
+			m_pageSize = info.dwPageSize;
+			m_memory = static_cast<char*>(VirtualAlloc(nullptr, 2 * m_pageSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+			DWORD oldProtect;
+			VirtualProtect(m_memory + m_pageSize, m_pageSize, PAGE_NOACCESS, &oldProtect);
+#else
+			m_pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+			m_memory = static_cast<char*>(mmap(nullptr, 2 * m_pageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+			mprotect(m_memory + m_pageSize, m_pageSize, PROT_NONE);
+#endif
+		}
+		~GuardedPage() {
+#if defined(_WIN32)
+			VirtualFree(m_memory, 0, MEM_RELEASE);
+#else
+			munmap(m_memory, 2 * m_pageSize);
+#endif
+		}
+		// 文本放不下时返回 nullptr
+		char* place(std::string_view text) {
+			if(text.size() + 1 > m_pageSize)
+				return nullptr;
+			char* start = m_memory + m_pageSize - text.size() - 1;
+			text.copy(start, text.size());
+			start[text.size()] = '\0';
+			return start;
+		}
+
+	private:
+		char* m_memory = nullptr;
+		size_t m_pageSize = 0;
+	};
+
+	// 同一文本在所有解析路径和内存位置上的结果都与基准相同
+	void CheckPaths(std::string_view name, const std::string& text, const Outcome& reference, GuardedPage& page) {
+		Check(Parse(text.c_str(), true, false) == reference, name, "arena differs");
+		Check(Parse(text.c_str(), false, true) == reference, name, "in-situ differs");
+		Check(Parse(text.c_str(), true, true) == reference, name, "arena in-situ differs");
+		// 从向量内的每个偏移开始, 覆盖未对齐的首个向量
+		alignas(64) char aligned[4096 + 64];
+		if(text.size() < 4096) {
+			for(int offset = 0; offset < 64; offset++) {
+				text.copy(aligned + offset, text.size());
+				aligned[offset + text.size()] = '\0';
+				if(!(Parse(aligned + offset, false, false) == reference)) {
+					Check(false, name, "result depends on alignment");
+					break;
+				}
+			}
+		}
+		if(const char* guarded = page.place(text)) {
+			Check(Parse(guarded, false, false) == reference, name, "differs at the end of a page");
+			Check(Parse(guarded, true, true) == reference, name, "in-situ differs at the end of a page");
+		}
+	}
+
+	void CheckTable(GuardedPage& page) {
+		for(const ConformanceCase& c : kCases) {
+			const Outcome outcome = Parse(c.text, false, false);
+			if(c.expected == kReject) {
+				Check(!outcome.ok, c.name, "accepted invalid text");
+			} else if(c.expected != kLenient) {
+				Check(outcome.ok && outcome.text == c.expected, c.name, outcome.ok ? "wrong value" : "rejected valid text");
+				// 写出的文本再解析得到相同的 DOM
+				ksJson* root = ksJson_Create();
+				ksJson_ReadFromBuffer(root, c.text, nullptr);
+				const std::string indented = Write(root, 0);
+				Check(Parse(indented.c_str(), false, false) == outcome, c.name, "indented round trip differs");
+				Check(Parse(outcome.text.c_str(), false, false) == outcome, c.name, "compact round trip differs");
+				ksJson_Destroy(root);
+			}
+			// tape 与 DOM 接受同样的文本, 包括宽松接受的
+			std::string copy(c.text);
+			ksJsonTape tape;
+			ksJsonTape_Init(&tape);
+			Check(ksJsonTape_Parse(&tape, copy.data(), nullptr) == outcome.ok, c.name, "tape and DOM disagree");
+			ksJsonTape_Destroy(&tape);
+			CheckPaths(c.name, c.text, outcome, page);
+		}
+	}
+
+	// 各种长度的空白, 覆盖向量内和跨向量的所有位置
+	void CheckWhiteSpace(GuardedPage& page) {
+		for(int length = 0; length <= 100; length++) {
+			std::string ws;
+			for(int i = 0; i < length; i++)
+				ws += " \t\r\n"[i % 4];
+			const std::string text = ws + "{" + ws + "\"a\"" + ws + ":" + ws + "[" + ws + "1" + ws + "," + ws + "2" + ws + "]" + ws + "}" + ws;
+			const Outcome expected{true, "{\"a\":[1,2]}"};
+			Check(Parse(text.c_str(), false, false) == expected, "white space", "wrong value");
+			CheckPaths("white space", text, expected, page);
+		}
+	}
+
+	// 在字符串的每个位置放一个转义或多字节字符, 检查扫描不会漏掉或多算
+	void CheckStrings(GuardedPage& page) {
+		struct Special {
+			const char* text;
+			const char* value;
+		};
+		const Special specials[] = {
+			{"\\\"", "\""}, {"\\\\", "\\"}, {"\\n", "\n"}, {"\\u00e9", "\xc3\xa9"}, {"\\ud83d\\ude00", "\xf0\x9f\x98\x80"}, {"\xc3\xa9", "\xc3\xa9"}, {"\x7f", "\x7f"},
+		};
+		for(int length = 1; length <= 80; length++) {
+			for(int position = 0; position < length; position++) {
+				for(const Special& special : specials) {
+					const std::string before(position, 'a');
+					const std::string after(length - position - 1, 'b');
+					const std::string text = "[\"" + before + special.text + after + "\"]";
+					const std::string value = before + special.value + after;
+					ksJson* root = ksJson_CreateWithArena(0);
+					std::string copy = text;
+					Check(ksJson_ReadFromBuffer(root, text.c_str(), nullptr) && value == ksJson_GetString(ksJson_GetMemberByIndex(root, 0), ""), "strings", "wrong value");
+					Check(ksJson_ReadFromBufferInSitu(root, copy.data(), nullptr) && value == ksJson_GetString(ksJson_GetMemberByIndex(root, 0), ""), "strings", "wrong in-situ value");
+					ksJson_Destroy(root);
+					if(const char* guarded = page.place(text)) {
+						ksJson* guardedRoot = ksJson_Create();
+						Check(ksJson_ReadFromBuffer(guardedRoot, guarded, nullptr) && value == ksJson_GetString(ksJson_GetMemberByIndex(guardedRoot, 0), ""), "strings", "wrong value at the end of a page");
+						ksJson_Destroy(guardedRoot);
+					}
+				}
+			}
+		}
+		// 未结束的字符串在页尾被拒绝
+		for(int length = 0; length <= 80; length++) {
+			const std::string text = "[\"" + std::string(length, 'a');
+			if(const char* guarded = page.place(text)) {
+				ksJson* root = ksJson_Create();
+				Check(!ksJson_ReadFromBuffer(root, guarded, nullptr), "strings", "accepted an unterminated string");
+				ksJson_Destroy(root);
+			}
+		}
+	}
+
+	// 整数精确, 浮点数与 strtod 的结果逐位相同
+	void CheckNumbers() {
+		uint64_t state = 12345;
+		const auto digit = [&state] {
+			state = state * 6364136223846793005ull + 1442695040888963407ull;
+			return static_cast<char>('0' + (state >> 33) % 10);
+		};
+		for(int length = 1; length <= 40; length++) {
+			for(int i = 0; i < 25; i++) {
+				std::string digits(1, static_cast<char>('1' + (digit() - '0') % 9));
+				while(static_cast<int>(digits.size()) < length)
+					digits += digit();
+				const std::string fraction = digits.substr(0, (length + 1) / 2) + "." + digits.substr((length + 1) / 2);
+				const std::string exponent = digits + "e" + (i % 2 ? "-" : "") + std::to_string(i * 13 % 330);
+				for(const std::string& number : {digits, "-" + digits, fraction, "-" + fraction, exponent}) {
+					ksJson* root = ksJson_Create();
+					const std::string text = "[" + number + "]";
+					ksJson_ReadFromBuffer(root, text.c_str(), nullptr);
+					const ksJson* value = ksJson_GetMemberByIndex(root, 0);
+					if(ksJson_IsFloatingPoint(value)) {
+						const double expected = strtod(number.c_str(), nullptr);
+						Check(ksJson_GetDouble(value, 0.0) == std::fmin(std::fmax(expected, -DBL_MAX), DBL_MAX), number, "inexact floating-point number");
+					} else if(number[0] == '-') {
+						Check(ksJson_GetInt64(value, 0) == strtoll(number.c_str(), nullptr, 10), number, "wrong integer");
+					} else {
+						Check(ksJson_GetUint64(value, 0) == strtoull(number.c_str(), nullptr, 10), number, "wrong integer");
+					}
+					// tape 延迟转换的数字与 DOM 相同
+					std::string copy(text);
+					ksJsonTape tape;
+					ksJsonTape_Init(&tape);
+					ksJsonTape_Parse(&tape, copy.data(), nullptr);
+					ksJson node;
+					const ksJson* lazy = ksJsonCursor_GetValue(ksJsonCursor_GetMemberByIndex(ksJsonTape_GetRoot(&tape), 0), &node);
+					Check(lazy != nullptr && lazy->type == value->type && ksJson_GetDouble(lazy, 0.0) == ksJson_GetDouble(value, 0.0) &&
+						ksJson_GetInt64(lazy, 0) == ksJson_GetInt64(value, 0), number, "tape number differs");
+					ksJsonTape_Destroy(&tape);
+					ksJson_Destroy(root);
+				}
+			}
+		}
+	}
+
+	void CheckDepth() {
+		const auto nested = [](int depth) { return std::string(depth, '[') + "1" + std::string(depth, ']'); };
+		ksJson* root = ksJson_Create();
+		Check(ksJson_ReadFromBuffer(root, nested(JSON_DEFAULT_MAX_DEPTH).c_str(), nullptr), "depth", "rejected the default depth");
+		Check(!ksJson_ReadFromBuffer(root, nested(JSON_DEFAULT_MAX_DEPTH + 1).c_str(), nullptr), "depth", "accepted more than the default depth");
+		ksJson_SetMaxDepth(root, 10000);
+		const std::string deep = nested(10000);
+		Check(ksJson_ReadFromBuffer(root, deep.c_str(), nullptr) && Write(root, JSON_WRITE_COMPACT) == deep, "depth", "deep round trip differs");
+		ksJson_Destroy(root);
+		// tape 使用相同的深度限制, 也不受调用栈限制
+		ksJsonTape tape;
+		ksJsonTape_Init(&tape);
+		std::string text = nested(JSON_DEFAULT_MAX_DEPTH);
+		Check(ksJsonTape_Parse(&tape, text.data(), nullptr), "tape depth", "rejected the default depth");
+		text = nested(JSON_DEFAULT_MAX_DEPTH + 1);
+		Check(!ksJsonTape_Parse(&tape, text.data(), nullptr), "tape depth", "accepted more than the default depth");
+		ksJsonTape_SetMaxDepth(&tape, 10000);
+		text = deep;
+		Check(ksJsonTape_Parse(&tape, text.data(), nullptr) && ksJsonCursor_GetMemberCount(ksJsonTape_GetRoot(&tape)) == 1, "tape depth", "rejected a deep document");
+		ksJsonTape_Destroy(&tape);
+		// 拉取解析也使用相同的深度限制
+		Check(PullEvents(nested(JSON_DEFAULT_MAX_DEPTH), {}).find("error") == std::string::npos, "pull depth", "rejected the default depth");
+		Check(PullEvents(nested(JSON_DEFAULT_MAX_DEPTH + 1), {}).ends_with("error:maximum depth"), "pull depth", "accepted more than the default depth");
+		Check(PullEvents(deep, {}, 10000).ends_with("]end"), "pull depth", "rejected a deep document");
+	}
+
+	// 文本中的转义, 数字和字面量在每个位置被分块切开, 事件与一次送入时相同
+	void CheckPullChunks() {
+		const std::string text =
+			"{\"name\":\"a\\\"b\\\\c\\nd\\u00e9\\ud83d\\ude00\","
+			"\"numbers\":[0,-12.5e+3,18446744073709551615,-9223372036854775808,0.000123,1E22],"
+			"\"literals\":[true,false,null],"
+			"\"k\\u0041y\":{\"skip\":[\"]}\\\"\",{}]}} [1]\n";
+		const std::string expected =
+			"{k:name;v:\"a\\\"b\\\\c\\nd\xc3\xa9\xf0\x9f\x98\x80\";"
+			"k:numbers;[v:0;v:-12500;v:18446744073709551615;v:-9223372036854775808;v:0.000123;v:1e+22;]"
+			"k:literals;[v:true;v:false;v:null;]"
+			"k:kAy;{k:skip;[v:\"]}\\\"\";{}]}}[v:1;]end";
+		Check(PullEvents(text, {}) == expected, "pull", "wrong events");
+		for(size_t split = 1; split < text.size(); split++) {
+			if(PullEvents(text, {split}) != expected) {
+				Check(false, "pull chunks", "events depend on the chunk boundary");
+				break;
+			}
+		}
+		std::vector<size_t> bytes;
+		for(size_t split = 1; split < text.size(); split++)
+			bytes.push_back(split);
+		Check(PullEvents(text, bytes) == expected, "pull bytes", "events differ when fed byte by byte");
+		// 跳过的容器中的字符串与转义同样可以被切开
+		const std::string skipped = "{k:name;v:\"a\\\"b\\\\c\\nd\xc3\xa9\xf0\x9f\x98\x80\";k:numbers;"
+									"k:literals;[v:true;v:false;v:null;]k:kAy;}[v:1;]end";
+		for(size_t split = 1; split < text.size(); split++) {
+			if(PullEvents(text, {split}, 0, true) != skipped) {
+				Check(false, "pull skip chunks", "skipping depends on the chunk boundary");
+				break;
+			}
+		}
+		Check(PullEvents(text, bytes, 0, true) == skipped, "pull skip bytes", "skipping differs when fed byte by byte");
+		// 在转义和数字中间结束的文本是错误
+		for(const char* truncated : {"[\"a\\", "[\"\\u00", "[-", "[1e", "[tru"})
+			Check(PullEvents(truncated, {1}).find("error") != std::string::npos, truncated, "accepted truncated text");
+	}
+
+	// RFC 7396 附录 A 的用例, 以及在有哈希索引的大对象上删除, 移动成员后的查找
+	void CheckMergePatch() {
+		const char* const cases[][3] = {
+			{R"({"a":"b"})", R"({"a":"c"})", R"({"a":"c"})"},
+			{R"({"a":"b"})", R"({"b":"c"})", R"({"a":"b","b":"c"})"},
+			{R"({"a":"b"})", R"({"a":null})", R"({})"},
+			{R"({"a":"b","b":"c"})", R"({"a":null})", R"({"b":"c"})"},
+			{R"({"a":["b"]})", R"({"a":"c"})", R"({"a":"c"})"},
+			{R"({"a":"c"})", R"({"a":["b"]})", R"({"a":["b"]})"},
+			{R"({"a":{"b":"c"}})", R"({"a":{"b":"d","c":null}})", R"({"a":{"b":"d"}})"},
+			{R"({"a":[{"b":"c"}]})", R"({"a":[1]})", R"({"a":[1]})"},
+			{R"(["a","b"])", R"(["c","d"])", R"(["c","d"])"},
+			{R"({"a":"b"})", R"(["c"])", R"(["c"])"},
+			{R"({"a":"foo"})", R"(null)", R"(null)"},
+			{R"({"a":"foo"})", R"("bar")", R"("bar")"},
+			{R"({"e":null})", R"({"a":1})", R"({"e":null,"a":1})"},
+			{R"([1,2])", R"({"a":"b","c":null})", R"({"a":"b"})"},
+			{R"({})", R"({"a":{"bb":{"ccc":null}}})", R"({"a":{"bb":{}}})"},
+			{R"({"a":1,"b":2})", R"({"a":null,"a":3})", R"({"b":2,"a":3})"},
+		};
+		for(const bool arena : {false, true}) {
+			for(const auto& c : cases) {
+				ksJson* target = arena ? ksJson_CreateWithArena(256) : ksJson_Create();
+				ksJson* patch = ksJson_Create();
+				ksJson_ReadFromBuffer(target, c[0], nullptr);
+				ksJson_ReadFromBuffer(patch, c[1], nullptr);
+				ksJson_MergePatch(target, patch);
+				Check(Write(target, JSON_WRITE_COMPACT) == c[2], c[1], "wrong merge patch result");
+				ksJson_Destroy(patch);
+				ksJson_Destroy(target);
+			}
+
+			ksJson* root = arena ? ksJson_CreateWithArena(256) : ksJson_Create();
+			ksJson* object = ksJson_SetObject(root);
+			std::string patchText = "{";
+			for(int i = 0; i < 1000; i++) {
+				char name[16];
+				snprintf(name, sizeof(name), "m%d", i);
+				ksJson_SetInt32(ksJson_AddObjectMember(object, name), i);
+				if(i % 3 == 0) {
+					patchText += '\"';
+					patchText += name;
+					patchText += "\":null,";
+				}
+			}
+			patchText += "\"m1\":{\"x\":[true]}}";
+			ksJson_GetMemberByName(object, "m0"); // 建立哈希索引
+			ksJson* patch = ksJson_Create();
+			ksJson_ReadFromBuffer(patch, patchText.c_str(), nullptr);
+			ksJson_MergePatch(object, patch);
+			ksJson_Destroy(patch);
+			ksJson_RemoveMemberByName(object, "m2");
+			ksJson_MoveMember(object, "moved", object, ksJson_GetMemberIndex(object, ksJson_GetMemberByName(object, "m4")));
+			bool found = ksJson_GetMemberCount(object) == 665;
+			for(int i = 0; i < 1000; i++) {
+				char name[16];
+				snprintf(name, sizeof(name), "m%d", i);
+				const ksJson* member = ksJson_GetMemberByName(object, name);
+				const bool expected = i % 3 != 0 && i != 2 && i != 4;
+				found = found && (member != nullptr) == expected && (!expected || i == 1 || ksJson_GetInt32(member, -1) == i);
+			}
+			found = found && ksJson_GetInt32(ksJson_GetMemberByName(object, "moved"), -1) == 4 &&
+					ksJson_IsObject(ksJson_GetMemberByName(object, "m1"));
+			Check(found, arena ? "merge patch arena" : "merge patch heap", "wrong members after removing members");
+			ksJson_Destroy(root);
+		}
+	}
+
+	// 多个线程同时查找同一个对象的成员, 竞争建立哈希索引, 小对象的查找使用各线程自己的提示
+	// 以 LXD_ENABLE_TSAN 构建时由 ThreadSanitizer 检查
+	void CheckConcurrentLookup() {
+		constexpr int kThreads = 4;
+		constexpr int kMembers = 100;
+		std::string text = "{";
+		for(int i = 0; i < kMembers; i++) {
+			char member[32];
+			snprintf(member, sizeof(member), "\"n%d\":%d,", i, i);
+			text += member;
+		}
+		text += "\"small\":{\"a\":1,\"b\":2,\"c\":3}}";
+		for(bool arena : {false, true}) {
+			for(int round = 0; round < 20; round++) {
+				ksJson* root = arena ? ksJson_CreateWithArena(4096) : ksJson_Create();
+				ksJson_ReadFromBuffer(root, text.c_str(), nullptr);
+				const ksJson* small = ksJson_GetMemberByName(root, "small");
+				std::atomic<int> ready{0};
+				std::atomic<int> wrong{0};
+				std::vector<std::thread> threads;
+				for(int t = 0; t < kThreads; t++) {
+					threads.emplace_back([&, t] {
+						ready++;
+						while(ready.load() < kThreads)
+							std::this_thread::yield();
+						for(int k = 0; k < kMembers; k++) {
+							const int i = (k * 7 + t * 13) % kMembers;
+							char name[16];
+							snprintf(name, sizeof(name), "n%d", i);
+							if(ksJson_GetInt32(ksJson_GetMemberByName(root, name), -1) != i)
+								wrong++;
+							const char smallName[2] = {static_cast<char>('a' + (k + t) % 3), '\0'};
+							if(ksJson_GetInt32(ksJson_GetMemberByName(small, smallName), -1) != 1 + (k + t) % 3)
+								wrong++;
+						}
+						if(ksJson_GetMemberByName(root, "missing") != nullptr)
+							wrong++;
+					});
+				}
+				for(auto& thread : threads)
+					thread.join();
+				Check(wrong.load() == 0, arena ? "concurrent lookup arena" : "concurrent lookup heap", "wrong member found");
+				ksJson_Destroy(root);
+			}
+		}
+	}
+}
+
+int main() {
+	GuardedPage page;
+	CheckTable(page);
+	CheckWhiteSpace(page);
+	CheckStrings(page);
+	CheckNumbers();
+	CheckDepth();
+	CheckPullChunks();
+	CheckMergePatch();
+	CheckConcurrentLookup();
+	printf("%d checks, %d failures\n", g_checks, g_failures);
+	return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,445 @@
+#include "json_corpus.h"
+#include "../glb.h"
+#include "../json.h"
+#include <cstring>
+#include <string>
+
+namespace lxd {
+	namespace {
+		// splitmix64, 同一种子在所有平台上得到同样的语料
+		class Random {
+		public:
+			explicit Random(uint64_t seed) : m_state(seed) {}
+			uint64_t next() {
+				uint64_t z = (m_state += 0x9E3779B97F4A7C15ull);
+				z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+				z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+				return z ^ (z >> 31);
+			}
+			// [lo, hi]
+			int range(int lo, int hi) {
+				return lo + static_cast<int>(next() % static_cast<uint64_t>(hi - lo + 1));
+			}
+			double uniform(double lo, double hi) {
+				return lo + (hi - lo) * static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0);
+			}
+			bool chance(int percent) {
+				return range(0, 99) < percent;
+			}
+
+		private:
+			uint64_t m_state;
+		};
+
+		constexpr const char* kWords[] = {
+			"the", "mesh", "tooth", "scan", "export", "crown", "margin", "model", "update", "release",
+			"quality", "report", "today", "again", "new", "fast", "check", "view", "link", "photo",
+		};
+		constexpr const char* kWideWords[] = {
+			"こんにちは", "東京", "歯科", "模型", "更新", "ありがとう", "牙冠", "数据", "😀", "Größe",
+		};
+
+		// 单词之间偶尔夹杂需要转义的引号, 反斜杠和换行
+		std::string Sentence(Random& random, int minWords, int maxWords) {
+			std::string text;
+			const int count = random.range(minWords, maxWords);
+			for(int i = 0; i < count; i++) {
+				if(i > 0)
+					text += random.chance(5) ? "\n" : " ";
+				text += random.chance(30) ? kWideWords[random.range(0, 9)] : kWords[random.range(0, 19)];
+				if(random.chance(4))
+					text += random.chance(50) ? "\"" : "\\";
+			}
+			return text;
+		}
+
+		std::string Digits(Random& random, int count) {
+			std::string digits(count, '0');
+			for(char& c : digits)
+				c = static_cast<char>('0' + random.range(0, 9));
+			digits[0] = static_cast<char>('1' + random.range(0, 8));
+			return digits;
+		}
+
+		std::string TakeText(ksJsonWriter& writer) {
+			ksJsonWriter_Finish(&writer);
+			std::string text(writer.buffer, writer.length);
+			free(writer.buffer);
+			return text;
+		}
+
+		void KeyString(ksJsonWriter* writer, const char* key, const std::string& value) {
+			ksJsonWriter_Key(writer, key);
+			ksJsonWriter_String(writer, value.c_str());
+		}
+		void KeyInt(ksJsonWriter* writer, const char* key, int64_t value) {
+			ksJsonWriter_Key(writer, key);
+			ksJsonWriter_Int64(writer, value);
+		}
+		void KeyBool(ksJsonWriter* writer, const char* key, bool value) {
+			ksJsonWriter_Key(writer, key);
+			ksJsonWriter_Bool(writer, value);
+		}
+		void KeyNull(ksJsonWriter* writer, const char* key) {
+			ksJsonWriter_Key(writer, key);
+			ksJsonWriter_Null(writer);
+		}
+
+		void WriteTwitterUser(ksJsonWriter* writer, Random& random) {
+			const std::string id = Digits(random, random.range(8, 10));
+			ksJsonWriter_BeginObject(writer);
+			KeyInt(writer, "id", std::stoll(id));
+			KeyString(writer, "id_str", id);
+			KeyString(writer, "name", Sentence(random, 1, 2));
+			KeyString(writer, "screen_name", kWords[random.range(0, 19)] + Digits(random, 4));
+			KeyString(writer, "location", Sentence(random, 0, 2));
+			KeyString(writer, "description", Sentence(random, 5, 30));
+			KeyNull(writer, "url");
+			ksJsonWriter_Key(writer, "entities");
+			ksJsonWriter_BeginObject(writer);
+			ksJsonWriter_Key(writer, "description");
+			ksJsonWriter_BeginObject(writer);
+			ksJsonWriter_Key(writer, "urls");
+			ksJsonWriter_BeginArray(writer);
+			ksJsonWriter_EndArray(writer);
+			ksJsonWriter_EndObject(writer);
+			ksJsonWriter_EndObject(writer);
+			KeyBool(writer, "protected", random.chance(10));
+			KeyInt(writer, "followers_count", random.range(0, 100000));
+			KeyInt(writer, "friends_count", random.range(0, 5000));
+			KeyInt(writer, "listed_count", random.range(0, 100));
+			KeyString(writer, "created_at", "Sun Jul 29 13:01:43 +0000 2012");
+			KeyInt(writer, "favourites_count", random.range(0, 20000));
+			KeyInt(writer, "utc_offset", random.chance(50) ? 32400 : -18000);
+			KeyString(writer, "time_zone", random.chance(50) ? "Tokyo" : "Beijing");
+			KeyBool(writer, "geo_enabled", random.chance(30));
+			KeyBool(writer, "verified", false);
+			KeyInt(writer, "statuses_count", random.range(0, 100000));
+			KeyString(writer, "lang", random.chance(70) ? "ja" : "en");
+			KeyBool(writer, "contributors_enabled", false);
+			KeyBool(writer, "is_translator", false);
+			KeyBool(writer, "is_translation_enabled", false);
+			KeyString(writer, "profile_background_color", "C0DEED");
+			KeyString(writer, "profile_background_image_url", "http://abs.twimg.com/images/themes/theme1/bg.png");
+			KeyString(writer, "profile_background_image_url_https", "https://abs.twimg.com/images/themes/theme1/bg.png");
+			KeyBool(writer, "profile_background_tile", false);
+			KeyString(writer, "profile_image_url", "http://pbs.twimg.com/profile_images/" + Digits(random, 18) + "/normal.jpeg");
+			KeyString(writer, "profile_image_url_https", "https://pbs.twimg.com/profile_images/" + Digits(random, 18) + "/normal.jpeg");
+			KeyString(writer, "profile_link_color", "0084B4");
+			KeyString(writer, "profile_sidebar_border_color", "C0DEED");
+			KeyString(writer, "profile_sidebar_fill_color", "DDEEF6");
+			KeyString(writer, "profile_text_color", "333333");
+			KeyBool(writer, "profile_use_background_image", true);
+			KeyBool(writer, "default_profile", true);
+			KeyBool(writer, "default_profile_image", false);
+			KeyBool(writer, "following", false);
+			KeyBool(writer, "follow_request_sent", false);
+			KeyBool(writer, "notifications", false);
+			ksJsonWriter_EndObject(writer);
+		}
+
+		void WriteTwitterStatus(ksJsonWriter* writer, Random& random, bool retweet) {
+			const std::string id = Digits(random, 18);
+			ksJsonWriter_BeginObject(writer);
+			ksJsonWriter_Key(writer, "metadata");
+			ksJsonWriter_BeginObject(writer);
+			KeyString(writer, "result_type", "recent");
+			KeyString(writer, "iso_language_code", random.chance(70) ? "ja" : "en");
+			ksJsonWriter_EndObject(writer);
+			KeyString(writer, "created_at", "Sun Aug 31 00:29:15 +0000 2014");
+			ksJsonWriter_Key(writer, "id");
+			ksJsonWriter_Uint64(writer, std::stoull(id));
+			KeyString(writer, "id_str", id);
+			KeyString(writer, "text", Sentence(random, 3, 40));
+			KeyString(writer, "source", "<a href=\"http://twitter.com/download/iphone\" rel=\"nofollow\">Twitter for iPhone</a>");
+			KeyBool(writer, "truncated", false);
+			KeyNull(writer, "in_reply_to_status_id");
+			KeyNull(writer, "in_reply_to_status_id_str");
+			KeyNull(writer, "in_reply_to_user_id");
+			KeyNull(writer, "in_reply_to_user_id_str");
+			KeyNull(writer, "in_reply_to_screen_name");
+			ksJsonWriter_Key(writer, "user");
+			WriteTwitterUser(writer, random);
+			KeyNull(writer, "geo");
+			KeyNull(writer, "coordinates");
+			KeyNull(writer, "place");
+			KeyNull(writer, "contributors");
+			if(retweet) {
+				ksJsonWriter_Key(writer, "retweeted_status");
+				WriteTwitterStatus(writer, random, false);
+			}
+			KeyInt(writer, "retweet_count", random.range(0, 1000));
+			KeyInt(writer, "favorite_count", random.range(0, 1000));
+			ksJsonWriter_Key(writer, "entities");
+			ksJsonWriter_BeginObject(writer);
+			for(const char* key : {"hashtags", "symbols", "urls"}) {
+				ksJsonWriter_Key(writer, key);
+				ksJsonWriter_BeginArray(writer);
+				ksJsonWriter_EndArray(writer);
+			}
+			ksJsonWriter_Key(writer, "user_mentions");
+			ksJsonWriter_BeginArray(writer);
+			for(int i = random.range(0, 3); i > 0; i--) {
+				const std::string userId = Digits(random, 10);
+				ksJsonWriter_BeginObject(writer);
+				KeyString(writer, "screen_name", kWords[random.range(0, 19)] + Digits(random, 3));
+				KeyString(writer, "name", Sentence(random, 1, 2));
+				KeyInt(writer, "id", std::stoll(userId));
+				KeyString(writer, "id_str", userId);
+				ksJsonWriter_Key(writer, "indices");
+				ksJsonWriter_BeginArray(writer);
+				ksJsonWriter_Int64(writer, random.range(0, 10));
+				ksJsonWriter_Int64(writer, random.range(10, 20));
+				ksJsonWriter_EndArray(writer);
+				ksJsonWriter_EndObject(writer);
+			}
+			ksJsonWriter_EndArray(writer);
+			ksJsonWriter_EndObject(writer);
+			KeyBool(writer, "favorited", false);
+			KeyBool(writer, "retweeted", false);
+			KeyString(writer, "lang", random.chance(70) ? "ja" : "en");
+			ksJsonWriter_EndObject(writer);
+		}
+
+		// 以 id 为键, 值为名字的对象
+		void WriteNames(ksJsonWriter* writer, Random& random, const char* key, const std::vector<int64_t>& ids) {
+			ksJsonWriter_Key(writer, key);
+			ksJsonWriter_BeginObject(writer);
+			for(const int64_t id : ids)
+				KeyString(writer, std::to_string(id).c_str(), Sentence(random, 1, 4));
+			ksJsonWriter_EndObject(writer);
+		}
+
+		std::vector<int64_t> MakeIds(Random& random, int count, int64_t base) {
+			std::vector<int64_t> ids(count);
+			for(auto& id : ids)
+				id = base + random.range(0, 99999999);
+			return ids;
+		}
+	}
+
+	std::string MakeCanadaLikeJson(uint64_t seed) {
+		Random random(seed);
+		ksJsonWriter writer;
+		ksJsonWriter_Init(&writer, nullptr, 0, nullptr, nullptr, JSON_WRITE_COMPACT);
+		ksJsonWriter_BeginObject(&writer);
+		KeyString(&writer, "type", "FeatureCollection");
+		ksJsonWriter_Key(&writer, "features");
+		ksJsonWriter_BeginArray(&writer);
+		ksJsonWriter_BeginObject(&writer);
+		KeyString(&writer, "type", "Feature");
+		ksJsonWriter_Key(&writer, "properties");
+		ksJsonWriter_BeginObject(&writer);
+		KeyString(&writer, "name", "Canada");
+		ksJsonWriter_EndObject(&writer);
+		ksJsonWriter_Key(&writer, "geometry");
+		ksJsonWriter_BeginObject(&writer);
+		KeyString(&writer, "type", "Polygon");
+		ksJsonWriter_Key(&writer, "coordinates");
+		ksJsonWriter_BeginArray(&writer);
+		// 480 个环, 每个环是首尾相同的折线, 共约 5.6 万个点
+		for(int ring = 0; ring < 480; ring++) {
+			double lon = random.uniform(-141.0, -52.0);
+			double lat = random.uniform(42.0, 83.0);
+			const int count = random.range(10, 220);
+			double first[2] = {lon, lat};
+			ksJsonWriter_BeginArray(&writer);
+			for(int i = 0; i <= count; i++) {
+				if(i == count) {
+					lon = first[0];
+					lat = first[1];
+				}
+				ksJsonWriter_BeginArray(&writer);
+				ksJsonWriter_Double(&writer, lon);
+				ksJsonWriter_Double(&writer, lat);
+				ksJsonWriter_EndArray(&writer);
+				lon += random.uniform(-0.05, 0.05);
+				lat += random.uniform(-0.05, 0.05);
+			}
+			ksJsonWriter_EndArray(&writer);
+		}
+		ksJsonWriter_EndArray(&writer);
+		ksJsonWriter_EndObject(&writer);
+		ksJsonWriter_EndObject(&writer);
+		ksJsonWriter_EndArray(&writer);
+		ksJsonWriter_EndObject(&writer);
+		return TakeText(writer);
+	}
+
+	std::string MakeTwitterLikeJson(uint64_t seed) {
+		Random random(seed);
+		ksJsonWriter writer;
+		ksJsonWriter_Init(&writer, nullptr, 0, nullptr, nullptr, 0);
+		ksJsonWriter_BeginObject(&writer);
+		ksJsonWriter_Key(&writer, "statuses");
+		ksJsonWriter_BeginArray(&writer);
+		for(int i = 0; i < 100; i++)
+			WriteTwitterStatus(&writer, random, random.chance(30));
+		ksJsonWriter_EndArray(&writer);
+		ksJsonWriter_Key(&writer, "search_metadata");
+		ksJsonWriter_BeginObject(&writer);
+		ksJsonWriter_Key(&writer, "completed_in");
+		ksJsonWriter_Double(&writer, 0.087);
+		ksJsonWriter_Key(&writer, "max_id");
+		ksJsonWriter_Uint64(&writer, 505874924095815681ull);
+		KeyString(&writer, "max_id_str", "505874924095815681");
+		KeyString(&writer, "next_results", "?max_id=505874847260352512&q=%E4%B8%80&count=100&include_entities=1");
+		KeyString(&writer, "query", "%E4%B8%80");
+		KeyString(&writer, "refresh_url", "?since_id=505874924095815681&q=%E4%B8%80&include_entities=1");
+		KeyInt(&writer, "count", 100);
+		KeyInt(&writer, "since_id", 0);
+		KeyString(&writer, "since_id_str", "0");
+		ksJsonWriter_EndObject(&writer);
+		ksJsonWriter_EndObject(&writer);
+		return TakeText(writer);
+	}
+
+	std::string MakeCitmLikeJson(uint64_t seed) {
+		Random random(seed);
+		const std::vector<int64_t> areaIds = MakeIds(random, 17, 205700000);
+		const std::vector<int64_t> audienceIds = MakeIds(random, 1, 337100000);
+		const std::vector<int64_t> eventIds = MakeIds(random, 184, 138500000);
+		const std::vector<int64_t> seatCategoryIds = MakeIds(random, 64, 338900000);
+		const std::vector<int64_t> subTopicIds = MakeIds(random, 19, 337100000);
+		const std::vector<int64_t> topicIds = MakeIds(random, 4, 107800000);
+
+		ksJsonWriter writer;
+		ksJsonWriter_Init(&writer, nullptr, 0, nullptr, nullptr, 0);
+		ksJsonWriter_BeginObject(&writer);
+		WriteNames(&writer, random, "areaNames", areaIds);
+		WriteNames(&writer, random, "audienceSubCategoryNames", audienceIds);
+		WriteNames(&writer, random, "blockNames", {});
+		ksJsonWriter_Key(&writer, "events");
+		ksJsonWriter_BeginObject(&writer);
+		for(const int64_t id : eventIds) {
+			ksJsonWriter_Key(&writer, std::to_string(id).c_str());
+			ksJsonWriter_BeginObject(&writer);
+			KeyNull(&writer, "description");
+			KeyInt(&writer, "id", id);
+			if(random.chance(20))
+				KeyString(&writer, "logo", "/images/UE0AAAAACEKo6QAAAAZDSVRN");
+			else
+				KeyNull(&writer, "logo");
+			KeyString(&writer, "name", Sentence(random, 1, 5));
+			ksJsonWriter_Key(&writer, "subTopicIds");
+			ksJsonWriter_BeginArray(&writer);
+			for(int i = random.range(1, 4); i > 0; i--)
+				ksJsonWriter_Int64(&writer, subTopicIds[random.range(0, 18)]);
+			ksJsonWriter_EndArray(&writer);
+			KeyNull(&writer, "subjectCode");
+			KeyNull(&writer, "subtitle");
+			ksJsonWriter_Key(&writer, "topicIds");
+			ksJsonWriter_BeginArray(&writer);
+			for(int i = random.range(1, 3); i > 0; i--)
+				ksJsonWriter_Int64(&writer, topicIds[random.range(0, 3)]);
+			ksJsonWriter_EndArray(&writer);
+			ksJsonWriter_EndObject(&writer);
+		}
+		ksJsonWriter_EndObject(&writer);
+		ksJsonWriter_Key(&writer, "performances");
+		ksJsonWriter_BeginArray(&writer);
+		for(int performance = 0; performance < 243; performance++) {
+			ksJsonWriter_BeginObject(&writer);
+			KeyInt(&writer, "eventId", eventIds[random.range(0, 183)]);
+			KeyInt(&writer, "id", 339880000 + performance);
+			KeyNull(&writer, "logo");
+			KeyNull(&writer, "name");
+			ksJsonWriter_Key(&writer, "prices");
+			ksJsonWriter_BeginArray(&writer);
+			for(int i = random.range(1, 10); i > 0; i--) {
+				ksJsonWriter_BeginObject(&writer);
+				KeyInt(&writer, "amount", random.range(10, 300) * 250);
+				KeyInt(&writer, "audienceSubCategoryId", audienceIds[0]);
+				KeyInt(&writer, "seatCategoryId", seatCategoryIds[random.range(0, 63)]);
+				ksJsonWriter_EndObject(&writer);
+			}
+			ksJsonWriter_EndArray(&writer);
+			ksJsonWriter_Key(&writer, "seatCategories");
+			ksJsonWriter_BeginArray(&writer);
+			for(int i = random.range(1, 5); i > 0; i--) {
+				ksJsonWriter_BeginObject(&writer);
+				ksJsonWriter_Key(&writer, "areas");
+				ksJsonWriter_BeginArray(&writer);
+				for(int j = random.range(1, 25); j > 0; j--) {
+					ksJsonWriter_BeginObject(&writer);
+					KeyInt(&writer, "areaId", areaIds[random.range(0, 16)]);
+					ksJsonWriter_Key(&writer, "blockIds");
+					ksJsonWriter_BeginArray(&writer);
+					ksJsonWriter_EndArray(&writer);
+					ksJsonWriter_EndObject(&writer);
+				}
+				ksJsonWriter_EndArray(&writer);
+				KeyInt(&writer, "seatCategoryId", seatCategoryIds[random.range(0, 63)]);
+				ksJsonWriter_EndObject(&writer);
+			}
+			ksJsonWriter_EndArray(&writer);
+			KeyNull(&writer, "seatMapImage");
+			KeyInt(&writer, "start", 1372701600000ll + 86400000ll * performance);
+			KeyString(&writer, "venueCode", "PLEYEL_PLEYEL");
+			ksJsonWriter_EndObject(&writer);
+		}
+		ksJsonWriter_EndArray(&writer);
+		WriteNames(&writer, random, "seatCategoryNames", seatCategoryIds);
+		WriteNames(&writer, random, "subTopicNames", subTopicIds);
+		WriteNames(&writer, random, "subjectNames", {});
+		WriteNames(&writer, random, "topicNames", topicIds);
+		ksJsonWriter_Key(&writer, "topicSubTopics");
+		ksJsonWriter_BeginObject(&writer);
+		for(const int64_t id : topicIds) {
+			ksJsonWriter_Key(&writer, std::to_string(id).c_str());
+			ksJsonWriter_BeginArray(&writer);
+			for(int i = random.range(1, 8); i > 0; i--)
+				ksJsonWriter_Int64(&writer, subTopicIds[random.range(0, 18)]);
+			ksJsonWriter_EndArray(&writer);
+		}
+		ksJsonWriter_EndObject(&writer);
+		ksJsonWriter_Key(&writer, "venueNames");
+		ksJsonWriter_BeginObject(&writer);
+		KeyString(&writer, "PLEYEL_PLEYEL", "Salle Pleyel");
+		ksJsonWriter_EndObject(&writer);
+		ksJsonWriter_EndObject(&writer);
+		return TakeText(writer);
+	}
+
+	std::string MakeGltfJson(int resolution, bool extraAttribute) {
+		std::vector<MyVec3f> points;
+		std::vector<Face> faces;
+		for(int y = 0; y < resolution; y++) {
+			for(int x = 0; x < resolution; x++)
+				points.push_back({{static_cast<float>(x), static_cast<float>(y), static_cast<float>((x * y) % 7)}});
+		}
+		for(int y = 0; y + 1 < resolution; y++) {
+			for(int x = 0; x + 1 < resolution; x++) {
+				const int i = y * resolution + x;
+				faces.push_back({{i, i + 1, i + resolution}});
+				faces.push_back({{i + 1, i + resolution + 1, i + resolution}});
+			}
+		}
+		Glb glb;
+		if(!glb.create(points, faces, extraAttribute ? std::vector<char>(points.size(), 1) : std::vector<char>()))
+			return {};
+		const std::vector<uint8_t> bytes = glb.searialize();
+		return GlbJsonChunk(std::string_view(reinterpret_cast<const char*>(bytes.data()), bytes.size()));
+	}
+
+	std::string GlbJsonChunk(std::string_view glb) {
+		// 12 字节文件头, 之后每块为 4 字节长度 + 4 字节类型 + 数据
+		uint32_t words[5];
+		if(glb.size() < sizeof(words))
+			return {};
+		std::memcpy(words, glb.data(), sizeof(words));
+		if(words[0] != 0x46546C67 || words[4] != 0x4E4F534A || words[3] > glb.size() - sizeof(words))
+			return {};
+		return std::string(glb.substr(sizeof(words), words[3]));
+	}
+
+	std::vector<JsonCorpusDocument> MakeJsonCorpus() {
+		return {
+			{"canada", MakeCanadaLikeJson(1)},
+			{"twitter", MakeTwitterLikeJson(2)},
+			{"citm_catalog", MakeCitmLikeJson(3)},
+			{"gltf_u16", MakeGltfJson(64, false)},
+			{"gltf_u32_extra", MakeGltfJson(256, true)},
+		};
+	}
+}
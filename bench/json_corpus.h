@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lxd {
+	struct JsonCorpusDocument {
+		std::string name;
+		std::string text;
+	};
+
+	// 与 canada.json 相似: 一个 GeoJSON 多边形集合, 几乎全是 17 位有效数字的浮点坐标
+	std::string MakeCanadaLikeJson(uint64_t seed);
+	// 与 twitter.json 相似: 100 条推文, 嵌套的用户对象, 含转义和多字节 UTF-8 的字符串
+	std::string MakeTwitterLikeJson(uint64_t seed);
+	// 与 citm_catalog.json 相似: 以数字为键的大对象, 大量整数数组和 null
+	std::string MakeCitmLikeJson(uint64_t seed);
+	// Glb::create 为 resolution x resolution 的网格生成的 JSON 块
+	std::string MakeGltfJson(int resolution, bool extraAttribute);
+	// .glb 文件中第一个块(JSON)的内容, 不是 glb 时返回空串
+	std::string GlbJsonChunk(std::string_view glb);
+
+	// 基准测试的标准语料, 内容只由种子决定
+	std::vector<JsonCorpusDocument> MakeJsonCorpus();
+}
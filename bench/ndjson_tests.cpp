@@ -0,0 +1,175 @@
+// ndjson.h 的逐行读取测试, 由 ctest 运行, 失败时返回非零
+// 覆盖 CRLF, 空行, 缺少末尾换行, 出错的行不影响下一行, 以及切块边界落在记录中间的大文本
+#include "../ndjson.h"
+#include "../json.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+	int g_checks = 0;
+	int g_failures = 0;
+
+	void Check(bool condition, std::string_view name, const char* what) {
+		g_checks++;
+		if(!condition) {
+			g_failures++;
+			printf("FAIL %.*s: %s\n", static_cast<int>(name.size()), name.data(), what);
+		}
+	}
+
+	struct Record {
+		size_t offset;
+		int64_t value; // 记录的 "i" 成员, 不是对象时为数组的第一个元素或数值本身
+	};
+
+	int64_t ValueOf(const ksJson* record) {
+		if(ksJson_IsObject(record))
+			return ksJson_GetInt64(ksJson_GetMemberByName(record, "i"), -1);
+		if(ksJson_IsArray(record))
+			return ksJson_GetInt64(ksJson_GetMemberByIndex(record, 0), -1);
+		return ksJson_GetInt64(record, -1);
+	}
+
+	// 回调并发执行, 按偏移排序后比较
+	std::vector<Record> ForEach(std::string_view text, std::vector<lxd::NdjsonError>* errors, size_t* count) {
+		std::vector<Record> records;
+		std::mutex mutex;
+		*count = lxd::ForEachNdjson(text, [&](size_t offset, const ksJson* record) {
+			const int64_t value = ValueOf(record);
+			std::lock_guard lock(mutex);
+			records.push_back({offset, value});
+		}, errors);
+		std::sort(records.begin(), records.end(), [](const Record& a, const Record& b) { return a.offset < b.offset; });
+		return records;
+	}
+
+	bool Same(const std::vector<Record>& a, const std::vector<Record>& b) {
+		if(a.size() != b.size())
+			return false;
+		for(size_t i = 0; i < a.size(); i++) {
+			if(a[i].offset != b[i].offset || a[i].value != b[i].value)
+				return false;
+		}
+		return true;
+	}
+
+	void CheckLines() {
+		// 空行, 只有空白的行, CRLF, 最后一行没有换行且以数值结尾
+		const std::string text = "{\"i\":1}\n\n  \t\n{\"i\":2}\r\n\r\n[3, \"x\"]\r\n  {\"i\":4}  \n5";
+		std::vector<lxd::NdjsonError> errors;
+		size_t count = 0;
+		const auto records = ForEach(text, &errors, &count);
+		const std::vector<Record> expected{{0, 1}, {13, 2}, {24, 3}, {34, 4}, {46, 5}};
+		Check(count == 5 && errors.empty(), "lines", "blank lines or CRLF not handled");
+		Check(Same(records, expected), "lines", "wrong offsets or values");
+
+		const auto read = lxd::ReadNdjson(text);
+		Check(read.size() == 5 && read.errors().empty(), "lines read", "wrong record count");
+		for(size_t i = 0; i < expected.size(); i++)
+			Check(ValueOf(read[i]) == expected[i].value, "lines read", "wrong value");
+		Check(ksJson_GetString(ksJson_GetMemberByIndex(read[2], 1), "") == std::string_view("x"), "lines read", "string not copied");
+
+		// 只有 CRLF 的最后一行, 末尾的字符串和对象
+		Check(lxd::ReadNdjson("1\r\n\"s\"\r\n").size() == 2, "crlf end", "wrong record count");
+		Check(lxd::ReadNdjson("{\"i\":7}").size() == 1, "no newline", "single record without newline");
+		Check(lxd::ReadNdjson("").size() == 0 && lxd::ReadNdjson("\n\r\n ").size() == 0, "empty", "records in blank text");
+	}
+
+	void CheckErrors() {
+		// 出错的行报告自己的偏移, 越过换行的记录也是错误, 下一行照常解析
+		const std::string text =
+			"[1,\n"							// 0: 数组在下一行才结束
+			"2]\n"							// 4: 值之后的文本被忽略
+			"\"open\n"						// 7: 字符串在下一行才结束
+			"{\"i\":8}\n"					// 13
+			"{\"i\":9, \"s\":\"a\\\n"		// 21: 转义在行尾
+			"{\"i\":10} trailing\n"			// 37
+			"{\"i\":";						// 55: 文本在值中间结束
+		std::vector<lxd::NdjsonError> errors;
+		size_t count = 0;
+		const auto records = ForEach(text, &errors, &count);
+		Check(count == 3 && Same(records, {{4, 2}, {13, 8}, {37, 10}}), "errors", "valid lines after errors not parsed");
+		std::vector<size_t> offsets;
+		for(const auto& error : errors)
+			offsets.push_back(error.offset);
+		Check(offsets == std::vector<size_t>{0, 7, 21, 55}, "errors", "wrong error offsets");
+		for(const auto& error : errors)
+			Check(error.message != nullptr, "errors", "missing error message");
+
+		const auto read = lxd::ReadNdjson(text);
+		Check(read.size() == 7 && read.errors().size() == 4, "errors read", "wrong record or error count");
+		Check(ksJson_IsNull(read[0]) && ValueOf(read[1]) == 2 && ValueOf(read[3]) == 8 && ValueOf(read[5]) == 10, "errors read", "failed lines not null");
+	}
+
+	// 大于切块下限的文本切成多块, 切点先落在记录中间再移到下一个换行之后
+	std::string MakeLargeText(std::vector<Record>& expected) {
+		std::string text;
+		for(int64_t i = 0; text.size() < 5u << 20; i++) {
+			if(i % 7 == 0)
+				text += i % 2 ? "\r\n" : "\n";
+			expected.push_back({text.size(), i});
+			text += "{\"i\":" + std::to_string(i) + ",\"s\":\"";
+			text.append(static_cast<size_t>(i * 37 % 300), 'a' + i % 26);
+			text += "\",\"a\":[1,2,{\"k\":\"\\u00e9\"}]}";
+			text += i % 3 ? "\n" : "\r\n";
+		}
+		// 最后一条记录没有换行
+		expected.push_back({text.size(), -7});
+		text += "[-7]";
+		return text;
+	}
+
+	void CheckChunks() {
+		std::vector<Record> expected;
+		const std::string text = MakeLargeText(expected);
+		std::vector<lxd::NdjsonError> errors;
+		size_t count = 0;
+		const auto records = ForEach(text, &errors, &count);
+		Check(errors.empty() && count == expected.size(), "chunks", "records lost or split at chunk boundaries");
+		Check(Same(records, expected), "chunks", "wrong offsets or values");
+
+		const auto read = lxd::ReadNdjson(text);
+		Check(read.size() == expected.size() && read.errors().empty(), "chunks read", "wrong record count");
+		bool same = read.size() == expected.size();
+		for(size_t i = 0; same && i < expected.size(); i++) {
+			same = ValueOf(read[i]) == expected[i].value &&
+				ksJson_GetString(ksJson_GetMemberByIndex(ksJson_GetMemberByIndex(ksJson_GetMemberByName(read[i], "a"), 2), 0), "") == std::string_view(i + 1 < expected.size() ? "\xC3\xA9" : "");
+		}
+		Check(same, "chunks read", "records not in line order");
+	}
+
+	void CheckFile() {
+		// 正好填满整页的文件末尾没有 0, 映射要补上, 最后一行的数值才能在文件末尾结束
+		const auto path = std::filesystem::temp_directory_path() / "lxd_ndjson_tests.ndjson";
+		std::string text = "{\"i\":1}\n";
+		text.append(4096 * 2 - text.size() - 3, ' ');
+		text += "\n42";
+		std::ofstream(path, std::ios::binary).write(text.data(), static_cast<std::streamsize>(text.size()));
+		std::vector<Record> records;
+		std::mutex mutex;
+		const size_t count = lxd::ForEachNdjsonFile(path.c_str(), [&](size_t offset, const ksJson* record) {
+			std::lock_guard lock(mutex);
+			records.push_back({offset, ValueOf(record)});
+		});
+		std::sort(records.begin(), records.end(), [](const Record& a, const Record& b) { return a.offset < b.offset; });
+		Check(count == 2 && Same(records, {{0, 1}, {text.size() - 2, 42}}), "file", "wrong records from a page sized file");
+		const auto read = lxd::ReadNdjsonFile(path.c_str());
+		Check(read.size() == 2 && ValueOf(read[1]) == 42, "file read", "wrong records from a page sized file");
+		std::filesystem::remove(path);
+	}
+}
+
+int main() {
+	CheckLines();
+	CheckErrors();
+	CheckChunks();
+	CheckFile();
+	printf("%d checks, %d failures\n", g_checks, g_failures);
+	return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,224 @@
+// tasks.h 的任务调度器测试, 由 ctest 运行, 失败时返回非零
+// 覆盖嵌套任务组, 取消从外层组传到内层组, wait 重新抛出第一个异常, 工作线程中的 wait 执行任务, 外部线程提交任务
+// 以 LXD_ENABLE_TSAN 构建时在 ThreadSanitizer 下运行
+#include "../tasks.h"
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+	int g_checks = 0;
+	int g_failures = 0;
+
+	void Check(bool condition, std::string_view name, const char* what) {
+		g_checks++;
+		if(!condition) {
+			g_failures++;
+			printf("FAIL %.*s: %s\n", static_cast<int>(name.size()), name.data(), what);
+		}
+	}
+
+	// 工作线程数固定, 与机器的核数无关
+	constexpr int kWorkers = 3;
+
+	void CheckNested() {
+		lxd::TaskScheduler scheduler(kWorkers);
+		std::atomic<int> sum{0};
+		lxd::TaskGroup outer(scheduler);
+		for(int i = 0; i < 16; i++) {
+			outer.run([&scheduler, &sum, i] {
+				lxd::TaskGroup inner(scheduler);
+				for(int j = 0; j < 64; j++)
+					inner.run([&sum, i, j] { sum.fetch_add(i * 64 + j, std::memory_order_relaxed); });
+				inner.wait();
+			});
+		}
+		Check(outer.wait(), "nested", "outer group reported cancelled");
+		Check(sum.load() == 1023 * 1024 / 2, "nested", "inner tasks did not all run once");
+
+		auto value = outer.async([&scheduler] {
+			lxd::TaskGroup inner(scheduler);
+			auto part = inner.async([] { return 20; });
+			inner.wait();
+			return part.get() + 22;
+		});
+		outer.wait();
+		Check(value.get() == 42, "nested async", "wrong result");
+	}
+
+	void CheckCancel() {
+		lxd::TaskScheduler scheduler(kWorkers);
+		std::atomic<int> ran{0};
+		std::atomic<bool> childCancelled{false};
+		std::atomic<bool> childCompleted{true};
+		auto owner = std::make_shared<int>(0);
+		lxd::TaskGroup outer(scheduler);
+		outer.run([&] {
+			lxd::TaskGroup child(scheduler);
+			outer.cancel();
+			childCancelled = child.isCancelled();
+			// 外层组取消后内层组的任务被跳过, 但仍然销毁可调用对象
+			for(int i = 0; i < 100; i++)
+				child.run([&ran, owner] { ran++; });
+			childCompleted = child.wait();
+		});
+		Check(!outer.wait(), "cancel", "outer group not reported cancelled");
+		Check(childCancelled.load(), "cancel", "child group did not see the cancelled parent");
+		Check(!childCompleted.load(), "cancel", "child wait did not report the cancellation");
+		Check(ran.load() == 0, "cancel", "tasks of the cancelled child group ran");
+		Check(owner.use_count() == 1, "cancel", "skipped tasks were not destroyed");
+
+		lxd::TaskGroup group(scheduler);
+		auto future = group.async([] { return 1; });
+		group.cancel();
+		group.wait();
+		// 任务可能在取消之前已经开始
+		int result = 0;
+		bool broken = false;
+		try {
+			result = future.get();
+		} catch(const std::future_error&) {
+			broken = true;
+		}
+		Check(broken || result == 1, "cancel async", "wrong result of a cancelled task");
+	}
+
+	void CheckException() {
+		lxd::TaskScheduler scheduler(kWorkers);
+		lxd::TaskGroup group(scheduler);
+		group.run([] { throw std::runtime_error("first"); });
+		// 只有在第一个异常记录并取消任务组之后才抛出, 或者被跳过
+		group.run([&group] {
+			while(!group.isCancelled())
+				std::this_thread::yield();
+			throw std::runtime_error("second");
+		});
+		std::string message;
+		try {
+			group.wait();
+		} catch(const std::runtime_error& error) {
+			message = error.what();
+		}
+		Check(message == "first", "exception", "wait did not rethrow the first exception");
+		bool rethrown = false;
+		bool completed = true;
+		try {
+			completed = group.wait();
+		} catch(...) {
+			rethrown = true;
+		}
+		Check(!rethrown && !completed, "exception", "second wait rethrew or reported completion");
+
+		lxd::TaskGroup many(scheduler);
+		std::atomic<int> thrown{0};
+		for(int i = 0; i < 200; i++) {
+			many.run([&thrown, i] {
+				thrown++;
+				throw std::runtime_error(std::to_string(i));
+			});
+		}
+		int caught = 0;
+		try {
+			many.wait();
+		} catch(const std::runtime_error&) {
+			caught++;
+		}
+		Check(caught == 1 && thrown.load() >= 1, "exception many", "wait did not rethrow exactly one exception");
+	}
+
+	void CheckHelping() {
+		// 只有一个工作线程, 外层任务等待内层组时若不执行任务就会死锁
+		lxd::TaskScheduler scheduler(1);
+		std::atomic<int> count{0};
+		std::atomic<bool> sameThread{true};
+		std::atomic<bool> finished{false};
+		lxd::TaskGroup outer(scheduler);
+		outer.run([&] {
+			const std::thread::id worker = std::this_thread::get_id();
+			lxd::TaskGroup inner(scheduler);
+			for(int i = 0; i < 100; i++) {
+				inner.run([&count, &sameThread, worker] {
+					count++;
+					if(std::this_thread::get_id() != worker)
+						sameThread = false;
+				});
+			}
+			inner.wait();
+			finished = true;
+		});
+		// 主线程不调用 wait, 不参与执行任务
+		while(!finished)
+			std::this_thread::yield();
+		outer.wait();
+		Check(count.load() == 100, "helping", "inner tasks did not all run");
+		Check(sameThread.load(), "helping", "inner tasks did not run on the waiting worker");
+
+		// 没有工作线程时由等待的线程执行全部任务
+		lxd::TaskScheduler serial(0);
+		lxd::TaskGroup group(serial);
+		int sum = 0;
+		for(int i = 0; i < 10; i++)
+			group.run([&serial, &sum, i] {
+				lxd::TaskGroup inner(serial);
+				inner.run([&sum, i] { sum += i; });
+				inner.wait();
+			});
+		group.wait();
+		Check(sum == 45, "helping without workers", "wrong sum");
+	}
+
+	void CheckExternal() {
+		lxd::TaskScheduler scheduler(kWorkers);
+		std::atomic<int> count{0};
+		lxd::TaskGroup group(scheduler);
+		std::vector<std::thread> threads;
+		for(int t = 0; t < 4; t++) {
+			threads.emplace_back([&group, &count] {
+				for(int i = 0; i < 1000; i++)
+					group.run([&count] { count.fetch_add(1, std::memory_order_relaxed); });
+			});
+		}
+		for(auto& thread : threads)
+			thread.join();
+		group.wait();
+		Check(count.load() == 4000, "external", "tasks from other threads did not all run");
+
+		// 每个外部线程等待自己的任务组
+		std::atomic<int> waited{0};
+		threads.clear();
+		for(int t = 0; t < 4; t++) {
+			threads.emplace_back([&scheduler, &waited] {
+				for(int r = 0; r < 20; r++) {
+					std::vector<int> values(100);
+					lxd::TaskGroup own(scheduler);
+					for(int i = 0; i < 100; i++)
+						own.run([&values, i] { values[i] = i; });
+					own.wait();
+					bool ok = true;
+					for(int i = 0; i < 100; i++)
+						ok = ok && values[i] == i;
+					if(ok)
+						waited++;
+				}
+			});
+		}
+		for(auto& thread : threads)
+			thread.join();
+		Check(waited.load() == 80, "external wait", "results of tasks not visible after wait");
+	}
+}
+
+int main() {
+	CheckNested();
+	CheckCancel();
+	CheckException();
+	CheckHelping();
+	CheckExternal();
+	printf("%d checks, %d failures\n", g_checks, g_failures);
+	return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,263 @@
+#include "deviation.h"
+#include "utils.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <variant>
+
+namespace lxd {
+	namespace {
+		constexpr uint32_t kLeafSize = 4;
+		constexpr size_t kGrain = 1 << 10;
+
+		inline float Dot(const float* a, const float* b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+
+		// Ericson, Real-Time Collision Detection, 5.1.5 ClosestPtPointTriangle
+		MyVec3f ClosestPointOnTriangle(const MyVec3f& p, const MyVec3f& a, const MyVec3f& b, const MyVec3f& c) {
+			float ab[3], ac[3], ap[3];
+			for(int k = 0; k < 3; k++) {
+				ab[k] = b.v[k] - a.v[k];
+				ac[k] = c.v[k] - a.v[k];
+				ap[k] = p.v[k] - a.v[k];
+			}
+			const float d1 = Dot(ab, ap), d2 = Dot(ac, ap);
+			if(d1 <= 0.0f && d2 <= 0.0f)
+				return a;
+			float bp[3];
+			for(int k = 0; k < 3; k++)
+				bp[k] = p.v[k] - b.v[k];
+			const float d3 = Dot(ab, bp), d4 = Dot(ac, bp);
+			if(d3 >= 0.0f && d4 <= d3)
+				return b;
+			auto lerp = [&](const MyVec3f& o, const float* dir, float t) {
+				return MyVec3f{{o.v[0] + t * dir[0], o.v[1] + t * dir[1], o.v[2] + t * dir[2]}};
+			};
+			const float vc = d1 * d4 - d3 * d2;
+			if(vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+				return lerp(a, ab, d1 / (d1 - d3));
+			float cp[3];
+			for(int k = 0; k < 3; k++)
+				cp[k] = p.v[k] - c.v[k];
+			const float d5 = Dot(ab, cp), d6 = Dot(ac, cp);
+			if(d6 >= 0.0f && d5 <= d6)
+				return c;
+			const float vb = d5 * d2 - d1 * d6;
+			if(vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+				return lerp(a, ac, d2 / (d2 - d6));
+			const float va = d3 * d6 - d5 * d4;
+			if(va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+				const float bc[3] = {c.v[0] - b.v[0], c.v[1] - b.v[1], c.v[2] - b.v[2]};
+				return lerp(b, bc, (d4 - d3) / ((d4 - d3) + (d5 - d6)));
+			}
+			const float denom = 1.0f / (va + vb + vc);
+			const float v = vb * denom, w = vc * denom;
+			return MyVec3f{{a.v[0] + ab[0] * v + ac[0] * w, a.v[1] + ab[1] * v + ac[1] * w, a.v[2] + ab[2] * v + ac[2] * w}};
+		}
+
+		float BoxDistance2(const float* min, const float* max, const MyVec3f& p) {
+			float d2 = 0.0f;
+			for(int k = 0; k < 3; k++) {
+				const float d = std::max({min[k] - p.v[k], 0.0f, p.v[k] - max[k]});
+				d2 += d * d;
+			}
+			return d2;
+		}
+
+		// 采样点: A 的顶点 + 每个面的中心
+		std::vector<MyVec3f> SamplePoints(std::span<const MyVec3f> points, std::span<const uint32_t> faces) {
+			const size_t nFace = faces.size() / 3;
+			std::vector<MyVec3f> samples(points.size() + nFace);
+			std::copy(points.begin(), points.end(), samples.begin());
+			ParallelFor(nFace, kGrain, [&](size_t begin, size_t end) {
+				for(size_t f = begin; f < end; f++) {
+					for(int k = 0; k < 3; k++)
+						samples[points.size() + f].v[k] = (points[faces[3 * f]].v[k] + points[faces[3 * f + 1]].v[k] + points[faces[3 * f + 2]].v[k]) / 3.0f;
+				}
+			});
+			return samples;
+		}
+
+		DeviationStats Summarize(const std::vector<TriangleBvh::Hit>& hits) {
+			DeviationStats stats;
+			stats.samples = hits.size();
+			if(hits.empty())
+				return stats;
+			double sum = 0.0, sum2 = 0.0;
+			for(const auto& hit : hits) {
+				const double d = std::abs(hit.distance);
+				stats.max = std::max(stats.max, static_cast<float>(d));
+				sum += d;
+				sum2 += d * d;
+			}
+			stats.mean = static_cast<float>(sum / hits.size());
+			stats.rms = static_cast<float>(std::sqrt(sum2 / hits.size()));
+			return stats;
+		}
+
+		std::vector<uint32_t> FacesOf(Glb& glb) {
+			std::vector<uint32_t> faces;
+			std::visit([&](auto indices) { faces.assign(indices.begin(), indices.end()); }, glb.getIndices());
+			return faces;
+		}
+	}
+
+	bool TriangleBvh::build(std::span<const MyVec3f> points, std::span<const uint32_t> faces) {
+		m_nodes.clear();
+		m_triangles.clear();
+		const size_t nFace = faces.size() / 3;
+		if(nFace == 0 || nFace >= UINT32_MAX)
+			return false;
+		if(std::any_of(faces.begin(), faces.end(), [&](uint32_t i) { return i >= points.size(); }))
+			return false;
+		m_triangles.resize(nFace);
+		ParallelFor(nFace, kGrain, [&](size_t begin, size_t end) {
+			for(size_t f = begin; f < end; f++) {
+				for(int k = 0; k < 3; k++)
+					m_triangles[f].v[k] = points[faces[3 * f + k]];
+				m_triangles[f].face = static_cast<uint32_t>(f);
+			}
+		});
+		m_nodes.reserve(2 * nFace / kLeafSize + 1);
+		buildNode(0, static_cast<uint32_t>(nFace));
+		return true;
+	}
+
+	uint32_t TriangleBvh::buildNode(uint32_t first, uint32_t count) {
+		const auto index = static_cast<uint32_t>(m_nodes.size());
+		m_nodes.emplace_back();
+		Node node;
+		float cmin[3], cmax[3];
+		for(int k = 0; k < 3; k++) {
+			node.min[k] = cmin[k] = std::numeric_limits<float>::max();
+			node.max[k] = cmax[k] = -std::numeric_limits<float>::max();
+		}
+		const auto begin = m_triangles.begin() + first, end = begin + count;
+		for(auto tri = begin; tri != end; ++tri) {
+			for(int k = 0; k < 3; k++) {
+				for(const auto& v : tri->v) {
+					node.min[k] = std::min(node.min[k], v.v[k]);
+					node.max[k] = std::max(node.max[k], v.v[k]);
+				}
+				const float c = tri->v[0].v[k] + tri->v[1].v[k] + tri->v[2].v[k];
+				cmin[k] = std::min(cmin[k], c);
+				cmax[k] = std::max(cmax[k], c);
+			}
+		}
+		if(count <= kLeafSize) {
+			node.first = first;
+			node.count = count;
+			m_nodes[index] = node;
+			return index;
+		}
+		// 沿质心范围最长的轴按中位数原地切分
+		int axis = 0;
+		for(int k = 1; k < 3; k++) {
+			if(cmax[k] - cmin[k] > cmax[axis] - cmin[axis])
+				axis = k;
+		}
+		const uint32_t half = count / 2;
+		std::nth_element(begin, begin + half, end, [axis](const Triangle& a, const Triangle& b) {
+			return a.v[0].v[axis] + a.v[1].v[axis] + a.v[2].v[axis] < b.v[0].v[axis] + b.v[1].v[axis] + b.v[2].v[axis];
+		});
+		buildNode(first, half);
+		node.first = buildNode(first + half, count - half);
+		node.count = 0;
+		m_nodes[index] = node;
+		return index;
+	}
+
+	TriangleBvh::Hit TriangleBvh::closest(const MyVec3f& query) const {
+		Hit hit;
+		if(m_nodes.empty())
+			return hit;
+		float best = std::numeric_limits<float>::max();
+		uint32_t stack[64];
+		int top = 0;
+		stack[top++] = 0;
+		while(top > 0) {
+			const Node& node = m_nodes[stack[--top]];
+			if(BoxDistance2(node.min, node.max, query) >= best)
+				continue;
+			if(node.count > 0) {
+				for(uint32_t i = node.first; i < node.first + node.count; i++) {
+					const Triangle& tri = m_triangles[i];
+					const MyVec3f q = ClosestPointOnTriangle(query, tri.v[0], tri.v[1], tri.v[2]);
+					const float d[3] = {query.v[0] - q.v[0], query.v[1] - q.v[1], query.v[2] - q.v[2]};
+					const float d2 = Dot(d, d);
+					if(d2 < best) {
+						best = d2;
+						hit.face = i;
+						hit.point = q;
+					}
+				}
+				continue;
+			}
+			// 先压远的子节点, 近的先出栈
+			const uint32_t left = static_cast<uint32_t>(&node - m_nodes.data()) + 1;
+			const uint32_t right = node.first;
+			const float dl = BoxDistance2(m_nodes[left].min, m_nodes[left].max, query);
+			const float dr = BoxDistance2(m_nodes[right].min, m_nodes[right].max, query);
+			if(dl <= dr) {
+				stack[top++] = right;
+				stack[top++] = left;
+			} else {
+				stack[top++] = left;
+				stack[top++] = right;
+			}
+		}
+		// 符号由三角形法向决定
+		const Triangle& tri = m_triangles[hit.face];
+		float ab[3], ac[3], n[3];
+		for(int k = 0; k < 3; k++) {
+			ab[k] = tri.v[1].v[k] - tri.v[0].v[k];
+			ac[k] = tri.v[2].v[k] - tri.v[0].v[k];
+		}
+		n[0] = ab[1] * ac[2] - ab[2] * ac[1];
+		n[1] = ab[2] * ac[0] - ab[0] * ac[2];
+		n[2] = ab[0] * ac[1] - ab[1] * ac[0];
+		const float d[3] = {query.v[0] - hit.point.v[0], query.v[1] - hit.point.v[1], query.v[2] - hit.point.v[2]};
+		hit.distance = Dot(d, n) < 0.0f ? -std::sqrt(best) : std::sqrt(best);
+		hit.face = tri.face;
+		return hit;
+	}
+
+	void TriangleBvh::closest(std::span<const MyVec3f> queries, std::vector<Hit>& hits) const {
+		hits.resize(queries.size());
+		ParallelFor(queries.size(), kGrain, [&](size_t begin, size_t end) {
+			for(size_t i = begin; i < end; i++)
+				hits[i] = closest(queries[i]);
+		});
+	}
+
+	DeviationReport ComputeDeviation(std::span<const MyVec3f> pointsA, std::span<const uint32_t> facesA,
+									 std::span<const MyVec3f> pointsB, std::span<const uint32_t> facesB) {
+		DeviationReport report;
+		TriangleBvh bvhA, bvhB;
+		if(!bvhA.build(pointsA, facesA) || !bvhB.build(pointsB, facesB))
+			return report;
+		std::vector<TriangleBvh::Hit> hits;
+		bvhB.closest(SamplePoints(pointsA, facesA), hits);
+		report.aToB = Summarize(hits);
+		report.perVertex.resize(pointsA.size());
+		for(size_t i = 0; i < pointsA.size(); i++)
+			report.perVertex[i] = hits[i].distance;
+		bvhA.closest(SamplePoints(pointsB, facesB), hits);
+		report.bToA = Summarize(hits);
+		report.hausdorff = std::max(report.aToB.max, report.bToA.max);
+		return report;
+	}
+
+	DeviationReport ComputeDeviation(Glb& a, Glb& b) {
+		const auto facesA = FacesOf(a);
+		const auto facesB = FacesOf(b);
+		return ComputeDeviation(a.getPositions(), facesA, b.getPositions(), facesB);
+	}
+
+	std::vector<char> DeviationToAttribute(std::span<const float> deviation, float range) {
+		std::vector<char> result(deviation.size());
+		const float scale = range > 0.0f ? 127.0f / range : 0.0f;
+		for(size_t i = 0; i < deviation.size(); i++)
+			result[i] = static_cast<char>(std::lround(std::clamp(deviation[i] * scale, -127.0f, 127.0f)));
+		return result;
+	}
+}
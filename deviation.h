@@ -0,0 +1,67 @@
+#pragma once
+
+#include "defines.h"
+#include "glb.h"
+#include <cstdint>
+#include <vector>
+#include <span>
+
+namespace lxd {
+	/// <summary>
+	/// 三角形包围盒层次树(BVH), 用于批量最近点查询
+	/// 叶子中的三角形按树的顺序连续存放, 查询时先访问较近的子节点并按当前最近距离剪枝
+	/// </summary>
+	class DLL_PUBLIC TriangleBvh {
+	public:
+		struct Hit {
+			float distance = 0.0f; // 有符号距离, 在三角形法向一侧为正
+			uint32_t face = UINT32_MAX;
+			MyVec3f point{};
+		};
+		bool build(std::span<const MyVec3f> points, std::span<const uint32_t> faces);
+		Hit closest(const MyVec3f& query) const;
+		// 并行批量查询, hits 大小与 queries 相同
+		void closest(std::span<const MyVec3f> queries, std::vector<Hit>& hits) const;
+		bool empty() const { return m_nodes.empty(); }
+
+	private:
+		struct Node {
+			float min[3];
+			float max[3];
+			uint32_t first; // 叶子: 第一个三角形; 内部节点: 右子节点(左子节点紧随其后)
+			uint32_t count; // 叶子中的三角形数, 内部节点为 0
+		};
+		struct Triangle {
+			MyVec3f v[3];
+			uint32_t face;
+		};
+		uint32_t buildNode(uint32_t first, uint32_t count);
+
+	private:
+		std::vector<Node> m_nodes;
+		std::vector<Triangle> m_triangles;
+	};
+
+	struct DeviationStats {
+		float max = 0.0f;  // 最大绝对距离
+		float mean = 0.0f; // 平均绝对距离
+		float rms = 0.0f;
+		size_t samples = 0;
+	};
+
+	struct DeviationReport {
+		DeviationStats aToB;
+		DeviationStats bToA;
+		float hausdorff = 0.0f; // 对称 Hausdorff 距离 max(aToB.max, bToA.max)
+		std::vector<float> perVertex; // A 的每个顶点到 B 的有符号距离
+	};
+
+	/// <summary>
+	/// 网格 A 与 B 的双向偏差: 在 A 的顶点和面中心采样, 查询到 B 的最近点, 再反向查询
+	/// </summary>
+	DLL_PUBLIC DeviationReport ComputeDeviation(std::span<const MyVec3f> pointsA, std::span<const uint32_t> facesA,
+												std::span<const MyVec3f> pointsB, std::span<const uint32_t> facesB);
+	DLL_PUBLIC DeviationReport ComputeDeviation(Glb& a, Glb& b);
+	// 把 [-range, range] 的偏差线性量化到 [-127, 127], 可直接作为 Glb::create 的顶点属性
+	DLL_PUBLIC std::vector<char> DeviationToAttribute(std::span<const float> deviation, float range);
+}
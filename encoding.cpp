@@ -1,5 +1,8 @@
 #include "encoding.h"
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
 #ifdef _WIN32
 #include <Windows.h>
 #include <stringapiset.h>
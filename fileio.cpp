@@ -7,8 +7,10 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <fts.h>
+#include <sys/mman.h>
 #endif
 #include <fmt/format.h>
+#include <algorithm>
 #include <cassert>
 #include <fmt/xchar.h>
 
@@ -510,6 +512,88 @@ namespace lxd {
 			 lastWT.tm_sec < otherTM.tm_sec;
 #else
 		 return false;
+#endif
+	 }
+
+	 MappedFile::MappedFile(const Char* path) {
+#ifdef _WIN32
+		 HANDLE file = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		 if(file == INVALID_HANDLE_VALUE)
+			 return;
+		 LARGE_INTEGER size{};
+		 SYSTEM_INFO info;
+		 GetSystemInfo(&info);
+		 if(GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+			 const size_t fileSize = static_cast<size_t>(size.QuadPart);
+			 if(fileSize % info.dwPageSize != 0) {
+				 // 最后一页的剩余部分为 0. 视图映射后即可关闭文件和映射句柄, 视图会保持映射有效
+				 HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				 if(mapping) {
+					 _data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+					 if(_data)
+						 _size = _mappedSize = fileSize;
+					 CloseHandle(mapping);
+				 }
+			 } else {
+				 // 文件正好填满最后一页时后面没有 0, 改为读入以 0 结尾的缓冲区
+				 char* buffer = new char[fileSize + 1];
+				 size_t done = 0;
+				 DWORD n = 0;
+				 while(done < fileSize && ReadFile(file, buffer + done, static_cast<DWORD>(std::min<size_t>(fileSize - done, 1u << 30)), &n, nullptr) && n > 0)
+					 done += n;
+				 if(done == fileSize) {
+					 buffer[fileSize] = '\0';
+					 _data = buffer;
+					 _size = fileSize;
+				 } else {
+					 delete[] buffer;
+				 }
+			 }
+		 }
+		 CloseHandle(file);
+#else
+		 const int fd = open(path, O_RDONLY);
+		 if(fd < 0)
+			 return;
+		 struct stat st;
+		 if(fstat(fd, &st) == 0 && st.st_size > 0) {
+			 const size_t size = static_cast<size_t>(st.st_size);
+			 const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+			 // 最后一页的剩余部分为 0, 文件正好填满最后一页时映射到一段匿名的零页之前
+			 const size_t mappedSize = size % pageSize == 0 ? size + pageSize : size;
+			 void* data = MAP_FAILED;
+			 if(mappedSize != size) {
+				 void* zeros = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+				 if(zeros != MAP_FAILED) {
+					 data = mmap(zeros, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0);
+					 if(data == MAP_FAILED)
+						 munmap(zeros, mappedSize);
+				 }
+			 } else {
+				 data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			 }
+			 if(data != MAP_FAILED) {
+				 madvise(data, size, MADV_SEQUENTIAL);
+				 _data = static_cast<const char*>(data);
+				 _size = size;
+				 _mappedSize = mappedSize;
+			 }
+		 }
+		 close(fd);
+#endif
+	 }
+
+	 MappedFile::~MappedFile() {
+		 if(!_data)
+			 return;
+		 if(_mappedSize == 0) {
+			 delete[] _data;
+			 return;
+		 }
+#ifdef _WIN32
+		 UnmapViewOfFile(_data);
+#else
+		 munmap(const_cast<char*>(_data), _mappedSize);
 #endif
 	 }
 }
\ No newline at end of file
@@ -61,4 +61,20 @@ namespace lxd {
 		Handle _handle{};
 		long long _size{};
 	};
+
+	// 只读映射整个文件, 打开或映射失败以及空文件时 data() 为 nullptr
+	// data() 之后总有一个 0 字节, 内容可以直接交给要求以 0 结尾的解析器
+	class DLL_PUBLIC MappedFile {
+	public:
+		explicit MappedFile(const Char* path);
+		~MappedFile();
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		const char* data() const { return _data; }
+		size_t size() const { return _size; }
+	private:
+		const char* _data{};
+		size_t _size{};
+		size_t _mappedSize{}; // 为 0 时内容读入了 new[] 分配的缓冲区
+	};
 }
\ No newline at end of file
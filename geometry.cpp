@@ -0,0 +1,450 @@
+#include "geometry.h"
+#include "utils.h"
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <variant>
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LXD_GEOMETRY_AVX2
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// AVX2 的核以 target 属性编译, 在运行时按 CPU 选择, 与 json.h 的 SIMD 扫描相同
+// flatten 把模板和辅助函数内联进 AVX2 的核, 默认目标编译的函数不能内联 AVX2 函数
+#if defined(_MSC_VER) && !defined(__clang__)
+#define LXD_TARGET_AVX2
+#else
+#define LXD_TARGET_AVX2 __attribute__((target("avx2"), flatten))
+#endif
+
+namespace lxd {
+	namespace {
+		constexpr size_t kGrain = 1 << 12;
+
+		// 把已排序的 (v << 32 | w) 键转成 CSR, offsets[v] 为第一个起点 >= v 的键位置
+		void BuildCsr(const std::vector<uint64_t>& keys, uint32_t nVertex, std::vector<uint32_t>& offsets, std::vector<uint32_t>& values) {
+			offsets.resize(size_t(nVertex) + 1);
+			values.resize(keys.size());
+			ParallelFor(size_t(nVertex) + 1, kGrain, [&](size_t begin, size_t end) {
+				for(size_t v = begin; v < end; v++)
+					offsets[v] = static_cast<uint32_t>(std::lower_bound(keys.begin(), keys.end(), uint64_t(v) << 32) - keys.begin());
+			});
+			ParallelFor(keys.size(), kGrain, [&](size_t begin, size_t end) {
+				for(size_t i = begin; i < end; i++)
+					values[i] = static_cast<uint32_t>(keys[i]);
+			});
+		}
+
+		template <typename T>
+		bool BuildAdjacency(MeshAdjacency& adjacency, std::span<const T> indices, uint32_t nVertex) {
+			if(indices.size() % 3 != 0 || indices.size() >= UINT32_MAX)
+				return false;
+			if(std::any_of(indices.begin(), indices.end(), [&](T i) { return i >= nVertex; }))
+				return false;
+			adjacency.faces.assign(indices.begin(), indices.end());
+			const size_t nFace = indices.size() / 3;
+			// 每条边正反两个方向各一个键, 排序去重后即为一环邻点
+			std::vector<uint64_t> keys(6 * nFace);
+			ParallelFor(nFace, kGrain, [&](size_t begin, size_t end) {
+				for(size_t f = begin; f < end; f++) {
+					for(size_t k = 0; k < 3; k++) {
+						const uint64_t a = indices[3 * f + k];
+						const uint64_t b = indices[3 * f + (k + 1) % 3];
+						keys[6 * f + 2 * k] = a << 32 | b;
+						keys[6 * f + 2 * k + 1] = b << 32 | a;
+					}
+				}
+			});
+			ParallelSort(keys.begin(), keys.end());
+			keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+			BuildCsr(keys, nVertex, adjacency.vertexOffsets, adjacency.vertexNeighbors);
+			// 顶点-面
+			keys.resize(3 * nFace);
+			ParallelFor(nFace, kGrain, [&](size_t begin, size_t end) {
+				for(size_t f = begin; f < end; f++) {
+					for(size_t k = 0; k < 3; k++)
+						keys[3 * f + k] = uint64_t(indices[3 * f + k]) << 32 | f;
+				}
+			});
+			ParallelSort(keys.begin(), keys.end());
+			BuildCsr(keys, nVertex, adjacency.faceOffsets, adjacency.vertexFaces);
+			return true;
+		}
+
+		// 运行时检测一次, 以 -mavx2 编译时总是使用 AVX2
+		bool HasAvx2() {
+#if defined(__AVX2__)
+			return true;
+#elif !defined(LXD_GEOMETRY_AVX2)
+			return false;
+#elif defined(_MSC_VER)
+			// 需要 CPUID.7.0:EBX 第 5 位, 以及保存 YMM 寄存器的操作系统(OSXSAVE, AVX 与 XCR0 的 SSE/AVX 位)
+			static const bool hasAvx2 = [] {
+				int info[4];
+				__cpuid(info, 0);
+				if(info[0] < 7)
+					return false;
+				__cpuid(info, 1);
+				const int osxsaveAvx = (1 << 27) | (1 << 28);
+				if((info[2] & osxsaveAvx) != osxsaveAvx || (_xgetbv(0) & 6) != 6)
+					return false;
+				__cpuidex(info, 7, 0);
+				return (info[1] & (1 << 5)) != 0;
+			}();
+			return hasAvx2;
+#else
+			static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+			return hasAvx2;
+#endif
+		}
+
+		// 求 idx[0, n) 对应坐标之和
+		inline void Gather3(const float* x, const float* y, const float* z, const uint32_t* idx, uint32_t n, float& sx, float& sy, float& sz) {
+			sx = sy = sz = 0.0f;
+			for(uint32_t j = 0; j < n; j++) {
+				sx += x[idx[j]];
+				sy += y[idx[j]];
+				sz += z[idx[j]];
+			}
+		}
+
+#if defined(LXD_GEOMETRY_AVX2)
+		LXD_TARGET_AVX2 inline float HorizontalSum(__m256 v) {
+			__m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+			s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+			s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+			return _mm_cvtss_f32(s);
+		}
+
+		LXD_TARGET_AVX2 inline void Gather3Avx2(const float* x, const float* y, const float* z, const uint32_t* idx, uint32_t n, float& sx, float& sy, float& sz) {
+			__m256 vx = _mm256_setzero_ps(), vy = _mm256_setzero_ps(), vz = _mm256_setzero_ps();
+			uint32_t j = 0;
+			for(; j + 8 <= n; j += 8) {
+				const __m256i vi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(idx + j));
+				vx = _mm256_add_ps(vx, _mm256_i32gather_ps(x, vi, 4));
+				vy = _mm256_add_ps(vy, _mm256_i32gather_ps(y, vi, 4));
+				vz = _mm256_add_ps(vz, _mm256_i32gather_ps(z, vi, 4));
+			}
+			if(j < n) {
+				const __m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(n - j)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+				const __m256i vi = _mm256_maskload_epi32(reinterpret_cast<const int*>(idx + j), mask);
+				const __m256 fmask = _mm256_castsi256_ps(mask);
+				vx = _mm256_add_ps(vx, _mm256_mask_i32gather_ps(_mm256_setzero_ps(), x, vi, fmask, 4));
+				vy = _mm256_add_ps(vy, _mm256_mask_i32gather_ps(_mm256_setzero_ps(), y, vi, fmask, 4));
+				vz = _mm256_add_ps(vz, _mm256_mask_i32gather_ps(_mm256_setzero_ps(), z, vi, fmask, 4));
+			}
+			sx = HorizontalSum(vx);
+			sy = HorizontalSum(vy);
+			sz = HorizontalSum(vz);
+		}
+
+		// 以下的 AVX2 核处理 8 的整数倍个元素, 返回剩余部分的起点
+		LXD_TARGET_AVX2 size_t BlendAvx2(float* p, const float* c, float w, size_t begin, size_t end) {
+			size_t i = begin;
+			const __m256 vw = _mm256_set1_ps(w);
+			for(; i + 8 <= end; i += 8) {
+				const __m256 vp = _mm256_loadu_ps(p + i);
+				const __m256 vc = _mm256_loadu_ps(c + i);
+				_mm256_storeu_ps(p + i, _mm256_add_ps(vp, _mm256_mul_ps(vw, _mm256_sub_ps(vc, vp))));
+			}
+			return i;
+		}
+
+		LXD_TARGET_AVX2 size_t NormalizeAvx2(float* x, float* y, float* z, size_t begin, size_t end) {
+			size_t i = begin;
+			const __m256 eps = _mm256_set1_ps(1.0e-30f);
+			for(; i + 8 <= end; i += 8) {
+				const __m256 vx = _mm256_loadu_ps(x + i);
+				const __m256 vy = _mm256_loadu_ps(y + i);
+				const __m256 vz = _mm256_loadu_ps(z + i);
+				const __m256 len2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy)), _mm256_mul_ps(vz, vz));
+				const __m256 valid = _mm256_cmp_ps(len2, eps, _CMP_GT_OQ);
+				const __m256 inv = _mm256_and_ps(valid, _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(_mm256_max_ps(len2, eps))));
+				_mm256_storeu_ps(x + i, _mm256_mul_ps(vx, inv));
+				_mm256_storeu_ps(y + i, _mm256_mul_ps(vy, inv));
+				_mm256_storeu_ps(z + i, _mm256_mul_ps(vz, inv));
+			}
+			return i;
+		}
+
+		// 一次处理 8 个面: 按步长 3 收集顶点索引, 再收集坐标
+		LXD_TARGET_AVX2 size_t FaceNormalsAvx2(const float* px, const float* py, const float* pz, const uint32_t* faces, PositionsSoA& normals, size_t begin, size_t end) {
+			size_t f = begin;
+			const __m256i stride = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+			for(; f + 8 <= end; f += 8) {
+				const int* base = reinterpret_cast<const int*>(faces + 3 * f);
+				const __m256i i0 = _mm256_i32gather_epi32(base, stride, 4);
+				const __m256i i1 = _mm256_i32gather_epi32(base + 1, stride, 4);
+				const __m256i i2 = _mm256_i32gather_epi32(base + 2, stride, 4);
+				const __m256 x0 = _mm256_i32gather_ps(px, i0, 4), y0 = _mm256_i32gather_ps(py, i0, 4), z0 = _mm256_i32gather_ps(pz, i0, 4);
+				const __m256 ax = _mm256_sub_ps(_mm256_i32gather_ps(px, i1, 4), x0);
+				const __m256 ay = _mm256_sub_ps(_mm256_i32gather_ps(py, i1, 4), y0);
+				const __m256 az = _mm256_sub_ps(_mm256_i32gather_ps(pz, i1, 4), z0);
+				const __m256 bx = _mm256_sub_ps(_mm256_i32gather_ps(px, i2, 4), x0);
+				const __m256 by = _mm256_sub_ps(_mm256_i32gather_ps(py, i2, 4), y0);
+				const __m256 bz = _mm256_sub_ps(_mm256_i32gather_ps(pz, i2, 4), z0);
+				_mm256_storeu_ps(&normals.x[f], _mm256_sub_ps(_mm256_mul_ps(ay, bz), _mm256_mul_ps(az, by)));
+				_mm256_storeu_ps(&normals.y[f], _mm256_sub_ps(_mm256_mul_ps(az, bx), _mm256_mul_ps(ax, bz)));
+				_mm256_storeu_ps(&normals.z[f], _mm256_sub_ps(_mm256_mul_ps(ax, by), _mm256_mul_ps(ay, bx)));
+			}
+			return f;
+		}
+#endif
+
+		// p[i] += w * (c[i] - p[i]), 连续数组上的逐元素运算
+		inline void Blend(float* p, const float* c, float w, size_t begin, size_t end, [[maybe_unused]] bool avx2) {
+			size_t i = begin;
+#if defined(LXD_GEOMETRY_AVX2)
+			if(avx2)
+				i = BlendAvx2(p, c, w, begin, end);
+#endif
+			for(; i < end; i++)
+				p[i] += w * (c[i] - p[i]);
+		}
+
+		// 归一化 (x, y, z)[begin, end), 零向量保持为零
+		inline void Normalize(float* x, float* y, float* z, size_t begin, size_t end, [[maybe_unused]] bool avx2) {
+			size_t i = begin;
+#if defined(LXD_GEOMETRY_AVX2)
+			if(avx2)
+				i = NormalizeAvx2(x, y, z, begin, end);
+#endif
+			for(; i < end; i++) {
+				const float len2 = x[i] * x[i] + y[i] * y[i] + z[i] * z[i];
+				const float inv = len2 > 1.0e-30f ? 1.0f / std::sqrt(len2) : 0.0f;
+				x[i] *= inv;
+				y[i] *= inv;
+				z[i] *= inv;
+			}
+		}
+
+		// 邻点质心, 孤立顶点与固定的边界顶点取自身
+		template <bool Avx2>
+		void Centroids(const PositionsSoA& positions, PositionsSoA& centroids, const MeshAdjacency& adjacency, bool fixBoundary, size_t begin, size_t end) {
+			for(size_t v = begin; v < end; v++) {
+				const uint32_t offset = adjacency.vertexOffsets[v];
+				const uint32_t n = adjacency.vertexOffsets[v + 1] - offset;
+				if(n == 0 || (fixBoundary && adjacency.isBoundaryVertex(static_cast<uint32_t>(v)))) {
+					centroids.x[v] = positions.x[v];
+					centroids.y[v] = positions.y[v];
+					centroids.z[v] = positions.z[v];
+					continue;
+				}
+				float sx, sy, sz;
+#if defined(LXD_GEOMETRY_AVX2)
+				if constexpr(Avx2)
+					Gather3Avx2(positions.x.data(), positions.y.data(), positions.z.data(), &adjacency.vertexNeighbors[offset], n, sx, sy, sz);
+				else
+#endif
+					Gather3(positions.x.data(), positions.y.data(), positions.z.data(), &adjacency.vertexNeighbors[offset], n, sx, sy, sz);
+				const float inv = 1.0f / static_cast<float>(n);
+				centroids.x[v] = sx * inv;
+				centroids.y[v] = sy * inv;
+				centroids.z[v] = sz * inv;
+			}
+		}
+
+		// 面积加权的顶点法向, 即相邻面的未归一化法向之和
+		template <bool Avx2>
+		void SumFaceNormals(const PositionsSoA& faceNormals, const MeshAdjacency& adjacency, PositionsSoA& normals, size_t begin, size_t end) {
+			for(size_t v = begin; v < end; v++) {
+				const uint32_t offset = adjacency.faceOffsets[v];
+				const uint32_t n = adjacency.faceOffsets[v + 1] - offset;
+#if defined(LXD_GEOMETRY_AVX2)
+				if constexpr(Avx2)
+					Gather3Avx2(faceNormals.x.data(), faceNormals.y.data(), faceNormals.z.data(), &adjacency.vertexFaces[offset], n, normals.x[v], normals.y[v], normals.z[v]);
+				else
+#endif
+					Gather3(faceNormals.x.data(), faceNormals.y.data(), faceNormals.z.data(), &adjacency.vertexFaces[offset], n, normals.x[v], normals.y[v], normals.z[v]);
+			}
+		}
+
+#if defined(LXD_GEOMETRY_AVX2)
+		LXD_TARGET_AVX2 void CentroidsAvx2(const PositionsSoA& positions, PositionsSoA& centroids, const MeshAdjacency& adjacency, bool fixBoundary, size_t begin, size_t end) {
+			Centroids<true>(positions, centroids, adjacency, fixBoundary, begin, end);
+		}
+
+		LXD_TARGET_AVX2 void SumFaceNormalsAvx2(const PositionsSoA& faceNormals, const MeshAdjacency& adjacency, PositionsSoA& normals, size_t begin, size_t end) {
+			SumFaceNormals<true>(faceNormals, adjacency, normals, begin, end);
+		}
+#endif
+
+		void SmoothStep(PositionsSoA& positions, PositionsSoA& centroids, const MeshAdjacency& adjacency, float w, bool fixBoundary) {
+			const size_t nVertex = positions.size();
+			const bool avx2 = HasAvx2();
+			ParallelFor(nVertex, kGrain, [&](size_t begin, size_t end) {
+#if defined(LXD_GEOMETRY_AVX2)
+				if(avx2) {
+					CentroidsAvx2(positions, centroids, adjacency, fixBoundary, begin, end);
+					return;
+				}
+#endif
+				Centroids<false>(positions, centroids, adjacency, fixBoundary, begin, end);
+			});
+			ParallelFor(nVertex, kGrain, [&](size_t begin, size_t end) {
+				Blend(positions.x.data(), centroids.x.data(), w, begin, end, avx2);
+				Blend(positions.y.data(), centroids.y.data(), w, begin, end, avx2);
+				Blend(positions.z.data(), centroids.z.data(), w, begin, end, avx2);
+			});
+		}
+	}
+
+	void PositionsSoA::resize(size_t n) {
+		x.resize(n);
+		y.resize(n);
+		z.resize(n);
+	}
+
+	void PositionsSoA::load(std::span<const MyVec3f> positions) {
+		resize(positions.size());
+		ParallelFor(positions.size(), kGrain, [&](size_t begin, size_t end) {
+			for(size_t i = begin; i < end; i++) {
+				x[i] = positions[i].v[0];
+				y[i] = positions[i].v[1];
+				z[i] = positions[i].v[2];
+			}
+		});
+	}
+
+	void PositionsSoA::store(std::span<MyVec3f> positions) const {
+		const size_t n = std::min(size(), positions.size());
+		ParallelFor(n, kGrain, [&](size_t begin, size_t end) {
+			for(size_t i = begin; i < end; i++)
+				positions[i] = {x[i], y[i], z[i]};
+		});
+	}
+
+	bool MeshAdjacency::build(std::span<const uint16_t> indices, uint32_t nVertex) {
+		return BuildAdjacency(*this, indices, nVertex);
+	}
+
+	bool MeshAdjacency::build(std::span<const uint32_t> indices, uint32_t nVertex) {
+		return BuildAdjacency(*this, indices, nVertex);
+	}
+
+	bool MeshAdjacency::build(Glb& glb) {
+		const auto nVertex = static_cast<uint32_t>(glb.getPositions().size());
+		return std::visit([&](auto indices) {
+			return BuildAdjacency(*this, std::span<const typename decltype(indices)::value_type>(indices), nVertex);
+		}, glb.getIndices());
+	}
+
+	void LaplacianSmooth(PositionsSoA& positions, const MeshAdjacency& adjacency, float lambda, int iterations, bool fixBoundary) {
+		PositionsSoA centroids;
+		centroids.resize(positions.size());
+		for(int i = 0; i < iterations; i++)
+			SmoothStep(positions, centroids, adjacency, lambda, fixBoundary);
+	}
+
+	void TaubinSmooth(PositionsSoA& positions, const MeshAdjacency& adjacency, float lambda, float mu, int iterations, bool fixBoundary) {
+		PositionsSoA centroids;
+		centroids.resize(positions.size());
+		for(int i = 0; i < iterations; i++) {
+			SmoothStep(positions, centroids, adjacency, lambda, fixBoundary);
+			SmoothStep(positions, centroids, adjacency, mu, fixBoundary);
+		}
+	}
+
+	void ComputeFaceNormals(const PositionsSoA& positions, std::span<const uint32_t> faces, PositionsSoA& normals, bool normalize) {
+		const size_t nFace = faces.size() / 3;
+		normals.resize(nFace);
+		const float* px = positions.x.data();
+		const float* py = positions.y.data();
+		const float* pz = positions.z.data();
+		const bool avx2 = HasAvx2();
+		ParallelFor(nFace, kGrain, [&](size_t begin, size_t end) {
+			size_t f = begin;
+#if defined(LXD_GEOMETRY_AVX2)
+			if(avx2)
+				f = FaceNormalsAvx2(px, py, pz, faces.data(), normals, begin, end);
+#endif
+			for(; f < end; f++) {
+				const uint32_t i0 = faces[3 * f], i1 = faces[3 * f + 1], i2 = faces[3 * f + 2];
+				const float ax = px[i1] - px[i0], ay = py[i1] - py[i0], az = pz[i1] - pz[i0];
+				const float bx = px[i2] - px[i0], by = py[i2] - py[i0], bz = pz[i2] - pz[i0];
+				normals.x[f] = ay * bz - az * by;
+				normals.y[f] = az * bx - ax * bz;
+				normals.z[f] = ax * by - ay * bx;
+			}
+			if(normalize)
+				Normalize(normals.x.data(), normals.y.data(), normals.z.data(), begin, end, avx2);
+		});
+	}
+
+	void ComputeVertexNormals(const PositionsSoA& positions, const MeshAdjacency& adjacency, PositionsSoA& normals) {
+		PositionsSoA faceNormals;
+		ComputeFaceNormals(positions, adjacency.faces, faceNormals, false);
+		const uint32_t nVertex = adjacency.vertexCount();
+		normals.resize(nVertex);
+		const bool avx2 = HasAvx2();
+		ParallelFor(nVertex, kGrain, [&](size_t begin, size_t end) {
+#if defined(LXD_GEOMETRY_AVX2)
+			if(avx2)
+				SumFaceNormalsAvx2(faceNormals, adjacency, normals, begin, end);
+			else
+#endif
+				SumFaceNormals<false>(faceNormals, adjacency, normals, begin, end);
+			Normalize(normals.x.data(), normals.y.data(), normals.z.data(), begin, end, avx2);
+		});
+	}
+
+	void ComputeCurvature(const PositionsSoA& positions, const MeshAdjacency& adjacency, std::vector<float>& mean, std::vector<float>& gaussian) {
+		PositionsSoA normals;
+		ComputeVertexNormals(positions, adjacency, normals);
+		const uint32_t nVertex = adjacency.vertexCount();
+		mean.assign(nVertex, 0.0f);
+		gaussian.assign(nVertex, 0.0f);
+		const float* px = positions.x.data();
+		const float* py = positions.y.data();
+		const float* pz = positions.z.data();
+		ParallelFor(nVertex, kGrain, [&](size_t begin, size_t end) {
+			for(size_t v = begin; v < end; v++) {
+				double area = 0.0, angle = 0.0;
+				double kx = 0.0, ky = 0.0, kz = 0.0;
+				for(uint32_t j = adjacency.faceOffsets[v]; j < adjacency.faceOffsets[v + 1]; j++) {
+					const uint32_t* face = &adjacency.faces[3 * adjacency.vertexFaces[j]];
+					// 旋转成 (v, a, b) 的顺序
+					const int k = face[0] == v ? 0 : (face[1] == v ? 1 : 2);
+					const uint32_t a = face[(k + 1) % 3], b = face[(k + 2) % 3];
+					const double ax = px[a] - px[v], ay = py[a] - py[v], az = pz[a] - pz[v];
+					const double bx = px[b] - px[v], by = py[b] - py[v], bz = pz[b] - pz[v];
+					const double cx = ay * bz - az * by, cy = az * bx - ax * bz, cz = ax * by - ay * bx;
+					const double cross = std::sqrt(cx * cx + cy * cy + cz * cz);
+					if(cross <= 0.0)
+						continue;
+					const double ab = ax * bx + ay * by + az * bz;
+					// a 处的角对着边 v-b, b 处的角对着边 v-a
+					const double cotA = ((-ax) * (bx - ax) + (-ay) * (by - ay) + (-az) * (bz - az)) / cross;
+					const double cotB = ((-bx) * (ax - bx) + (-by) * (ay - by) + (-bz) * (az - bz)) / cross;
+					kx -= cotB * ax + cotA * bx;
+					ky -= cotB * ay + cotA * by;
+					kz -= cotB * az + cotA * bz;
+					angle += std::atan2(cross, ab);
+					area += cross / 6.0;
+				}
+				if(area <= 0.0)
+					continue;
+				const double h = std::sqrt(kx * kx + ky * ky + kz * kz) / (4.0 * area);
+				const bool convex = kx * normals.x[v] + ky * normals.y[v] + kz * normals.z[v] >= 0.0;
+				mean[v] = static_cast<float>(convex ? h : -h);
+				const double full = adjacency.isBoundaryVertex(static_cast<uint32_t>(v)) ? std::numbers::pi : 2.0 * std::numbers::pi;
+				gaussian[v] = static_cast<float>((full - angle) / area);
+			}
+		});
+	}
+
+	bool TaubinSmooth(Glb& glb, float lambda, float mu, int iterations, bool fixBoundary) {
+		MeshAdjacency adjacency;
+		if(!adjacency.build(glb))
+			return false;
+		auto points = glb.getPositions();
+		PositionsSoA positions;
+		positions.load(points);
+		TaubinSmooth(positions, adjacency, lambda, mu, iterations, fixBoundary);
+		positions.store(points);
+		return true;
+	}
+}
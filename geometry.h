@@ -0,0 +1,60 @@
+#pragma once
+
+#include "defines.h"
+#include "glb.h"
+#include <cstdint>
+#include <vector>
+#include <span>
+
+namespace lxd {
+	/// <summary>
+	/// 顶点坐标的 SoA(structure-of-arrays) 视图, x/y/z 各自连续存放, 以便内层循环向量化
+	/// 也用于存放法向等逐顶点/逐面的三维量
+	/// </summary>
+	struct DLL_PUBLIC PositionsSoA {
+		std::vector<float> x, y, z;
+
+		size_t size() const { return x.size(); }
+		void resize(size_t n);
+		void load(std::span<const MyVec3f> positions);
+		void store(std::span<MyVec3f> positions) const;
+	};
+
+	/// <summary>
+	/// 由三角形索引构建的 CSR 邻接表:
+	/// 顶点 v 的一环邻点为 vertexNeighbors[vertexOffsets[v], vertexOffsets[v + 1])
+	/// 顶点 v 的相邻面为 vertexFaces[faceOffsets[v], faceOffsets[v + 1])
+	/// </summary>
+	struct DLL_PUBLIC MeshAdjacency {
+		std::vector<uint32_t> faces; // 三角形索引, 每 3 个一组
+		std::vector<uint32_t> vertexOffsets;
+		std::vector<uint32_t> vertexNeighbors;
+		std::vector<uint32_t> faceOffsets;
+		std::vector<uint32_t> vertexFaces;
+
+		bool build(std::span<const uint16_t> indices, uint32_t nVertex);
+		bool build(std::span<const uint32_t> indices, uint32_t nVertex);
+		bool build(Glb& glb);
+		uint32_t vertexCount() const { return vertexOffsets.empty() ? 0 : static_cast<uint32_t>(vertexOffsets.size() - 1); }
+		uint32_t faceCount() const { return static_cast<uint32_t>(faces.size() / 3); }
+		// 流形网格上, 内部顶点的邻点数等于相邻面数, 边界顶点多一个
+		bool isBoundaryVertex(uint32_t v) const {
+			return vertexOffsets[v + 1] - vertexOffsets[v] != faceOffsets[v + 1] - faceOffsets[v];
+		}
+	};
+
+	// Laplacian 平滑, 每次迭代 p += lambda * (邻点质心 - p), fixBoundary 时边界顶点不动
+	DLL_PUBLIC void LaplacianSmooth(PositionsSoA& positions, const MeshAdjacency& adjacency, float lambda, int iterations = 1, bool fixBoundary = true);
+	// Taubin λ|μ 平滑, 交替使用正负步长以避免收缩, 要求 mu < -lambda
+	DLL_PUBLIC void TaubinSmooth(PositionsSoA& positions, const MeshAdjacency& adjacency, float lambda = 0.5f, float mu = -0.53f, int iterations = 10, bool fixBoundary = true);
+	// 面法向, normalize 为 false 时长度为三角形面积的 2 倍
+	DLL_PUBLIC void ComputeFaceNormals(const PositionsSoA& positions, std::span<const uint32_t> faces, PositionsSoA& normals, bool normalize = true);
+	// 面积加权的单位顶点法向
+	DLL_PUBLIC void ComputeVertexNormals(const PositionsSoA& positions, const MeshAdjacency& adjacency, PositionsSoA& normals);
+	// 离散平均曲率(余切公式, 沿顶点法向为正)与高斯曲率(角亏), 面积取相邻面积的 1/3
+	DLL_PUBLIC void ComputeCurvature(const PositionsSoA& positions, const MeshAdjacency& adjacency, std::vector<float>& mean, std::vector<float>& gaussian);
+
+	// 直接对 Glb 的顶点做 Taubin 平滑并写回
+	// 法向与曲率只有上面的 PositionsSoA 版本: Glb 只有索引, POSITION 与 _EXTRAATTR 三个 accessor, 不能写入 NORMAL 等属性
+	DLL_PUBLIC bool TaubinSmooth(Glb& glb, float lambda = 0.5f, float mu = -0.53f, int iterations = 10, bool fixBoundary = true);
+}
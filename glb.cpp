@@ -1,9 +1,28 @@
 ﻿#include "glb.h"
 #include <cassert>
+#include <climits>
+#include <cstring>
 #include "json.h"
+#include "jsonbind.h"
 #include <unordered_map>
+#include <utility>
 #include "debug.h"
 #include "fileio.h"
+#include "utils.h"
+
+template <>
+struct lxd::JsonBinding<lxd::Glb::Accessor> {
+	using T = lxd::Glb::Accessor;
+	static constexpr auto fields = std::make_tuple(JsonField("bufferView", &T::bufferView), JsonField("byteOffset", &T::byteOffset),
+		JsonField("componentType", &T::componentType), JsonField("count", &T::count), JsonField("type", &T::type));
+};
+
+template <>
+struct lxd::JsonBinding<lxd::Glb::BufferView> {
+	using T = lxd::Glb::BufferView;
+	static constexpr auto fields = std::make_tuple(JsonField("buffer", &T::buffer), JsonField("byteOffset", &T::byteOffset),
+		JsonField("byteLength", &T::byteLength), JsonField("byteStride", &T::byteStride), JsonField("target", &T::target));
+};
 
 namespace std {
 	template<>
@@ -110,13 +129,7 @@ namespace lxd {
 			BufferView bufferView{.buffer = 0, .byteOffset = 0, .byteLength = static_cast<int>(chunk.data.size()), .target = 34963};
 			m_bufferViews.push_back(bufferView);
 			// 每个 Chunk 长度需要是 4 的倍数, 此 chunk = indices + positions, postions 永远是 4 的倍数，因此只需要处理 ushort index 这种情况
-			auto curSize = chunk.data.size();
-			if(curSize % 4 != 0) {
-				size_t extra = 4 - curSize % 4;
-				for(size_t i = 0; i < extra; i++) {
-					chunk.data.push_back(0x00);
-				}
-			}
+			chunk.data.resize((chunk.data.size() + 3) & ~size_t(3), 0);
 		}
 		{
 			BufferView bufferView{.buffer = 0, .byteOffset = static_cast<int>(chunk.data.size()), .target = 34962};
@@ -125,92 +138,13 @@ namespace lxd {
 			bufferView.byteLength = static_cast<int>(chunk.data.size() - bufferView.byteOffset);
 			m_bufferViews.push_back(bufferView);
 		}
-		// JSON
-		char* json = NULL;
-		int length = 0;
-		{
-			// asset
-			ksJson* rootNode = ksJson_SetObject(ksJson_Create());
-			ksJson* asset = ksJson_SetObject(ksJson_AddObjectMember(rootNode, "asset"));
-			ksJson_SetString(ksJson_AddObjectMember(asset, "version"), "2.0");
-			// buffers
-			{
-				ksJson* buffers = ksJson_SetArray(ksJson_AddObjectMember(rootNode, "buffers"));
-				ksJson* idxBuffer = ksJson_SetObject(ksJson_AddArrayElement(buffers));
-				ksJson_SetUint64(ksJson_AddObjectMember(idxBuffer, "byteLength"), chunk.data.size());
-			}
-			// buffer views
-			ksJson* bufferViews = ksJson_SetArray(ksJson_AddObjectMember(rootNode, "bufferViews"));
-			for(auto& bufferView : m_bufferViews) {
-				ksJson* pBufferView = ksJson_SetObject(ksJson_AddArrayElement(bufferViews));
-				ksJson_SetUint32(ksJson_AddObjectMember(pBufferView, "buffer"), bufferView.buffer);
-				ksJson_SetUint32(ksJson_AddObjectMember(pBufferView, "byteOffset"), bufferView.byteOffset); // buffer 内的偏移
-				ksJson_SetUint64(ksJson_AddObjectMember(pBufferView, "byteLength"), bufferView.byteLength);
-				ksJson_SetUint32(ksJson_AddObjectMember(pBufferView, "target"), bufferView.target);
-			}
-			// accessors
-			{
-				size_t idxSize, idxCnt;
-				std::visit([&](auto& indices) {
-					idxSize = sizeof(indices[0]);
-					idxCnt = indices.size();
-				}, indicesVar);
-				ksJson* accessors = ksJson_SetArray(ksJson_AddObjectMember(rootNode, "accessors"));
-				ksJson* idxAccessor = ksJson_SetObject(ksJson_AddArrayElement(accessors));
-				ksJson_SetUint32(ksJson_AddObjectMember(idxAccessor, "bufferView"), 0);
-				ksJson_SetUint32(ksJson_AddObjectMember(idxAccessor, "byteOffset"), 0); // bufferView 内的偏移
-				ksJson_SetUint32(ksJson_AddObjectMember(idxAccessor, "componentType"), idxSize == 2 ? 5123 : 5125); // unsigned short
-				ksJson_SetUint64(ksJson_AddObjectMember(idxAccessor, "count"), idxCnt);
-				ksJson_SetString(ksJson_AddObjectMember(idxAccessor, "type"), "SCALAR");
-				ksJson* posAccessor = ksJson_SetObject(ksJson_AddArrayElement(accessors));
-				ksJson_SetUint32(ksJson_AddObjectMember(posAccessor, "bufferView"), 1);
-				ksJson_SetUint32(ksJson_AddObjectMember(posAccessor, "byteOffset"), 0);
-				ksJson_SetUint32(ksJson_AddObjectMember(posAccessor, "componentType"), 5126);// float
-				ksJson_SetUint64(ksJson_AddObjectMember(posAccessor, "count"), points.size());
-				ksJson_SetString(ksJson_AddObjectMember(posAccessor, "type"), "VEC3");
-			}
-			// meshes
-			{
-				ksJson* meshes = ksJson_SetArray(ksJson_AddObjectMember(rootNode, "meshes"));
-				ksJson* mesh0 = ksJson_SetObject(ksJson_AddArrayElement(meshes));
-				ksJson* primitives = ksJson_SetArray(ksJson_AddObjectMember(mesh0, "primitives"));
-				ksJson* primitive0 = ksJson_SetObject(ksJson_AddArrayElement(primitives));
-				ksJson* attributes = ksJson_SetObject(ksJson_AddObjectMember(primitive0, "attributes"));
-				ksJson_SetUint32(ksJson_AddObjectMember(primitive0, "indices"), 0); // accessor 0
-				ksJson_SetUint32(ksJson_AddObjectMember(attributes, "POSITION"), 1); // accessor 1
-			}
-			// nodes
-			{
-				ksJson* nodes = ksJson_SetArray(ksJson_AddObjectMember(rootNode, "nodes"));
-				ksJson* node0 = ksJson_SetObject(ksJson_AddArrayElement(nodes));
-				ksJson_SetUint32(ksJson_AddObjectMember(node0, "mesh"), 0);
-			}
-			// scene
-			{
-				ksJson_SetUint32(ksJson_AddObjectMember(rootNode, "scene"), 0);
-				ksJson* scenes = ksJson_SetArray(ksJson_AddObjectMember(rootNode, "scenes"));
-				ksJson* scene0 = ksJson_SetObject(ksJson_AddArrayElement(scenes));
-				ksJson* nodes = ksJson_SetArray(ksJson_AddObjectMember(scene0, "nodes"));
-				ksJson_SetUint32(ksJson_AddArrayElement(nodes), 0);
-			}
-			ksJson_WriteToBuffer(rootNode, &json, &length);
-			ksJson_Destroy(rootNode);
-		}
-		// JSON
-		Chunk jsonChunk;
-		jsonChunk.type = 0x4E4F534A; // JSON
-		{
-			jsonChunk.data.assign(json, json + length);
-			// 每个 Chunk 末尾需要 4 字节对齐
-			auto curSize = jsonChunk.data.size();
-			if(curSize % 4 != 0) {
-				auto extra = 4 - curSize % 4;
-				for(size_t n = 0; n < extra; n++) {
-					jsonChunk.data.push_back(' '); // JSON 利用空格字符对齐
-				}
-			}
-		}
-		free(json);
+		// Accessors
+		std::visit([&](auto& indices) {
+			const int componentType = sizeof(indices[0]) == 2 ? 5123 : 5125; // unsigned short / unsigned int
+			m_accessors.push_back({.bufferView = 0, .byteOffset = 0, .componentType = componentType, .count = static_cast<int>(indices.size()), .type = "SCALAR"});
+		}, indicesVar);
+		m_accessors.push_back({.bufferView = 1, .byteOffset = 0, .componentType = 5126, .count = static_cast<int>(points.size()), .type = "VEC3"}); // float
+		Chunk jsonChunk = makeJsonChunk(chunk.data.size());
 		m_chunks.emplace_back(std::move(jsonChunk));
 		m_chunks.emplace_back(std::move(chunk));
 		return true;
@@ -219,6 +153,7 @@ namespace lxd {
 	bool Glb::create(const std::vector<MyVec3f>& points, const std::vector<Face>& faces, const std::vector<char>& extraAttribute) {
 	    if (points.empty())
 			return false;
+		clear();
 
 		std::variant<std::vector<uint16_t>, std::vector<uint32_t>> indicesVar;// 索引
 	    size_t nFacet = faces.size();
@@ -250,13 +185,7 @@ namespace lxd {
 			BufferView bufferView{.buffer = 0, .byteOffset = 0, .byteLength = static_cast<int>(chunk.data.size()), .target = 34963};
 			m_bufferViews.push_back(bufferView);
 			// 每个 Chunk 长度需要是 4 的倍数, 此 chunk = indices + positions, postions 永远是 4 的倍数，因此只需要处理 ushort index 这种情况
-			auto curSize = chunk.data.size();
-			if(curSize % 4 != 0) {
-				size_t extra = 4 - curSize % 4;
-				for(size_t i = 0; i < extra; i++) {
-					chunk.data.push_back(0x00);
-				}
-			}
+			chunk.data.resize((chunk.data.size() + 3) & ~size_t(3), 0);
 		}
 		{ // Position
 			BufferView bufferView{.buffer = 0, .byteOffset = static_cast<int>(chunk.data.size()), .target = 34962};
@@ -271,112 +200,125 @@ namespace lxd {
 		    bufferView.byteLength = static_cast<int>(chunk.data.size() - bufferView.byteOffset);
 		    m_bufferViews.push_back(bufferView);
 		    // 每个 Chunk 长度需要是 4 的倍数, 此 chunk = indices + positions, postions 永远是 4 的倍数，因此只需要处理 char 这种情况
-		    auto curSize = chunk.data.size();
-		    if (curSize % 4 != 0) {
-			    size_t extra = 4 - curSize % 4;
-			    for (size_t i = 0; i < extra; i++) {
-				    chunk.data.push_back(0x00);
-			    }
-		    }
+		    chunk.data.resize((chunk.data.size() + 3) & ~size_t(3), 0);
 		}
-		// JSON
-		char* json = NULL;
-		int length = 0;
-		{
-			// asset
-			ksJson* rootNode = ksJson_SetObject(ksJson_Create());
-			ksJson* asset = ksJson_SetObject(ksJson_AddObjectMember(rootNode, "asset"));
-			ksJson_SetString(ksJson_AddObjectMember(asset, "version"), "2.0");
-			// buffers
-			{
-				ksJson* buffers = ksJson_SetArray(ksJson_AddObjectMember(rootNode, "buffers"));
-				ksJson* idxBuffer = ksJson_SetObject(ksJson_AddArrayElement(buffers));
-				ksJson_SetUint64(ksJson_AddObjectMember(idxBuffer, "byteLength"), chunk.data.size());
-			}
-			// buffer views
-			ksJson* bufferViews = ksJson_SetArray(ksJson_AddObjectMember(rootNode, "bufferViews"));
-			for(auto& bufferView : m_bufferViews) {
-				ksJson* pBufferView = ksJson_SetObject(ksJson_AddArrayElement(bufferViews));
-				ksJson_SetUint32(ksJson_AddObjectMember(pBufferView, "buffer"), bufferView.buffer);
-				ksJson_SetUint32(ksJson_AddObjectMember(pBufferView, "byteOffset"), bufferView.byteOffset); // buffer 内的偏移
-				ksJson_SetUint64(ksJson_AddObjectMember(pBufferView, "byteLength"), bufferView.byteLength);
-				ksJson_SetUint32(ksJson_AddObjectMember(pBufferView, "target"), bufferView.target);
-			}
-			// accessors
-			{
-				size_t idxSize, idxCnt;
-				std::visit([&](auto& indices) {
-					idxSize = sizeof(indices[0]);
-					idxCnt = indices.size();
-					}, indicesVar);
-				ksJson* accessors = ksJson_SetArray(ksJson_AddObjectMember(rootNode, "accessors"));
-				ksJson* idxAccessor = ksJson_SetObject(ksJson_AddArrayElement(accessors));
-				ksJson_SetUint32(ksJson_AddObjectMember(idxAccessor, "bufferView"), 0);
-				ksJson_SetUint32(ksJson_AddObjectMember(idxAccessor, "byteOffset"), 0); // bufferView 内的偏移
-				ksJson_SetUint32(ksJson_AddObjectMember(idxAccessor, "componentType"), idxSize == 2 ? 5123 : 5125); // unsigned short
-				ksJson_SetUint64(ksJson_AddObjectMember(idxAccessor, "count"), idxCnt);
-				ksJson_SetString(ksJson_AddObjectMember(idxAccessor, "type"), "SCALAR");
-				ksJson* posAccessor = ksJson_SetObject(ksJson_AddArrayElement(accessors));
-				ksJson_SetUint32(ksJson_AddObjectMember(posAccessor, "bufferView"), 1);
-				ksJson_SetUint32(ksJson_AddObjectMember(posAccessor, "byteOffset"), 0);
-				ksJson_SetUint32(ksJson_AddObjectMember(posAccessor, "componentType"), 5126);// float
-				ksJson_SetUint64(ksJson_AddObjectMember(posAccessor, "count"), points.size());
-				ksJson_SetString(ksJson_AddObjectMember(posAccessor, "type"), "VEC3");
-			    ksJson* extraAccessor = ksJson_SetObject(ksJson_AddArrayElement(accessors));
-			    ksJson_SetUint32(ksJson_AddObjectMember(extraAccessor, "bufferView"), 2);
-			    ksJson_SetUint32(ksJson_AddObjectMember(extraAccessor, "byteOffset"), 0); // bufferView 内的偏移
-			    ksJson_SetUint32(ksJson_AddObjectMember(extraAccessor, "componentType"), 5120); // char
-			    ksJson_SetUint64(ksJson_AddObjectMember(extraAccessor, "count"), extraAttribute.size());
-			    ksJson_SetString(ksJson_AddObjectMember(extraAccessor, "type"), "SCALAR");
-			}
-			// meshes
-			{
-				ksJson* meshes = ksJson_SetArray(ksJson_AddObjectMember(rootNode, "meshes"));
-				ksJson* mesh0 = ksJson_SetObject(ksJson_AddArrayElement(meshes));
-				ksJson* primitives = ksJson_SetArray(ksJson_AddObjectMember(mesh0, "primitives"));
-				ksJson* primitive0 = ksJson_SetObject(ksJson_AddArrayElement(primitives));
-				ksJson* attributes = ksJson_SetObject(ksJson_AddObjectMember(primitive0, "attributes"));
-				ksJson_SetUint32(ksJson_AddObjectMember(primitive0, "indices"), 0); // accessor 0
-				ksJson_SetUint32(ksJson_AddObjectMember(attributes, "POSITION"), 1); // accessor 1
-			    ksJson_SetUint32(ksJson_AddObjectMember(attributes, "_EXTRAATTR"), 2); // accessor 2, 自定义顶点属性
-			}
-			// nodes
-			{
-				ksJson* nodes = ksJson_SetArray(ksJson_AddObjectMember(rootNode, "nodes"));
-				ksJson* node0 = ksJson_SetObject(ksJson_AddArrayElement(nodes));
-				ksJson_SetUint32(ksJson_AddObjectMember(node0, "mesh"), 0);
-			}
-			// scene
-			{
-				ksJson_SetUint32(ksJson_AddObjectMember(rootNode, "scene"), 0);
-				ksJson* scenes = ksJson_SetArray(ksJson_AddObjectMember(rootNode, "scenes"));
-				ksJson* scene0 = ksJson_SetObject(ksJson_AddArrayElement(scenes));
-				ksJson* nodes = ksJson_SetArray(ksJson_AddObjectMember(scene0, "nodes"));
-				ksJson_SetUint32(ksJson_AddArrayElement(nodes), 0);
-			}
-			ksJson_WriteToBuffer(rootNode, &json, &length);
-			ksJson_Destroy(rootNode);
-		}
-		// JSON
-		Chunk jsonChunk;
-		jsonChunk.type = 0x4E4F534A; // JSON
-		{
-			jsonChunk.data.assign(json, json + length);
-			// 每个 Chunk 末尾需要 4 字节对齐
-			auto curSize = jsonChunk.data.size();
-			if(curSize % 4 != 0) {
-				auto extra = 4 - curSize % 4;
-				for(size_t n = 0; n < extra; n++) {
-					jsonChunk.data.push_back(' '); // JSON 利用空格字符对齐
-				}
-			}
-		}
-		free(json);
+		// Accessors
+		std::visit([&](auto& indices) {
+			const int componentType = sizeof(indices[0]) == 2 ? 5123 : 5125; // unsigned short / unsigned int
+			m_accessors.push_back({.bufferView = 0, .byteOffset = 0, .componentType = componentType, .count = static_cast<int>(indices.size()), .type = "SCALAR"});
+		}, indicesVar);
+		m_accessors.push_back({.bufferView = 1, .byteOffset = 0, .componentType = 5126, .count = static_cast<int>(points.size()), .type = "VEC3"}); // float
+		m_accessors.push_back({.bufferView = 2, .byteOffset = 0, .componentType = 5120, .count = static_cast<int>(extraAttribute.size()), .type = "SCALAR"}); // char
+		Chunk jsonChunk = makeJsonChunk(chunk.data.size());
 		m_chunks.emplace_back(std::move(jsonChunk));
 		m_chunks.emplace_back(std::move(chunk));
 		return true;
 	}
 
+	Glb::Chunk Glb::makeJsonChunk(size_t binaryLength) const {
+		Chunk jsonChunk;
+		jsonChunk.type = 0x4E4F534A; // JSON
+		// 不构建 DOM, 经栈上的缓冲直接写入 jsonChunk.data; 通常整个 JSON 都在缓冲内, 只分配一次
+		auto sink = [](void* context, const char* data, const size_t length) {
+			auto& out = *static_cast<std::vector<char>*>(context);
+			out.insert(out.end(), data, data + length);
+			return true;
+		};
+		char buffer[1024];
+		jsonChunk.data.reserve(sizeof(buffer));
+		ksJsonWriter writer;
+		ksJsonWriter_Init(&writer, buffer, sizeof(buffer), sink, &jsonChunk.data, JSON_WRITE_COMPACT);
+		auto writeUint = [&writer](const char* name, uint64_t value) {
+			ksJsonWriter_Key(&writer, name);
+			ksJsonWriter_Uint64(&writer, value);
+		};
+		auto writeString = [&writer](const char* name, const char* value) {
+			ksJsonWriter_Key(&writer, name);
+			ksJsonWriter_String(&writer, value);
+		};
+		ksJsonWriter_BeginObject(&writer);
+		// asset
+		ksJsonWriter_Key(&writer, "asset");
+		ksJsonWriter_BeginObject(&writer);
+		writeString("version", "2.0");
+		ksJsonWriter_EndObject(&writer);
+		// buffers
+		ksJsonWriter_Key(&writer, "buffers");
+		ksJsonWriter_BeginArray(&writer);
+		ksJsonWriter_BeginObject(&writer);
+		writeUint("byteLength", binaryLength);
+		ksJsonWriter_EndObject(&writer);
+		ksJsonWriter_EndArray(&writer);
+		// buffer views
+		ksJsonWriter_Key(&writer, "bufferViews");
+		ksJsonWriter_BeginArray(&writer);
+		for(auto& bufferView : m_bufferViews) {
+			ksJsonWriter_BeginObject(&writer);
+			writeUint("buffer", bufferView.buffer);
+			writeUint("byteOffset", bufferView.byteOffset); // buffer 内的偏移
+			writeUint("byteLength", bufferView.byteLength);
+			if(bufferView.byteStride != 0)
+				writeUint("byteStride", bufferView.byteStride);
+			writeUint("target", bufferView.target);
+			ksJsonWriter_EndObject(&writer);
+		}
+		ksJsonWriter_EndArray(&writer);
+		// accessors
+		ksJsonWriter_Key(&writer, "accessors");
+		ksJsonWriter_BeginArray(&writer);
+		for(auto& accessor : m_accessors) {
+			ksJsonWriter_BeginObject(&writer);
+			writeUint("bufferView", accessor.bufferView);
+			writeUint("byteOffset", accessor.byteOffset); // bufferView 内的偏移
+			writeUint("componentType", accessor.componentType);
+			writeUint("count", accessor.count);
+			writeString("type", accessor.type);
+			ksJsonWriter_EndObject(&writer);
+		}
+		ksJsonWriter_EndArray(&writer);
+		// meshes
+		ksJsonWriter_Key(&writer, "meshes");
+		ksJsonWriter_BeginArray(&writer);
+		ksJsonWriter_BeginObject(&writer);
+		ksJsonWriter_Key(&writer, "primitives");
+		ksJsonWriter_BeginArray(&writer);
+		ksJsonWriter_BeginObject(&writer);
+		ksJsonWriter_Key(&writer, "attributes");
+		ksJsonWriter_BeginObject(&writer);
+		writeUint("POSITION", 1); // accessor 1
+		if(m_accessors.size() > 2)
+			writeUint("_EXTRAATTR", 2); // accessor 2, 自定义顶点属性
+		ksJsonWriter_EndObject(&writer);
+		writeUint("indices", 0); // accessor 0
+		ksJsonWriter_EndObject(&writer);
+		ksJsonWriter_EndArray(&writer);
+		ksJsonWriter_EndObject(&writer);
+		ksJsonWriter_EndArray(&writer);
+		// nodes
+		ksJsonWriter_Key(&writer, "nodes");
+		ksJsonWriter_BeginArray(&writer);
+		ksJsonWriter_BeginObject(&writer);
+		writeUint("mesh", 0);
+		ksJsonWriter_EndObject(&writer);
+		ksJsonWriter_EndArray(&writer);
+		// scene
+		writeUint("scene", 0);
+		ksJsonWriter_Key(&writer, "scenes");
+		ksJsonWriter_BeginArray(&writer);
+		ksJsonWriter_BeginObject(&writer);
+		ksJsonWriter_Key(&writer, "nodes");
+		ksJsonWriter_BeginArray(&writer);
+		ksJsonWriter_Uint64(&writer, 0);
+		ksJsonWriter_EndArray(&writer);
+		ksJsonWriter_EndObject(&writer);
+		ksJsonWriter_EndArray(&writer);
+		ksJsonWriter_EndObject(&writer);
+		ksJsonWriter_Finish(&writer);
+		// 每个 Chunk 末尾需要 4 字节对齐, JSON 利用空格字符对齐
+		jsonChunk.data.resize((jsonChunk.data.size() + 3) & ~size_t(3), ' ');
+		return jsonChunk;
+	}
+
 	bool Glb::save(const String& path) {
 		lxd::File file(path, lxd::WriteOnly | lxd::Truncate);
 		m_header.length = static_cast<uint32_t>(sizeof(Header));
@@ -419,21 +361,92 @@ namespace lxd {
 		return result;
 	}
 
+	size_t Glb::stlSize() const {
+		size_t nIndex = 0;
+		std::visit([&](auto indices) { nIndex = indices.size(); }, getIndices());
+		return 84 + 50 * (nIndex / 3);
+	}
+
+	bool Glb::writeStl(char* dst, size_t size) const {
+		const auto points = getPositions();
+		// 直接读 accessor 的索引和顶点, 不复制
+		return std::visit([&](auto faces) {
+			const size_t nFacet = faces.size() / 3;
+			if(size < 84 + 50 * nFacet || nFacet > UINT32_MAX)
+				return false;
+			if(std::any_of(faces.begin(), faces.end(), [&](uint32_t i) { return i >= points.size(); }))
+				return false;
+
+			std::memset(dst, 0, 80);
+			std::memcpy(dst, "binary stl", 10);
+			const auto count = static_cast<uint32_t>(nFacet);
+			std::memcpy(dst + 80, &count, sizeof(count));
+			ParallelFor(nFacet, 1 << 14, [&](size_t begin, size_t end) {
+				for(size_t f = begin; f < end; f++) {
+					const float* p[3] = {points[faces[3 * f]].v, points[faces[3 * f + 1]].v, points[faces[3 * f + 2]].v};
+					// 与 ComputeFaceNormals 相同: 两条边的叉积, 归一化, 退化的面法向为零
+					const float ax = p[1][0] - p[0][0], ay = p[1][1] - p[0][1], az = p[1][2] - p[0][2];
+					const float bx = p[2][0] - p[0][0], by = p[2][1] - p[0][1], bz = p[2][2] - p[0][2];
+					float normal[3] = {ay * bz - az * by, az * bx - ax * bz, ax * by - ay * bx};
+					const float len2 = normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2];
+					const float inv = len2 > 1.0e-30f ? 1.0f / std::sqrt(len2) : 0.0f;
+					for(float& n : normal)
+						n *= inv;
+					char* facet = dst + 84 + 50 * f;
+					std::memcpy(facet, normal, sizeof(normal));
+					for(int k = 0; k < 3; k++)
+						std::memcpy(facet + 12 + 12 * k, p[k], sizeof(MyVec3f));
+					std::memset(facet + 48, 0, 2);
+				}
+			});
+			return true;
+		}, getIndices());
+	}
+
+	std::vector<char> Glb::toStl() const {
+		std::vector<char> result(stlSize());
+		if(!writeStl(result.data(), result.size()))
+			return {};
+		return result;
+	}
+
+	bool Glb::saveAsStl(const String& path) const {
+		auto stl = toStl();
+		if(stl.empty())
+			return false;
+		lxd::File file(path, lxd::WriteOnly | lxd::Truncate);
+		return file.write(stl.data(), stl.size());
+	}
+
 	std::span<MyVec3f> Glb::getPositions() {
+		const auto positions = std::as_const(*this).getPositions();
+		return {const_cast<MyVec3f*>(positions.data()), positions.size()};
+	}
+
+	std::span<const MyVec3f> Glb::getPositions() const {
 		assert(m_accessors.size() >= 2 && m_bufferViews.size() >= 2);
 		assert(m_accessors[1].componentType == 5126 && std::strcmp(m_accessors[1].type, "VEC3") == 0);
-		std::span<MyVec3f> result{reinterpret_cast<MyVec3f*>(m_chunks[1].data.data() + m_accessors[1].byteOffset + m_bufferViews[m_accessors[1].bufferView].byteOffset), static_cast<size_t>(m_accessors[1].count)};
+		std::span<const MyVec3f> result{reinterpret_cast<const MyVec3f*>(m_chunks[1].data.data() + m_accessors[1].byteOffset + m_bufferViews[m_accessors[1].bufferView].byteOffset), static_cast<size_t>(m_accessors[1].count)};
 		return result;
 	}
 
 	std::variant<std::span<uint16_t>, std::span<uint32_t>> Glb::getIndices() {
-		assert(m_accessors.size() >= 2 && m_bufferViews.size() >= 2);
 		std::variant<std::span<uint16_t>, std::span<uint32_t>> result;
+		std::visit([&](auto indices) {
+			using Index = std::remove_const_t<typename decltype(indices)::element_type>;
+			result = std::span<Index>{const_cast<Index*>(indices.data()), indices.size()};
+		}, std::as_const(*this).getIndices());
+		return result;
+	}
+
+	std::variant<std::span<const uint16_t>, std::span<const uint32_t>> Glb::getIndices() const {
+		assert(m_accessors.size() >= 2 && m_bufferViews.size() >= 2);
+		std::variant<std::span<const uint16_t>, std::span<const uint32_t>> result;
 		assert(std::strcmp(m_accessors[0].type,"SCALAR") == 0);
 		if(m_accessors[0].componentType == 5123) {
-			result = std::span<uint16_t>{reinterpret_cast<uint16_t*>(m_chunks[1].data.data()), static_cast<size_t>(m_accessors[0].count)};
+			result = std::span<const uint16_t>{reinterpret_cast<const uint16_t*>(m_chunks[1].data.data()), static_cast<size_t>(m_accessors[0].count)};
 		} else if(m_accessors[0].componentType == 5125) {
-			result = std::span<uint32_t>{reinterpret_cast<uint32_t*>(m_chunks[1].data.data()), static_cast<size_t>(m_accessors[0].count)};
+			result = std::span<const uint32_t>{reinterpret_cast<const uint32_t*>(m_chunks[1].data.data()), static_cast<size_t>(m_accessors[0].count)};
 		}
 		return result;
 	}
@@ -460,6 +473,8 @@ namespace lxd {
 		Chunk chunk;
 		uint32_t length = *reinterpret_cast<const uint32_t*>(data);
 		chunk.type = *reinterpret_cast<const uint32_t*>(data + 4);
+		// JSON chunk 多留 1 字节, extractJson 原地解析时放结尾的 0
+		chunk.data.reserve(length + (chunk.type == 0x4E4F534A));
 		chunk.data.assign(const_cast<char*>(data) + 4 + 4, const_cast<char*>(data) + 4 + 4 + length);
 		m_chunks.emplace_back(std::move(chunk));
 		if(4 + 4 + length < size)
@@ -468,32 +483,20 @@ namespace lxd {
 
 	void Glb::extractJson() {
 		assert(!m_chunks.empty() && m_chunks[0].type == 0x4E4F534A);
-		const char* buffer = m_chunks[0].data.data();
-		ksJson* rootNode = ksJson_Create();
-		if(ksJson_ReadFromBuffer(rootNode, buffer, NULL)) {
-			const ksJson* accessors = ksJson_GetMemberByName(rootNode, "accessors");
-			const ksJson* bufferViews = ksJson_GetMemberByName(rootNode, "bufferViews");
-			for(int i = 0; i < ksJson_GetMemberCount(accessors); i++) {
-				const ksJson* accessorNode = ksJson_GetMemberByIndex(accessors, i);
-				Accessor accessor;
-				accessor.bufferView = ksJson_GetInt32(ksJson_GetMemberByName(accessorNode, "bufferView"), 0);
-				accessor.byteOffset = ksJson_GetInt32(ksJson_GetMemberByName(accessorNode, "byteOffset"), 0);
-				accessor.componentType = ksJson_GetInt32(ksJson_GetMemberByName(accessorNode, "componentType"), 0);
-				accessor.count = ksJson_GetInt32(ksJson_GetMemberByName(accessorNode, "count"), 0);
-				strcpy(accessor.type, ksJson_GetString(ksJson_GetMemberByName(accessorNode, "type"), ""));
-				m_accessors.push_back(accessor);
-			}
-			for(int i = 0; i < ksJson_GetMemberCount(bufferViews); i++) {
-				const ksJson* bufferviewNode = ksJson_GetMemberByIndex(bufferViews, i);
-				BufferView bufferview;
-				bufferview.buffer = ksJson_GetInt32(ksJson_GetMemberByName(bufferviewNode, "buffer"), 0);
-				bufferview.byteOffset = ksJson_GetInt32(ksJson_GetMemberByName(bufferviewNode, "byteOffset"), 0);
-				bufferview.byteLength = ksJson_GetInt32(ksJson_GetMemberByName(bufferviewNode, "byteLength"), 0);
-				bufferview.target = ksJson_GetInt32(ksJson_GetMemberByName(bufferviewNode, "target"), 0);
-				m_bufferViews.push_back(bufferview);
-			}
+		// 只读少数字段, 用 tape 解析, 不建 DOM, 数字读取时才转换
+		// 直接在 chunk 上原地解析, 不复制; 解析后 chunk 由读到的字段重新生成, 与 create 等写出的 JSON 相同
+		std::vector<char>& json = m_chunks[0].data;
+		json.push_back('\0');
+		ksJsonTape tape;
+		ksJsonTape_Init(&tape);
+		if(ksJsonTape_Parse(&tape, json.data(), NULL)) {
+			// 绑定表一次遍历每个对象的成员, 缺少的字段为 0
+			const ksJsonCursor root = ksJsonTape_GetRoot(&tape);
+			ReadJson(ksJsonCursor_GetMemberByName(root, "accessors"), m_accessors);
+			ReadJson(ksJsonCursor_GetMemberByName(root, "bufferViews"), m_bufferViews);
 		}
-		ksJson_Destroy(rootNode);
+		ksJsonTape_Destroy(&tape);
+		m_chunks[0] = makeJsonChunk(m_chunks.size() > 1 ? m_chunks[1].data.size() : 0);
 	}
 
 
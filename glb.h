@@ -6,6 +6,7 @@
 #include <string_view>
 #include <span>
 #include <variant>
+#include <cmath>
 
 namespace lxd {
 	struct MyVec3f {
@@ -13,7 +14,7 @@ namespace lxd {
 		friend bool operator==(const MyVec3f& a, const MyVec3f& b) {
 		    float cwiseAbsSum = 0;
 			for (int i = 0; i < 3; i++) {
-			    cwiseAbsSum += abs(a.v[i] - b.v[i]);
+			    cwiseAbsSum += std::abs(a.v[i] - b.v[i]);
 			}
 		    return cwiseAbsSum < 1.0e-7;
 		}
@@ -23,7 +24,7 @@ namespace lxd {
 	    friend bool operator==(const MyVec3d& a, const MyVec3d& b) {
 		    double cwiseAbsSum = 0;
 		    for (int i = 0; i < 3; i++) {
-			    cwiseAbsSum += abs(a.v[i] - b.v[i]);
+			    cwiseAbsSum += std::abs(a.v[i] - b.v[i]);
 		    }
 		    return cwiseAbsSum < 1.0e-7;
 	    }
@@ -67,14 +68,24 @@ namespace lxd {
 	    bool create(const std::vector<MyVec3f>& points, const std::vector<Face>& faces, const std::vector<char>& extraAttribute);
 		bool save(const String& path);
 		std::vector<uint8_t> searialize();
+		// 二进制 STL: 80 字节头 + 4 字节面数 + 每个面 50 字节
+		size_t stlSize() const;
+		// 写入预先分配(或 mmap)的 dst, 每个面的偏移固定, 各线程写互不重叠的区间
+		bool writeStl(char* dst, size_t size) const;
+		std::vector<char> toStl() const;
+		bool saveAsStl(const String& path) const;
 		//
 		std::span<MyVec3f> getPositions();
+		std::span<const MyVec3f> getPositions() const;
 		std::variant<std::span<uint16_t>, std::span<uint32_t>> getIndices();
+		std::variant<std::span<const uint16_t>, std::span<const uint32_t>> getIndices() const;
 	    std::span<char> getExtraAttribute();
 	private:
 		void clear();
 		void extractChunk(const char* data, size_t size);
 		void extractJson();
+		// 由 m_bufferViews 和 m_accessors 直接写出 glTF JSON, 已按 4 字节对齐
+		Chunk makeJsonChunk(size_t binaryLength) const;
 	private:
 		Header m_header;
 		std::vector<Accessor> m_accessors;
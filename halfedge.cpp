@@ -0,0 +1,147 @@
+#include "halfedge.h"
+#include "glb.h"
+#include "utils.h"
+#include <algorithm>
+#include <variant>
+
+namespace lxd {
+	namespace {
+		// 有向边 (from, to) 打包成 64 位排序键, 反向边只需交换高低 32 位
+		struct EdgeKey {
+			uint64_t key;
+			uint32_t h;
+			friend bool operator<(const EdgeKey& a, const EdgeKey& b) {
+				return a.key < b.key || (a.key == b.key && a.h < b.h);
+			}
+		};
+		constexpr uint64_t MakeKey(uint64_t from, uint64_t to) { return from << 32 | to; }
+		constexpr uint32_t KeyFrom(uint64_t key) { return static_cast<uint32_t>(key >> 32); }
+		constexpr uint64_t Reverse(uint64_t key) { return key << 32 | key >> 32; }
+		constexpr size_t kGrain = 1 << 14;
+	}
+
+	bool HalfEdgeMesh::build(std::span<const uint16_t> indices, uint32_t nVertex) {
+		return buildImpl(indices, nVertex);
+	}
+
+	bool HalfEdgeMesh::build(std::span<const uint32_t> indices, uint32_t nVertex) {
+		return buildImpl(indices, nVertex);
+	}
+
+	bool HalfEdgeMesh::build(Glb& glb) {
+		const auto nVertex = static_cast<uint32_t>(glb.getPositions().size());
+		return std::visit([&](auto indices) {
+			return buildImpl(std::span<const typename decltype(indices)::value_type>(indices), nVertex);
+		}, glb.getIndices());
+	}
+
+	void HalfEdgeMesh::clear() {
+		m_from.clear();
+		m_opposite.clear();
+		m_edge.clear();
+		m_outgoing.clear();
+		m_edgeCount = 0;
+	}
+
+	size_t HalfEdgeMesh::memoryUsage() const {
+		return sizeof(uint32_t) * (m_from.capacity() + m_opposite.capacity() + m_edge.capacity() + m_outgoing.capacity());
+	}
+
+	std::vector<uint32_t> HalfEdgeMesh::boundaryHalfEdges() const {
+		std::vector<uint32_t> result;
+		for(uint32_t h = 0; h < halfEdgeCount(); h++) {
+			if(isBoundary(h))
+				result.push_back(h);
+		}
+		return result;
+	}
+
+	template <typename T>
+	bool HalfEdgeMesh::buildImpl(std::span<const T> indices, uint32_t nVertex) {
+		clear();
+		if(indices.size() % 3 != 0 || indices.size() >= kInvalid)
+			return false;
+		const auto nHalfEdge = static_cast<uint32_t>(indices.size());
+		if(std::any_of(indices.begin(), indices.end(), [&](T i) { return i >= nVertex; }))
+			return false;
+
+		m_from.resize(nHalfEdge);
+		m_opposite.assign(nHalfEdge, kInvalid);
+		m_edge.resize(nHalfEdge);
+		m_outgoing.assign(nVertex, kInvalid);
+
+		// 1. 生成有向边键并行排序, 相同起点的出边排在一起
+		std::vector<EdgeKey> keys(nHalfEdge);
+		ParallelFor(nHalfEdge, kGrain, [&](size_t begin, size_t end) {
+			for(size_t h = begin; h < end; h++) {
+				m_from[h] = indices[h];
+				const size_t n = h % 3 == 2 ? h - 2 : h + 1;
+				keys[h] = {MakeKey(indices[h], indices[n]), static_cast<uint32_t>(h)};
+			}
+		});
+		ParallelSort(keys.begin(), keys.end());
+
+		// 2. 二分查找反向边; 正反向边都唯一时才配对, 否则是非流形边
+		auto unique = [&](size_t i) {
+			return (i == 0 || keys[i - 1].key != keys[i].key) && (i + 1 == keys.size() || keys[i + 1].key != keys[i].key);
+		};
+		ParallelFor(nHalfEdge, kGrain, [&](size_t begin, size_t end) {
+			for(size_t i = begin; i < end; i++) {
+				const uint64_t key = keys[i].key;
+				const uint64_t reverse = Reverse(key);
+				if(reverse == key || !unique(i))
+					continue;
+				auto it = std::lower_bound(keys.begin(), keys.end(), EdgeKey{reverse, 0});
+				if(it != keys.end() && it->key == reverse && unique(it - keys.begin()))
+					m_opposite[keys[i].h] = it->h;
+			}
+		});
+
+		// 3. 每个顶点的出边在 keys 中连续, 边界出边优先
+		ParallelFor(nHalfEdge, kGrain, [&](size_t begin, size_t end) {
+			for(size_t i = begin; i < end; i++) {
+				const uint32_t v = KeyFrom(keys[i].key);
+				if(i > 0 && KeyFrom(keys[i - 1].key) == v)
+					continue;
+				uint32_t h = keys[i].h;
+				for(size_t j = i; j < keys.size() && KeyFrom(keys[j].key) == v; j++) {
+					if(m_opposite[keys[j].h] == kInvalid) {
+						h = keys[j].h;
+						break;
+					}
+				}
+				m_outgoing[v] = h;
+			}
+		});
+		keys = {};
+
+		// 4. 无向边编号: 边界半边或两条对边中编号较小者持有该边, 分块计数后前缀和
+		const uint32_t nChunk = std::clamp<uint32_t>(nHalfEdge / kGrain, 1, 4 * std::max(1u, std::thread::hardware_concurrency()));
+		auto chunkBegin = [&](uint32_t chunk) { return static_cast<uint32_t>(uint64_t(nHalfEdge) * chunk / nChunk); };
+		auto owner = [&](uint32_t h) { return m_opposite[h] == kInvalid || h < m_opposite[h]; };
+		std::vector<uint32_t> offsets(nChunk + 1, 0);
+		RunParallel(nChunk, [&](uint32_t chunk) {
+			uint32_t count = 0;
+			for(uint32_t h = chunkBegin(chunk); h < chunkBegin(chunk + 1); h++)
+				count += owner(h);
+			offsets[chunk + 1] = count;
+		});
+		for(uint32_t chunk = 0; chunk < nChunk; chunk++)
+			offsets[chunk + 1] += offsets[chunk];
+		m_edgeCount = offsets[nChunk];
+		RunParallel(nChunk, [&](uint32_t chunk) {
+			uint32_t id = offsets[chunk];
+			for(uint32_t h = chunkBegin(chunk); h < chunkBegin(chunk + 1); h++) {
+				if(owner(h))
+					m_edge[h] = id++;
+			}
+		});
+		ParallelFor(nHalfEdge, kGrain, [&](size_t begin, size_t end) {
+			for(size_t h = begin; h < end; h++) {
+				if(!owner(static_cast<uint32_t>(h)))
+					m_edge[h] = m_edge[m_opposite[h]];
+			}
+		});
+		return true;
+	}
+}
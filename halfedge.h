@@ -0,0 +1,80 @@
+#pragma once
+
+#include "defines.h"
+#include <cstdint>
+#include <vector>
+#include <span>
+
+namespace lxd {
+	class Glb;
+	/// <summary>
+	/// 基于索引的半边结构, 由 Glb::getIndices() 的三角形索引构建, 供边界检测/平滑/补洞等算法复用
+	/// 半边 h 属于面 h / 3, 面内下一条半边为 next(h), 因此 next/prev/face 都不需要存储
+	/// 每条半边只存 起点/对边/无向边编号 三个 uint32 (12 字节), 另外每个顶点存一条出边
+	/// 非流形边(同一有向边出现多次)的对边记为 kInvalid, 按边界处理
+	/// </summary>
+	class DLL_PUBLIC HalfEdgeMesh {
+	public:
+		static constexpr uint32_t kInvalid = UINT32_MAX;
+
+		bool build(std::span<const uint16_t> indices, uint32_t nVertex);
+		bool build(std::span<const uint32_t> indices, uint32_t nVertex);
+		bool build(Glb& glb);
+		void clear();
+
+		uint32_t vertexCount() const { return static_cast<uint32_t>(m_outgoing.size()); }
+		uint32_t faceCount() const { return halfEdgeCount() / 3; }
+		uint32_t halfEdgeCount() const { return static_cast<uint32_t>(m_from.size()); }
+		uint32_t edgeCount() const { return m_edgeCount; }
+		size_t memoryUsage() const;
+
+		static uint32_t face(uint32_t h) { return h / 3; }
+		static uint32_t next(uint32_t h) { return h % 3 == 2 ? h - 2 : h + 1; }
+		static uint32_t prev(uint32_t h) { return h % 3 == 0 ? h + 2 : h - 1; }
+		uint32_t from(uint32_t h) const { return m_from[h]; }
+		uint32_t to(uint32_t h) const { return m_from[next(h)]; }
+		uint32_t opposite(uint32_t h) const { return m_opposite[h]; }
+		uint32_t edge(uint32_t h) const { return m_edge[h]; }
+		bool isBoundary(uint32_t h) const { return m_opposite[h] == kInvalid; }
+		// 以 v 为起点的一条出边, 边界顶点优先返回边界半边, 孤立顶点返回 kInvalid
+		uint32_t outgoing(uint32_t v) const { return m_outgoing[v]; }
+		bool isBoundaryVertex(uint32_t v) const { return m_outgoing[v] != kInvalid && isBoundary(m_outgoing[v]); }
+
+		// 绕顶点 v 依次访问出边 func(h), 非流形顶点只访问 outgoing(v) 所在的扇形
+		template <typename Func>
+		void forEachOutgoing(uint32_t v, Func&& func) const {
+			const uint32_t start = m_outgoing[v];
+			if(start == kInvalid)
+				return;
+			uint32_t h = start;
+			do {
+				func(h);
+				h = m_opposite[prev(h)];
+			} while(h != kInvalid && h != start);
+		}
+		// 访问顶点 v 的一环邻点 func(w)
+		template <typename Func>
+		void forEachNeighbor(uint32_t v, Func&& func) const {
+			uint32_t last = kInvalid;
+			forEachOutgoing(v, [&](uint32_t h) {
+				func(to(h));
+				last = h;
+			});
+			// 边界顶点: 扇形末尾那条入边的起点不是任何出边的终点
+			if(last != kInvalid && isBoundary(prev(last)))
+				func(from(prev(last)));
+		}
+		std::vector<uint32_t> boundaryHalfEdges() const;
+
+	private:
+		template <typename T>
+		bool buildImpl(std::span<const T> indices, uint32_t nVertex);
+
+	private:
+		std::vector<uint32_t> m_from;     // 半边起点
+		std::vector<uint32_t> m_opposite; // 对边, 边界为 kInvalid
+		std::vector<uint32_t> m_edge;     // 无向边编号, 与对边共享
+		std::vector<uint32_t> m_outgoing; // 每个顶点的一条出边
+		uint32_t m_edgeCount = 0;
+	};
+}
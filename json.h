@@ -64,6 +64,14 @@ the members of an object where it left off during the last lookup.
 If the DOM is traversed in the order it is stored, then this results
 in only a single string comparison per lookup. This implementation keeps
 objects in the same order in the DOM as they appear in the JSON text.
+Where a lookup left off is remembered per thread instead of in the DOM,
+so reading never modifies the DOM and any number of threads can read
+the same DOM concurrently, as long as no thread modifies it.
+
+Objects that are used as maps, with thousands of members looked up in
+no particular order, are the exception. An object with 32 or more members
+gets a hash table of its member names when a member is first looked up
+by name, which makes every further lookup constant time.
 
 This implementation stores the members of an object, or the elements
 of an array, in an exponentially growing mapped array per object or
@@ -88,11 +96,12 @@ The JSON specification allows an implementation to set limits on the
 range and precision of numbers. This implementation can accurately
 represent the full 8-bit, 16-bit, 32-bit and 64-bit, signed and
 unsigned integer ranges. This implementation can also accurately
-represent all 32-bit and 64-bit floating-point values. The minimum
-and maximum floating-point numbers are parsed with full precision
-and all other floating-point numbers are represented within 4 ulps.
-For instance, this implementation parses the following numbers with
-full precision.
+represent all 32-bit and 64-bit floating-point values. Floating-point
+numbers are parsed to the nearest double (Eisel-Lemire) and written
+with the fewest digits that read back as the same double, or as the
+same float for numbers set with ksJson_SetFloat(). Writing and parsing
+a floating-point number therefore reproduces it exactly. For instance,
+this implementation parses the following numbers with full precision.
 
 	INT8_MIN         -128
 	INT16_MIN        -32768
@@ -122,8 +131,9 @@ both UTF8 and UTF16 with surrogate pairs. UTF32 is not supported.
 This implementation does not set limits on the length of strings.
 
 The JSON specification allows an implementation to set limits on
-the maximum depth of nesting. This implementation uses a recursive
-parser with a maximum recursion depth of 128.
+the maximum depth of nesting. This implementation parses and writes
+text with an explicit stack instead of recursion. The nesting depth
+is limited to 128 by default and can be changed with ksJson_SetMaxDepth().
 
 The JSON specification allows an implementation to set limits on the
 size of texts that it accepts. This implementation does not have any
@@ -139,12 +149,20 @@ INTERFACE
 =========
 
 struct ksJson;
+struct ksJsonFile;
 
 ksJson *		ksJson_Create();
+ksJson *		ksJson_CreateWithArena( const size_t blockSize );	// Nodes and strings are allocated from blocks of 'blockSize' bytes.
+void			ksJson_Reset( ksJson * rootNode );						// Clears the DOM to null. An arena is rewound for reuse.
 void			ksJson_Destroy( ksJson * rootNode );
+void			ksJson_SetMaxDepth( ksJson * rootNode, const int maxDepth );			// Limits the nesting of objects and arrays, 128 by default.
 
 bool			ksJson_ReadFromBuffer( ksJson * rootNode, const char * buffer, const char ** errorStringOut );
-bool			ksJson_ReadFromFile( ksJson * rootNode, const char * fileName, const char ** errorStringOut );
+bool			ksJson_ReadFromBufferInSitu( ksJson * rootNode, char * buffer, const char ** errorStringOut );	// Strings are borrowed from the modified buffer.
+bool			ksJson_ReadFromBufferLength( ksJson * rootNode, const char * buffer, const size_t length, const char ** errorStringOut );	// The value must end within 'length' bytes.
+bool			ksJson_ReadFromFile( ksJson * rootNode, const char * fileName, const char ** errorStringOut );	// Parses the memory mapped file.
+bool			ksJson_ReadFromFileInSitu( ksJson * rootNode, ksJsonFile * file, const char * fileName, const char ** errorStringOut );	// Strings are borrowed from the mapping.
+void			ksJsonFile_Close( ksJsonFile * file );									// Unmaps a file after the DOM that borrows from it is destroyed.
 bool			ksJson_WriteToBuffer( const ksJson * rootNode, char ** bufferOut, int * lengthOut );	// Buffer is allocated with malloc.
 bool			ksJson_WriteToFile( const ksJson * rootNode, const char * fileName );
 
@@ -156,6 +174,7 @@ int				ksJson_GetMemberCount( const ksJson * node );							// Get the number of
 ksJson *		ksJson_GetMemberByIndex( const ksJson * node, const int index );		// Get an object member or array element by index.
 ksJson *		ksJson_GetMemberByName( const ksJson * node, const char * name );		// Case-sensitive lookup of an object member by name.
 const char *	ksJson_GetMemberName( const ksJson * node );							// Returns the name of this member.
+int				ksJson_GetMemberIndex( const ksJson * node, const ksJson * member );	// Returns the index of a member or -1.
 
 bool			ksJson_IsNull( const ksJson * node );									// Returns true if the node != NULL and the value is 'null'.
 bool			ksJson_IsBoolean( const ksJson * node );								// Returns true if the node != NULL and the value is 'true' or 'false'.
@@ -179,6 +198,7 @@ uint64_t		ksJson_GetUint64( const ksJson * node, const uint64_t defaultValue );
 float			ksJson_GetFloat( const ksJson * node, const float defaultValue );		// Returns 'defaultValue' if IsNumber( node ) == false.
 double			ksJson_GetDouble( const ksJson * node, const double defaultValue );		// Returns 'defaultValue' if IsNumber( node ) == false.
 const char *	ksJson_GetString( const ksJson * node, const char * defaultValue );		// Returns 'defaultValue' if IsString( node ) == false.
+const void *	ksJson_GetBytes( const ksJson * node, size_t * lengthOut );				// Returns NULL if IsString( node ) == false.
 
 //
 // create & modify
@@ -203,6 +223,89 @@ ksJson *		ksJson_SetUint64( ksJson * node, const uint64_t value );				// Turns t
 ksJson *		ksJson_SetFloat( ksJson * node, const float value );					// Turns the node into a 32-bit floating-point number with the given value.
 ksJson *		ksJson_SetDouble( ksJson * node, const double value );					// Turns the node into a 64-bit floating-point number with the given value.
 ksJson *		ksJson_SetString( ksJson * node, const char * value );					// Turns the node into a string with the given value.
+ksJson *		ksJson_SetBytes( ksJson * node, const void * data, const size_t length );	// Turns the node into a byte string that may contain zeros.
+ksJson *		ksJson_SetValue( ksJson * node, const ksJson * value );					// Turns the node into a deep copy of the value, which may be part of another DOM.
+
+bool			ksJson_RemoveMember( ksJson * node, const int index );					// Removes an object member or array element. Later members move down one place.
+bool			ksJson_RemoveMemberByName( ksJson * node, const char * name );			// Removes an object member with the given name.
+ksJson *		ksJson_MoveMember( ksJson * node, const char * name, ksJson * from, const int index );	// Moves a member with its subtree to the end of the node.
+ksJson *		ksJson_MergePatch( ksJson * target, const ksJson * patch );				// Applies an RFC 7396 merge patch to the target.
+
+//
+// streaming writer
+//
+
+struct ksJsonWriter;
+typedef bool ( *ksJsonSinkFunc )( void * context, const char * data, const size_t length );	// Returns false on failure.
+
+void			ksJsonWriter_Init( ksJsonWriter * writer, char * buffer, const size_t bufferSize,
+									ksJsonSinkFunc sink, void * sinkContext, const int flags );	// Without a sink the writer grows its own buffer.
+void			ksJsonWriter_BeginObject( ksJsonWriter * writer );
+void			ksJsonWriter_EndObject( ksJsonWriter * writer );
+void			ksJsonWriter_BeginArray( ksJsonWriter * writer );
+void			ksJsonWriter_EndArray( ksJsonWriter * writer );
+void			ksJsonWriter_Key( ksJsonWriter * writer, const char * name );			// Writes the name of the next object member.
+void			ksJsonWriter_Null( ksJsonWriter * writer );
+void			ksJsonWriter_Bool( ksJsonWriter * writer, const bool value );
+void			ksJsonWriter_Int64( ksJsonWriter * writer, const int64_t value );
+void			ksJsonWriter_Uint64( ksJsonWriter * writer, const uint64_t value );
+void			ksJsonWriter_Float( ksJsonWriter * writer, const float value );
+void			ksJsonWriter_Double( ksJsonWriter * writer, const double value );
+void			ksJsonWriter_String( ksJsonWriter * writer, const char * value );
+void			ksJsonWriter_StringLength( ksJsonWriter * writer, const char * value, const size_t length );	// Zeros in the value are escaped.
+void			ksJsonWriter_Bytes( ksJsonWriter * writer, const void * data, const size_t length );	// Writes a base64 encoded string.
+void			ksJsonWriter_Node( ksJsonWriter * writer, const ksJson * node );		// Writes a DOM node with all its members.
+void			ksJsonWriter_Flush( ksJsonWriter * writer );							// Passes the buffered text to the sink.
+bool			ksJsonWriter_Finish( ksJsonWriter * writer );							// Flushes and returns false if the sink failed.
+
+//
+// pull parser
+//
+
+struct ksJsonPull;
+
+void			ksJsonPull_Init( ksJsonPull * parser );
+void			ksJsonPull_Destroy( ksJsonPull * parser );
+void			ksJsonPull_SetMaxDepth( ksJsonPull * parser, const int maxDepth );		// Limits the nesting of objects and arrays, 128 by default.
+void			ksJsonPull_Feed( ksJsonPull * parser, const char * data, const size_t length, const bool last );	// Chunks may split tokens.
+ksJsonPullEvent	ksJsonPull_Next( ksJsonPull * parser );									// Returns JSON_PULL_NEED_INPUT when a chunk must be fed.
+void			ksJsonPull_Skip( ksJsonPull * parser );									// Skips the object or array just begun, or the value of the member just named.
+const char *	ksJsonPull_GetKey( const ksJsonPull * parser );						// Member name of JSON_PULL_KEY.
+const ksJson *	ksJsonPull_GetValue( const ksJsonPull * parser );						// Null, boolean, number or string of JSON_PULL_VALUE.
+int				ksJsonPull_GetDepth( const ksJsonPull * parser );						// Number of open objects and arrays.
+const char *	ksJsonPull_GetError( const ksJsonPull * parser );
+
+//
+// tape
+//
+
+struct ksJsonTape;
+struct ksJsonCursor;
+
+void			ksJsonTape_Init( ksJsonTape * tape );
+void			ksJsonTape_Destroy( ksJsonTape * tape );
+void			ksJsonTape_SetMaxDepth( ksJsonTape * tape, const int maxDepth );		// Limits the nesting of objects and arrays, 128 by default.
+bool			ksJsonTape_Parse( ksJsonTape * tape, char * buffer, const char ** errorStringOut );	// Strings are borrowed from the modified buffer.
+ksJsonCursor	ksJsonTape_GetRoot( const ksJsonTape * tape );
+
+int				ksJsonCursor_GetMemberCount( const ksJsonCursor cursor );
+ksJsonCursor	ksJsonCursor_GetMemberByIndex( const ksJsonCursor cursor, const int index );	// Skips 'index' members unless they are all leaf values.
+ksJsonCursor	ksJsonCursor_GetMemberByName( const ksJsonCursor cursor, const char * name );
+ksJsonCursor	ksJsonCursor_GetFirstMember( const ksJsonCursor cursor );				// Invalid if the object or array is empty.
+ksJsonCursor	ksJsonCursor_GetNextMember( const ksJsonCursor cursor );				// Invalid after the last member.
+const char *	ksJsonCursor_GetMemberName( const ksJsonCursor cursor );
+bool			ksJsonCursor_IsValid( const ksJsonCursor cursor );						// False if the value was not found.
+
+The ksJsonCursor_Is* and ksJsonCursor_Get* functions match the ksJson_Is* and ksJson_Get* functions.
+
+//
+// CBOR and MessagePack
+//
+
+bool			ksJson_ReadFromCbor( ksJson * rootNode, const void * data, const size_t length, const char ** errorStringOut );
+bool			ksJson_ReadFromMsgPack( ksJson * rootNode, const void * data, const size_t length, const char ** errorStringOut );
+bool			ksJson_WriteToCbor( const ksJson * rootNode, char ** bufferOut, int * lengthOut );		// Buffer is allocated with malloc.
+bool			ksJson_WriteToMsgPack( const ksJson * rootNode, char ** bufferOut, int * lengthOut );	// Buffer is allocated with malloc.
 
 
 USAGE
@@ -246,6 +349,161 @@ The object members and array elements are kept in the order they are added.
 A JSON object or array can be cleared by calling ksJson_SetObject() or
 ksJson_SetArray() respectively.
 
+Single members are removed with ksJson_RemoveMember() or ksJson_RemoveMemberByName().
+The members after a removed member move down one place, so pointers to them are no
+longer valid. ksJson_MoveMember() moves a member with its whole subtree to the end
+of an object or array, optionally under a new name. Within a DOM, the subtree is
+relinked instead of copied. ksJson_SetValue() turns a node into a copy of any other
+value, which may be part of another DOM.
+
+ksJson_MergePatch() applies a JSON merge patch (RFC 7396) in place. Members of the
+patch with a null value remove the member with that name, objects are merged member
+by member and all other values replace the value of the target. Only the members
+named by the patch are touched, so patching a large document takes time in proportion
+to the size of the patch instead of rebuilding the document. Only an object from which
+members are removed is compacted once:
+
+    ksJson * patch = ksJson_Create();
+    ksJson_ReadFromBuffer( patch, "{ \"server\": { \"port\": 8080, \"debug\": null } }", NULL );
+    ksJson_MergePatch( config, patch );
+    ksJson_Destroy( patch );
+
+Like nodes that are added, a value or patch can not be part of the node it is applied to.
+
+A DOM created with ksJson_CreateWithArena() allocates all its nodes, member
+maps and strings from large blocks instead of calling malloc() for each of them.
+ksJson_Destroy() then frees the blocks instead of walking the tree. Memory of
+values that are replaced, removed or cleared is not reclaimed until the root node
+is cleared with ksJson_Reset() or by reading a new document into it, after which
+the blocks are reused. This makes parsing many documents in a loop with the
+same root node essentially allocation free. Member names are interned, so an
+array of objects with the same members stores every name only once. Only arena
+DOMs intern names. A DOM created with ksJson_Create() frees every name with its
+member, so it still allocates one copy of the name per member.
+
+    ksJson * rootNode = ksJson_CreateWithArena( 0 );
+    while ( ReceiveMessage( &message ) )
+    {
+        if ( ksJson_ReadFromBuffer( rootNode, message, NULL ) ) ...
+    }
+    ksJson_Destroy( rootNode );
+
+ksJson_ReadFromBufferInSitu() parses a mutable buffer without allocating memory
+for strings. Escape sequences are collapsed in place, every string is terminated
+by overwriting its closing quote, and the member names and string values of the
+DOM point into the buffer. The buffer is no longer valid JSON afterwards and must
+outlive the DOM. Values that are later changed with ksJson_Set* own their memory
+as usual.
+
+ksJson_ReadFromFile() memory maps the file and parses it straight from the file
+cache, so the file is never copied into an allocated buffer. For large files,
+ksJson_ReadFromFileInSitu() additionally borrows the strings from a copy-on-write
+mapping, so only the DOM nodes and the pages with strings take up memory of their
+own. The mapping is kept in a ksJsonFile that must outlive the DOM.
+
+    ksJsonFile file;
+    ksJson * rootNode = ksJson_CreateWithArena( 0 );
+    if ( ksJson_ReadFromFileInSitu( rootNode, &file, "snapshot.json", NULL ) ) ...
+    ksJson_Destroy( rootNode );
+    ksJsonFile_Close( &file );
+
+A ksJsonWriter writes JSON text without building a DOM. The text is collected
+in a fixed-size buffer that is passed to a sink function whenever it is full.
+Values are written in document order and every object member is preceded by
+its name. JSON_WRITE_COMPACT leaves out all white space. For instance, to write
+directly to a file:
+
+    bool WriteToFile( void * context, const char * data, const size_t length )
+    {
+        return static_cast<lxd::File *>( context )->write( data, length );
+    }
+
+    char buffer[4096];
+    ksJsonWriter writer;
+    ksJsonWriter_Init( &writer, buffer, sizeof( buffer ), WriteToFile, &file, JSON_WRITE_COMPACT );
+    ksJsonWriter_BeginObject( &writer );
+    ksJsonWriter_Key( &writer, "count" );
+    ksJsonWriter_Int64( &writer, 10 );
+    ksJsonWriter_Key( &writer, "values" );
+    ksJsonWriter_BeginArray( &writer );
+    ksJsonWriter_Float( &writer, 2.0f );
+    ksJsonWriter_EndArray( &writer );
+    ksJsonWriter_EndObject( &writer );
+    if ( !ksJsonWriter_Finish( &writer ) ) ...
+
+ksJson_WriteToBuffer() and ksJson_WriteToFile() use the same writer.
+
+A ksJsonPull reads text of any size without building a DOM. The text is fed
+in chunks as the parser asks for it, and a value is passed as a ksJson node
+so the usual ksJson_Get* functions apply. Objects and arrays that are not
+of interest are skipped without parsing them. For instance, to filter the
+records of a large array in a file:
+
+    ksJsonPull parser;
+    ksJsonPull_Init( &parser );
+    char chunk[65536];
+    bool isUser = false;
+    for ( bool done = false; !done; )
+    {
+        switch ( ksJsonPull_Next( &parser ) )
+        {
+            case JSON_PULL_NEED_INPUT:
+            {
+                const size_t length = fread( chunk, 1, sizeof( chunk ), file );
+                ksJsonPull_Feed( &parser, chunk, length, length < sizeof( chunk ) );
+                break;
+            }
+            case JSON_PULL_KEY:
+            {
+                if ( strcmp( ksJsonPull_GetKey( &parser ), "history" ) == 0 )
+                {
+                    ksJsonPull_Skip( &parser );
+                }
+                isUser = ( strcmp( ksJsonPull_GetKey( &parser ), "user" ) == 0 );
+                break;
+            }
+            case JSON_PULL_VALUE:
+            {
+                if ( isUser ) ... ksJson_GetString( ksJsonPull_GetValue( &parser ), "" ) ...
+                isUser = false;
+                break;
+            }
+            case JSON_PULL_END:
+            case JSON_PULL_ERROR:
+                done = true;
+                break;
+            default:
+                break;
+        }
+    }
+    ksJsonPull_Destroy( &parser );
+
+A ksJsonTape parses a mutable buffer like ksJson_ReadFromBufferInSitu() but without
+building a DOM. Values are reached through a ksJsonCursor, which is passed by value,
+and numbers are only converted when they are read. This makes picking a few values
+out of a large document much cheaper than parsing it into a DOM. A cursor that did not
+find a value is not valid and all ksJsonCursor_Get* functions return the default value.
+
+    ksJsonTape tape;
+    ksJsonTape_Init( &tape );
+    if ( ksJsonTape_Parse( &tape, buffer, NULL ) )
+    {
+        const ksJsonCursor vertices = ksJsonCursor_GetMemberByName( ksJsonTape_GetRoot( &tape ), "vertices" );
+        for ( ksJsonCursor vertex = ksJsonCursor_GetFirstMember( vertices ); ksJsonCursor_IsValid( vertex );
+                vertex = ksJsonCursor_GetNextMember( vertex ) )
+        {
+            const float x = ksJsonCursor_GetFloat( ksJsonCursor_GetMemberByName( vertex, "x" ), 0.0f );
+        }
+    }
+    ksJsonTape_Destroy( &tape );
+
+ksJson_ReadFromCbor() and ksJson_ReadFromMsgPack() build the same DOM from CBOR
+and MessagePack data as ksJson_ReadFromBuffer() builds from JSON text, and
+ksJson_WriteToCbor() and ksJson_WriteToMsgPack() write any DOM in these formats.
+Numbers are stored in binary, so nothing is formatted or parsed. Byte strings
+become strings set with ksJson_SetBytes(). ksJson_GetBytes() returns their data
+and length, and they are written to JSON text as base64 encoded strings.
+
 
 EXAMPLES
 ========
@@ -432,11 +690,44 @@ Traverse DOM    2.6 GHz        2.6 GHz        2.1 GHz        2.1 GHz        2.1
 #if defined( _MSC_VER )
 #include <intrin.h>
 #endif
+#if defined( __cplusplus )
+#include "strings/numbers.h"	// exact number parsing and shortest number formatting
+#include <atomic>
+#endif
+
+#if defined( JSON_NO_SIMD )
+	// scalar scanning only
+#elif defined( __x86_64__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 ) || defined( __SSE2__ )
+	#define JSON_SIMD_SSE2
+	#define JSON_SIMD_AVX2			// compiled for every x86 target, selected at run-time
+	#include <immintrin.h>
+#elif defined( __ARM_NEON ) || defined( _M_ARM64 )
+	#define JSON_SIMD_NEON
+	#include <arm_neon.h>
+#endif
+
+#if defined( JSON_NO_MMAP )
+	// read files into an allocated buffer
+#elif defined( _WIN32 )
+	#define JSON_MMAP_WIN32
+	#if !defined( NOMINMAX )
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#elif defined( __unix__ ) || defined( __APPLE__ )
+	#define JSON_MMAP_POSIX
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
 
 #define JSON_MIN( x, y )			( ( x <= y ) ? x : y )
 #define JSON_MAX( x, y )			( ( x >= y ) ? x : y )
 #define JSON_CLAMP( x, min, max )	( ( x >= min ) ? ( ( x <= max ) ? x : max ) : min )
 #define JSON_MAX_RECURSION			128
+#define JSON_DEFAULT_MAX_DEPTH		JSON_MAX_RECURSION	// default nesting limit of ksJson_SetMaxDepth()
+#define JSON_PARSE_STACK_SIZE		64	// nesting depth that is parsed or written without allocating a stack
 #define JSON_MAP_GRANULARITY		4	// 128, 2048 etc. members
 #define JSON_BASE_ALLOC_PWR			4	// [16, 32, 64, 128], [256, 512, 1024, 2048] etc. members
 
@@ -455,6 +746,16 @@ typedef enum
 	JSON_MAX_ENUM	= 0x7FFFFFFF	// Make sure this enum is 32 bits.
 } JsonType_t;
 
+// JSON node flags
+#define JSON_FLAG_ARENA				1	// node memory is owned by a ksJsonArena
+#define JSON_FLAG_BORROWED_NAME		2	// name points into the buffer passed to ksJson_ReadFromBufferInSitu()
+#define JSON_FLAG_BORROWED_VALUE	4	// valueString points into the buffer passed to ksJson_ReadFromBufferInSitu()
+#define JSON_FLAG_SINGLE			8	// number was set with ksJson_SetFloat() and is written with float precision
+#define JSON_FLAG_BYTES				16	// string was set with ksJson_SetBytes() and its length is stored in front of it
+
+// JSON parse flags
+#define JSON_PARSE_IN_SITU			1	// unescape strings in place and borrow them from the buffer
+
 // JSON node
 // 32-bit sizeof( ksJson ) = 64-bit sizeof( ksJson ) = 32
 typedef struct ksJson
@@ -472,13 +773,268 @@ typedef struct ksJson
 		char *				valueString;	// string value
 		struct ksJson **	memberMap;		// object/array members
 	};
-	JsonType_t		type;					// type of value
-	int				membersAllocated;		// number of allocated members
+	uint8_t			type;					// type of value (JsonType_t)
+	uint8_t			flags;					// JSON_FLAG_*
+	uint16_t		maxDepth;				// nesting limit of a root node, zero for JSON_DEFAULT_MAX_DEPTH
 	int				memberCount;			// number of actual members
-	int				memberIndex;			// mutable member index for faster lookups
+	union
+	{
+		struct
+		{
+			int		membersAllocated;		// number of allocated members
+			int		padding;				// keeps the size the same between 32-bit and 64-bit
+		};
+		struct ksJsonArena *	arena;		// arena of a leaf node or an object/array without members
+	};
 } ksJson;
 
-static ksJson * ksJson_Create()
+/*
+================================================================================================
+
+Arena
+
+All nodes, member maps and strings of a DOM created with ksJson_CreateWithArena() are
+allocated from a chain of blocks owned by the root node. Nothing is freed individually.
+Destroying the DOM releases all blocks at once. Clearing the root node, for instance by
+reading a new document into it, rewinds the arena so the blocks are reused. If a document
+needed more than one block, the blocks are coalesced into a single block on rewind.
+
+Objects and arrays with members keep the arena pointer in a slot in front of the member map,
+next to the slot of the hash index. All other nodes keep it in the 'arena' field.
+
+Member names are interned per arena. Every distinct name is stored once and all members with
+that name share the same pointer, so arrays of objects with the same members only store their
+names once. ksJson_GetMemberByName() looks up the name in the table of the arena first, and
+then compares the member names by pointer. A name that is not in the table is not the name of
+any member. The table is cleared when the arena is rewound. Names are not interned without an
+arena, where each member owns and frees its own name.
+
+================================================================================================
+*/
+
+typedef struct ksJsonArenaBlock
+{
+	struct ksJsonArenaBlock *	next;
+	size_t						size;		// number of bytes following this header
+} ksJsonArenaBlock;
+
+typedef struct ksJsonArena
+{
+	ksJson				root;				// must be first, the root node is part of the arena
+	ksJsonArenaBlock *	blocks;				// most recently added block first
+	char *				current;
+	char *				end;
+	size_t				blockSize;
+	int					indexLock;			// held while a hash index is allocated from the arena
+	// Only arena DOMs intern names. A DOM created with ksJson_Create() has no arena and no table.
+	// There every member owns its name and frees it with the member, so a heap DOM still stores
+	// one copy of the name per member, and lookups by name compare strings instead of pointers.
+	struct ksJsonName *	names;				// interned member names
+	uint32_t			nameMask;			// number of name entries minus one
+	uint32_t			nameCount;
+} ksJsonArena;
+
+typedef struct ksJsonName
+{
+	uint32_t		hash;
+	const char *	name;					// NULL for an empty entry
+} ksJsonName;
+
+#define JSON_ARENA_MIN_NAMES			64	// power of two
+
+#define JSON_ARENA_DEFAULT_BLOCK_SIZE	( 64 * 1024 )
+
+// Allocations are rounded up to 8 bytes, so every allocation is 8-byte aligned.
+static inline size_t ksJsonArena_RoundSize( const size_t size )
+{
+	return ( size + 7 ) & ~(size_t)7;
+}
+
+static void * ksJsonArena_Alloc( ksJsonArena * arena, size_t size )
+{
+	size = ksJsonArena_RoundSize( size );
+	if ( (size_t)( arena->end - arena->current ) < size )
+	{
+		const size_t blockSize = JSON_MAX( arena->blockSize, size );
+		ksJsonArenaBlock * block = (ksJsonArenaBlock *) malloc( sizeof( ksJsonArenaBlock ) + blockSize );
+		block->size = blockSize;
+		if ( size > arena->blockSize / 2 && arena->blocks != NULL )
+		{
+			// Large allocations get a block of their own and the current block stays in use.
+			block->next = arena->blocks->next;
+			arena->blocks->next = block;
+			return block + 1;
+		}
+		block->next = arena->blocks;
+		arena->blocks = block;
+		arena->current = (char *)( block + 1 );
+		arena->end = arena->current + blockSize;
+	}
+	void * ptr = arena->current;
+	arena->current += size;
+	return ptr;
+}
+
+static void ksJsonArena_Rewind( ksJsonArena * arena )
+{
+	if ( arena->names != NULL )
+	{
+		memset( arena->names, 0, ( arena->nameMask + 1 ) * sizeof( ksJsonName ) );
+		arena->nameCount = 0;
+	}
+	if ( arena->blocks == NULL )
+	{
+		return;
+	}
+	if ( arena->blocks->next != NULL )
+	{
+		size_t totalSize = 0;
+		for ( ksJsonArenaBlock * block = arena->blocks; block != NULL; )
+		{
+			ksJsonArenaBlock * next = block->next;
+			totalSize += block->size;
+			free( block );
+			block = next;
+		}
+		arena->blocks = (ksJsonArenaBlock *) malloc( sizeof( ksJsonArenaBlock ) + totalSize );
+		arena->blocks->next = NULL;
+		arena->blocks->size = totalSize;
+	}
+	arena->current = (char *)( arena->blocks + 1 );
+	arena->end = arena->current + arena->blocks->size;
+}
+
+static ksJsonArena * ksJson_GetArena( const ksJson * node )
+{
+	if ( ( node->flags & JSON_FLAG_ARENA ) == 0 )
+	{
+		return NULL;
+	}
+	if ( ( node->type == JSON_OBJECT || node->type == JSON_ARRAY ) && node->memberCount > 0 )
+	{
+		return ( (ksJsonArena **)node->memberMap )[-1];
+	}
+	return node->arena;
+}
+
+static void * ksJson_Alloc( ksJsonArena * arena, const size_t size )
+{
+	return ( arena != NULL ) ? ksJsonArena_Alloc( arena, size ) : malloc( size );
+}
+
+static char * ksJson_StringDup( ksJsonArena * arena, const char * string )
+{
+	const size_t length = strlen( string );
+	char * copy = (char *) ksJson_Alloc( arena, length + 1 );
+	memcpy( copy, string, length + 1 );
+	return copy;
+}
+
+// FNV-1a
+static uint32_t ksJson_HashName( const char * name )
+{
+	uint32_t hash = 2166136261u;
+	for ( ; name[0] != '\0'; name++ )
+	{
+		hash = ( hash ^ (unsigned char)name[0] ) * 16777619u;
+	}
+	return hash;
+}
+
+// Returns the interned copy of 'name' or NULL if no member has this name.
+static const char * ksJsonArena_FindName( const ksJsonArena * arena, const char * name, const uint32_t hash )
+{
+	if ( arena->names == NULL )
+	{
+		return NULL;
+	}
+	for ( uint32_t entry = hash & arena->nameMask; arena->names[entry].name != NULL; entry = ( entry + 1 ) & arena->nameMask )
+	{
+		if ( arena->names[entry].hash == hash && strcmp( arena->names[entry].name, name ) == 0 )
+		{
+			return arena->names[entry].name;
+		}
+	}
+	return NULL;
+}
+
+static void ksJsonArena_InsertName( ksJsonArena * arena, const char * name, const uint32_t hash )
+{
+	if ( ( arena->nameCount + 1 ) * 2 > arena->nameMask + 1 || arena->names == NULL )
+	{
+		// Keep the table at most half full.
+		const uint32_t oldCount = ( arena->names != NULL ) ? arena->nameMask + 1 : 0;
+		const uint32_t newCount = JSON_MAX( oldCount * 2, (uint32_t)JSON_ARENA_MIN_NAMES );
+		ksJsonName * oldNames = arena->names;
+		arena->names = (ksJsonName *) calloc( newCount, sizeof( ksJsonName ) );
+		arena->nameMask = newCount - 1;
+		for ( uint32_t i = 0; i < oldCount; i++ )
+		{
+			if ( oldNames[i].name != NULL )
+			{
+				uint32_t entry = oldNames[i].hash & arena->nameMask;
+				while ( arena->names[entry].name != NULL )
+				{
+					entry = ( entry + 1 ) & arena->nameMask;
+				}
+				arena->names[entry] = oldNames[i];
+			}
+		}
+		free( oldNames );
+	}
+	uint32_t entry = hash & arena->nameMask;
+	while ( arena->names[entry].name != NULL )
+	{
+		entry = ( entry + 1 ) & arena->nameMask;
+	}
+	arena->names[entry].hash = hash;
+	arena->names[entry].name = name;
+	arena->nameCount++;
+}
+
+// Returns the interned copy of a name that was just allocated from the arena or borrowed from
+// the buffer. If the name is already interned and it was the last allocation, it is released.
+static char * ksJsonArena_InternName( ksJsonArena * arena, char * name )
+{
+	const uint32_t hash = ksJson_HashName( name );
+	const char * interned = ksJsonArena_FindName( arena, name, hash );
+	if ( interned == NULL )
+	{
+		ksJsonArena_InsertName( arena, name, hash );
+		return name;
+	}
+	const size_t size = ksJsonArena_RoundSize( strlen( name ) + 1 );
+	if ( name >= (char *)( arena->blocks + 1 ) && name + size == arena->current )
+	{
+		arena->current = name;
+	}
+	return (char *)interned;
+}
+
+static char * ksJson_InternName( ksJsonArena * arena, char * name )
+{
+	return ( arena != NULL ) ? ksJsonArena_InternName( arena, name ) : name;
+}
+
+#define JSON_BYTES_HEADER		sizeof( uint64_t )	// length in front of a byte string
+
+// Allocates a byte string of 'length' bytes plus a trailing zero.
+static char * ksJson_AllocBytes( ksJsonArena * arena, const size_t length )
+{
+	char * bytes = (char *) ksJson_Alloc( arena, JSON_BYTES_HEADER + length + 1 );
+	const uint64_t header = length;
+	memcpy( bytes, &header, sizeof( header ) );
+	return bytes + JSON_BYTES_HEADER;
+}
+
+static size_t ksJson_GetBytesLength( const ksJson * node )
+{
+	uint64_t header;
+	memcpy( &header, node->valueString - JSON_BYTES_HEADER, sizeof( header ) );
+	return (size_t)header;
+}
+
+[[maybe_unused]] static ksJson * ksJson_Create()
 {
 	ksJson * json = (ksJson *) calloc( 1, sizeof( ksJson ) );
 	json->valueString = (char *)"null";
@@ -486,6 +1042,18 @@ static ksJson * ksJson_Create()
 	return json;
 }
 
+// A 'blockSize' of zero selects JSON_ARENA_DEFAULT_BLOCK_SIZE.
+[[maybe_unused]] static ksJson * ksJson_CreateWithArena( const size_t blockSize )
+{
+	ksJsonArena * arena = (ksJsonArena *) calloc( 1, sizeof( ksJsonArena ) );
+	arena->blockSize = ( blockSize > 0 ) ? blockSize : JSON_ARENA_DEFAULT_BLOCK_SIZE;
+	arena->root.valueString = (char *)"null";
+	arena->root.type = JSON_NULL;
+	arena->root.flags = JSON_FLAG_ARENA;
+	arena->root.arena = arena;
+	return &arena->root;
+}
+
 static int MemberIndexToMapIndex( int index )
 {
 	index >>= JSON_BASE_ALLOC_PWR;
@@ -525,23 +1093,244 @@ static int MapMemberCount( int mapIndex, int memberCount )
 	return JSON_MIN( ( 1 << ( JSON_BASE_ALLOC_PWR + mapIndex ) ), memberCount ) - MapMemberOffset( mapIndex );
 }
 
+/*
+================================================================================================
+
+Hash index
+
+Looking up a member by name is a linear search, unless members are looked up in the order
+they are stored. Objects with at least JSON_HASH_INDEX_MIN_MEMBERS members therefore get an
+open-addressing hash table of their member names, which is built by the first lookup by name.
+Every entry stores the hash of a name next to the index of the member, so a lookup only compares
+names with the same hash. Smaller objects never get an index and pay nothing for it.
+
+The index is allocated like the rest of the DOM, with malloc or from the arena, and is stored
+in a slot in front of the member map. Adding or removing a member updates the index in place.
+Only when the index would become more than half full is it discarded, and the next lookup
+builds a larger one. Because any number of threads may look up members concurrently, an index
+is published atomically. Without an arena, threads that race to build the same index each
+build one and all but the first discard theirs. With an arena, only one index is allocated
+at a time, and a lookup that finds the arena busy searches linearly instead of waiting.
+
+================================================================================================
+*/
+
+#if defined( __cplusplus )
+	#define JSON_ATOMIC_LOAD( ptr )						std::atomic_ref( *(ptr) ).load( std::memory_order_acquire )
+	#define JSON_ATOMIC_STORE( ptr, value )				std::atomic_ref( *(ptr) ).store( value, std::memory_order_release )
+	#define JSON_ATOMIC_EXCHANGE( ptr, value )			std::atomic_ref( *(ptr) ).exchange( value, std::memory_order_acquire )
+	#define JSON_ATOMIC_CAS( ptr, expected, desired )	std::atomic_ref( *(ptr) ).compare_exchange_strong( expected, desired, std::memory_order_acq_rel, std::memory_order_acquire )
+#else
+	#define JSON_ATOMIC_LOAD( ptr )						__atomic_load_n( ptr, __ATOMIC_ACQUIRE )
+	#define JSON_ATOMIC_STORE( ptr, value )				__atomic_store_n( ptr, value, __ATOMIC_RELEASE )
+	#define JSON_ATOMIC_EXCHANGE( ptr, value )			__atomic_exchange_n( ptr, value, __ATOMIC_ACQUIRE )
+	#define JSON_ATOMIC_CAS( ptr, expected, desired )	__atomic_compare_exchange_n( ptr, &(expected), desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE )
+#endif
+
+#define JSON_MAP_HEADER					2	// hash index and arena pointer in front of the member map
+#define JSON_HASH_INDEX_MIN_MEMBERS		32
+
+typedef struct ksJsonHashEntry
+{
+	uint32_t		hash;
+	int				memberIndex;			// -1 for an empty entry
+} ksJsonHashEntry;
+
+typedef struct ksJsonHashIndex
+{
+	uint32_t		mask;					// number of entries minus one
+	uint32_t		reserved;
+	ksJsonHashEntry	entries[1];
+} ksJsonHashIndex;
+
+static ksJsonHashIndex ** ksJson_GetHashIndexSlot( const ksJson * node )
+{
+	return (ksJsonHashIndex **)( node->memberMap - JSON_MAP_HEADER );
+}
+
+static ksJsonHashIndex * ksJson_BuildHashIndex( const ksJson * node, ksJsonArena * arena )
+{
+	uint32_t entryCount = 1;
+	while ( entryCount < (uint32_t)node->memberCount * 2 )
+	{
+		entryCount <<= 1;
+	}
+	ksJsonHashIndex * index = (ksJsonHashIndex *) ksJson_Alloc( arena, sizeof( ksJsonHashIndex ) + ( entryCount - 1 ) * sizeof( ksJsonHashEntry ) );
+	index->mask = entryCount - 1;
+	index->reserved = 0;
+	memset( index->entries, 0xFF, entryCount * sizeof( ksJsonHashEntry ) );
+
+	// Members are inserted in order, so the first of several members with the same name is found first.
+	const int endMapIndex = MemberIndexToMapIndex( node->memberCount - 1 );
+	for ( int mapIndex = 0; mapIndex <= endMapIndex; mapIndex++ )
+	{
+		const ksJson * members = node->memberMap[mapIndex];
+		const int mapMemberCount = MapMemberCount( mapIndex, node->memberCount );
+		for ( int i = 0; i < mapMemberCount; i++ )
+		{
+			const uint32_t hash = ksJson_HashName( members[i].name );
+			uint32_t entry = hash & index->mask;
+			while ( index->entries[entry].memberIndex >= 0 )
+			{
+				entry = ( entry + 1 ) & index->mask;
+			}
+			index->entries[entry].hash = hash;
+			index->entries[entry].memberIndex = MapMemberOffset( mapIndex ) + i;
+		}
+	}
+	return index;
+}
+
+// Returns the hash index of an object, building it if needed.
+// Returns NULL if the object is too small for an index or the arena is busy building another index.
+static const ksJsonHashIndex * ksJson_GetHashIndex( const ksJson * node )
+{
+	if ( node->memberCount < JSON_HASH_INDEX_MIN_MEMBERS )
+	{
+		return NULL;
+	}
+	ksJsonHashIndex ** slot = ksJson_GetHashIndexSlot( node );
+	ksJsonHashIndex * index = JSON_ATOMIC_LOAD( slot );
+	if ( index != NULL )
+	{
+		return index;
+	}
+	ksJsonArena * arena = ksJson_GetArena( node );
+	if ( arena != NULL )
+	{
+		if ( JSON_ATOMIC_EXCHANGE( &arena->indexLock, 1 ) != 0 )
+		{
+			return NULL;
+		}
+		index = JSON_ATOMIC_LOAD( slot );
+		if ( index == NULL )
+		{
+			index = ksJson_BuildHashIndex( node, arena );
+			JSON_ATOMIC_STORE( slot, index );
+		}
+		JSON_ATOMIC_STORE( &arena->indexLock, 0 );
+		return index;
+	}
+	index = ksJson_BuildHashIndex( node, NULL );
+	ksJsonHashIndex * expected = NULL;
+	if ( !JSON_ATOMIC_CAS( slot, expected, index ) )
+	{
+		free( index );
+		return expected;
+	}
+	return index;
+}
+
+// Discards the hash index of an object with members that is about to change.
+static void ksJson_DropHashIndex( ksJson * node )
+{
+	ksJsonHashIndex ** slot = ksJson_GetHashIndexSlot( node );
+	if ( *slot != NULL )
+	{
+		if ( ( node->flags & JSON_FLAG_ARENA ) == 0 )
+		{
+			free( *slot );
+		}
+		*slot = NULL;
+	}
+}
+
+// Adds a member that was just added and named to the hash index of the object, if it has one.
+static void ksJson_IndexMember( ksJson * node, const int memberIndex )
+{
+	ksJsonHashIndex * index = *ksJson_GetHashIndexSlot( node );
+	if ( index == NULL )
+	{
+		return;
+	}
+	if ( (uint32_t)node->memberCount * 2 > index->mask + 1 )
+	{
+		ksJson_DropHashIndex( node );
+		return;
+	}
+	const int mapIndex = MemberIndexToMapIndex( memberIndex );
+	const uint32_t hash = ksJson_HashName( node->memberMap[mapIndex][memberIndex - MapMemberOffset( mapIndex )].name );
+	uint32_t entry = hash & index->mask;
+	while ( index->entries[entry].memberIndex >= 0 )
+	{
+		entry = ( entry + 1 ) & index->mask;
+	}
+	index->entries[entry].hash = hash;
+	index->entries[entry].memberIndex = memberIndex;
+}
+
+// Deletes the entry of a member from a hash index without renumbering the other members.
+static void ksJson_DeleteHashEntry( ksJsonHashIndex * index, const uint32_t hash, const int memberIndex )
+{
+	uint32_t entry = hash & index->mask;
+	while ( index->entries[entry].memberIndex != memberIndex )
+	{
+		entry = ( entry + 1 ) & index->mask;
+	}
+	// Move later entries of the same cluster back into the gap, unless that would put
+	// them in front of the slot their hash maps to.
+	for ( uint32_t next = ( entry + 1 ) & index->mask; index->entries[next].memberIndex >= 0; next = ( next + 1 ) & index->mask )
+	{
+		const uint32_t home = index->entries[next].hash & index->mask;
+		if ( ( ( next - home ) & index->mask ) >= ( ( next - entry ) & index->mask ) )
+		{
+			index->entries[entry] = index->entries[next];
+			entry = next;
+		}
+	}
+	index->entries[entry].memberIndex = -1;
+}
+
+// Removes a member that is about to be removed from the hash index of the object, if it has one,
+// and renumbers the members after it.
+static void ksJson_UnindexMember( ksJson * node, const int memberIndex )
+{
+	ksJsonHashIndex * index = *ksJson_GetHashIndexSlot( node );
+	if ( index == NULL )
+	{
+		return;
+	}
+	const int mapIndex = MemberIndexToMapIndex( memberIndex );
+	ksJson_DeleteHashEntry( index, ksJson_HashName( node->memberMap[mapIndex][memberIndex - MapMemberOffset( mapIndex )].name ), memberIndex );
+	for ( uint32_t i = 0; i <= index->mask; i++ )
+	{
+		if ( index->entries[i].memberIndex > memberIndex )
+		{
+			index->entries[i].memberIndex--;
+		}
+	}
+}
+
+// The hash index of an object is kept. The caller adds the member to it once it is named.
 static ksJson * ksJson_AllocMember( ksJson * node )
 {
+	ksJsonArena * arena = ksJson_GetArena( node );
+	if ( node->memberCount == 0 )
+	{
+		node->membersAllocated = 0;		// may have held the arena pointer
+		node->padding = 0;
+	}
 	const int mapIndex = MemberIndexToMapIndex( node->memberCount );
 	if ( node->memberCount >= node->membersAllocated )
 	{
 		if ( ( mapIndex & ( JSON_MAP_GRANULARITY - 1 ) ) == 0 )
 		{
-			ksJson ** newMemberMap = (ksJson **) malloc( ( mapIndex + JSON_MAP_GRANULARITY ) * sizeof( ksJson * ) );
+			void ** header = (void **) ksJson_Alloc( arena, ( JSON_MAP_HEADER + mapIndex + JSON_MAP_GRANULARITY ) * sizeof( ksJson * ) );
+			header[0] = ( mapIndex > 0 ) ? *ksJson_GetHashIndexSlot( node ) : NULL;		// hash index
+			header[1] = arena;
+			ksJson ** newMemberMap = (ksJson **)( header + JSON_MAP_HEADER );
 			if ( mapIndex > 0 )
 			{
 				memcpy( newMemberMap, node->memberMap, mapIndex * sizeof( ksJson * ) );
-				free( node->memberMap );
+				if ( arena == NULL )
+				{
+					free( node->memberMap - JSON_MAP_HEADER );
+				}
 			}
 			node->memberMap = newMemberMap;
 		}
 		const int mapSize = JSON_MAX( MapMemberOffset( mapIndex ), ( 1 << JSON_BASE_ALLOC_PWR ) );
-		node->memberMap[mapIndex] = (ksJson *) malloc( mapSize * sizeof( ksJson ) );
+		node->memberMap[mapIndex] = (ksJson *) ksJson_Alloc( arena, mapSize * sizeof( ksJson ) );
 		node->membersAllocated += mapSize;
 	}
 	const int memberOffset = MapMemberOffset( mapIndex );
@@ -550,25 +1339,57 @@ static ksJson * ksJson_AllocMember( ksJson * node )
 	member->valueInt64 = 0;
 	member->valueString = (char *)"null";
 	member->type = JSON_NULL;
-	member->membersAllocated = 0;
+	member->flags = node->flags & JSON_FLAG_ARENA;
+	member->maxDepth = 0;
 	member->memberCount = 0;
-	member->memberIndex = 0;
+	member->membersAllocated = 0;
+	member->padding = 0;
+	if ( arena != NULL )
+	{
+		member->arena = arena;
+	}
 	return member;
 }
 
 static void ksJson_FreeNode( ksJson * node, const bool freeName )
 {
 	assert( node->type >= JSON_NULL && node->type <= JSON_ARRAY );		// stale ksJson pointer?
+	ksJsonArena * arena = ksJson_GetArena( node );
+	if ( arena != NULL )
+	{
+		// Arena memory is only released as a whole.
+		if ( freeName )
+		{
+			node->name = NULL;
+			node->flags &= ~JSON_FLAG_BORROWED_NAME;
+		}
+		node->flags &= ~( JSON_FLAG_BORROWED_VALUE | JSON_FLAG_SINGLE | JSON_FLAG_BYTES );
+		if ( node == &arena->root )
+		{
+			ksJsonArena_Rewind( arena );
+		}
+		node->valueInt64 = 0;
+		node->valueString = (char *)"null";
+		node->type = JSON_NULL;
+		node->memberCount = 0;
+		node->arena = arena;
+		return;
+	}
 	if ( freeName )
 	{
-		free( node->name );
+		if ( ( node->flags & JSON_FLAG_BORROWED_NAME ) == 0 )
+		{
+			free( node->name );
+		}
 		node->name = NULL;
+		node->flags &= ~JSON_FLAG_BORROWED_NAME;
 	}
 	if ( node->type == JSON_OBJECT || node->type == JSON_ARRAY )
 	{
 		if ( node->memberCount > 0 )
 		{
-			const int endMapIndex = MemberIndexToMapIndex( node->memberCount - 1 );
+			// Removed members may have left member maps allocated at the end.
+			const int endMapIndex = MemberIndexToMapIndex( node->membersAllocated - 1 );
 			for ( int mapIndex = 0; mapIndex <= endMapIndex; mapIndex++ )
 			{
 				ksJson * members = node->memberMap[mapIndex];
@@ -579,51 +1400,392 @@ static void ksJson_FreeNode( ksJson * node, const bool freeName )
 				}
 				free( members );
 			}
-			free( node->memberMap );
+			free( *ksJson_GetHashIndexSlot( node ) );
+			free( node->memberMap - JSON_MAP_HEADER );
 		}
 	}
-	else if ( node->type == JSON_STRING )
+	else if ( node->type == JSON_STRING && ( node->flags & JSON_FLAG_BYTES ) != 0 )
+	{
+		free( node->valueString - JSON_BYTES_HEADER );
+	}
+	else if ( node->type == JSON_STRING && ( node->flags & JSON_FLAG_BORROWED_VALUE ) == 0 )
 	{
 		free( node->valueString );
 	}
+	node->flags &= ~( JSON_FLAG_BORROWED_VALUE | JSON_FLAG_SINGLE | JSON_FLAG_BYTES );
 	node->valueInt64 = 0;
 	node->valueString = (char *)"null";
 	node->type = JSON_NULL;
 	node->membersAllocated = 0;
 	node->memberCount = 0;
-	node->memberIndex = 0;
+	node->padding = 0;
 }
 
 static inline void ksJson_Destroy( ksJson * rootNode )
 {
 	if ( rootNode != NULL /* && is an actual root */ )
 	{
+		ksJsonArena * arena = ksJson_GetArena( rootNode );
+		if ( arena != NULL )
+		{
+			assert( rootNode == &arena->root );
+			for ( ksJsonArenaBlock * block = arena->blocks; block != NULL; )
+			{
+				ksJsonArenaBlock * next = block->next;
+				free( block );
+				block = next;
+			}
+			free( arena->names );
+			free( arena );
+			return;
+		}
 		ksJson_FreeNode( rootNode, true );
 		free( rootNode );
 	}
 }
 
-// Parses white space.
-// Returns a pointer to the first character after the white space.
-static const char * ksJson_ParseWhiteSpace( const char * buffer )
+// Clears the DOM to null. The blocks of an arena DOM are kept for the next document.
+[[maybe_unused]] static inline void ksJson_Reset( ksJson * rootNode )
 {
-	while ( buffer[0] != '\0' && (unsigned char)buffer[0] <= ' ' )
+	if ( rootNode != NULL )
 	{
-		buffer++;
+		ksJson_FreeNode( rootNode, true );
 	}
-	return buffer;
 }
 
-// Parses a hexadecimal string up to four digits and stores the integer result in 'value'.
-// Returns a pointer to the first character after the string.
-static const char * ksJson_ParseHex4( unsigned int * value, const char * buffer )
+// Limits the nesting of objects and arrays in documents that are read into or written from
+// 'rootNode'. Reading a deeper document fails, while deeper nodes are written as null.
+[[maybe_unused]] static inline void ksJson_SetMaxDepth( ksJson * rootNode, const int maxDepth )
 {
-	int v = 0;
-	for( unsigned int digit = 0; digit < 4; digit++, buffer++ )
+	if ( rootNode != NULL )
 	{
-		unsigned int d = buffer[0];
+		rootNode->maxDepth = (uint16_t)JSON_CLAMP( maxDepth, 1, UINT16_MAX );
+	}
+}
 
-		if ( ( d >= '0' ) && ( d <= '9' ) ) d = d - '0';
+static inline int ksJson_GetMaxDepth( const ksJson * rootNode )
+{
+	return ( rootNode->maxDepth != 0 ) ? rootNode->maxDepth : JSON_DEFAULT_MAX_DEPTH;
+}
+
+/*
+================================================================================================
+
+SIMD scanning
+
+White space runs and the plain parts of strings are skipped 16 or 32 bytes at a time.
+The text is only zero terminated, so a vector load may read past the end of the text.
+Loads are therefore only issued when they do not cross a 4 kB page boundary, which
+guarantees they do not touch memory that is not mapped. Close to a page boundary a
+single byte is handled at a time. The bytes read past the terminating zero are never
+used, but address and thread sanitizers do not know that.
+
+SSE2 and NEON are part of the respective base instruction sets. The AVX2 path is
+compiled for every x86 target and selected at run-time. Define JSON_NO_SIMD to only
+use the scalar code.
+
+================================================================================================
+*/
+
+#if defined( _MSC_VER )
+	#define JSON_NO_SANITIZE			__declspec( no_sanitize_address )
+#elif defined( __GNUC__ )
+	#define JSON_NO_SANITIZE			__attribute__(( no_sanitize_address, no_sanitize_thread ))
+#else
+	#define JSON_NO_SANITIZE
+#endif
+
+#if defined( _MSC_VER ) && !defined( __clang__ )
+	#define JSON_TARGET_AVX2
+#else
+	#define JSON_TARGET_AVX2			__attribute__(( target( "avx2" ) ))
+#endif
+
+#define JSON_PAGE_SAFE( ptr, bytes )	( ( (uintptr_t)( ptr ) & 4095 ) <= 4096 - ( bytes ) )
+
+#if defined( JSON_SIMD_AVX2 ) && defined( _MSC_VER )
+// AVX2 needs the CPUID.7.0:EBX bit 5 and an OS that saves the YMM registers, which means
+// OSXSAVE and AVX in CPUID.1:ECX, and the SSE and AVX state bits in XCR0.
+static inline bool ksJson_DetectAvx2()
+{
+	int info[4];
+	__cpuid( info, 0 );
+	if ( info[0] < 7 )
+	{
+		return false;
+	}
+	__cpuid( info, 1 );
+	const int osxsaveAvx = ( 1 << 27 ) | ( 1 << 28 );
+	if ( ( info[2] & osxsaveAvx ) != osxsaveAvx || ( _xgetbv( 0 ) & 6 ) != 6 )
+	{
+		return false;
+	}
+	__cpuidex( info, 7, 0 );
+	return ( info[1] & ( 1 << 5 ) ) != 0;
+}
+#endif
+
+static inline bool ksJson_CpuHasAvx2()
+{
+#if !defined( JSON_SIMD_AVX2 )
+	return false;
+#elif defined( _MSC_VER )
+	// Detected once, threads that race here store the same value.
+	static volatile int hasAvx2 = -1;
+	if ( hasAvx2 < 0 )
+	{
+		hasAvx2 = ksJson_DetectAvx2();
+	}
+	return hasAvx2 != 0;
+#else
+	return __builtin_cpu_supports( "avx2" );
+#endif
+}
+
+static inline int ksJson_CountTrailingZeros( uint64_t value )
+{
+	assert( value != 0 );
+#if defined( _MSC_VER ) && !defined( __clang__ ) && ( defined( _M_X64 ) || defined( _M_ARM64 ) )
+	unsigned long index;
+	_BitScanForward64( &index, value );
+	return (int)index;
+#elif defined( _MSC_VER ) && !defined( __clang__ )
+	unsigned long index;
+	if ( _BitScanForward( &index, (unsigned long)value ) )
+	{
+		return (int)index;
+	}
+	_BitScanForward( &index, (unsigned long)( value >> 32 ) );
+	return (int)index + 32;
+#else
+	return __builtin_ctzll( value );
+#endif
+}
+
+// Byte classes: white space is [1, 32], a string is interrupted by a quote, a backslash or zero.
+#define JSON_IS_WHITE_SPACE( c )	( (unsigned char)( (c) - 1 ) < ' ' )
+#define JSON_IS_STRING_SPECIAL( c )	( (c) == '\"' || (c) == '\\' || (c) == '\0' )
+
+#if defined( JSON_SIMD_SSE2 )
+
+// Returns a bit mask of the 16 bytes that are not white space.
+JSON_NO_SANITIZE static inline uint32_t ksJson_NonWhiteSpaceMask_SSE2( const char * buffer )
+{
+	const __m128i v = _mm_loadu_si128( (const __m128i *)buffer );
+	const __m128i space = _mm_set1_epi8( ' ' );
+	const __m128i white = _mm_andnot_si128( _mm_cmpeq_epi8( v, _mm_setzero_si128() ), _mm_cmpeq_epi8( _mm_max_epu8( v, space ), space ) );
+	return ~(uint32_t)_mm_movemask_epi8( white ) & 0xFFFF;
+}
+
+// Returns a bit mask of the quotes, backslashes and zeros in 16 bytes.
+JSON_NO_SANITIZE static inline uint32_t ksJson_StringSpecialMask_SSE2( const char * buffer )
+{
+	const __m128i v = _mm_loadu_si128( (const __m128i *)buffer );
+	const __m128i quote = _mm_cmpeq_epi8( v, _mm_set1_epi8( '\"' ) );
+	const __m128i backslash = _mm_cmpeq_epi8( v, _mm_set1_epi8( '\\' ) );
+	const __m128i zero = _mm_cmpeq_epi8( v, _mm_setzero_si128() );
+	return (uint32_t)_mm_movemask_epi8( _mm_or_si128( _mm_or_si128( quote, backslash ), zero ) );
+}
+
+// Returns a bit mask of the 32 bytes that are not white space.
+JSON_TARGET_AVX2 JSON_NO_SANITIZE static inline uint32_t ksJson_NonWhiteSpaceMask_AVX2( const char * buffer )
+{
+	const __m256i v = _mm256_loadu_si256( (const __m256i *)buffer );
+	const __m256i space = _mm256_set1_epi8( ' ' );
+	const __m256i white = _mm256_andnot_si256( _mm256_cmpeq_epi8( v, _mm256_setzero_si256() ), _mm256_cmpeq_epi8( _mm256_max_epu8( v, space ), space ) );
+	return ~(uint32_t)_mm256_movemask_epi8( white );
+}
+
+// Returns a bit mask of the quotes, backslashes and zeros in 32 bytes.
+JSON_TARGET_AVX2 JSON_NO_SANITIZE static inline uint32_t ksJson_StringSpecialMask_AVX2( const char * buffer )
+{
+	const __m256i v = _mm256_loadu_si256( (const __m256i *)buffer );
+	const __m256i quote = _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '\"' ) );
+	const __m256i backslash = _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '\\' ) );
+	const __m256i zero = _mm256_cmpeq_epi8( v, _mm256_setzero_si256() );
+	return (uint32_t)_mm256_movemask_epi8( _mm256_or_si256( _mm256_or_si256( quote, backslash ), zero ) );
+}
+
+#define JSON_SIMD_WIDTH				16
+#define JSON_NON_WHITE_SPACE_MASK	ksJson_NonWhiteSpaceMask_SSE2
+#define JSON_STRING_SPECIAL_MASK	ksJson_StringSpecialMask_SSE2
+
+#elif defined( JSON_SIMD_NEON )
+
+// Narrows a byte comparison result to a mask with 4 bits per byte.
+static inline uint64_t ksJson_NeonMask( const uint8x16_t cmp )
+{
+	return vget_lane_u64( vreinterpret_u64_u8( vshrn_n_u16( vreinterpretq_u16_u8( cmp ), 4 ) ), 0 );
+}
+
+// Returns a mask with 4 bits for each of the 16 bytes that is not white space.
+JSON_NO_SANITIZE static inline uint64_t ksJson_NonWhiteSpaceMask_NEON( const char * buffer )
+{
+	const uint8x16_t v = vld1q_u8( (const uint8_t *)buffer );
+	return ~ksJson_NeonMask( vandq_u8( vcleq_u8( v, vdupq_n_u8( ' ' ) ), vtstq_u8( v, v ) ) );
+}
+
+// Returns a mask with 4 bits for each quote, backslash and zero in 16 bytes.
+JSON_NO_SANITIZE static inline uint64_t ksJson_StringSpecialMask_NEON( const char * buffer )
+{
+	const uint8x16_t v = vld1q_u8( (const uint8_t *)buffer );
+	const uint8x16_t quote = vceqq_u8( v, vdupq_n_u8( '\"' ) );
+	const uint8x16_t backslash = vceqq_u8( v, vdupq_n_u8( '\\' ) );
+	const uint8x16_t zero = vceqq_u8( v, vdupq_n_u8( 0 ) );
+	return ksJson_NeonMask( vorrq_u8( vorrq_u8( quote, backslash ), zero ) );
+}
+
+#define JSON_SIMD_WIDTH				16
+#define JSON_NON_WHITE_SPACE_MASK	ksJson_NonWhiteSpaceMask_NEON
+#define JSON_STRING_SPECIAL_MASK	ksJson_StringSpecialMask_NEON
+
+#endif
+
+#if defined( JSON_SIMD_NEON )
+	#define JSON_MASK_TO_OFFSET( mask )	( ksJson_CountTrailingZeros( mask ) >> 2 )
+#else
+	#define JSON_MASK_TO_OFFSET( mask )	ksJson_CountTrailingZeros( mask )
+#endif
+
+// Loops over 'width' bytes at a time until 'maskFunc' finds a byte. Close to a page boundary
+// a single byte is tested with 'scalarTest' instead.
+#define JSON_SIMD_SCAN_LOOP( buffer, width, maskFunc, scalarTest )		\
+	for ( ; ; )															\
+	{																	\
+		if ( JSON_PAGE_SAFE( buffer, width ) )							\
+		{																\
+			const uint64_t mask = maskFunc( buffer );					\
+			if ( mask != 0 )											\
+			{															\
+				return buffer + JSON_MASK_TO_OFFSET( mask );			\
+			}															\
+			buffer += width;											\
+		}																\
+		else if ( scalarTest( buffer[0] ) )								\
+		{																\
+			return buffer;												\
+		}																\
+		else															\
+		{																\
+			buffer++;													\
+		}																\
+	}
+
+#define JSON_IS_NOT_WHITE_SPACE( c )	( !JSON_IS_WHITE_SPACE( c ) )
+
+#if defined( JSON_SIMD_WIDTH )
+
+static const char * ksJson_SkipWhiteSpace_Loop( const char * buffer )
+{
+	JSON_SIMD_SCAN_LOOP( buffer, JSON_SIMD_WIDTH, JSON_NON_WHITE_SPACE_MASK, JSON_IS_NOT_WHITE_SPACE )
+}
+
+static const char * ksJson_ScanString_Loop( const char * buffer )
+{
+	JSON_SIMD_SCAN_LOOP( buffer, JSON_SIMD_WIDTH, JSON_STRING_SPECIAL_MASK, JSON_IS_STRING_SPECIAL )
+}
+
+#endif
+
+#if defined( JSON_SIMD_AVX2 )
+
+JSON_TARGET_AVX2 static const char * ksJson_SkipWhiteSpace_AVX2( const char * buffer )
+{
+	JSON_SIMD_SCAN_LOOP( buffer, 32, ksJson_NonWhiteSpaceMask_AVX2, JSON_IS_NOT_WHITE_SPACE )
+}
+
+JSON_TARGET_AVX2 static const char * ksJson_ScanString_AVX2( const char * buffer )
+{
+	JSON_SIMD_SCAN_LOOP( buffer, 32, ksJson_StringSpecialMask_AVX2, JSON_IS_STRING_SPECIAL )
+}
+
+#endif
+
+// Returns a pointer to the first character that is not white space.
+static inline const char * ksJson_SkipWhiteSpace( const char * buffer )
+{
+#if defined( JSON_SIMD_WIDTH )
+	// Most runs are short. The first vector is tested inline, longer runs go to the widest loop available.
+	if ( JSON_PAGE_SAFE( buffer, JSON_SIMD_WIDTH ) )
+	{
+		const uint64_t mask = JSON_NON_WHITE_SPACE_MASK( buffer );
+		if ( mask != 0 )
+		{
+			return buffer + JSON_MASK_TO_OFFSET( mask );
+		}
+		buffer += JSON_SIMD_WIDTH;
+	}
+#if defined( JSON_SIMD_AVX2 )
+	if ( ksJson_CpuHasAvx2() )
+	{
+		return ksJson_SkipWhiteSpace_AVX2( buffer );
+	}
+#endif
+	return ksJson_SkipWhiteSpace_Loop( buffer );
+#else
+	while ( JSON_IS_WHITE_SPACE( buffer[0] ) )
+	{
+		buffer++;
+	}
+	return buffer;
+#endif
+}
+
+// Returns a pointer to the first quote, backslash or terminating zero.
+static inline const char * ksJson_ScanString( const char * buffer )
+{
+#if defined( JSON_SIMD_WIDTH )
+	if ( JSON_PAGE_SAFE( buffer, JSON_SIMD_WIDTH ) )
+	{
+		const uint64_t mask = JSON_STRING_SPECIAL_MASK( buffer );
+		if ( mask != 0 )
+		{
+			return buffer + JSON_MASK_TO_OFFSET( mask );
+		}
+		buffer += JSON_SIMD_WIDTH;
+	}
+#if defined( JSON_SIMD_AVX2 )
+	if ( ksJson_CpuHasAvx2() )
+	{
+		return ksJson_ScanString_AVX2( buffer );
+	}
+#endif
+	return ksJson_ScanString_Loop( buffer );
+#else
+	while ( !JSON_IS_STRING_SPECIAL( buffer[0] ) )
+	{
+		buffer++;
+	}
+	return buffer;
+#endif
+}
+
+// Parses white space.
+// Returns a pointer to the first character after the white space.
+static const char * ksJson_ParseWhiteSpace( const char * buffer )
+{
+	// Compact text has no white space and indented text mostly a single space between tokens.
+	if ( !JSON_IS_WHITE_SPACE( buffer[0] ) )
+	{
+		return buffer;
+	}
+	if ( !JSON_IS_WHITE_SPACE( buffer[1] ) )
+	{
+		return buffer + 1;
+	}
+	return ksJson_SkipWhiteSpace( buffer + 2 );
+}
+
+// Parses a hexadecimal string up to four digits and stores the integer result in 'value'.
+// Returns a pointer to the first character after the string.
+static const char * ksJson_ParseHex4( unsigned int * value, const char * buffer )
+{
+	int v = 0;
+	for( unsigned int digit = 0; digit < 4; digit++, buffer++ )
+	{
+		unsigned int d = buffer[0];
+
+		if ( ( d >= '0' ) && ( d <= '9' ) ) d = d - '0';
 		else if ( ( d >= 'a') && ( d <= 'f' ) ) d = 10 + d - 'a';
 		else if ( ( d >= 'A' ) && ( d <= 'F' ) ) d = 10 + d - 'A';
 		else break;
@@ -659,31 +1821,27 @@ static const unsigned char json_firstByteMark[7] =
 	0x00, 0x00, 0xC0, 0xE0, 0xF0, 0xF8, 0xFC
 };
 
-// Parses a string and stores the result in 'value'.
-// Returns a pointer to the first character after the string.
-static const char * ksJson_ParseString( char ** value, const char * buffer, const char ** errorStringOut )
+// Unescapes the string that starts at 'buffer', just after the opening quote, into '*outInOut'.
+// The unescaped string is never longer than the escaped string, so the output may overlap the input.
+// Advances '*outInOut' to the end of the output and returns a pointer to the closing quote.
+static const char * ksJson_UnescapeString( char ** outInOut, const char * buffer, const char ** errorStringOut )
 {
-	assert( buffer[0] == '\"' );
-	buffer++;
-
-	int length = 0;
-	for ( const char * str = buffer; *str != '\"' && *str != '\0'; length++ )
-	{
-		// Collapse escaped characters and skip escaped quotes.
-		if ( str[0] == '\\' && str[1] != '\0' ) str++;
-		str++;
-	}
-
-	char * out = (char *) malloc( length + 1 );
-	char * outPtr = out;
-
-	while ( buffer[0] != '\"' && buffer[0] != '\0' )
+	char * outPtr = *outInOut;
+	for ( ; ; )
 	{
+		// Copy everything up to the next quote or escape at once.
+		const char * run = ksJson_ScanString( buffer );
+		if ( outPtr != buffer )
+		{
+			memmove( outPtr, buffer, run - buffer );
+		}
+		outPtr += run - buffer;
+		buffer = run;
 		if ( buffer[0] != '\\' )
 		{
-			*outPtr++ = *buffer++;
+			break;
 		}
-		else if ( json_escape[(unsigned char)buffer[1]] )
+		if ( json_escape[(unsigned char)buffer[1]] )
 		{
 			*outPtr++ = json_escape[(unsigned char)buffer[1]];
 			buffer += 2;
@@ -703,7 +1861,6 @@ static const char * ksJson_ParseString( char ** value, const char * buffer, cons
 					buffer = ksJson_ParseHex4( &uc2, buffer + 2 );
 					if ( uc2 < 0xDC00 || uc2 > 0xDFFF )
 					{
-						free( out );
 						*errorStringOut = "invalid unicode";
 						return buffer;
 					}
@@ -726,131 +1883,169 @@ static const char * ksJson_ParseString( char ** value, const char * buffer, cons
 		}
 		else
 		{
+			// Unknown escape, keep only the escaped character so the output is not longer than counted.
+			buffer += ( buffer[1] != '\0' );
 			*outPtr++ = *buffer++;
 		}
 	}
-
-	*outPtr = 0;
-	if ( *buffer != '\"' )
+	if ( buffer[0] != '\"' )
 	{
-		free( out );
 		*errorStringOut = "missing trailing quote";
-		return buffer;
 	}
+	*outInOut = outPtr;
+	return buffer;
+}
+
+// Parses a string and stores the result in 'value'.
+// Returns a pointer to the first character after the string.
+static const char * ksJson_ParseString( char ** value, ksJsonArena * arena, const char * buffer, const char ** errorStringOut )
+{
+	assert( buffer[0] == '\"' );
 	buffer++;
 
-	*value = out;
+	// Collapse escaped characters and skip escaped quotes.
+	int escapes = 0;
+	const char * str = buffer;
+	for ( ; ; )
+	{
+		str = ksJson_ScanString( str );
+		if ( str[0] != '\\' )
+		{
+			break;
+		}
+		escapes += ( str[1] != '\0' );
+		str += 1 + ( str[1] != '\0' );
+	}
+	const int length = (int)( str - buffer ) - escapes;
 
-	return buffer;
+	char * out = (char *) ksJson_Alloc( arena, length + 1 );
+	if ( escapes == 0 )
+	{
+		// Plain strings are copied directly instead of running the unescape pass.
+		memcpy( out, buffer, length );
+		out[length] = '\0';
+		if ( str[0] != '\"' )
+		{
+			*errorStringOut = "missing trailing quote";
+			if ( arena == NULL )
+			{
+				free( out );
+			}
+			return str;
+		}
+		*value = out;
+		return str + 1;
+	}
+	char * outPtr = out;
+	buffer = ksJson_UnescapeString( &outPtr, buffer, errorStringOut );
+	if ( *errorStringOut != NULL )
+	{
+		if ( arena == NULL )
+		{
+			free( out );
+		}
+		return buffer;
+	}
+	*outPtr = '\0';
+	*value = out;
+	return buffer + 1;
 }
 
-// from 10^-308 to 10^+308
-static const double json_pow10[] =
-{
-	1e-308,1e-307,1e-306,1e-305,
-	1e-304,1e-303,1e-302,1e-301,1e-300,1e-299,1e-298,1e-297,1e-296,1e-295,1e-294,1e-293,1e-292,1e-291,1e-290,1e-289,
-	1e-288,1e-287,1e-286,1e-285,1e-284,1e-283,1e-282,1e-281,1e-280,1e-279,1e-278,1e-277,1e-276,1e-275,1e-274,1e-273,
-	1e-272,1e-271,1e-270,1e-269,1e-268,1e-267,1e-266,1e-265,1e-264,1e-263,1e-262,1e-261,1e-260,1e-259,1e-258,1e-257,
-	1e-256,1e-255,1e-254,1e-253,1e-252,1e-251,1e-250,1e-249,1e-248,1e-247,1e-246,1e-245,1e-244,1e-243,1e-242,1e-241,
-	1e-240,1e-239,1e-238,1e-237,1e-236,1e-235,1e-234,1e-233,1e-232,1e-231,1e-230,1e-229,1e-228,1e-227,1e-226,1e-225,
-	1e-224,1e-223,1e-222,1e-221,1e-220,1e-219,1e-218,1e-217,1e-216,1e-215,1e-214,1e-213,1e-212,1e-211,1e-210,1e-209,
-	1e-208,1e-207,1e-206,1e-205,1e-204,1e-203,1e-202,1e-201,1e-200,1e-199,1e-198,1e-197,1e-196,1e-195,1e-194,1e-193,
-	1e-192,1e-191,1e-190,1e-189,1e-188,1e-187,1e-186,1e-185,1e-184,1e-183,1e-182,1e-181,1e-180,1e-179,1e-178,1e-177,
-	1e-176,1e-175,1e-174,1e-173,1e-172,1e-171,1e-170,1e-169,1e-168,1e-167,1e-166,1e-165,1e-164,1e-163,1e-162,1e-161,
-	1e-160,1e-159,1e-158,1e-157,1e-156,1e-155,1e-154,1e-153,1e-152,1e-151,1e-150,1e-149,1e-148,1e-147,1e-146,1e-145,
-	1e-144,1e-143,1e-142,1e-141,1e-140,1e-139,1e-138,1e-137,1e-136,1e-135,1e-134,1e-133,1e-132,1e-131,1e-130,1e-129,
-	1e-128,1e-127,1e-126,1e-125,1e-124,1e-123,1e-122,1e-121,1e-120,1e-119,1e-118,1e-117,1e-116,1e-115,1e-114,1e-113,
-	1e-112,1e-111,1e-110,1e-109,1e-108,1e-107,1e-106,1e-105,1e-104,1e-103,1e-102,1e-101,1e-100, 1e-99, 1e-98, 1e-97,
-	 1e-96, 1e-95, 1e-94, 1e-93, 1e-92, 1e-91, 1e-90, 1e-89, 1e-88, 1e-87, 1e-86, 1e-85, 1e-84, 1e-83, 1e-82, 1e-81,
-	 1e-80, 1e-79, 1e-78, 1e-77, 1e-76, 1e-75, 1e-74, 1e-73, 1e-72, 1e-71, 1e-70, 1e-69, 1e-68, 1e-67, 1e-66, 1e-65,
-	 1e-64, 1e-63, 1e-62, 1e-61, 1e-60, 1e-59, 1e-58, 1e-57, 1e-56, 1e-55, 1e-54, 1e-53, 1e-52, 1e-51, 1e-50, 1e-49,
-	 1e-48, 1e-47, 1e-46, 1e-45, 1e-44, 1e-43, 1e-42, 1e-41, 1e-40, 1e-39, 1e-38, 1e-37, 1e-36, 1e-35, 1e-34, 1e-33,
-	 1e-32, 1e-31, 1e-30, 1e-29, 1e-28, 1e-27, 1e-26, 1e-25, 1e-24, 1e-23, 1e-22, 1e-21, 1e-20, 1e-19, 1e-18, 1e-17,
-	 1e-16, 1e-15, 1e-14, 1e-13, 1e-12, 1e-11, 1e-10,  1e-9,  1e-8,  1e-7,  1e-6,  1e-5,  1e-4,  1e-3,  1e-2,  1e-1,
-	  1e+0,  1e+1,  1e+2,  1e+3,  1e+4,  1e+5,  1e+6,  1e+7,  1e+8,  1e+9, 1e+10, 1e+11, 1e+12, 1e+13, 1e+14, 1e+15,
-	 1e+16, 1e+17, 1e+18, 1e+19, 1e+20, 1e+21, 1e+22, 1e+23, 1e+24, 1e+25, 1e+26, 1e+27, 1e+28, 1e+29, 1e+30, 1e+31,
-	 1e+32, 1e+33, 1e+34, 1e+35, 1e+36, 1e+37, 1e+38, 1e+39, 1e+40, 1e+41, 1e+42, 1e+43, 1e+44, 1e+45, 1e+46, 1e+47,
-	 1e+48, 1e+49, 1e+50, 1e+51, 1e+52, 1e+53, 1e+54, 1e+55, 1e+56, 1e+57, 1e+58, 1e+59, 1e+60, 1e+61, 1e+62, 1e+63,
-	 1e+64, 1e+65, 1e+66, 1e+67, 1e+68, 1e+69, 1e+70, 1e+71, 1e+72, 1e+73, 1e+74, 1e+75, 1e+76, 1e+77, 1e+78, 1e+79,
-	 1e+80, 1e+81, 1e+82, 1e+83, 1e+84, 1e+85, 1e+86, 1e+87, 1e+88, 1e+89, 1e+90, 1e+91, 1e+92, 1e+93, 1e+94, 1e+95,
-	 1e+96, 1e+97, 1e+98, 1e+99,1e+100,1e+101,1e+102,1e+103,1e+104,1e+105,1e+106,1e+107,1e+108,1e+109,1e+110,1e+111,
-	1e+112,1e+113,1e+114,1e+115,1e+116,1e+117,1e+118,1e+119,1e+120,1e+121,1e+122,1e+123,1e+124,1e+125,1e+126,1e+127,
-	1e+128,1e+129,1e+130,1e+131,1e+132,1e+133,1e+134,1e+135,1e+136,1e+137,1e+138,1e+139,1e+140,1e+141,1e+142,1e+143,
-	1e+144,1e+145,1e+146,1e+147,1e+148,1e+149,1e+150,1e+151,1e+152,1e+153,1e+154,1e+155,1e+156,1e+157,1e+158,1e+159,
-	1e+160,1e+161,1e+162,1e+163,1e+164,1e+165,1e+166,1e+167,1e+168,1e+169,1e+170,1e+171,1e+172,1e+173,1e+174,1e+175,
-	1e+176,1e+177,1e+178,1e+179,1e+180,1e+181,1e+182,1e+183,1e+184,1e+185,1e+186,1e+187,1e+188,1e+189,1e+190,1e+191,
-	1e+192,1e+193,1e+194,1e+195,1e+196,1e+197,1e+198,1e+199,1e+200,1e+201,1e+202,1e+203,1e+204,1e+205,1e+206,1e+207,
-	1e+208,1e+209,1e+210,1e+211,1e+212,1e+213,1e+214,1e+215,1e+216,1e+217,1e+218,1e+219,1e+220,1e+221,1e+222,1e+223,
-	1e+224,1e+225,1e+226,1e+227,1e+228,1e+229,1e+230,1e+231,1e+232,1e+233,1e+234,1e+235,1e+236,1e+237,1e+238,1e+239,
-	1e+240,1e+241,1e+242,1e+243,1e+244,1e+245,1e+246,1e+247,1e+248,1e+249,1e+250,1e+251,1e+252,1e+253,1e+254,1e+255,
-	1e+256,1e+257,1e+258,1e+259,1e+260,1e+261,1e+262,1e+263,1e+264,1e+265,1e+266,1e+267,1e+268,1e+269,1e+270,1e+271,
-	1e+272,1e+273,1e+274,1e+275,1e+276,1e+277,1e+278,1e+279,1e+280,1e+281,1e+282,1e+283,1e+284,1e+285,1e+286,1e+287,
-	1e+288,1e+289,1e+290,1e+291,1e+292,1e+293,1e+294,1e+295,1e+296,1e+297,1e+298,1e+299,1e+300,1e+301,1e+302,1e+303,
-	1e+304,1e+305,1e+306,1e+307,1e+308
-};
+// Parses a string in place and stores a pointer into the buffer in 'value'.
+// The closing quote, or an earlier character if the string has escapes, is replaced with the terminating zero.
+// Returns a pointer to the first character after the string.
+static const char * ksJson_ParseStringInSitu( char ** value, char * buffer, const char ** errorStringOut )
+{
+	assert( buffer[0] == '\"' );
+	buffer++;
+
+	char * outPtr = buffer;
+	const char * end = ksJson_UnescapeString( &outPtr, buffer, errorStringOut );
+	if ( *errorStringOut != NULL )
+	{
+		return end;
+	}
+	*outPtr = '\0';
+	*value = buffer;
+	return end + 1;
+}
 
 // Parses a number and stores the result in 'valueInt64', 'valueUint64' or 'valueDouble'.
+// Integers that fit in 64 bits are stored exactly. Anything else is converted to the nearest double,
+// where numbers that overflow are clamped to the largest finite double.
 // Returns a pointer to the first character after the number.
-static const char * ksJson_ParseNumber( JsonType_t * type, int64_t * valueInt64, uint64_t * valueUint64, double * valueDouble,
+static const char * ksJson_ParseNumber( uint8_t * type, int64_t * valueInt64, uint64_t * valueUint64, double * valueDouble,
 										const char * buffer, const char ** errorStringOut )
 {
 	(void)errorStringOut;
 
-	int sign = 1;
-	int nonZeroDigits = 0;
-	int fractionalDigits = 0;
-	int exponentSign = 1;
-	int exponentValue = 0;
-	uint64_t uint64Value = 0;
-	double doubleValue = 0.0;
-	bool uint64Overflowed = false;
-
+	bool negative = false;
 	if ( buffer[0] == '-' )
 	{
-		sign = -1;
+		negative = true;
 		buffer++;
 	}
 	else if ( buffer[0] == '+' )
 	{
-		sign = 1;
 		buffer++;
 	}
 
-	// Skip leading zeros and parse integer digits.
+	const char * start = buffer;
+	uint64_t uint64Value = 0;
+	bool uint64Overflowed = false;
+	uint64_t mantissa = 0;		// at most 19 significant digits
+	int mantissaDigits = 0;
+	int exponent = 0;
+	bool truncated = false;		// non-zero digits did not fit in the mantissa
+
+	// Parse integer digits, leading zeros are not significant.
 	while ( buffer[0] >= '0' && buffer[0] <= '9' )
 	{
-		const char d = ( buffer[0] - '0' );
+		const int d = ( buffer[0] - '0' );
 		uint64Overflowed |= ( uint64Value > ( UINT64_MAX / 10 ) ) | ( ( uint64Value * 10 ) > UINT64_MAX - d );
 		uint64Value = ( uint64Value * 10 ) + d;
-		doubleValue = ( doubleValue * 10.0 ) + d;
-		nonZeroDigits += ( uint64Value != 0 );
+		if ( mantissaDigits < 19 )
+		{
+			mantissa = ( mantissa * 10 ) + d;
+			mantissaDigits += ( mantissa != 0 );
+		}
+		else
+		{
+			exponent++;
+			truncated |= ( d != 0 );
+		}
 		buffer++;
 	}
+	bool isFloat = uint64Overflowed || ( negative && uint64Value > (uint64_t)INT64_MAX + 1 );
 	// Parse fractional digits.
 	if ( buffer[0] == '.' )
 	{
+		isFloat = true;
 		buffer++;
-		while ( buffer[0] >= '0' && buffer[0] <= '9' && nonZeroDigits < 17 )
-		{
-			doubleValue = ( doubleValue * 10.0 ) + ( buffer[0] - '0' );
-			nonZeroDigits += ( doubleValue != 0.0 );
-			fractionalDigits++;
-			buffer++;
-		}
-		// Skip the remaining digits.
 		while ( buffer[0] >= '0' && buffer[0] <= '9' )
 		{
+			const int d = ( buffer[0] - '0' );
+			if ( mantissaDigits < 19 )
+			{
+				mantissa = ( mantissa * 10 ) + d;
+				mantissaDigits += ( mantissa != 0 );
+				exponent--;
+			}
+			else
+			{
+				truncated |= ( d != 0 );
+			}
 			buffer++;
 		}
 	}
 	// Parse exponent.
 	if ( buffer[0] == 'e' || buffer[0] == 'E' )
 	{
+		isFloat = true;
 		buffer++;
-		exponentSign = 1;
+		int exponentSign = 1;
 		if ( buffer[0] == '+' )
 		{
-			exponentSign = 1;
 			buffer++;
 		}
 		else if ( buffer[0] == '-' )
@@ -858,166 +2053,277 @@ static const char * ksJson_ParseNumber( JsonType_t * type, int64_t * valueInt64,
 			exponentSign = -1;
 			buffer++;
 		}
+		int exponentValue = 0;
 		while ( buffer[0] >= '0' && buffer[0] <= '9' )
 		{
-			exponentValue = ( exponentValue * 10 ) + ( buffer[0] - '0' );
+			// Anything this large is zero or infinite anyway.
+			if ( exponentValue < 100000 )
+			{
+				exponentValue = ( exponentValue * 10 ) + ( buffer[0] - '0' );
+			}
 			buffer++;
 		}
+		exponent += exponentSign * exponentValue;
 	}
 
-	if ( fractionalDigits != 0 || exponentValue != 0 || uint64Overflowed || ( sign < 0 && uint64Value > (uint64_t)INT64_MAX + 1 ) )
+	if ( !isFloat )
 	{
-		*type = JSON_FLOAT;
-		const int exp = exponentSign * exponentValue - fractionalDigits;
-		if ( exp > 308 )
-		{
-			*valueDouble = sign * DBL_MAX;
-		}
-		else if ( exp >= -284 )
-		{
-			const int pow0 = 308 + 16;
-			const int pow1 = 308 * 2 + exp - pow0;
-			assert(pow0 >= 0 && (unsigned long long)pow0 < sizeof(json_pow10) / sizeof(json_pow10[0]));
-			assert(pow1 >= 0 && (unsigned long long)pow1 < sizeof(json_pow10) / sizeof(json_pow10[0]));
-			const double v = doubleValue * json_pow10[pow0] * json_pow10[pow1];
-			*valueDouble = sign * ( v <= DBL_MAX ? v : DBL_MAX );
-		}
-		else if ( exp >= -324 )
+		if ( negative )
 		{
-			const int pow0 = 16;
-			const int pow1 = 308 * 2 + exp - pow0;
-			assert(pow0 >= 0 && (unsigned long long)pow0 < sizeof(json_pow10) / sizeof(json_pow10[0]));
-			assert(pow1 >= 0 && (unsigned long long)pow1 < sizeof(json_pow10) / sizeof(json_pow10[0]));
-			*valueDouble = sign * doubleValue * json_pow10[pow0] * json_pow10[pow1];
+			*type = JSON_INT;
+			*valueInt64 = (int64_t)( 0 - uint64Value );	// also INT64_MIN without overflow
 		}
 		else
 		{
-			*valueDouble = 0.0;
+			*type = JSON_UINT;
+			*valueUint64 = uint64Value;
 		}
+		return buffer;
 	}
-	else if ( sign < 0 )
+
+	*type = JSON_FLOAT;
+#if defined( __cplusplus )
+	// Exact conversion, only numbers with more than 19 significant digits need to look at the text again.
+	double value = absl::numbers_internal::DecimalToDouble( mantissa, exponent, false );
+	if ( truncated )
 	{
-		*type = JSON_INT;
-		*valueInt64 = -(int64_t)uint64Value;
+		absl::numbers_internal::ParseDouble( start, buffer, &value );
 	}
-	else
+#else
+	(void)truncated;
+	double value = strtod( start, NULL );
+#endif
+	if ( value > DBL_MAX )
 	{
-		*type = JSON_UINT;
-		*valueUint64 = uint64Value;
+		value = DBL_MAX;
 	}
-
+	*valueDouble = negative ? -value : value;
 	return buffer;
 }
 
-static const char * ksJson_ParseValue( ksJson * json, const int recursion, const char * buffer, const char ** errorStringOut )
+// Skips the characters that ksJson_ParseNumber() would consume without converting them.
+// Returns a pointer to the first character after the number.
+static const char * ksJson_SkipNumber( const char * buffer )
 {
-	assert( errorStringOut != NULL );
-	if ( recursion > JSON_MAX_RECURSION )
+	if ( buffer[0] == '-' || buffer[0] == '+' )
 	{
-		*errorStringOut = "maximum recursion";
-		return buffer;
+		buffer++;
 	}
-
-	buffer = ksJson_ParseWhiteSpace( buffer );
-
-	if ( buffer[0] == 'n' )
+	while ( buffer[0] >= '0' && buffer[0] <= '9' )
 	{
-		assert( strncmp( buffer, "null", 4 ) == 0 );
-		json->type = JSON_NULL;
-		json->valueString = (char *)"null";
-		return buffer + 4;
-	}
-	else if ( buffer[0] == 'f' )
-	{ 
-		assert( strncmp( buffer, "false", 5 ) == 0 );
-		json->type = JSON_BOOLEAN;
-		json->valueString = (char *)"false";
-		return buffer + 5;
+		buffer++;
 	}
-	else if ( buffer[0] == 't' )
+	if ( buffer[0] == '.' )
 	{
-		assert( strncmp( buffer, "true", 4 ) == 0 );
-		json->type = JSON_BOOLEAN;
-		json->valueString = (char *)"true";
-		return buffer + 4;
-	}
-	else if ( buffer[0] == '\"' )
+		buffer++;
+		while ( buffer[0] >= '0' && buffer[0] <= '9' )
+		{
+			buffer++;
+		}
+	}
+	if ( buffer[0] == 'e' || buffer[0] == 'E' )
+	{
+		buffer++;
+		if ( buffer[0] == '+' || buffer[0] == '-' )
+		{
+			buffer++;
+		}
+		while ( buffer[0] >= '0' && buffer[0] <= '9' )
+		{
+			buffer++;
+		}
+	}
+	return buffer;
+}
+
+// Parses a null, boolean, string or number value.
+static inline const char * ksJson_ParseLeaf( ksJson * json, ksJsonArena * arena, const int parseFlags, const char * buffer, const char ** errorStringOut )
+{
+	if ( buffer[0] == 'n' )
+	{
+		if ( strncmp( buffer, "null", 4 ) != 0 )
+		{
+			*errorStringOut = "invalid literal";
+			return buffer;
+		}
+		json->type = JSON_NULL;
+		json->valueString = (char *)"null";
+		return buffer + 4;
+	}
+	else if ( buffer[0] == 'f' )
+	{ 
+		if ( strncmp( buffer, "false", 5 ) != 0 )
+		{
+			*errorStringOut = "invalid literal";
+			return buffer;
+		}
+		json->type = JSON_BOOLEAN;
+		json->valueString = (char *)"false";
+		return buffer + 5;
+	}
+	else if ( buffer[0] == 't' )
+	{
+		if ( strncmp( buffer, "true", 4 ) != 0 )
+		{
+			*errorStringOut = "invalid literal";
+			return buffer;
+		}
+		json->type = JSON_BOOLEAN;
+		json->valueString = (char *)"true";
+		return buffer + 4;
+	}
+	else if ( buffer[0] == '\"' )
 	{
-		json->type = JSON_STRING;
-		return ksJson_ParseString( &json->valueString, buffer, errorStringOut );
+		if ( parseFlags & JSON_PARSE_IN_SITU )
+		{
+			buffer = ksJson_ParseStringInSitu( &json->valueString, (char *)buffer, errorStringOut );
+			json->flags |= JSON_FLAG_BORROWED_VALUE;
+		}
+		else
+		{
+			buffer = ksJson_ParseString( &json->valueString, arena, buffer, errorStringOut );
+		}
+		if ( *errorStringOut == NULL )
+		{
+			json->type = JSON_STRING;	// Only a successfully parsed string owns 'valueString'.
+		}
+		return buffer;
 	}
-	else if ( buffer[0] == '{' )
+	else
 	{
-		json->type = JSON_OBJECT;
-		json->memberMap = NULL;
+		return ksJson_ParseNumber( &json->type, &json->valueInt64, &json->valueUint64, &json->valueDouble, buffer, errorStringOut );
+	}
+}
 
-		buffer++;
-		while ( *errorStringOut == NULL )
+// Adds the next member to an object or array. For an object, the member name and colon are parsed.
+static inline const char * ksJson_ParseMember( ksJson ** memberOut, ksJson * json, ksJsonArena * arena, const int parseFlags, const char * buffer, const char ** errorStringOut )
+{
+	ksJson * member = ksJson_AllocMember( json );
+	*memberOut = member;
+	if ( json->type == JSON_ARRAY )
+	{
+		return buffer;
+	}
+	buffer = ksJson_ParseWhiteSpace( buffer );
+	if ( buffer[0] != '\"' )
+	{
+		*errorStringOut = "missing member name";
+		return buffer;
+	}
+	if ( parseFlags & JSON_PARSE_IN_SITU )
+	{
+		buffer = ksJson_ParseStringInSitu( &member->name, (char *)buffer, errorStringOut );
+		member->flags |= JSON_FLAG_BORROWED_NAME;
+	}
+	else
+	{
+		buffer = ksJson_ParseString( &member->name, arena, buffer, errorStringOut );
+	}
+	if ( *errorStringOut != NULL )
+	{
+		return buffer;
+	}
+	member->name = ksJson_InternName( arena, member->name );
+	buffer = ksJson_ParseWhiteSpace( buffer );
+	if ( buffer[0] != ':' )
+	{
+		*errorStringOut = "missing colon";
+		return buffer;
+	}
+	return buffer + 1;
+}
+
+// Parses a value with all its members. Instead of recursing, the objects and arrays that are
+// still open are kept on an explicit stack, so the nesting depth is only limited by 'maxDepth'
+// and not by the size of the call stack of the thread.
+static const char * ksJson_ParseValue( ksJson * json, const int maxDepth, const int parseFlags, const char * buffer, const char ** errorStringOut )
+{
+	assert( errorStringOut != NULL );
+	ksJsonArena * arena = ksJson_GetArena( json );
+	ksJson * localStack[JSON_PARSE_STACK_SIZE];
+	ksJson ** stack = localStack;
+	int stackSize = JSON_PARSE_STACK_SIZE;
+	int depth = 0;
+
+	for ( ;; )
+	{
+		buffer = ksJson_ParseWhiteSpace( buffer );
+		if ( buffer[0] == '{' || buffer[0] == '[' )
 		{
-			buffer = ksJson_ParseWhiteSpace( buffer );
-			if ( buffer[0] == '}' )
+			if ( depth >= maxDepth )
 			{
-				buffer++;
+				*errorStringOut = "maximum depth";
 				break;
 			}
-			if ( json->memberCount > 0 )
+			const char close = ( buffer[0] == '{' ) ? '}' : ']';
+			json->type = ( buffer[0] == '{' ) ? JSON_OBJECT : JSON_ARRAY;
+			json->memberMap = NULL;
+			buffer = ksJson_ParseWhiteSpace( buffer + 1 );
+			if ( buffer[0] != close )
 			{
-				if ( buffer[0] != ',' )
+				if ( depth == stackSize )
+				{
+					ksJson ** newStack = (ksJson **) malloc( 2 * stackSize * sizeof( ksJson * ) );
+					memcpy( newStack, stack, stackSize * sizeof( ksJson * ) );
+					if ( stack != localStack )
+					{
+						free( stack );
+					}
+					stack = newStack;
+					stackSize *= 2;
+				}
+				stack[depth++] = json;
+				buffer = ksJson_ParseMember( &json, json, arena, parseFlags, buffer, errorStringOut );
+				if ( *errorStringOut != NULL )
 				{
-					*errorStringOut = "missing comma";
-					return buffer;
+					break;
 				}
-				buffer++;
+				continue;
 			}
-			ksJson * member = ksJson_AllocMember( json );
-			buffer = ksJson_ParseWhiteSpace( buffer );
-			buffer = ksJson_ParseString( &member->name, buffer, errorStringOut );
-			buffer = ksJson_ParseWhiteSpace( buffer );
-			if ( buffer[0] != ':' )
+			buffer++;
+		}
+		else
+		{
+			buffer = ksJson_ParseLeaf( json, arena, parseFlags, buffer, errorStringOut );
+			if ( *errorStringOut != NULL )
 			{
-				*errorStringOut = "missing colon";
-				return buffer;
+				break;
 			}
-			buffer++;
-			buffer = ksJson_ParseValue( member, recursion + 1, buffer, errorStringOut );
 		}
-		return buffer;
-	}
-	else if ( buffer[0] == '[' )
-	{ 
-		json->type = JSON_ARRAY;
-		json->memberMap = NULL;
 
-		buffer++;
-		while ( *errorStringOut == NULL )
+		// The value is complete. Close the objects and arrays that end here and
+		// continue with the next member of the innermost one that is still open.
+		while ( depth > 0 )
 		{
+			ksJson * parent = stack[depth - 1];
 			buffer = ksJson_ParseWhiteSpace( buffer );
-			if ( buffer[0] == ']' )
+			if ( buffer[0] == ',' )
 			{
-				buffer++;
+				buffer = ksJson_ParseMember( &json, parent, arena, parseFlags, buffer + 1, errorStringOut );
 				break;
 			}
-			if ( json->memberCount > 0 )
+			if ( buffer[0] != ( ( parent->type == JSON_OBJECT ) ? '}' : ']' ) )
 			{
-				if ( buffer[0] != ',' )
-				{
-					*errorStringOut = "missing comma";
-					return buffer;
-				}
-				buffer++;
+				*errorStringOut = "missing comma";
+				break;
 			}
-			ksJson * member = ksJson_AllocMember( json );
-			buffer = ksJson_ParseValue( member, recursion + 1, buffer, errorStringOut );
+			buffer++;
+			depth--;
+		}
+		if ( depth == 0 || *errorStringOut != NULL )
+		{
+			break;
 		}
-		return buffer;
 	}
-	else
+
+	if ( stack != localStack )
 	{
-		return ksJson_ParseNumber( &json->type, &json->valueInt64, &json->valueUint64, &json->valueDouble, buffer, errorStringOut );
+		free( stack );
 	}
+	return buffer;
 }
 
-static bool ksJson_ReadFromBuffer( ksJson * rootNode, const char * buffer, const char ** errorStringOut )
+[[maybe_unused]] static bool ksJson_ReadFromBuffer( ksJson * rootNode, const char * buffer, const char ** errorStringOut )
 {
 	if ( rootNode == NULL || buffer == NULL )
 	{
@@ -1030,7 +2336,7 @@ static bool ksJson_ReadFromBuffer( ksJson * rootNode, const char * buffer, const
 	ksJson_FreeNode( rootNode, true );
 
 	const char * error = NULL;
-	ksJson_ParseValue( rootNode, 0, buffer, &error );
+	ksJson_ParseValue( rootNode, ksJson_GetMaxDepth( rootNode ), 0, buffer, &error );
 	if ( error != NULL )
 	{
 		if ( errorStringOut != NULL )
@@ -1043,9 +2349,14 @@ static bool ksJson_ReadFromBuffer( ksJson * rootNode, const char * buffer, const
 	return true;
 }
 
-[[maybe_unused]] static bool ksJson_ReadFromFile( ksJson * rootNode, const char * fileName, const char ** errorStringOut )
+// Parses the value at the start of 'buffer', which must end within the first 'length' bytes.
+// This parses one record of a larger text without copying it. Text after the value within
+// 'length' is ignored like with ksJson_ReadFromBuffer(). The parser still stops at the first zero,
+// so a malformed value that runs past 'length' reads on until it fails or the text ends, and
+// the text must be zero terminated.
+[[maybe_unused]] static bool ksJson_ReadFromBufferLength( ksJson * rootNode, const char * buffer, const size_t length, const char ** errorStringOut )
 {
-	if ( rootNode == NULL || fileName == NULL )
+	if ( rootNode == NULL || buffer == NULL )
 	{
 		return false;
 	}
@@ -1055,36 +2366,41 @@ static bool ksJson_ReadFromBuffer( ksJson * rootNode, const char * buffer, const
 	}
 	ksJson_FreeNode( rootNode, true );
 
-	FILE * file = fopen( fileName, "rb" );
-	if ( file == NULL )
+	const char * error = NULL;
+	const char * end = ksJson_ParseValue( rootNode, ksJson_GetMaxDepth( rootNode ), 0, buffer, &error );
+	if ( error == NULL && end > buffer + length )
+	{
+		error = "value continues past the length";
+	}
+	if ( error != NULL )
 	{
 		if ( errorStringOut != NULL )
 		{
-			*errorStringOut = "failed to open file";
+			*errorStringOut = error;
 		}
+		ksJson_FreeNode( rootNode, true );
 		return false;
 	}
+	return true;
+}
 
-	fseek( file, 0L, SEEK_END );
-	size_t bufferSize = ftell( file );
-	fseek( file, 0L, SEEK_SET );
-
-	char * buffer = (char *) malloc( bufferSize + 1 );
-	if ( fread( buffer, 1, bufferSize, file ) != bufferSize )
+// Parses a mutable buffer without copying strings. Strings are unescaped in place and the
+// member names and string values of the DOM point into the buffer, so the buffer must stay
+// unmodified for as long as the DOM is used.
+[[maybe_unused]] static bool ksJson_ReadFromBufferInSitu( ksJson * rootNode, char * buffer, const char ** errorStringOut )
+{
+	if ( rootNode == NULL || buffer == NULL )
 	{
-		if ( errorStringOut != NULL )
-		{
-			*errorStringOut = "failed to read file";
-		}
-		free( buffer );
-		fclose( file );
 		return false;
 	}
-	buffer[bufferSize] = '\0';	// make sure the buffer is zero terminated
-	fclose( file );
+	if ( errorStringOut != NULL )
+	{
+		*errorStringOut = NULL;
+	}
+	ksJson_FreeNode( rootNode, true );
 
 	const char * error = NULL;
-	ksJson_ParseValue( rootNode, 0, buffer, &error );
+	ksJson_ParseValue( rootNode, ksJson_GetMaxDepth( rootNode ), JSON_PARSE_IN_SITU, buffer, &error );
 	if ( error != NULL )
 	{
 		if ( errorStringOut != NULL )
@@ -1092,585 +2408,3459 @@ static bool ksJson_ReadFromBuffer( ksJson * rootNode, const char * buffer, const
 			*errorStringOut = error;
 		}
 		ksJson_FreeNode( rootNode, true );
-		free( buffer );
 		return false;
 	}
-
-	free( buffer );
 	return true;
 }
 
-static void ksJson_Printf( char ** bufferInOut, int * lengthInOut, int * offsetInOut, const int extraLength, const char * format, ... )
+/*
+================================================================================================
+
+Files
+
+A ksJsonFile holds the contents of a file followed by a zero. The file is memory mapped, so
+parsing reads the pages straight from the file cache and the contents are never copied into
+an allocated buffer. Beyond the end of the file, the rest of the last page of a mapping reads
+as zeros, which terminates the text without touching the file. Only a file that exactly fills
+its last page needs an extra zero page. On POSIX systems the file is mapped in front of an
+anonymous page. On Windows, and where memory mapping is not available, such a file is read
+into an allocated buffer instead.
+
+A file opened for in-situ parsing is mapped copy-on-write. Strings are unescaped in place
+and borrowed by the DOM like with ksJson_ReadFromBufferInSitu(), which only copies the pages
+that hold strings, while the file itself is never modified.
+
+================================================================================================
+*/
+
+typedef struct ksJsonFile
+{
+	char *		data;				// file contents followed by a zero
+	size_t		size;				// file size in bytes
+	size_t		mappedSize;			// zero if the contents were read into an allocated buffer
+} ksJsonFile;
+
+static bool ksJsonFile_Read( ksJsonFile * file, FILE * fp )
 {
-	if ( *offsetInOut + extraLength + 1 + 1 > *lengthInOut )
+	fseek( fp, 0L, SEEK_END );
+	file->size = ftell( fp );
+	fseek( fp, 0L, SEEK_SET );
+
+	file->data = (char *) malloc( file->size + 1 );
+	if ( fread( file->data, 1, file->size, fp ) != file->size )
 	{
-		int newLength = ( *lengthInOut <= 0 ) ? 128 : *lengthInOut * 2;
-		while ( newLength < *offsetInOut + extraLength + 1 )
-		{
-			newLength *= 2;
-		}
-		char * newBuffer = (char *) malloc( newLength );
-		memcpy( newBuffer, *bufferInOut, *offsetInOut );
-		free( *bufferInOut );
-		*bufferInOut = newBuffer;
-		*lengthInOut = newLength;
+		free( file->data );
+		file->data = NULL;
+		return false;
 	}
-	va_list args;
-	va_start( args, format );
-	*offsetInOut += vsprintf( &(*bufferInOut)[*offsetInOut], format, args );
-	va_end( args );
-	assert( *offsetInOut <= *lengthInOut );
+	file->data[file->size] = '\0';	// make sure the buffer is zero terminated
+	return true;
 }
 
-static void ksJson_WriteValue( const ksJson * node, int recursion, char ** bufferInOut, int * lengthInOut, int * offsetInOut, const int indent, const bool lastChild )
+#if defined( JSON_MMAP_WIN32 )
+
+static bool ksJsonFile_Map( ksJsonFile * file, const char * fileName, const bool copyOnWrite )
 {
-	if ( recursion > JSON_MAX_RECURSION )
+	HANDLE handle = CreateFileA( fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+	if ( handle == INVALID_HANDLE_VALUE )
 	{
-		return;
+		return false;
 	}
-
-	const int maxIndent = 32;
-	const char * indentTable = "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t";
-	assert( indent <= maxIndent );
-
-	if ( node->type == JSON_NULL || node->type == JSON_BOOLEAN )
+	SYSTEM_INFO info;
+	GetSystemInfo( &info );
+	LARGE_INTEGER size;
+	if ( !GetFileSizeEx( handle, &size ) || size.QuadPart == 0 || size.QuadPart % info.dwPageSize == 0 )
 	{
-		ksJson_Printf( bufferInOut, lengthInOut, offsetInOut, (int)strlen( node->valueString ) + 2, "%s%s\n", node->valueString, lastChild ? "" : "," );
+		CloseHandle( handle );
+		return false;
 	}
-	else if ( node->type == JSON_INT )
+	HANDLE mapping = CreateFileMappingA( handle, NULL, copyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, NULL );
+	CloseHandle( handle );
+	if ( mapping == NULL )
 	{
-		char temp[1024];
-		const int length = sprintf( temp, "%lld", (long long int)node->valueInt64 );
-		ksJson_Printf( bufferInOut, lengthInOut, offsetInOut, length + 2, "%s%s\n", temp, lastChild ? "" : "," );
+		return false;
 	}
-	else if ( node->type == JSON_UINT )
+	file->data = (char *) MapViewOfFile( mapping, copyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0 );
+	CloseHandle( mapping );		// the view keeps the mapping alive
+	if ( file->data == NULL )
 	{
-		char temp[1024];
-		const int length = sprintf( temp, "%llu", (unsigned long long int)node->valueUint64 );
-		ksJson_Printf( bufferInOut, lengthInOut, offsetInOut, length + 2, "%s%s\n", temp, lastChild ? "" : "," );
+		return false;
 	}
-	else if ( node->type == JSON_FLOAT )
+	file->size = (size_t)size.QuadPart;
+	file->mappedSize = file->size;
+	return true;
+}
+
+static void ksJsonFile_Unmap( ksJsonFile * file )
+{
+	UnmapViewOfFile( file->data );
+}
+
+#elif defined( JSON_MMAP_POSIX )
+
+static bool ksJsonFile_Map( ksJsonFile * file, const char * fileName, const bool copyOnWrite )
+{
+	const int fd = open( fileName, O_RDONLY );
+	if ( fd < 0 )
 	{
-		char temp[1024];
-		int length = sprintf( temp, "%g", node->valueDouble );
-		ksJson_Printf( bufferInOut, lengthInOut, offsetInOut, length + 2, "%s%s\n", temp, lastChild ? "" : "," );
+		return false;
 	}
-	else if ( node->type == JSON_STRING )
+	struct stat st;
+	if ( fstat( fd, &st ) != 0 || st.st_size == 0 )
 	{
-		// 刘旭修改：输出字符串时在两端加引号
-		ksJson_Printf(bufferInOut, lengthInOut, offsetInOut, 1, "\"");
-		for ( const char * ptr = node->valueString; ptr[0] != '\0'; ptr++ )
-		{
-			if ( (unsigned char)ptr[0] < ' ' || ptr[0] == '\"' || ptr[0] == '\\' )
-			{
-				switch ( ptr[0] )
-				{
-					case '\\': ksJson_Printf( bufferInOut, lengthInOut, offsetInOut, 2, "\\\\" ); break;
-					case '\"': ksJson_Printf( bufferInOut, lengthInOut, offsetInOut, 2, "\\\"" ); break;
-					case '\b': ksJson_Printf( bufferInOut, lengthInOut, offsetInOut, 2, "\\b" ); break;
-					case '\f': ksJson_Printf( bufferInOut, lengthInOut, offsetInOut, 2, "\\f" ); break;
-					case '\n': ksJson_Printf( bufferInOut, lengthInOut, offsetInOut, 2, "\\n" ); break;
-					case '\r': ksJson_Printf( bufferInOut, lengthInOut, offsetInOut, 2, "\\r" ); break;
-					case '\t': ksJson_Printf( bufferInOut, lengthInOut, offsetInOut, 2, "\\t" ); break;
-					default: ksJson_Printf( bufferInOut, lengthInOut, offsetInOut, 6, "\\u%04x", ptr[0] ); break;
-				}
-			}
-			else
-			{
-				ksJson_Printf( bufferInOut, lengthInOut, offsetInOut, 1, "%c", ptr[0] );
-			}
-		}
-		ksJson_Printf(bufferInOut, lengthInOut, offsetInOut, 1, "\"");
-		ksJson_Printf( bufferInOut, lengthInOut, offsetInOut, 2, "%s\n", lastChild ? "" : "," );
+		close( fd );
+		return false;
 	}
-	else if ( node->type == JSON_OBJECT )
+	const size_t size = (size_t)st.st_size;
+	const size_t pageSize = (size_t)sysconf( _SC_PAGESIZE );
+	const int protection = copyOnWrite ? ( PROT_READ | PROT_WRITE ) : PROT_READ;
+	// A file that fills its last page is mapped over the start of a zeroed anonymous mapping.
+	const size_t mappedSize = ( size % pageSize == 0 ) ? size + pageSize : size;
+	void * data = NULL;
+	if ( mappedSize != size )
 	{
-		ksJson_Printf( bufferInOut, lengthInOut, offsetInOut, 2, "{\n" );
-		if ( node->memberCount > 0 )
+		void * zeros = mmap( NULL, mappedSize, protection, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+		data = ( zeros != MAP_FAILED ) ? mmap( zeros, size, protection, MAP_PRIVATE | MAP_FIXED, fd, 0 ) : MAP_FAILED;
+		if ( data == MAP_FAILED && zeros != MAP_FAILED )
 		{
-			const int endMapIndex = MemberIndexToMapIndex( node->memberCount - 1 );
-			for ( int mapIndex = 0; mapIndex <= endMapIndex; mapIndex++ )
-			{
-				const ksJson * members = node->memberMap[mapIndex];
-				const int mapMemberCount = MapMemberCount( mapIndex, node->memberCount ); 
-				for ( int i = 0; i < mapMemberCount; i++ )
-				{
-					const ksJson * member = &members[i];
-					ksJson_Printf( bufferInOut, lengthInOut, offsetInOut, indent + 1 + (int)strlen( member->name ) + 5, "%s\"%s\" : ", &indentTable[maxIndent - ( indent + 1 )], member->name );
-					ksJson_WriteValue( member, recursion + 1, bufferInOut, lengthInOut, offsetInOut, indent + 1, ( mapIndex == endMapIndex && i == mapMemberCount - 1 ) );
-				}
-			}
+			munmap( zeros, mappedSize );
 		}
-		ksJson_Printf( bufferInOut, lengthInOut, offsetInOut, indent + 2, "%s}%s\n", &indentTable[maxIndent - indent], lastChild ? "" : "," );
 	}
-	else if ( node->type == JSON_ARRAY )
+	else
 	{
-		ksJson_Printf( bufferInOut, lengthInOut, offsetInOut, 2, "[\n" );
-		if ( node->memberCount > 0 )
-		{
-			const int endMapIndex = MemberIndexToMapIndex( node->memberCount - 1 );
-			for ( int mapIndex = 0; mapIndex <= endMapIndex; mapIndex++ )
-			{
-				const ksJson * members = node->memberMap[mapIndex];
-				const int mapMemberCount = MapMemberCount( mapIndex, node->memberCount ); 
-				for ( int i = 0; i < mapMemberCount; i++ )
-				{
-					const ksJson * member = &members[i];
-					ksJson_Printf( bufferInOut, lengthInOut, offsetInOut, indent + 1, "%s", &indentTable[maxIndent - ( indent + 1 )] );
-					ksJson_WriteValue( member, recursion + 1, bufferInOut, lengthInOut, offsetInOut, indent + 1, ( mapIndex == endMapIndex && i == mapMemberCount - 1 ) );
-				}
-			}
-		}
-		ksJson_Printf( bufferInOut, lengthInOut, offsetInOut, indent + 2, "%s]%s\n", &indentTable[maxIndent - indent], lastChild ? "" : "," );
+		data = mmap( NULL, size, protection, MAP_PRIVATE, fd, 0 );
 	}
-}
-
-// 'lengthOut' is the length of 'bufferOut' without trailing zero.
-static inline bool ksJson_WriteToBuffer( const ksJson * rootNode, char ** bufferOut, int * lengthOut )
-{
-	if ( rootNode == NULL || bufferOut == NULL || lengthOut == NULL )
+	close( fd );		// the mapping keeps the file open
+	if ( data == MAP_FAILED )
 	{
 		return false;
 	}
-	*bufferOut = NULL;
-	*lengthOut = 0;
-	int offset = 0;
-	ksJson_WriteValue( rootNode, 0, bufferOut, lengthOut, &offset, 0, true );
-	*lengthOut = offset;
+	madvise( data, size, MADV_SEQUENTIAL );
+	file->data = (char *)data;
+	file->size = size;
+	file->mappedSize = mappedSize;
 	return true;
 }
 
-[[maybe_unused]] static bool ksJson_WriteToFile( const ksJson * rootNode, const char * fileName )
+static void ksJsonFile_Unmap( ksJsonFile * file )
 {
-	if ( rootNode == NULL || fileName == NULL )
-	{
-		return false;
-	}
-	char * buffer = NULL;
-	int length = 0;
-	int offset = 0;
-	ksJson_WriteValue( rootNode, 0, &buffer, &length, &offset, 0, true );
+	munmap( file->data, file->mappedSize );
+}
 
-	FILE * file = fopen( fileName, "wb" );
-	if ( file == NULL )
+#endif
+
+// With 'copyOnWrite' the contents may be modified without modifying the file.
+static bool ksJsonFile_Open( ksJsonFile * file, const char * fileName, const bool copyOnWrite )
+{
+	file->data = NULL;
+	file->size = 0;
+	file->mappedSize = 0;
+#if defined( JSON_MMAP_WIN32 ) || defined( JSON_MMAP_POSIX )
+	if ( ksJsonFile_Map( file, fileName, copyOnWrite ) )
 	{
-		free( buffer );
-		return false;
+		return true;
 	}
-	if ( fwrite( buffer, 1, offset, file ) != (size_t) offset )
+#else
+	(void)copyOnWrite;
+#endif
+	FILE * fp = fopen( fileName, "rb" );
+	if ( fp == NULL )
 	{
-		free( buffer );
-		fclose( file );
 		return false;
 	}
-	fclose( file );
-	free( buffer );
-	return true;
+	const bool result = ksJsonFile_Read( file, fp );
+	fclose( fp );
+	return result;
 }
 
-static int ksJson_GetMemberCount( const ksJson * node )
+static void ksJsonFile_Close( ksJsonFile * file )
 {
-	if ( node != NULL )
+	if ( file->data == NULL )
 	{
-		assert( node->type >= JSON_NULL && node->type <= JSON_ARRAY );
-		return node->memberCount;
+		return;
 	}
-	return 0;
+#if defined( JSON_MMAP_WIN32 ) || defined( JSON_MMAP_POSIX )
+	if ( file->mappedSize > 0 )
+	{
+		ksJsonFile_Unmap( file );
+	}
+	else
+#endif
+	{
+		free( file->data );
+	}
+	file->data = NULL;
+	file->size = 0;
+	file->mappedSize = 0;
 }
 
-static ksJson * ksJson_GetMemberByIndex( const ksJson * node, const int index )
+static bool ksJson_ReadFromFileFlags( ksJson * rootNode, ksJsonFile * file, const char * fileName, const int parseFlags, const char ** errorStringOut )
 {
-	if ( node != NULL )
+	if ( errorStringOut != NULL )
 	{
-		assert( node->type >= JSON_NULL && node->type <= JSON_ARRAY );
-		if ( node->type == JSON_OBJECT || node->type == JSON_ARRAY )
+		*errorStringOut = NULL;
+	}
+	ksJson_FreeNode( rootNode, true );
+
+	if ( !ksJsonFile_Open( file, fileName, ( parseFlags & JSON_PARSE_IN_SITU ) != 0 ) )
+	{
+		if ( errorStringOut != NULL )
 		{
-			if ( index >= 0 && index < node->memberCount )
-			{
-				const int mapIndex = MemberIndexToMapIndex( index );
-				const int memberOffset = MapMemberOffset( mapIndex );
-				return &node->memberMap[mapIndex][index - memberOffset];
-			}
+			*errorStringOut = "failed to read file";
 		}
+		return false;
 	}
-	return NULL;
-}
 
-static ksJson * ksJson_GetMemberByName( const ksJson * node, const char * name )
-{
-	if ( node != NULL && node->type == JSON_OBJECT && node->memberCount > 0 )
+	const char * error = NULL;
+	ksJson_ParseValue( rootNode, ksJson_GetMaxDepth( rootNode ), parseFlags, file->data, &error );
+	if ( error != NULL )
 	{
-		assert( name != NULL );
-		const int startMapIndex = MemberIndexToMapIndex( node->memberIndex );
-		const int endMapIndex = MemberIndexToMapIndex( node->memberCount - 1 );
-		int firstMemberOffset = node->memberIndex - MapMemberOffset( startMapIndex );
-		for ( int mapIndex = startMapIndex; mapIndex <= endMapIndex; mapIndex++ )
-		{
-			ksJson * members = node->memberMap[mapIndex];
-			const int mapMemberCount = MapMemberCount( mapIndex, node->memberCount ); 
-			for ( int i = firstMemberOffset; i < mapMemberCount; i++ )
-			{
-				if ( strcmp( members[i].name, name ) == 0 )
-				{
-					const int newMemberIndex = MapMemberOffset( mapIndex ) + i + 1;
-					*(int *)&node->memberIndex = ( newMemberIndex < node->memberCount ) ? newMemberIndex : 0;	// mutable
-					return &members[i];
-				}
-			}
-			firstMemberOffset = 0;
-		}
-		for ( int mapIndex = 0; mapIndex <= startMapIndex; mapIndex++ )
+		if ( errorStringOut != NULL )
 		{
-			ksJson * members = node->memberMap[mapIndex];
-			const int mapMemberCount = MapMemberCount( mapIndex, node->memberIndex ); 
-			for ( int i = 0; i < mapMemberCount; i++ )
-			{
-				if ( strcmp( members[i].name, name ) == 0 )
-				{
-					const int newMemberIndex = MapMemberOffset( mapIndex ) + i + 1;
-					*(int *)&node->memberIndex = ( newMemberIndex < node->memberCount ) ? newMemberIndex : 0;	// mutable
-					return &members[i];
-				}
-			}
+			*errorStringOut = error;
 		}
+		ksJson_FreeNode( rootNode, true );
+		ksJsonFile_Close( file );
+		return false;
 	}
-	return NULL;
+	return true;
 }
 
-[[maybe_unused]] static const char * ksJson_GetMemberName( const ksJson * node )
+// Parses the file straight from its memory mapping and copies the strings into the DOM.
+[[maybe_unused]] static bool ksJson_ReadFromFile( ksJson * rootNode, const char * fileName, const char ** errorStringOut )
 {
-	if ( node != NULL && node->name != NULL )
+	if ( rootNode == NULL || fileName == NULL )
 	{
-		assert( node->type >= JSON_NULL && node->type <= JSON_ARRAY );
-		return node->name;
+		return false;
 	}
-	return "";
-}
-
-static inline bool ksJson_IsNull( const ksJson * node )
-{
-	return ( node != NULL && node->type == JSON_NULL );
+	ksJsonFile file;
+	const bool result = ksJson_ReadFromFileFlags( rootNode, &file, fileName, 0, errorStringOut );
+	ksJsonFile_Close( &file );
+	return result;
 }
 
-static inline bool ksJson_IsBoolean( const ksJson * node )
+// Parses the file in its copy-on-write memory mapping without copying strings. The member names
+// and string values of the DOM point into 'file', which must be closed with ksJsonFile_Close()
+// after the DOM is destroyed or cleared. Closing 'file' is harmless if parsing failed.
+[[maybe_unused]] static bool ksJson_ReadFromFileInSitu( ksJson * rootNode, ksJsonFile * file, const char * fileName, const char ** errorStringOut )
 {
-	return ( node != NULL && node->type == JSON_BOOLEAN );
+	if ( rootNode == NULL || file == NULL || fileName == NULL )
+	{
+		return false;
+	}
+	return ksJson_ReadFromFileFlags( rootNode, file, fileName, JSON_PARSE_IN_SITU, errorStringOut );
 }
 
-static inline bool ksJson_IsNumber( const ksJson * node )
-{
-	return ( node != NULL && ( node->type == JSON_INT || node->type == JSON_UINT || node->type == JSON_FLOAT ) );
-}
+/*
+================================================================================================
 
-static inline bool ksJson_IsInteger( const ksJson * node )
-{
-	return ( node != NULL && ( node->type == JSON_INT || node->type == JSON_UINT ) );
-}
+Pull parser
 
-static inline bool ksJson_IsUnsigned( const ksJson * node )
-{
-	return ( node != NULL && node->type == JSON_UINT );
-}
+A ksJsonPull reads JSON text as a sequence of events without building a DOM. The text is fed
+in chunks of any size and a chunk may end in the middle of a token. When the buffered text
+ends before the next token is complete, ksJsonPull_Next() returns JSON_PULL_NEED_INPUT and
+the partial token is kept until the next chunk is fed. Apart from the buffered text, which is
+at most a chunk plus a partial token, the memory used only depends on the nesting depth.
+Like a DOM, the parser rejects text that is nested deeper than ksJsonPull_SetMaxDepth().
 
-static inline bool ksJson_IsFloatingPoint( const ksJson * node )
-{
-	return ( node != NULL && node->type == JSON_FLOAT );
-}
+Strings are unescaped in place in the buffer of the parser. Member names and string values
+are therefore only valid until the next call to ksJsonPull_Next() or ksJsonPull_Feed().
 
-static inline bool ksJson_IsString( const ksJson * node )
-{
-	return ( node != NULL && node->type == JSON_STRING );
-}
+ksJsonPull_Skip() skips the rest of an object or array, or the value of an object member,
+by scanning for the matching bracket without parsing or validating anything in between.
 
-static inline bool ksJson_IsObject( const ksJson * node )
-{
-	return ( node != NULL && node->type == JSON_OBJECT );
-}
+A sequence of values separated by white space, such as newline-delimited JSON, is read
+one value after another.
 
-static inline bool ksJson_IsArray( const ksJson * node )
-{
-	return ( node != NULL && node->type == JSON_ARRAY );
-}
+================================================================================================
+*/
 
-static inline bool ksJson_GetBool( const ksJson * node, const bool defaultValue )
+typedef enum
 {
-	return ksJson_IsBoolean( node ) ? node->valueString[0] == 't' : defaultValue;
-}
+	JSON_PULL_NEED_INPUT,			// feed the next chunk of text
+	JSON_PULL_END,					// all text was read
+	JSON_PULL_ERROR,				// the text is invalid, see ksJsonPull_GetError()
+	JSON_PULL_BEGIN_OBJECT,
+	JSON_PULL_END_OBJECT,
+	JSON_PULL_BEGIN_ARRAY,
+	JSON_PULL_END_ARRAY,
+	JSON_PULL_KEY,					// member name, see ksJsonPull_GetKey()
+	JSON_PULL_VALUE					// null, boolean, number or string, see ksJsonPull_GetValue()
+} ksJsonPullEvent;
 
-static inline int8_t ksJson_GetInt8( const ksJson * node, const int8_t defaultValue )
+typedef enum
 {
-	return	( ( node == NULL ) ?				defaultValue :
-			( ( node->type == JSON_INT ) ?		(int8_t)JSON_CLAMP( node->valueInt64, INT8_MIN, INT8_MAX ) :
-			( ( node->type == JSON_UINT ) ?		(int8_t)JSON_MIN( node->valueUint64, INT8_MAX ) :
-			( ( node->type == JSON_FLOAT ) ?	(int8_t)JSON_CLAMP( node->valueDouble, INT8_MIN, INT8_MAX ) : defaultValue ) ) ) );
-}
-
-static inline uint8_t ksJson_GetUint8( const ksJson * node, const uint8_t defaultValue )
+	JSON_PULL_STATE_VALUE,			// a value, or the next value at the top level
+	JSON_PULL_STATE_FIRST_VALUE,	// the first array element or ']'
+	JSON_PULL_STATE_FIRST_KEY,		// the first member name or '}'
+	JSON_PULL_STATE_KEY,			// a member name after ','
+	JSON_PULL_STATE_COLON,			// ':' after a member name
+	JSON_PULL_STATE_NEXT			// ',' or the end of the innermost object or array
+} ksJsonPullState;
+
+typedef struct ksJsonPull
 {
-	return	( ( node == NULL ) ?				defaultValue :
-			( ( node->type == JSON_UINT ) ?		(uint8_t)JSON_MIN( node->valueUint64, UINT8_MAX ) :
-			( ( node->type == JSON_INT ) ?		(uint8_t)JSON_CLAMP( node->valueInt64, 0, UINT8_MAX ) :
-			( ( node->type == JSON_FLOAT ) ?	(uint8_t)JSON_CLAMP( node->valueDouble, 0, UINT8_MAX ) : defaultValue ) ) ) );
-}
-
-static inline int16_t ksJson_GetInt16( const ksJson * node, const int16_t defaultValue )
+	char *			buffer;			// buffered text followed by a terminating zero
+	size_t			bufferSize;
+	size_t			offset;			// start of the text that is not consumed yet
+	size_t			length;			// length of the buffered text
+	size_t			scanned;		// bytes of a partial string at 'offset' that were already scanned
+	bool			last;			// no more text follows the buffered text
+	bool			skipValue;		// skip the next value
+	bool			skipInString;
+	int				skipDepth;		// number of brackets to close while skipping
+	ksJsonPullState	state;
+	ksJsonPullEvent	event;			// last returned event
+	int				depth;
+	int				maxDepth;		// nesting limit, zero for JSON_DEFAULT_MAX_DEPTH
+	int				stackSize;
+	uint8_t *		stack;			// JSON_OBJECT or JSON_ARRAY for each open level, grows with the depth
+	char *			key;
+	ksJson			value;
+	const char *	error;
+} ksJsonPull;
+
+[[maybe_unused]] static void ksJsonPull_Init( ksJsonPull * parser )
 {
-	return	( ( node == NULL ) ?				defaultValue :
-			( ( node->type == JSON_INT ) ?		(int16_t)JSON_CLAMP( node->valueInt64, INT16_MIN, INT16_MAX ) :
-			( ( node->type == JSON_UINT ) ?		(int16_t)JSON_MIN( node->valueUint64, INT16_MAX ) :
-			( ( node->type == JSON_FLOAT ) ?	(int16_t)JSON_CLAMP( node->valueDouble, INT16_MIN, INT16_MAX ) : defaultValue ) ) ) );
+	memset( parser, 0, sizeof( ksJsonPull ) );
+	parser->state = JSON_PULL_STATE_VALUE;
+	parser->event = JSON_PULL_NEED_INPUT;
+	parser->value.type = JSON_NULL;
+	parser->value.valueString = (char *)"null";
 }
 
-static inline uint16_t ksJson_GetUint16( const ksJson * node, const uint16_t defaultValue )
+[[maybe_unused]] static void ksJsonPull_Destroy( ksJsonPull * parser )
 {
-	return	( ( node == NULL ) ?				defaultValue :
-			( ( node->type == JSON_UINT ) ?		(uint16_t)JSON_MIN( node->valueUint64, UINT16_MAX ) :
-			( ( node->type == JSON_INT ) ?		(uint16_t)JSON_CLAMP( node->valueInt64, 0, UINT16_MAX ) :
-			( ( node->type == JSON_FLOAT ) ?	(uint16_t)JSON_CLAMP( node->valueDouble, 0, UINT16_MAX ) : defaultValue ) ) ) );
+	free( parser->buffer );
+	free( parser->stack );
+	parser->buffer = NULL;
+	parser->bufferSize = 0;
+	parser->stack = NULL;
+	parser->stackSize = 0;
 }
 
-static inline int32_t ksJson_GetInt32( const ksJson * node, const int32_t defaultValue )
+[[maybe_unused]] static inline void ksJsonPull_SetMaxDepth( ksJsonPull * parser, const int maxDepth )
 {
-	return	( ( node == NULL ) ?				defaultValue :
-			( ( node->type == JSON_INT ) ?		(int32_t)JSON_CLAMP( node->valueInt64, INT32_MIN, INT32_MAX ) :
-			( ( node->type == JSON_UINT ) ?		(int32_t)JSON_MIN( node->valueUint64, INT32_MAX ) :
-			( ( node->type == JSON_FLOAT ) ?	(int32_t)JSON_CLAMP( node->valueDouble, INT32_MIN, INT32_MAX ) : defaultValue ) ) ) );
+	if ( parser != NULL )
+	{
+		parser->maxDepth = JSON_CLAMP( maxDepth, 1, UINT16_MAX );
+	}
 }
 
-static inline uint32_t ksJson_GetUint32( const ksJson * node, const uint32_t defaultValue )
+// Appends the next chunk of text. Pass 'last' with the final chunk, which may be empty.
+[[maybe_unused]] static void ksJsonPull_Feed( ksJsonPull * parser, const char * data, const size_t length, const bool last )
 {
-	return	( ( node == NULL ) ?				defaultValue :
-			( ( node->type == JSON_UINT ) ?		(uint32_t)JSON_MIN( node->valueUint64, UINT32_MAX ) :
-			( ( node->type == JSON_INT ) ?		(uint32_t)JSON_CLAMP( node->valueInt64, 0, UINT32_MAX ) :
-			( ( node->type == JSON_FLOAT ) ?	(uint32_t)JSON_CLAMP( node->valueDouble, 0, UINT32_MAX ) : defaultValue ) ) ) );
+	// Only the text that was not consumed yet is kept, which is at most a partial token.
+	const size_t remaining = parser->length - parser->offset;
+	if ( remaining + length + 1 > parser->bufferSize )
+	{
+		size_t newSize = JSON_MAX( parser->bufferSize * 2, (size_t)4096 );
+		while ( newSize < remaining + length + 1 )
+		{
+			newSize *= 2;
+		}
+		char * newBuffer = (char *) malloc( newSize );
+		if ( remaining > 0 )
+		{
+			memcpy( newBuffer, parser->buffer + parser->offset, remaining );
+		}
+		free( parser->buffer );
+		parser->buffer = newBuffer;
+		parser->bufferSize = newSize;
+	}
+	else if ( parser->offset > 0 )
+	{
+		memmove( parser->buffer, parser->buffer + parser->offset, remaining );
+	}
+	if ( length > 0 )
+	{
+		memcpy( parser->buffer + remaining, data, length );
+	}
+	parser->offset = 0;
+	parser->length = remaining + length;
+	parser->buffer[parser->length] = '\0';
+	parser->last = last;
+	parser->key = NULL;
+	parser->value.type = JSON_NULL;
+	parser->value.valueString = (char *)"null";
 }
 
-static inline int64_t ksJson_GetInt64( const ksJson * node, const int64_t defaultValue )
+// Called when the buffered text ends before the next token is complete.
+static ksJsonPullEvent ksJsonPull_EndOfInput( ksJsonPull * parser, const bool partial )
 {
-	return	( ( node == NULL ) ?				defaultValue :
-			( ( node->type == JSON_INT ) ?		(int64_t)node->valueInt64 :
-			( ( node->type == JSON_UINT ) ?		(int64_t)JSON_MIN( node->valueUint64, INT64_MAX ) :
-			( ( node->type == JSON_FLOAT ) ?	(int64_t)JSON_CLAMP( node->valueDouble, INT64_MIN, (double)INT64_MAX ) : defaultValue ) ) ) );
+	if ( !parser->last )
+	{
+		return JSON_PULL_NEED_INPUT;
+	}
+	if ( partial || parser->depth > 0 || parser->skipDepth > 0 || parser->skipValue || parser->state != JSON_PULL_STATE_VALUE )
+	{
+		parser->error = "unexpected end of text";
+		return JSON_PULL_ERROR;
+	}
+	return JSON_PULL_END;
 }
 
-static inline uint64_t ksJson_GetUint64( const ksJson * node, const uint64_t defaultValue )
+// Returns true if the closing quote of the string at 'offset' is buffered.
+static bool ksJsonPull_IsStringComplete( ksJsonPull * parser )
 {
-	return	( ( node == NULL ) ?				defaultValue :
-			( ( node->type == JSON_UINT ) ?		(uint64_t)node->valueUint64 :
-			( ( node->type == JSON_INT ) ?		(uint64_t)JSON_CLAMP( node->valueInt64, 0, INT64_MAX ) :
-			( ( node->type == JSON_FLOAT ) ?	(uint64_t)JSON_CLAMP( node->valueDouble, 0, (double)UINT64_MAX ) : defaultValue ) ) ) );
+	const char * start = parser->buffer + parser->offset;
+	const char * end = parser->buffer + parser->length;
+	const char * ptr = start + JSON_MAX( parser->scanned, (size_t)1 );
+	for ( ; ; )
+	{
+		ptr = ksJson_ScanString( ptr );
+		if ( ptr[0] == '\"' || ( ptr[0] == '\0' && ptr < end ) )
+		{
+			parser->scanned = 0;
+			return true;	// an embedded zero is reported by the string parser
+		}
+		if ( ptr >= end || ptr + 1 >= end )
+		{
+			parser->scanned = ptr - start;	// resume at the end or at an escape that is split
+			return false;
+		}
+		ptr += 2;
+	}
 }
 
-static inline float ksJson_GetFloat( const ksJson * node, const float defaultValue )
+static bool ksJsonPull_IsDelimiter( const char c )
 {
-	return	( ( node == NULL ) ?				defaultValue :
-			( ( node->type == JSON_FLOAT ) ?	(float)JSON_CLAMP( node->valueDouble, -FLT_MAX, FLT_MAX ) :
-			( ( node->type == JSON_INT ) ?		(float)node->valueInt64 :
-			( ( node->type == JSON_UINT ) ?		(float)node->valueUint64 : defaultValue ) ) ) );
+	return JSON_IS_WHITE_SPACE( c ) || c == ',' || c == ']' || c == '}' || c == ':' || c == '\0';
 }
 
-static inline double ksJson_GetDouble( const ksJson * node, const double defaultValue )
+// Scans for the bracket that closes the skipped object or array. Returns false if the buffered text ends first.
+static bool ksJsonPull_SkipContainer( ksJsonPull * parser )
 {
-	return	( ( node == NULL ) ?				defaultValue :
-			( ( node->type == JSON_FLOAT ) ?	(double)node->valueDouble :
-			( ( node->type == JSON_INT ) ?		(double)node->valueInt64 :
-			( ( node->type == JSON_UINT ) ?		(double)node->valueUint64 : defaultValue ) ) ) );
+	const char * end = parser->buffer + parser->length;
+	const char * ptr = parser->buffer + parser->offset;
+	while ( ptr < end )
+	{
+		if ( parser->skipInString )
+		{
+			ptr = ksJson_ScanString( ptr );
+			if ( ptr[0] == '\\' )
+			{
+				if ( ptr + 1 >= end )
+				{
+					break;
+				}
+				ptr += 2;
+				continue;
+			}
+			if ( ptr < end )
+			{
+				parser->skipInString = ( ptr[0] != '\"' );
+				ptr++;
+			}
+			continue;
+		}
+		ptr += strcspn( ptr, "\"{}[]" );
+		if ( ptr >= end )
+		{
+			break;
+		}
+		const char c = *ptr++;
+		if ( c == '\"' )
+		{
+			parser->skipInString = true;
+		}
+		else if ( c == '{' || c == '[' )
+		{
+			parser->skipDepth++;
+		}
+		else if ( c == '}' || c == ']' )
+		{
+			if ( --parser->skipDepth == 0 )
+			{
+				parser->offset = ptr - parser->buffer;
+				return true;
+			}
+		}
+	}
+	parser->offset = ptr - parser->buffer;
+	return false;
 }
 
-static inline const char * ksJson_GetString( const ksJson * node, const char * defaultValue )
+static void ksJsonPull_EndValue( ksJsonPull * parser )
 {
-	return ksJson_IsString( node ) ? node->valueString : defaultValue;
+	parser->state = ( parser->depth > 0 ) ? JSON_PULL_STATE_NEXT : JSON_PULL_STATE_VALUE;
 }
 
-static inline ksJson * ksJson_AddObjectMember( ksJson * node, const char * name )
+static ksJsonPullEvent ksJsonPull_Close( ksJsonPull * parser, const char c )
 {
-	if ( node != NULL && node->type == JSON_OBJECT )
+	const bool isObject = ( parser->stack[parser->depth - 1] == JSON_OBJECT );
+	if ( c != ( isObject ? '}' : ']' ) )
 	{
-		assert( name != NULL );
-		ksJson * member = ksJson_AllocMember( node );
-		const size_t length = strlen( name );
-		member->name = (char *) malloc( length + 1 );
-		strcpy( member->name, name );
-		member->name[length] = '\0';
-		return member;
+		parser->error = ( parser->state == JSON_PULL_STATE_NEXT ) ? "missing comma" : "missing value";
+		return JSON_PULL_ERROR;
 	}
-	return NULL;
+	parser->offset++;
+	parser->depth--;
+	ksJsonPull_EndValue( parser );
+	return isObject ? JSON_PULL_END_OBJECT : JSON_PULL_END_ARRAY;
 }
 
-static inline ksJson * ksJson_AddArrayElement( ksJson * node )
+static ksJsonPullEvent ksJsonPull_ParseValue( ksJsonPull * parser, char * start )
 {
-	if ( node != NULL && node->type == JSON_ARRAY )
+	const char c = start[0];
+	if ( c == '{' || c == '[' )
 	{
-		ksJson * element = ksJson_AllocMember( node );
-		return element;
+		if ( parser->depth >= ( ( parser->maxDepth != 0 ) ? parser->maxDepth : JSON_DEFAULT_MAX_DEPTH ) )
+		{
+			parser->error = "maximum depth";
+			return JSON_PULL_ERROR;
+		}
+		if ( parser->depth == parser->stackSize )
+		{
+			parser->stackSize = JSON_MAX( 2 * parser->stackSize, JSON_PARSE_STACK_SIZE );
+			parser->stack = (uint8_t *) realloc( parser->stack, parser->stackSize );
+		}
+		parser->stack[parser->depth++] = ( c == '{' ) ? JSON_OBJECT : JSON_ARRAY;
+		parser->offset++;
+		parser->state = ( c == '{' ) ? JSON_PULL_STATE_FIRST_KEY : JSON_PULL_STATE_FIRST_VALUE;
+		return ( c == '{' ) ? JSON_PULL_BEGIN_OBJECT : JSON_PULL_BEGIN_ARRAY;
 	}
-	return NULL;
-}
-
-static inline ksJson * ksJson_SetObject( ksJson * node )
-{
-	if ( node != NULL )
+	if ( c == '\"' )
 	{
-		ksJson_FreeNode( node, false );
-		node->type = JSON_OBJECT;
+		if ( !ksJsonPull_IsStringComplete( parser ) )
+		{
+			return ksJsonPull_EndOfInput( parser, true );
+		}
+		const char * end = ksJson_ParseStringInSitu( &parser->value.valueString, start, &parser->error );
+		if ( parser->error != NULL )
+		{
+			return JSON_PULL_ERROR;
+		}
+		parser->value.type = JSON_STRING;
+		parser->offset = end - parser->buffer;
+		ksJsonPull_EndValue( parser );
+		return JSON_PULL_VALUE;
 	}
-	return node;
-}
 
-static inline ksJson * ksJson_SetArray( ksJson * node )
-{
-	if ( node != NULL )
+	// A literal or number is complete once the character after it is buffered.
+	const char * end = start;
+	while ( !ksJsonPull_IsDelimiter( end[0] ) )
 	{
-		ksJson_FreeNode( node, false );
-		node->type = JSON_ARRAY;
+		end++;
 	}
-	return node;
-}
-
-static inline ksJson * ksJson_SetNull( ksJson * node )
-{
-	if ( node != NULL )
+	if ( end == parser->buffer + parser->length && !parser->last )
 	{
-		ksJson_FreeNode( node, false );
-		node->type = JSON_NULL;
-		node->valueString = (char *)"null";
+		return JSON_PULL_NEED_INPUT;
 	}
-	return node;
-}
-
-static inline ksJson * ksJson_SetBoolean( ksJson * node, const bool value )
-{
-	if ( node != NULL )
+	const size_t length = end - start;
+	if ( length == 4 && strncmp( start, "null", 4 ) == 0 )
 	{
-		ksJson_FreeNode( node, false );
-		node->type = JSON_BOOLEAN;
-		node->valueString = value ? (char *)"true" : (char *)"false";
+		parser->value.type = JSON_NULL;
+		parser->value.valueString = (char *)"null";
 	}
-	return node;
-}
-
-static inline ksJson * ksJson_SetInt8( ksJson * node, const int8_t value )
-{
-	if ( node != NULL )
+	else if ( length == 4 && strncmp( start, "true", 4 ) == 0 )
 	{
-		ksJson_FreeNode( node, false );
-		node->type = JSON_INT;
-		node->valueInt64 = value;
+		parser->value.type = JSON_BOOLEAN;
+		parser->value.valueString = (char *)"true";
 	}
-	return node;
+	else if ( length == 5 && strncmp( start, "false", 5 ) == 0 )
+	{
+		parser->value.type = JSON_BOOLEAN;
+		parser->value.valueString = (char *)"false";
+	}
+	else
+	{
+		const char * digits = start + ( c == '-' );
+		if ( digits[0] < '0' || digits[0] > '9' ||
+				ksJson_ParseNumber( &parser->value.type, &parser->value.valueInt64, &parser->value.valueUint64, &parser->value.valueDouble,
+									start, &parser->error ) != end )
+		{
+			parser->error = ( c == '-' || ( c >= '0' && c <= '9' ) ) ? "invalid number" : "invalid value";
+			return JSON_PULL_ERROR;
+		}
+	}
+	parser->offset = end - parser->buffer;
+	ksJsonPull_EndValue( parser );
+	return JSON_PULL_VALUE;
 }
 
-static inline ksJson * ksJson_SetUint8( ksJson * node, const uint8_t value )
+static ksJsonPullEvent ksJsonPull_NextEvent( ksJsonPull * parser )
 {
-	if ( node != NULL )
+	for ( ; ; )
 	{
-		ksJson_FreeNode( node, false );
-		node->type = JSON_UINT;
-		node->valueUint64 = value;
+		if ( parser->error != NULL )
+		{
+			return JSON_PULL_ERROR;
+		}
+		if ( parser->buffer == NULL )
+		{
+			return ksJsonPull_EndOfInput( parser, false );
+		}
+		if ( parser->skipDepth > 0 )
+		{
+			if ( !ksJsonPull_SkipContainer( parser ) )
+			{
+				return ksJsonPull_EndOfInput( parser, true );
+			}
+			ksJsonPull_EndValue( parser );
+		}
+
+		char * start = (char *)ksJson_ParseWhiteSpace( parser->buffer + parser->offset );
+		parser->offset = start - parser->buffer;
+		if ( parser->offset == parser->length )
+		{
+			return ksJsonPull_EndOfInput( parser, false );
+		}
+
+		ksJsonPullEvent event = JSON_PULL_ERROR;
+		switch ( parser->state )
+		{
+			case JSON_PULL_STATE_NEXT:
+			{
+				if ( start[0] == ',' )
+				{
+					parser->offset++;
+					parser->state = ( parser->stack[parser->depth - 1] == JSON_OBJECT ) ? JSON_PULL_STATE_KEY : JSON_PULL_STATE_VALUE;
+					continue;
+				}
+				return ksJsonPull_Close( parser, start[0] );
+			}
+			case JSON_PULL_STATE_COLON:
+			{
+				if ( start[0] != ':' )
+				{
+					parser->error = "missing colon";
+					return JSON_PULL_ERROR;
+				}
+				parser->offset++;
+				parser->state = JSON_PULL_STATE_VALUE;
+				continue;
+			}
+			case JSON_PULL_STATE_FIRST_KEY:
+			case JSON_PULL_STATE_KEY:
+			{
+				if ( start[0] == '}' && parser->state == JSON_PULL_STATE_FIRST_KEY )
+				{
+					return ksJsonPull_Close( parser, start[0] );
+				}
+				if ( start[0] != '\"' )
+				{
+					parser->error = "missing member name";
+					return JSON_PULL_ERROR;
+				}
+				if ( !ksJsonPull_IsStringComplete( parser ) )
+				{
+					return ksJsonPull_EndOfInput( parser, true );
+				}
+				const char * end = ksJson_ParseStringInSitu( &parser->key, start, &parser->error );
+				if ( parser->error != NULL )
+				{
+					return JSON_PULL_ERROR;
+				}
+				parser->offset = end - parser->buffer;
+				parser->state = JSON_PULL_STATE_COLON;
+				return JSON_PULL_KEY;
+			}
+			case JSON_PULL_STATE_FIRST_VALUE:
+			case JSON_PULL_STATE_VALUE:
+			{
+				if ( start[0] == ']' && parser->state == JSON_PULL_STATE_FIRST_VALUE )
+				{
+					return ksJsonPull_Close( parser, start[0] );
+				}
+				event = ksJsonPull_ParseValue( parser, start );
+				break;
+			}
+		}
+		if ( parser->skipValue && ( event == JSON_PULL_VALUE || event == JSON_PULL_BEGIN_OBJECT || event == JSON_PULL_BEGIN_ARRAY ) )
+		{
+			parser->skipValue = false;
+			if ( event != JSON_PULL_VALUE )
+			{
+				parser->depth--;
+				parser->skipDepth = 1;
+				parser->skipInString = false;
+			}
+			continue;
+		}
+		return event;
 	}
-	return node;
 }
 
-static inline ksJson * ksJson_SetInt16( ksJson * node, const int16_t value )
+// Returns the next event. The member name and value of the event are valid until the next call.
+[[maybe_unused]] static ksJsonPullEvent ksJsonPull_Next( ksJsonPull * parser )
 {
-	if ( node != NULL )
+	parser->event = ksJsonPull_NextEvent( parser );
+	return parser->event;
+}
+
+// After JSON_PULL_BEGIN_OBJECT or JSON_PULL_BEGIN_ARRAY, skips the rest of the object or array including its end.
+// After JSON_PULL_KEY, skips the value of the member.
+[[maybe_unused]] static void ksJsonPull_Skip( ksJsonPull * parser )
+{
+	if ( parser->event == JSON_PULL_BEGIN_OBJECT || parser->event == JSON_PULL_BEGIN_ARRAY )
 	{
-		ksJson_FreeNode( node, false );
-		node->type = JSON_INT;
-		node->valueInt64 = value;
+		parser->depth--;
+		parser->skipDepth = 1;
+		parser->skipInString = false;
+	}
+	else if ( parser->event == JSON_PULL_KEY )
+	{
+		parser->skipValue = true;
 	}
-	return node;
 }
 
-static inline ksJson * ksJson_SetUint16( ksJson * node, const uint16_t value )
+[[maybe_unused]] static const char * ksJsonPull_GetKey( const ksJsonPull * parser )
 {
-	if ( node != NULL )
+	return ( parser->event == JSON_PULL_KEY ) ? parser->key : NULL;
+}
+
+[[maybe_unused]] static const ksJson * ksJsonPull_GetValue( const ksJsonPull * parser )
+{
+	return ( parser->event == JSON_PULL_VALUE ) ? &parser->value : NULL;
+}
+
+[[maybe_unused]] static int ksJsonPull_GetDepth( const ksJsonPull * parser )
+{
+	return parser->depth;
+}
+
+[[maybe_unused]] static const char * ksJsonPull_GetError( const ksJsonPull * parser )
+{
+	return parser->error;
+}
+
+// Writes the shortest text that reads back as the same double, or as the same float for 'single' precision numbers.
+static int ksJson_FormatDouble( char * buffer, const double value, const bool single )
+{
+#if defined( __cplusplus )
+	return (int)( single ?	absl::numbers_internal::ShortestToBuffer( (float)value, buffer ) :
+							absl::numbers_internal::ShortestToBuffer( value, buffer ) );
+#else
+	return sprintf( buffer, single ? "%.9g" : "%.17g", value );
+#endif
+}
+
+/*
+================================================================================================
+
+Writer
+
+A ksJsonWriter emits JSON text token by token into a fixed-size buffer. Whenever the buffer
+is full, its contents are passed to a sink which may write them to a file, a socket or any
+other stream, after which the buffer is reused. Strings that do not fit in the buffer are
+passed to the sink in pieces. Documents can be written directly, without building a DOM,
+by calling the ksJsonWriter_Begin*, ksJsonWriter_End*, ksJsonWriter_Key and value functions
+in document order. A DOM, or part of one, is written with ksJsonWriter_Node(). If the sink
+fails, all remaining output is discarded and ksJsonWriter_Finish() returns false.
+
+Without a sink the writer grows a buffer allocated with malloc instead of flushing it.
+
+By default every object member and array element is written on a new line indented with
+tabs. JSON_WRITE_COMPACT writes no white space at all.
+
+================================================================================================
+*/
+
+typedef bool ( *ksJsonSinkFunc )( void * context, const char * data, const size_t length );
+
+#define JSON_WRITE_COMPACT			1	// no white space between tokens
+#define JSON_WRITER_MIN_BUFFER		64	// a fixed buffer must at least fit any number
+
+typedef struct ksJsonWriter
+{
+	char *				buffer;
+	size_t				bufferSize;
+	size_t				length;				// number of bytes in the buffer that are not flushed yet
+	ksJsonSinkFunc		sink;				// NULL to grow the buffer instead of flushing it
+	void *				sinkContext;
+	int					flags;				// JSON_WRITE_*
+	int					depth;				// number of open objects and arrays
+	int					maxDepth;			// objects and arrays nested deeper are written as null by ksJsonWriter_Node()
+	bool				first;				// nothing was written yet to the innermost object or array
+	bool				afterKey;			// a member name was written and its value is next
+	bool				failed;				// the sink failed, all remaining output is discarded
+} ksJsonWriter;
+
+// With a sink, 'buffer' is flushed whenever it is full. Without a sink, 'buffer' must be NULL
+// and the writer allocates a buffer that is owned by the caller after ksJsonWriter_Finish().
+static void ksJsonWriter_Init( ksJsonWriter * writer, char * buffer, const size_t bufferSize, ksJsonSinkFunc sink, void * sinkContext, const int flags )
+{
+	assert( ( sink != NULL ) ? ( buffer != NULL && bufferSize >= JSON_WRITER_MIN_BUFFER ) : ( buffer == NULL ) );
+	writer->buffer = buffer;
+	writer->bufferSize = ( sink != NULL ) ? bufferSize : 0;
+	writer->length = 0;
+	writer->sink = sink;
+	writer->sinkContext = sinkContext;
+	writer->flags = flags;
+	writer->depth = 0;
+	writer->maxDepth = JSON_DEFAULT_MAX_DEPTH;
+	writer->first = true;
+	writer->afterKey = false;
+	writer->failed = false;
+}
+
+static void ksJsonWriter_Flush( ksJsonWriter * writer )
+{
+	if ( writer->sink != NULL && writer->length > 0 )
 	{
-		ksJson_FreeNode( node, false );
-		node->type = JSON_UINT;
-		node->valueUint64 = value;
+		if ( !writer->failed && !writer->sink( writer->sinkContext, writer->buffer, writer->length ) )
+		{
+			writer->failed = true;
+		}
+		writer->length = 0;
 	}
-	return node;
 }
 
-static inline ksJson * ksJson_SetInt32( ksJson * node, const int32_t value )
+// Returns a pointer to at least 'bytes' free bytes at the end of the buffer.
+static char * ksJsonWriter_Reserve( ksJsonWriter * writer, const size_t bytes )
 {
-	if ( node != NULL )
+	if ( writer->length + bytes > writer->bufferSize )
 	{
-		ksJson_FreeNode( node, false );
-		node->type = JSON_INT;
-		node->valueInt64 = value;
+		if ( writer->sink != NULL )
+		{
+			assert( bytes <= writer->bufferSize );
+			ksJsonWriter_Flush( writer );
+		}
+		else
+		{
+			size_t newSize = JSON_MAX( writer->bufferSize * 2, (size_t)256 );
+			while ( newSize < writer->length + bytes )
+			{
+				newSize *= 2;
+			}
+			writer->buffer = (char *) realloc( writer->buffer, newSize );
+			writer->bufferSize = newSize;
+		}
 	}
-	return node;
+	return writer->buffer + writer->length;
 }
 
-static inline ksJson * ksJson_SetUint32( ksJson * node, const uint32_t value )
+static void ksJsonWriter_Append( ksJsonWriter * writer, const char * data, const size_t length )
 {
-	if ( node != NULL )
+	if ( writer->sink != NULL && writer->length + length > writer->bufferSize )
 	{
-		ksJson_FreeNode( node, false );
-		node->type = JSON_UINT;
-		node->valueUint64 = value;
+		ksJsonWriter_Flush( writer );
+		if ( length > writer->bufferSize )
+		{
+			if ( !writer->failed && !writer->sink( writer->sinkContext, data, length ) )
+			{
+				writer->failed = true;
+			}
+			return;
+		}
 	}
-	return node;
+	memcpy( ksJsonWriter_Reserve( writer, length ), data, length );
+	writer->length += length;
 }
 
-static inline ksJson * ksJson_SetInt64( ksJson * node, const int64_t value )
+static void ksJsonWriter_PutChar( ksJsonWriter * writer, const char c )
 {
-	if ( node != NULL )
+	ksJsonWriter_Reserve( writer, 1 )[0] = c;
+	writer->length++;
+}
+
+static void ksJsonWriter_NewLine( ksJsonWriter * writer )
+{
+	ksJsonWriter_PutChar( writer, '\n' );
+	for ( int remaining = writer->depth; remaining > 0; )
 	{
-		ksJson_FreeNode( node, false );
-		node->type = JSON_INT;
-		node->valueInt64 = value;
+		const int count = JSON_MIN( remaining, JSON_WRITER_MIN_BUFFER );
+		memset( ksJsonWriter_Reserve( writer, count ), '\t', count );
+		writer->length += count;
+		remaining -= count;
 	}
-	return node;
 }
 
-static inline ksJson * ksJson_SetUint64( ksJson * node, const uint64_t value )
+// Writes the separator and indentation in front of an object member or array element.
+static void ksJsonWriter_BeginToken( ksJsonWriter * writer )
 {
-	if ( node != NULL )
+	if ( writer->afterKey )
 	{
-		ksJson_FreeNode( node, false );
-		node->type = JSON_UINT;
-		node->valueUint64 = value;
+		writer->afterKey = false;
+		return;
 	}
-	return node;
+	if ( writer->depth > 0 )
+	{
+		if ( !writer->first )
+		{
+			ksJsonWriter_PutChar( writer, ',' );
+		}
+		if ( ( writer->flags & JSON_WRITE_COMPACT ) == 0 )
+		{
+			ksJsonWriter_NewLine( writer );
+		}
+	}
+	writer->first = false;
 }
 
-static inline ksJson * ksJson_SetFloat( ksJson * node, const float value )
+// Terminates an indented document with a new line.
+static void ksJsonWriter_EndToken( ksJsonWriter * writer )
 {
-	if ( node != NULL )
+	if ( writer->depth == 0 && ( writer->flags & JSON_WRITE_COMPACT ) == 0 )
 	{
-		ksJson_FreeNode( node, false );
-		node->type = JSON_FLOAT;
-		node->valueDouble = value;
+		ksJsonWriter_PutChar( writer, '\n' );
 	}
-	return node;
 }
 
-static inline ksJson * ksJson_SetDouble( ksJson * node, const double value )
+// Writes the escape sequence of a quote, backslash or control character.
+static void ksJsonWriter_EscapeChar( ksJsonWriter * writer, const unsigned char c )
 {
-	if ( node != NULL )
+	char * out = ksJsonWriter_Reserve( writer, 6 );
+	out[0] = '\\';
+	switch ( c )
 	{
-		ksJson_FreeNode( node, false );
-		node->type = JSON_FLOAT;
-		node->valueDouble = value;
+		case '\\': out[1] = '\\'; break;
+		case '\"': out[1] = '\"'; break;
+		case '\b': out[1] = 'b'; break;
+		case '\f': out[1] = 'f'; break;
+		case '\n': out[1] = 'n'; break;
+		case '\r': out[1] = 'r'; break;
+		case '\t': out[1] = 't'; break;
+		default:
+		{
+			out[1] = 'u';
+			out[2] = '0';
+			out[3] = '0';
+			out[4] = "0123456789abcdef"[c >> 4];
+			out[5] = "0123456789abcdef"[c & 15];
+			writer->length += 4;
+			break;
+		}
 	}
-	return node;
+	writer->length += 2;
 }
 
-static inline ksJson * ksJson_SetString( ksJson * node, const char * value )
+static void ksJsonWriter_QuotedString( ksJsonWriter * writer, const char * string )
 {
-	if ( node != NULL )
+	ksJsonWriter_PutChar( writer, '\"' );
+	const char * run = string;
+	for ( const char * ptr = string; ; ptr++ )
 	{
-		assert( value != NULL );
-		ksJson_FreeNode( node, false );
-		node->type = JSON_STRING;
-		const int length = (int)strlen( value );
-		node->valueString = (char *) malloc( length + 1 );
-		strcpy( node->valueString, value );
+		const unsigned char c = (unsigned char)ptr[0];
+		if ( c >= ' ' && c != '\"' && c != '\\' )
+		{
+			continue;
+		}
+		ksJsonWriter_Append( writer, run, ptr - run );
+		if ( c == '\0' )
+		{
+			break;
+		}
+		run = ptr + 1;
+		ksJsonWriter_EscapeChar( writer, c );
 	}
-	return node;
+	ksJsonWriter_PutChar( writer, '\"' );
+}
+
+// Like ksJsonWriter_QuotedString() but for a string of known length, where a zero is escaped.
+static void ksJsonWriter_QuotedStringLength( ksJsonWriter * writer, const char * string, const size_t length )
+{
+	ksJsonWriter_PutChar( writer, '\"' );
+	const char * run = string;
+	const char * end = string + length;
+	for ( const char * ptr = string; ptr < end; ptr++ )
+	{
+		const unsigned char c = (unsigned char)ptr[0];
+		if ( c >= ' ' && c != '\"' && c != '\\' )
+		{
+			continue;
+		}
+		ksJsonWriter_Append( writer, run, ptr - run );
+		run = ptr + 1;
+		ksJsonWriter_EscapeChar( writer, c );
+	}
+	ksJsonWriter_Append( writer, run, end - run );
+	ksJsonWriter_PutChar( writer, '\"' );
+}
+
+static void ksJsonWriter_Open( ksJsonWriter * writer, const char c )
+{
+	ksJsonWriter_BeginToken( writer );
+	ksJsonWriter_PutChar( writer, c );
+	writer->depth++;
+	writer->first = true;
+}
+
+static void ksJsonWriter_Close( ksJsonWriter * writer, const char c )
+{
+	assert( writer->depth > 0 && !writer->afterKey );
+	writer->depth--;
+	if ( ( writer->flags & JSON_WRITE_COMPACT ) == 0 )
+	{
+		ksJsonWriter_NewLine( writer );
+	}
+	ksJsonWriter_PutChar( writer, c );
+	writer->first = false;
+	ksJsonWriter_EndToken( writer );
+}
+
+[[maybe_unused]] static void ksJsonWriter_BeginObject( ksJsonWriter * writer ) { ksJsonWriter_Open( writer, '{' ); }
+[[maybe_unused]] static void ksJsonWriter_EndObject( ksJsonWriter * writer ) { ksJsonWriter_Close( writer, '}' ); }
+[[maybe_unused]] static void ksJsonWriter_BeginArray( ksJsonWriter * writer ) { ksJsonWriter_Open( writer, '[' ); }
+[[maybe_unused]] static void ksJsonWriter_EndArray( ksJsonWriter * writer ) { ksJsonWriter_Close( writer, ']' ); }
+
+// Writes the name of the next object member, which must be followed by its value.
+static void ksJsonWriter_Key( ksJsonWriter * writer, const char * name )
+{
+	assert( writer->depth > 0 && !writer->afterKey );
+	ksJsonWriter_BeginToken( writer );
+	ksJsonWriter_QuotedString( writer, name );
+	if ( ( writer->flags & JSON_WRITE_COMPACT ) != 0 )
+	{
+		ksJsonWriter_PutChar( writer, ':' );
+	}
+	else
+	{
+		ksJsonWriter_Append( writer, " : ", 3 );
+	}
+	writer->afterKey = true;
+}
+
+static void ksJsonWriter_Literal( ksJsonWriter * writer, const char * literal )
+{
+	ksJsonWriter_BeginToken( writer );
+	ksJsonWriter_Append( writer, literal, strlen( literal ) );
+	ksJsonWriter_EndToken( writer );
+}
+
+[[maybe_unused]] static void ksJsonWriter_Null( ksJsonWriter * writer ) { ksJsonWriter_Literal( writer, "null" ); }
+[[maybe_unused]] static void ksJsonWriter_Bool( ksJsonWriter * writer, const bool value ) { ksJsonWriter_Literal( writer, value ? "true" : "false" ); }
+
+static void ksJsonWriter_Int64( ksJsonWriter * writer, const int64_t value )
+{
+	ksJsonWriter_BeginToken( writer );
+	char * out = ksJsonWriter_Reserve( writer, 32 );
+#if defined( __cplusplus )
+	writer->length += absl::numbers_internal::FastIntToBuffer( value, out ) - out;
+#else
+	writer->length += sprintf( out, "%lld", (long long int)value );
+#endif
+	ksJsonWriter_EndToken( writer );
+}
+
+static void ksJsonWriter_Uint64( ksJsonWriter * writer, const uint64_t value )
+{
+	ksJsonWriter_BeginToken( writer );
+	char * out = ksJsonWriter_Reserve( writer, 32 );
+#if defined( __cplusplus )
+	writer->length += absl::numbers_internal::FastIntToBuffer( value, out ) - out;
+#else
+	writer->length += sprintf( out, "%llu", (unsigned long long int)value );
+#endif
+	ksJsonWriter_EndToken( writer );
+}
+
+static void ksJsonWriter_Number( ksJsonWriter * writer, const double value, const bool single )
+{
+	ksJsonWriter_BeginToken( writer );
+	writer->length += ksJson_FormatDouble( ksJsonWriter_Reserve( writer, 32 ), value, single );
+	ksJsonWriter_EndToken( writer );
+}
+
+[[maybe_unused]] static void ksJsonWriter_Float( ksJsonWriter * writer, const float value ) { ksJsonWriter_Number( writer, value, true ); }
+[[maybe_unused]] static void ksJsonWriter_Double( ksJsonWriter * writer, const double value ) { ksJsonWriter_Number( writer, value, false ); }
+
+static void ksJsonWriter_String( ksJsonWriter * writer, const char * value )
+{
+	ksJsonWriter_BeginToken( writer );
+	ksJsonWriter_QuotedString( writer, ( value != NULL ) ? value : "" );
+	ksJsonWriter_EndToken( writer );
+}
+
+[[maybe_unused]] static void ksJsonWriter_StringLength( ksJsonWriter * writer, const char * value, const size_t length )
+{
+	ksJsonWriter_BeginToken( writer );
+	ksJsonWriter_QuotedStringLength( writer, ( value != NULL ) ? value : "", ( value != NULL ) ? length : 0 );
+	ksJsonWriter_EndToken( writer );
+}
+
+// Writes a byte string as a base64 encoded string.
+static void ksJsonWriter_Bytes( ksJsonWriter * writer, const void * data, const size_t length )
+{
+	static const char base64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	const uint8_t * bytes = (const uint8_t *)data;
+	ksJsonWriter_BeginToken( writer );
+	ksJsonWriter_PutChar( writer, '\"' );
+	for ( size_t i = 0; i < length; i += 3 )
+	{
+		const size_t remaining = length - i;
+		const uint32_t triple = ( bytes[i] << 16 ) | ( ( remaining > 1 ) ? bytes[i + 1] << 8 : 0 ) | ( ( remaining > 2 ) ? bytes[i + 2] : 0 );
+		char * out = ksJsonWriter_Reserve( writer, 4 );
+		out[0] = base64[( triple >> 18 ) & 63];
+		out[1] = base64[( triple >> 12 ) & 63];
+		out[2] = ( remaining > 1 ) ? base64[( triple >> 6 ) & 63] : '=';
+		out[3] = ( remaining > 2 ) ? base64[triple & 63] : '=';
+		writer->length += 4;
+	}
+	ksJsonWriter_PutChar( writer, '\"' );
+	ksJsonWriter_EndToken( writer );
+}
+
+// Writes a null, boolean, number or string node.
+static inline void ksJsonWriter_Leaf( ksJsonWriter * writer, const ksJson * node )
+{
+	if ( node->type == JSON_NULL || node->type == JSON_BOOLEAN )
+	{
+		ksJsonWriter_Literal( writer, node->valueString );
+	}
+	else if ( node->type == JSON_INT )
+	{
+		ksJsonWriter_Int64( writer, node->valueInt64 );
+	}
+	else if ( node->type == JSON_UINT )
+	{
+		ksJsonWriter_Uint64( writer, node->valueUint64 );
+	}
+	else if ( node->type == JSON_FLOAT )
+	{
+		ksJsonWriter_Number( writer, node->valueDouble, ( node->flags & JSON_FLAG_SINGLE ) != 0 );
+	}
+	else if ( node->type == JSON_STRING && ( node->flags & JSON_FLAG_BYTES ) != 0 )
+	{
+		ksJsonWriter_Bytes( writer, node->valueString, ksJson_GetBytesLength( node ) );
+	}
+	else if ( node->type == JSON_STRING )
+	{
+		ksJsonWriter_String( writer, node->valueString );
+	}
+}
+
+// An object or array that is being written by ksJsonWriter_Node().
+typedef struct ksJsonWriterFrame
+{
+	const ksJson *	node;
+	const ksJson *	members;				// current member map
+	int				mapIndex;
+	int				mapMemberCount;			// number of members in the current member map
+	int				index;					// next member in the current member map
+	int				remaining;				// number of members that are not written yet
+} ksJsonWriterFrame;
+
+// Writes a DOM node with all its members. Instead of recursing, the objects and arrays that are
+// still open are kept on an explicit stack. Objects and arrays nested deeper than 'maxDepth'
+// of the writer are written as null.
+static void ksJsonWriter_Node( ksJsonWriter * writer, const ksJson * node )
+{
+	ksJsonWriterFrame localStack[JSON_PARSE_STACK_SIZE];
+	ksJsonWriterFrame * stack = localStack;
+	int stackSize = JSON_PARSE_STACK_SIZE;
+	int depth = 0;
+
+	for ( ;; )
+	{
+		if ( node->type != JSON_OBJECT && node->type != JSON_ARRAY )
+		{
+			ksJsonWriter_Leaf( writer, node );
+		}
+		else if ( writer->depth >= writer->maxDepth )
+		{
+			ksJsonWriter_Literal( writer, "null" );
+		}
+		else
+		{
+			ksJsonWriter_Open( writer, ( node->type == JSON_OBJECT ) ? '{' : '[' );
+			if ( node->memberCount > 0 )
+			{
+				if ( depth == stackSize )
+				{
+					ksJsonWriterFrame * newStack = (ksJsonWriterFrame *) malloc( 2 * stackSize * sizeof( ksJsonWriterFrame ) );
+					memcpy( newStack, stack, stackSize * sizeof( ksJsonWriterFrame ) );
+					if ( stack != localStack )
+					{
+						free( stack );
+					}
+					stack = newStack;
+					stackSize *= 2;
+				}
+				ksJsonWriterFrame * frame = &stack[depth++];
+				frame->node = node;
+				frame->members = node->memberMap[0];
+				frame->mapIndex = 0;
+				frame->mapMemberCount = MapMemberCount( 0, node->memberCount );
+				frame->index = 0;
+				frame->remaining = node->memberCount;
+			}
+			else
+			{
+				ksJsonWriter_Close( writer, ( node->type == JSON_OBJECT ) ? '}' : ']' );
+			}
+		}
+
+		// Close the objects and arrays that are complete and continue
+		// with the next member of the innermost one that is still open.
+		while ( depth > 0 )
+		{
+			ksJsonWriterFrame * frame = &stack[depth - 1];
+			if ( frame->remaining == 0 )
+			{
+				ksJsonWriter_Close( writer, ( frame->node->type == JSON_OBJECT ) ? '}' : ']' );
+				depth--;
+				continue;
+			}
+			if ( frame->index == frame->mapMemberCount )
+			{
+				frame->mapIndex++;
+				frame->members = frame->node->memberMap[frame->mapIndex];
+				frame->mapMemberCount = MapMemberCount( frame->mapIndex, frame->node->memberCount );
+				frame->index = 0;
+			}
+			node = &frame->members[frame->index++];
+			frame->remaining--;
+			if ( frame->node->type == JSON_OBJECT )
+			{
+				ksJsonWriter_Key( writer, node->name );
+			}
+			break;
+		}
+		if ( depth == 0 )
+		{
+			break;
+		}
+	}
+
+	if ( stack != localStack )
+	{
+		free( stack );
+	}
+}
+
+// Flushes the remaining output. Returns false if the sink failed.
+static bool ksJsonWriter_Finish( ksJsonWriter * writer )
+{
+	assert( writer->depth == 0 && !writer->afterKey );
+	ksJsonWriter_Flush( writer );
+	return !writer->failed;
+}
+
+// Sink that writes to a FILE opened in binary mode.
+static bool ksJsonWriter_FileSink( void * context, const char * data, const size_t length )
+{
+	return fwrite( data, 1, length, (FILE *)context ) == length;
+}
+
+// 'lengthOut' is the length of 'bufferOut' without trailing zero.
+static inline bool ksJson_WriteToBuffer( const ksJson * rootNode, char ** bufferOut, int * lengthOut )
+{
+	if ( rootNode == NULL || bufferOut == NULL || lengthOut == NULL )
+	{
+		return false;
+	}
+	ksJsonWriter writer;
+	ksJsonWriter_Init( &writer, NULL, 0, NULL, NULL, 0 );
+	writer.maxDepth = ksJson_GetMaxDepth( rootNode );
+	ksJsonWriter_Node( &writer, rootNode );
+	ksJsonWriter_Reserve( &writer, 1 )[0] = '\0';
+	*bufferOut = writer.buffer;
+	*lengthOut = (int)writer.length;
+	return true;
+}
+
+[[maybe_unused]] static bool ksJson_WriteToFile( const ksJson * rootNode, const char * fileName )
+{
+	if ( rootNode == NULL || fileName == NULL )
+	{
+		return false;
+	}
+	FILE * file = fopen( fileName, "wb" );
+	if ( file == NULL )
+	{
+		return false;
+	}
+	char buffer[16 * 1024];
+	ksJsonWriter writer;
+	ksJsonWriter_Init( &writer, buffer, sizeof( buffer ), ksJsonWriter_FileSink, file, 0 );
+	writer.maxDepth = ksJson_GetMaxDepth( rootNode );
+	ksJsonWriter_Node( &writer, rootNode );
+	const bool success = ksJsonWriter_Finish( &writer );
+	return ( fclose( file ) == 0 ) && success;
+}
+
+[[maybe_unused]] static int ksJson_GetMemberCount( const ksJson * node )
+{
+	if ( node != NULL )
+	{
+		assert( node->type >= JSON_NULL && node->type <= JSON_ARRAY );
+		return node->memberCount;
+	}
+	return 0;
+}
+
+static ksJson * ksJson_GetMemberByIndex( const ksJson * node, const int index )
+{
+	if ( node != NULL )
+	{
+		assert( node->type >= JSON_NULL && node->type <= JSON_ARRAY );
+		if ( node->type == JSON_OBJECT || node->type == JSON_ARRAY )
+		{
+			if ( index >= 0 && index < node->memberCount )
+			{
+				const int mapIndex = MemberIndexToMapIndex( index );
+				const int memberOffset = MapMemberOffset( mapIndex );
+				return &node->memberMap[mapIndex][index - memberOffset];
+			}
+		}
+	}
+	return NULL;
+}
+
+// Returns the index of an object member or array element, or -1 if 'member' is not one of them.
+[[maybe_unused]] static int ksJson_GetMemberIndex( const ksJson * node, const ksJson * member )
+{
+	if ( node != NULL && ( node->type == JSON_OBJECT || node->type == JSON_ARRAY ) && node->memberCount > 0 )
+	{
+		const int endMapIndex = MemberIndexToMapIndex( node->memberCount - 1 );
+		for ( int mapIndex = 0; mapIndex <= endMapIndex; mapIndex++ )
+		{
+			const ksJson * members = node->memberMap[mapIndex];
+			const int mapMemberCount = MapMemberCount( mapIndex, node->memberCount );
+			if ( (uintptr_t)member >= (uintptr_t)members && (uintptr_t)member < (uintptr_t)( members + mapMemberCount ) )
+			{
+				return MapMemberOffset( mapIndex ) + (int)( member - members );
+			}
+		}
+	}
+	return -1;
+}
+
+/*
+================================================================================================
+
+Lookup hints
+
+Looking up an object member by name continues where the previous lookup in the same object
+left off. The position is kept per thread in a small table indexed by the address of the object,
+instead of in the object itself, so lookups never write to the DOM and any number of threads
+can read the same DOM concurrently. A hint is only where the search starts, so a hint that is
+evicted, or that belongs to an object that was freed or changed, only makes a lookup slower.
+
+================================================================================================
+*/
+
+// In C++ there is one table per thread for the whole program. In C every source file has its own
+// table, which only costs the hints of lookups made from other source files.
+#if defined( __cplusplus )
+	#define JSON_THREAD_LOCAL	inline thread_local
+#elif defined( _MSC_VER )
+	#define JSON_THREAD_LOCAL	static __declspec( thread )
+#else
+	#define JSON_THREAD_LOCAL	static _Thread_local
+#endif
+
+#define JSON_LOOKUP_HINTS		64		// power of two
+
+typedef struct ksJsonLookupHint
+{
+	const ksJson *	node;
+	int				memberIndex;		// member after the last member found
+} ksJsonLookupHint;
+
+JSON_THREAD_LOCAL ksJsonLookupHint json_lookupHints[JSON_LOOKUP_HINTS];
+
+static ksJsonLookupHint * ksJson_GetLookupHint( const ksJson * node )
+{
+	const uintptr_t key = (uintptr_t)node / sizeof( ksJson );
+	return &json_lookupHints[( key ^ ( key >> 6 ) ) & ( JSON_LOOKUP_HINTS - 1 )];
+}
+
+// The members of an arena DOM share the interned names, which are compared by pointer.
+static inline bool ksJson_NameEquals( const char * memberName, const char * name, const char * interned )
+{
+	return ( interned != NULL ) ? memberName == interned : strcmp( memberName, name ) == 0;
+}
+
+static ksJson * ksJson_GetMemberByName( const ksJson * node, const char * name )
+{
+	if ( node != NULL && node->type == JSON_OBJECT && node->memberCount > 0 )
+	{
+		assert( name != NULL );
+		const ksJsonArena * arena = ksJson_GetArena( node );
+		const ksJsonHashIndex * index = ksJson_GetHashIndex( node );
+		const uint32_t hash = ( arena != NULL || index != NULL ) ? ksJson_HashName( name ) : 0;
+		const char * interned = NULL;
+		if ( arena != NULL )
+		{
+			interned = ksJsonArena_FindName( arena, name, hash );
+			if ( interned == NULL )
+			{
+				return NULL;
+			}
+		}
+		if ( index != NULL )
+		{
+			for ( uint32_t entry = hash & index->mask; index->entries[entry].memberIndex >= 0; entry = ( entry + 1 ) & index->mask )
+			{
+				if ( index->entries[entry].hash == hash )
+				{
+					const int memberIndex = index->entries[entry].memberIndex;
+					const int mapIndex = MemberIndexToMapIndex( memberIndex );
+					ksJson * member = &node->memberMap[mapIndex][memberIndex - MapMemberOffset( mapIndex )];
+					if ( ksJson_NameEquals( member->name, name, interned ) )
+					{
+						return member;
+					}
+				}
+			}
+			return NULL;
+		}
+		ksJsonLookupHint * hint = ksJson_GetLookupHint( node );
+		const int memberIndex = ( hint->node == node && hint->memberIndex < node->memberCount ) ? hint->memberIndex : 0;
+		const int startMapIndex = MemberIndexToMapIndex( memberIndex );
+		const int endMapIndex = MemberIndexToMapIndex( node->memberCount - 1 );
+		int firstMemberOffset = memberIndex - MapMemberOffset( startMapIndex );
+		for ( int mapIndex = startMapIndex; mapIndex <= endMapIndex; mapIndex++ )
+		{
+			ksJson * members = node->memberMap[mapIndex];
+			const int mapMemberCount = MapMemberCount( mapIndex, node->memberCount );
+			for ( int i = firstMemberOffset; i < mapMemberCount; i++ )
+			{
+				if ( ksJson_NameEquals( members[i].name, name, interned ) )
+				{
+					const int newMemberIndex = MapMemberOffset( mapIndex ) + i + 1;
+					hint->node = node;
+					hint->memberIndex = ( newMemberIndex < node->memberCount ) ? newMemberIndex : 0;
+					return &members[i];
+				}
+			}
+			firstMemberOffset = 0;
+		}
+		for ( int mapIndex = 0; mapIndex <= startMapIndex; mapIndex++ )
+		{
+			ksJson * members = node->memberMap[mapIndex];
+			const int mapMemberCount = MapMemberCount( mapIndex, memberIndex );
+			for ( int i = 0; i < mapMemberCount; i++ )
+			{
+				if ( ksJson_NameEquals( members[i].name, name, interned ) )
+				{
+					const int newMemberIndex = MapMemberOffset( mapIndex ) + i + 1;
+					hint->node = node;
+					hint->memberIndex = ( newMemberIndex < node->memberCount ) ? newMemberIndex : 0;
+					return &members[i];
+				}
+			}
+		}
+	}
+	return NULL;
+}
+
+[[maybe_unused]] static const char * ksJson_GetMemberName( const ksJson * node )
+{
+	if ( node != NULL && node->name != NULL )
+	{
+		assert( node->type >= JSON_NULL && node->type <= JSON_ARRAY );
+		return node->name;
+	}
+	return "";
+}
+
+static inline bool ksJson_IsNull( const ksJson * node )
+{
+	return ( node != NULL && node->type == JSON_NULL );
+}
+
+static inline bool ksJson_IsBoolean( const ksJson * node )
+{
+	return ( node != NULL && node->type == JSON_BOOLEAN );
+}
+
+static inline bool ksJson_IsNumber( const ksJson * node )
+{
+	return ( node != NULL && ( node->type == JSON_INT || node->type == JSON_UINT || node->type == JSON_FLOAT ) );
+}
+
+static inline bool ksJson_IsInteger( const ksJson * node )
+{
+	return ( node != NULL && ( node->type == JSON_INT || node->type == JSON_UINT ) );
+}
+
+static inline bool ksJson_IsUnsigned( const ksJson * node )
+{
+	return ( node != NULL && node->type == JSON_UINT );
+}
+
+static inline bool ksJson_IsFloatingPoint( const ksJson * node )
+{
+	return ( node != NULL && node->type == JSON_FLOAT );
+}
+
+static inline bool ksJson_IsString( const ksJson * node )
+{
+	return ( node != NULL && node->type == JSON_STRING );
+}
+
+static inline bool ksJson_IsObject( const ksJson * node )
+{
+	return ( node != NULL && node->type == JSON_OBJECT );
+}
+
+static inline bool ksJson_IsArray( const ksJson * node )
+{
+	return ( node != NULL && node->type == JSON_ARRAY );
+}
+
+static inline bool ksJson_GetBool( const ksJson * node, const bool defaultValue )
+{
+	return ksJson_IsBoolean( node ) ? node->valueString[0] == 't' : defaultValue;
+}
+
+static inline int8_t ksJson_GetInt8( const ksJson * node, const int8_t defaultValue )
+{
+	return	( ( node == NULL ) ?				defaultValue :
+			( ( node->type == JSON_INT ) ?		(int8_t)JSON_CLAMP( node->valueInt64, INT8_MIN, INT8_MAX ) :
+			( ( node->type == JSON_UINT ) ?		(int8_t)JSON_MIN( node->valueUint64, INT8_MAX ) :
+			( ( node->type == JSON_FLOAT ) ?	(int8_t)JSON_CLAMP( node->valueDouble, INT8_MIN, INT8_MAX ) : defaultValue ) ) ) );
+}
+
+static inline uint8_t ksJson_GetUint8( const ksJson * node, const uint8_t defaultValue )
+{
+	return	( ( node == NULL ) ?				defaultValue :
+			( ( node->type == JSON_UINT ) ?		(uint8_t)JSON_MIN( node->valueUint64, UINT8_MAX ) :
+			( ( node->type == JSON_INT ) ?		(uint8_t)JSON_CLAMP( node->valueInt64, 0, UINT8_MAX ) :
+			( ( node->type == JSON_FLOAT ) ?	(uint8_t)JSON_CLAMP( node->valueDouble, 0, UINT8_MAX ) : defaultValue ) ) ) );
+}
+
+static inline int16_t ksJson_GetInt16( const ksJson * node, const int16_t defaultValue )
+{
+	return	( ( node == NULL ) ?				defaultValue :
+			( ( node->type == JSON_INT ) ?		(int16_t)JSON_CLAMP( node->valueInt64, INT16_MIN, INT16_MAX ) :
+			( ( node->type == JSON_UINT ) ?		(int16_t)JSON_MIN( node->valueUint64, INT16_MAX ) :
+			( ( node->type == JSON_FLOAT ) ?	(int16_t)JSON_CLAMP( node->valueDouble, INT16_MIN, INT16_MAX ) : defaultValue ) ) ) );
+}
+
+static inline uint16_t ksJson_GetUint16( const ksJson * node, const uint16_t defaultValue )
+{
+	return	( ( node == NULL ) ?				defaultValue :
+			( ( node->type == JSON_UINT ) ?		(uint16_t)JSON_MIN( node->valueUint64, UINT16_MAX ) :
+			( ( node->type == JSON_INT ) ?		(uint16_t)JSON_CLAMP( node->valueInt64, 0, UINT16_MAX ) :
+			( ( node->type == JSON_FLOAT ) ?	(uint16_t)JSON_CLAMP( node->valueDouble, 0, UINT16_MAX ) : defaultValue ) ) ) );
+}
+
+static inline int32_t ksJson_GetInt32( const ksJson * node, const int32_t defaultValue )
+{
+	return	( ( node == NULL ) ?				defaultValue :
+			( ( node->type == JSON_INT ) ?		(int32_t)JSON_CLAMP( node->valueInt64, INT32_MIN, INT32_MAX ) :
+			( ( node->type == JSON_UINT ) ?		(int32_t)JSON_MIN( node->valueUint64, INT32_MAX ) :
+			( ( node->type == JSON_FLOAT ) ?	(int32_t)JSON_CLAMP( node->valueDouble, INT32_MIN, INT32_MAX ) : defaultValue ) ) ) );
+}
+
+static inline uint32_t ksJson_GetUint32( const ksJson * node, const uint32_t defaultValue )
+{
+	return	( ( node == NULL ) ?				defaultValue :
+			( ( node->type == JSON_UINT ) ?		(uint32_t)JSON_MIN( node->valueUint64, UINT32_MAX ) :
+			( ( node->type == JSON_INT ) ?		(uint32_t)JSON_CLAMP( node->valueInt64, 0, UINT32_MAX ) :
+			( ( node->type == JSON_FLOAT ) ?	(uint32_t)JSON_CLAMP( node->valueDouble, 0, UINT32_MAX ) : defaultValue ) ) ) );
+}
+
+static inline int64_t ksJson_GetInt64( const ksJson * node, const int64_t defaultValue )
+{
+	return	( ( node == NULL ) ?				defaultValue :
+			( ( node->type == JSON_INT ) ?		(int64_t)node->valueInt64 :
+			( ( node->type == JSON_UINT ) ?		(int64_t)JSON_MIN( node->valueUint64, INT64_MAX ) :
+			( ( node->type == JSON_FLOAT ) ?	(int64_t)JSON_CLAMP( node->valueDouble, INT64_MIN, (double)INT64_MAX ) : defaultValue ) ) ) );
+}
+
+static inline uint64_t ksJson_GetUint64( const ksJson * node, const uint64_t defaultValue )
+{
+	return	( ( node == NULL ) ?				defaultValue :
+			( ( node->type == JSON_UINT ) ?		(uint64_t)node->valueUint64 :
+			( ( node->type == JSON_INT ) ?		(uint64_t)JSON_CLAMP( node->valueInt64, 0, INT64_MAX ) :
+			( ( node->type == JSON_FLOAT ) ?	(uint64_t)JSON_CLAMP( node->valueDouble, 0, (double)UINT64_MAX ) : defaultValue ) ) ) );
+}
+
+static inline float ksJson_GetFloat( const ksJson * node, const float defaultValue )
+{
+	return	( ( node == NULL ) ?				defaultValue :
+			( ( node->type == JSON_FLOAT ) ?	(float)JSON_CLAMP( node->valueDouble, -FLT_MAX, FLT_MAX ) :
+			( ( node->type == JSON_INT ) ?		(float)node->valueInt64 :
+			( ( node->type == JSON_UINT ) ?		(float)node->valueUint64 : defaultValue ) ) ) );
+}
+
+static inline double ksJson_GetDouble( const ksJson * node, const double defaultValue )
+{
+	return	( ( node == NULL ) ?				defaultValue :
+			( ( node->type == JSON_FLOAT ) ?	(double)node->valueDouble :
+			( ( node->type == JSON_INT ) ?		(double)node->valueInt64 :
+			( ( node->type == JSON_UINT ) ?		(double)node->valueUint64 : defaultValue ) ) ) );
+}
+
+static inline const char * ksJson_GetString( const ksJson * node, const char * defaultValue )
+{
+	return ksJson_IsString( node ) ? node->valueString : defaultValue;
+}
+
+[[maybe_unused]] static inline const void * ksJson_GetBytes( const ksJson * node, size_t * lengthOut )
+{
+	const bool isString = ksJson_IsString( node );
+	*lengthOut = !isString ? 0 : ( ( node->flags & JSON_FLAG_BYTES ) != 0 ) ? ksJson_GetBytesLength( node ) : strlen( node->valueString );
+	return isString ? node->valueString : NULL;
+}
+
+static inline ksJson * ksJson_AddObjectMember( ksJson * node, const char * name )
+{
+	if ( node != NULL && node->type == JSON_OBJECT )
+	{
+		assert( name != NULL );
+		ksJson * member = ksJson_AllocMember( node );
+		ksJsonArena * arena = ksJson_GetArena( node );
+		member->name = ksJson_InternName( arena, ksJson_StringDup( arena, name ) );
+		ksJson_IndexMember( node, node->memberCount - 1 );
+		return member;
+	}
+	return NULL;
+}
+
+static inline ksJson * ksJson_AddArrayElement( ksJson * node )
+{
+	if ( node != NULL && node->type == JSON_ARRAY )
+	{
+		ksJson * element = ksJson_AllocMember( node );
+		return element;
+	}
+	return NULL;
+}
+
+static inline ksJson * ksJson_SetObject( ksJson * node )
+{
+	if ( node != NULL )
+	{
+		ksJson_FreeNode( node, false );
+		node->type = JSON_OBJECT;
+	}
+	return node;
+}
+
+static inline ksJson * ksJson_SetArray( ksJson * node )
+{
+	if ( node != NULL )
+	{
+		ksJson_FreeNode( node, false );
+		node->type = JSON_ARRAY;
+	}
+	return node;
+}
+
+static inline ksJson * ksJson_SetNull( ksJson * node )
+{
+	if ( node != NULL )
+	{
+		ksJson_FreeNode( node, false );
+		node->type = JSON_NULL;
+		node->valueString = (char *)"null";
+	}
+	return node;
+}
+
+static inline ksJson * ksJson_SetBoolean( ksJson * node, const bool value )
+{
+	if ( node != NULL )
+	{
+		ksJson_FreeNode( node, false );
+		node->type = JSON_BOOLEAN;
+		node->valueString = value ? (char *)"true" : (char *)"false";
+	}
+	return node;
+}
+
+static inline ksJson * ksJson_SetInt8( ksJson * node, const int8_t value )
+{
+	if ( node != NULL )
+	{
+		ksJson_FreeNode( node, false );
+		node->type = JSON_INT;
+		node->valueInt64 = value;
+	}
+	return node;
+}
+
+static inline ksJson * ksJson_SetUint8( ksJson * node, const uint8_t value )
+{
+	if ( node != NULL )
+	{
+		ksJson_FreeNode( node, false );
+		node->type = JSON_UINT;
+		node->valueUint64 = value;
+	}
+	return node;
+}
+
+static inline ksJson * ksJson_SetInt16( ksJson * node, const int16_t value )
+{
+	if ( node != NULL )
+	{
+		ksJson_FreeNode( node, false );
+		node->type = JSON_INT;
+		node->valueInt64 = value;
+	}
+	return node;
+}
+
+static inline ksJson * ksJson_SetUint16( ksJson * node, const uint16_t value )
+{
+	if ( node != NULL )
+	{
+		ksJson_FreeNode( node, false );
+		node->type = JSON_UINT;
+		node->valueUint64 = value;
+	}
+	return node;
+}
+
+static inline ksJson * ksJson_SetInt32( ksJson * node, const int32_t value )
+{
+	if ( node != NULL )
+	{
+		ksJson_FreeNode( node, false );
+		node->type = JSON_INT;
+		node->valueInt64 = value;
+	}
+	return node;
+}
+
+static inline ksJson * ksJson_SetUint32( ksJson * node, const uint32_t value )
+{
+	if ( node != NULL )
+	{
+		ksJson_FreeNode( node, false );
+		node->type = JSON_UINT;
+		node->valueUint64 = value;
+	}
+	return node;
+}
+
+static inline ksJson * ksJson_SetInt64( ksJson * node, const int64_t value )
+{
+	if ( node != NULL )
+	{
+		ksJson_FreeNode( node, false );
+		node->type = JSON_INT;
+		node->valueInt64 = value;
+	}
+	return node;
+}
+
+static inline ksJson * ksJson_SetUint64( ksJson * node, const uint64_t value )
+{
+	if ( node != NULL )
+	{
+		ksJson_FreeNode( node, false );
+		node->type = JSON_UINT;
+		node->valueUint64 = value;
+	}
+	return node;
+}
+
+static inline ksJson * ksJson_SetFloat( ksJson * node, const float value )
+{
+	if ( node != NULL )
+	{
+		ksJson_FreeNode( node, false );
+		node->type = JSON_FLOAT;
+		node->flags |= JSON_FLAG_SINGLE;
+		node->valueDouble = value;
+	}
+	return node;
+}
+
+static inline ksJson * ksJson_SetDouble( ksJson * node, const double value )
+{
+	if ( node != NULL )
+	{
+		ksJson_FreeNode( node, false );
+		node->type = JSON_FLOAT;
+		node->valueDouble = value;
+	}
+	return node;
+}
+
+static inline ksJson * ksJson_SetString( ksJson * node, const char * value )
+{
+	if ( node != NULL )
+	{
+		assert( value != NULL );
+		ksJson_FreeNode( node, false );
+		node->type = JSON_STRING;
+		node->valueString = ksJson_StringDup( ksJson_GetArena( node ), value );
+	}
+	return node;
+}
+
+[[maybe_unused]] static inline ksJson * ksJson_SetBytes( ksJson * node, const void * data, const size_t length )
+{
+	if ( node != NULL )
+	{
+		assert( data != NULL || length == 0 );
+		ksJson_FreeNode( node, false );
+		node->type = JSON_STRING;
+		node->flags |= JSON_FLAG_BYTES;
+		node->valueString = ksJson_AllocBytes( ksJson_GetArena( node ), length );
+		if ( length > 0 )
+		{
+			memcpy( node->valueString, data, length );
+		}
+		node->valueString[length] = '\0';
+	}
+	return node;
+}
+
+/*
+================================================================================================
+
+Mutation
+
+Members are stored in order in the member maps, so removing a member moves the members after
+it one place down, across map boundaries. This costs time in proportion to the number of members
+after it in the same object or array, and nothing anywhere else in the DOM is touched. Member
+maps are not shrunk until the last member is removed, after which the object or array has no
+member map, like an object or array that never had members.
+
+Moving a member between two objects or arrays that share the same allocator, both with malloc
+or both from the same arena, relinks the subtree. Only the member node itself is copied and its
+member maps and strings stay where they are. Otherwise the subtree is copied and the original is
+freed.
+
+A merge patch only marks the members it removes. Once all members of the patch are applied to
+an object, the remaining members of that object are moved down in a single pass and its hash
+index is renumbered once, so removing many members from a large object does not cost a pass
+over the object for every removed member.
+
+Copying a value and applying a merge patch keep the objects and arrays that are still open on
+an explicit stack, like parsing and writing, instead of recursing.
+
+================================================================================================
+*/
+
+// Turns the node into a copy of a null, boolean, number or string value,
+// or into an empty object or array if the value is an object or array.
+static void ksJson_CopyLeaf( ksJson * node, const ksJson * value )
+{
+	ksJson_FreeNode( node, false );
+	ksJsonArena * arena = ksJson_GetArena( node );
+	node->type = value->type;
+	if ( value->type == JSON_STRING && ( value->flags & JSON_FLAG_BYTES ) != 0 )
+	{
+		const size_t length = ksJson_GetBytesLength( value );
+		node->flags |= JSON_FLAG_BYTES;
+		node->valueString = ksJson_AllocBytes( arena, length );
+		memcpy( node->valueString, value->valueString, length + 1 );
+	}
+	else if ( value->type == JSON_STRING )
+	{
+		node->valueString = ksJson_StringDup( arena, value->valueString );
+	}
+	else if ( value->type != JSON_OBJECT && value->type != JSON_ARRAY )
+	{
+		node->valueUint64 = value->valueUint64;		// also the literal of null and booleans
+		node->flags |= value->flags & JSON_FLAG_SINGLE;
+	}
+}
+
+// An object or array that is being copied by ksJson_SetValue() or patched by ksJson_MergePatch().
+typedef struct ksJsonCopyFrame
+{
+	ksJson *		node;
+	const ksJson *	value;
+	int				index;					// next member of 'value'
+	int				removed;				// members of 'node' that are marked for removal
+} ksJsonCopyFrame;
+
+static ksJsonCopyFrame * ksJson_PushCopyFrame( ksJsonCopyFrame ** stack, int * stackSize, const ksJsonCopyFrame * localStack, const int depth )
+{
+	if ( depth == *stackSize )
+	{
+		ksJsonCopyFrame * newStack = (ksJsonCopyFrame *) malloc( 2 * *stackSize * sizeof( ksJsonCopyFrame ) );
+		memcpy( newStack, *stack, *stackSize * sizeof( ksJsonCopyFrame ) );
+		if ( *stack != localStack )
+		{
+			free( *stack );
+		}
+		*stack = newStack;
+		*stackSize *= 2;
+	}
+	return &( *stack )[depth];
+}
+
+// Turns the node into a deep copy of 'value', which may be part of another DOM,
+// but must not be part of the subtree of the node.
+[[maybe_unused]] static ksJson * ksJson_SetValue( ksJson * node, const ksJson * value )
+{
+	if ( node == NULL || value == NULL || node == value )
+	{
+		return node;
+	}
+	assert( value->type >= JSON_NULL && value->type <= JSON_ARRAY );
+	ksJsonCopyFrame localStack[JSON_PARSE_STACK_SIZE];
+	ksJsonCopyFrame * stack = localStack;
+	int stackSize = JSON_PARSE_STACK_SIZE;
+	int depth = 0;
+
+	ksJson_CopyLeaf( node, value );
+	if ( value->memberCount > 0 )
+	{
+		ksJsonCopyFrame * pushed = ksJson_PushCopyFrame( &stack, &stackSize, localStack, depth++ );
+		pushed->node = node;
+		pushed->value = value;
+		pushed->index = 0;
+		pushed->removed = 0;
+	}
+	while ( depth > 0 )
+	{
+		ksJsonCopyFrame * frame = &stack[depth - 1];
+		if ( frame->index == frame->value->memberCount )
+		{
+			depth--;
+			continue;
+		}
+		const ksJson * member = ksJson_GetMemberByIndex( frame->value, frame->index++ );
+		ksJson * copy = ( frame->node->type == JSON_OBJECT ) ? ksJson_AddObjectMember( frame->node, member->name ) : ksJson_AddArrayElement( frame->node );
+		ksJson_CopyLeaf( copy, member );
+		if ( member->memberCount > 0 )
+		{
+			ksJsonCopyFrame * pushed = ksJson_PushCopyFrame( &stack, &stackSize, localStack, depth++ );
+			pushed->node = copy;
+			pushed->value = member;
+			pushed->index = 0;
+			pushed->removed = 0;
+		}
+	}
+
+	if ( stack != localStack )
+	{
+		free( stack );
+	}
+	return node;
+}
+
+// Releases the member maps of an object or array of which the last member was removed.
+static void ksJson_FreeMemberMap( ksJson * node, ksJsonArena * arena )
+{
+	if ( arena == NULL )
+	{
+		const int allocatedMapIndex = MemberIndexToMapIndex( node->membersAllocated - 1 );
+		for ( int mapIndex = 0; mapIndex <= allocatedMapIndex; mapIndex++ )
+		{
+			free( node->memberMap[mapIndex] );
+		}
+		free( *ksJson_GetHashIndexSlot( node ) );
+		free( node->memberMap - JSON_MAP_HEADER );
+		node->membersAllocated = 0;
+		node->padding = 0;
+	}
+	else
+	{
+		node->arena = arena;
+	}
+	node->valueString = (char *)"null";
+}
+
+// Moves the members after a member that was freed or moved away one place down.
+static void ksJson_CloseMemberGap( ksJson * node, const int index )
+{
+	ksJsonArena * arena = ksJson_GetArena( node );
+	const int endMapIndex = MemberIndexToMapIndex( node->memberCount - 1 );
+	int offset = index - MapMemberOffset( MemberIndexToMapIndex( index ) );
+	for ( int mapIndex = MemberIndexToMapIndex( index ); mapIndex <= endMapIndex; mapIndex++ )
+	{
+		ksJson * members = node->memberMap[mapIndex];
+		const int mapMemberCount = MapMemberCount( mapIndex, node->memberCount );
+		memmove( &members[offset], &members[offset + 1], ( mapMemberCount - offset - 1 ) * sizeof( ksJson ) );
+		if ( mapIndex < endMapIndex )
+		{
+			members[mapMemberCount - 1] = node->memberMap[mapIndex + 1][0];
+		}
+		offset = 0;
+	}
+	if ( --node->memberCount == 0 )
+	{
+		ksJson_FreeMemberMap( node, arena );
+	}
+}
+
+// Removes all members that were freed and marked with JSON_NONE in a single pass.
+// The hash index is renumbered once instead of for every removed member.
+static void ksJson_RemoveMarkedMembers( ksJson * node )
+{
+	ksJsonArena * arena = ksJson_GetArena( node );
+	ksJsonHashIndex * index = *ksJson_GetHashIndexSlot( node );
+	int * newIndices = ( index != NULL ) ? (int *) malloc( node->memberCount * sizeof( int ) ) : NULL;
+	int count = 0;
+	const int endMapIndex = MemberIndexToMapIndex( node->memberCount - 1 );
+	for ( int mapIndex = 0; mapIndex <= endMapIndex; mapIndex++ )
+	{
+		ksJson * members = node->memberMap[mapIndex];
+		const int mapMemberCount = MapMemberCount( mapIndex, node->memberCount );
+		for ( int i = 0; i < mapMemberCount; i++ )
+		{
+			const int memberIndex = MapMemberOffset( mapIndex ) + i;
+			if ( members[i].type == JSON_NONE )
+			{
+				if ( index != NULL )
+				{
+					ksJson_DeleteHashEntry( index, ksJson_HashName( members[i].name ), memberIndex );
+				}
+				if ( arena == NULL && ( members[i].flags & JSON_FLAG_BORROWED_NAME ) == 0 )
+				{
+					free( members[i].name );
+				}
+				continue;
+			}
+			if ( newIndices != NULL )
+			{
+				newIndices[memberIndex] = count;
+			}
+			if ( count != memberIndex )
+			{
+				const int countMapIndex = MemberIndexToMapIndex( count );
+				node->memberMap[countMapIndex][count - MapMemberOffset( countMapIndex )] = members[i];
+			}
+			count++;
+		}
+	}
+	node->memberCount = count;
+	if ( count == 0 )
+	{
+		ksJson_FreeMemberMap( node, arena );
+	}
+	else if ( index != NULL )
+	{
+		for ( uint32_t entry = 0; entry <= index->mask; entry++ )
+		{
+			if ( index->entries[entry].memberIndex >= 0 )
+			{
+				index->entries[entry].memberIndex = newIndices[index->entries[entry].memberIndex];
+			}
+		}
+	}
+	free( newIndices );
+}
+
+// Removes an object member or array element. The members after it move one place down,
+// so pointers to them are no longer valid.
+[[maybe_unused]] static bool ksJson_RemoveMember( ksJson * node, const int index )
+{
+	ksJson * member = ksJson_GetMemberByIndex( node, index );
+	if ( member == NULL )
+	{
+		return false;
+	}
+	ksJson_UnindexMember( node, index );
+	ksJson_FreeNode( member, true );
+	ksJson_CloseMemberGap( node, index );
+	return true;
+}
+
+[[maybe_unused]] static bool ksJson_RemoveMemberByName( ksJson * node, const char * name )
+{
+	return ksJson_RemoveMember( node, ksJson_GetMemberIndex( node, ksJson_GetMemberByName( node, name ) ) );
+}
+
+// Moves member 'index' of 'from' with its subtree to the end of the node and returns it.
+// The member is renamed to 'name' unless 'name' is NULL. The node must not be part of the
+// moved subtree.
+[[maybe_unused]] static ksJson * ksJson_MoveMember( ksJson * node, const char * name, ksJson * from, const int index )
+{
+	ksJson * member = ksJson_GetMemberByIndex( from, index );
+	if ( node == NULL || member == NULL || ( node->type != JSON_OBJECT && node->type != JSON_ARRAY ) )
+	{
+		return NULL;
+	}
+	ksJson * moved = ( node->type == JSON_OBJECT ) ? ksJson_AddObjectMember( node, ( name != NULL ) ? name : ksJson_GetMemberName( member ) ) : ksJson_AddArrayElement( node );
+	// The node itself moves down one place if it is a later member of 'from'.
+	const int nodeIndex = ksJson_GetMemberIndex( from, node );
+	ksJsonArena * arena = ksJson_GetArena( from );
+	if ( ksJson_GetArena( node ) == arena )
+	{
+		char * movedName = moved->name;
+		*moved = *member;
+		moved->name = movedName;
+		moved->flags &= ~JSON_FLAG_BORROWED_NAME;
+		ksJson_UnindexMember( from, index );
+		if ( arena == NULL && ( member->flags & JSON_FLAG_BORROWED_NAME ) == 0 )
+		{
+			free( member->name );
+		}
+		ksJson_CloseMemberGap( from, index );
+	}
+	else
+	{
+		ksJson_SetValue( moved, member );
+		ksJson_RemoveMember( from, index );
+	}
+	if ( nodeIndex > index )
+	{
+		node = ksJson_GetMemberByIndex( from, nodeIndex - 1 );
+	}
+	// The new member also moved down if it was added to 'from'.
+	return ksJson_GetMemberByIndex( node, node->memberCount - 1 );
+}
+
+// Applies a JSON merge patch (RFC 7396). Members of the patch that are null remove the member
+// of the target with the same name, objects are merged and all other values replace the value
+// in the target. Only the members named by the patch are visited, except that an object from
+// which members are removed is compacted once. The patch must not be part of the target.
+[[maybe_unused]] static ksJson * ksJson_MergePatch( ksJson * target, const ksJson * patch )
+{
+	if ( target == NULL || patch == NULL )
+	{
+		return target;
+	}
+	if ( patch->type != JSON_OBJECT )
+	{
+		return ksJson_SetValue( target, patch );
+	}
+	if ( target->type != JSON_OBJECT )
+	{
+		ksJson_SetObject( target );
+	}
+	ksJsonCopyFrame localStack[JSON_PARSE_STACK_SIZE];
+	ksJsonCopyFrame * stack = localStack;
+	int stackSize = JSON_PARSE_STACK_SIZE;
+	int depth = 0;
+
+	if ( patch->memberCount > 0 )
+	{
+		ksJsonCopyFrame * pushed = ksJson_PushCopyFrame( &stack, &stackSize, localStack, depth++ );
+		pushed->node = target;
+		pushed->value = patch;
+		pushed->index = 0;
+		pushed->removed = 0;
+	}
+	while ( depth > 0 )
+	{
+		ksJsonCopyFrame * frame = &stack[depth - 1];
+		if ( frame->index == frame->value->memberCount )
+		{
+			if ( frame->removed > 0 )
+			{
+				ksJson_RemoveMarkedMembers( frame->node );
+			}
+			depth--;
+			continue;
+		}
+		const ksJson * value = ksJson_GetMemberByIndex( frame->value, frame->index++ );
+		ksJson * member = ksJson_GetMemberByName( frame->node, value->name );
+		if ( member != NULL && member->type == JSON_NONE )
+		{
+			member = NULL;		// already removed by an earlier member of the patch with the same name
+		}
+		if ( value->type == JSON_NULL )
+		{
+			// Removed members keep their name and their slot until the whole object is patched.
+			if ( member != NULL )
+			{
+				ksJson_FreeNode( member, false );
+				member->type = JSON_NONE;
+				frame->removed++;
+			}
+			continue;
+		}
+		if ( member == NULL )
+		{
+			member = ksJson_AddObjectMember( frame->node, value->name );
+		}
+		if ( value->type != JSON_OBJECT )
+		{
+			ksJson_SetValue( member, value );
+			continue;
+		}
+		if ( member->type != JSON_OBJECT )
+		{
+			ksJson_SetObject( member );
+		}
+		if ( value->memberCount > 0 )
+		{
+			ksJsonCopyFrame * pushed = ksJson_PushCopyFrame( &stack, &stackSize, localStack, depth++ );
+			pushed->node = member;
+			pushed->value = value;
+			pushed->index = 0;
+			pushed->removed = 0;
+		}
+	}
+
+	if ( stack != localStack )
+	{
+		free( stack );
+	}
+	return target;
+}
+
+/*
+================================================================================================
+
+Tape
+
+A ksJsonTape is a read-only alternative to the DOM for when only a few values of a document
+are needed. Parsing only finds the structure of the text and records every value as an entry
+in a single flat array, the tape, in document order. No nodes are allocated. Numbers are
+checked with the same rules as ksJson_ParseNumber(), so the tape accepts exactly the text that
+ksJson_ReadFromBufferInSitu() accepts, but they are not converted until they are read through
+a ksJsonCursor. Like the DOM, the nesting is limited by a depth and not by the call stack.
+
+The members of an object or array directly follow its entry, and the entry of an object or
+array stores the index of the entry after its last member. Skipping a value therefore never
+depends on its size. An array without objects or arrays as elements is indexed directly.
+
+Like ksJson_ReadFromBufferInSitu(), the text is modified. Strings are unescaped in place and
+terminated with a zero, so member names and string values point into the buffer, which must
+outlive the tape. The text may be at most 4 GB.
+
+================================================================================================
+*/
+
+#define JSON_TAPE_NUMBER			9				// a number that is converted when it is read
+#define JSON_TAPE_MAX_COUNT			0xFFFFFF		// larger member counts are counted when queried
+
+typedef struct ksJsonTapeEntry
+{
+	uint32_t	type : 8;			// JSON_NULL, JSON_BOOLEAN, JSON_STRING, JSON_OBJECT, JSON_ARRAY or JSON_TAPE_NUMBER
+	uint32_t	count : 24;			// number of members of an object or array
+	uint32_t	value;				// text offset of a string or number, 1 for true, or the entry after the last member
+	uint32_t	name;				// text offset of the member name, 0 if the value is not an object member
+} ksJsonTapeEntry;
+
+typedef struct ksJsonTape
+{
+	char *				text;
+	ksJsonTapeEntry *	entries;
+	int					entryCount;
+	int					entriesAllocated;
+	int					maxDepth;			// zero for JSON_DEFAULT_MAX_DEPTH
+} ksJsonTape;
+
+typedef struct ksJsonCursor
+{
+	const ksJsonTape *	tape;
+	int					index;		// -1 if the cursor does not point at a value
+	int					end;		// entry after the last member of the parent
+} ksJsonCursor;
+
+[[maybe_unused]] static void ksJsonTape_Init( ksJsonTape * tape )
+{
+	memset( tape, 0, sizeof( ksJsonTape ) );
+}
+
+[[maybe_unused]] static void ksJsonTape_Destroy( ksJsonTape * tape )
+{
+	free( tape->entries );
+	memset( tape, 0, sizeof( ksJsonTape ) );
+}
+
+[[maybe_unused]] static inline void ksJsonTape_SetMaxDepth( ksJsonTape * tape, const int maxDepth )
+{
+	if ( tape != NULL )
+	{
+		tape->maxDepth = JSON_CLAMP( maxDepth, 1, UINT16_MAX );
+	}
+}
+
+// Appends an entry for the value at 'buffer' and returns its index, or -1 if the text is too large.
+static int ksJsonTape_AddEntry( ksJsonTape * tape, const int type, const char * buffer )
+{
+	const size_t offset = (size_t)( buffer - tape->text );
+	if ( offset > UINT32_MAX || tape->entryCount == INT32_MAX )
+	{
+		return -1;
+	}
+	if ( tape->entryCount >= tape->entriesAllocated )
+	{
+		const int newAllocated = ( tape->entriesAllocated > 0 ) ? (int)JSON_MIN( (int64_t)tape->entriesAllocated * 2, (int64_t)INT32_MAX ) : 256;
+		tape->entries = (ksJsonTapeEntry *) realloc( tape->entries, newAllocated * sizeof( ksJsonTapeEntry ) );
+		tape->entriesAllocated = newAllocated;
+	}
+	ksJsonTapeEntry * entry = &tape->entries[tape->entryCount];
+	entry->type = (uint32_t)type;
+	entry->count = 0;
+	entry->value = (uint32_t)offset;
+	entry->name = 0;
+	return tape->entryCount++;
+}
+
+// Parses the name and colon of the next member of an object. The name is 0 for an array.
+static char * ksJsonTape_ParseMemberName( ksJsonTape * tape, const int type, char * buffer, uint32_t * nameOut, const char ** errorStringOut )
+{
+	*nameOut = 0;
+	if ( type == JSON_ARRAY )
+	{
+		return buffer;
+	}
+	buffer = (char *)ksJson_ParseWhiteSpace( buffer );
+	if ( buffer[0] != '\"' )
+	{
+		*errorStringOut = "missing member name";
+		return buffer;
+	}
+	char * name = NULL;
+	buffer = (char *)ksJson_ParseStringInSitu( &name, buffer, errorStringOut );
+	if ( *errorStringOut != NULL )
+	{
+		return buffer;
+	}
+	*nameOut = (uint32_t)( name - tape->text );
+	buffer = (char *)ksJson_ParseWhiteSpace( buffer );
+	if ( buffer[0] != ':' )
+	{
+		*errorStringOut = "missing colon";
+		return buffer;
+	}
+	return buffer + 1;
+}
+
+typedef struct ksJsonTapeFrame
+{
+	int		index;					// entry of the open object or array
+	int		count;					// members parsed so far
+} ksJsonTapeFrame;
+
+// Parses a value with all its members in the same order as ksJson_ParseValue(). The objects
+// and arrays that are still open are kept on an explicit stack.
+static const char * ksJsonTape_ParseValue( ksJsonTape * tape, const int maxDepth, char * buffer, const char ** errorStringOut )
+{
+	assert( errorStringOut != NULL );
+	ksJsonTapeFrame localStack[JSON_PARSE_STACK_SIZE];
+	ksJsonTapeFrame * stack = localStack;
+	int stackSize = JSON_PARSE_STACK_SIZE;
+	int depth = 0;
+	uint32_t name = 0;
+
+	for ( ;; )
+	{
+		buffer = (char *)ksJson_ParseWhiteSpace( buffer );
+
+		int type = JSON_TAPE_NUMBER;
+		switch ( buffer[0] )
+		{
+			case 'n': type = JSON_NULL; break;
+			case 'f': type = JSON_BOOLEAN; break;
+			case 't': type = JSON_BOOLEAN; break;
+			case '\"': type = JSON_STRING; break;
+			case '{': type = JSON_OBJECT; break;
+			case '[': type = JSON_ARRAY; break;
+		}
+		const int index = ksJsonTape_AddEntry( tape, type, buffer );
+		if ( index < 0 )
+		{
+			*errorStringOut = "text too large";
+			break;
+		}
+		tape->entries[index].name = name;
+
+		if ( type == JSON_OBJECT || type == JSON_ARRAY )
+		{
+			if ( depth >= maxDepth )
+			{
+				*errorStringOut = "maximum depth";
+				break;
+			}
+			buffer = (char *)ksJson_ParseWhiteSpace( buffer + 1 );
+			if ( buffer[0] != ( ( type == JSON_OBJECT ) ? '}' : ']' ) )
+			{
+				if ( depth == stackSize )
+				{
+					ksJsonTapeFrame * newStack = (ksJsonTapeFrame *) malloc( 2 * stackSize * sizeof( ksJsonTapeFrame ) );
+					memcpy( newStack, stack, stackSize * sizeof( ksJsonTapeFrame ) );
+					if ( stack != localStack )
+					{
+						free( stack );
+					}
+					stack = newStack;
+					stackSize *= 2;
+				}
+				stack[depth].index = index;
+				stack[depth].count = 0;
+				depth++;
+				buffer = ksJsonTape_ParseMemberName( tape, type, buffer, &name, errorStringOut );
+				if ( *errorStringOut != NULL )
+				{
+					break;
+				}
+				continue;
+			}
+			buffer++;
+			tape->entries[index].value = (uint32_t)tape->entryCount;
+		}
+		else if ( type == JSON_NULL || type == JSON_BOOLEAN )
+		{
+			const char * literal = ( buffer[0] == 'n' ) ? "null" : ( ( buffer[0] == 't' ) ? "true" : "false" );
+			const size_t length = strlen( literal );
+			if ( strncmp( buffer, literal, length ) != 0 )
+			{
+				*errorStringOut = "invalid literal";
+				break;
+			}
+			tape->entries[index].value = ( buffer[0] == 't' );
+			buffer += length;
+		}
+		else if ( type == JSON_STRING )
+		{
+			char * value = NULL;
+			buffer = (char *)ksJson_ParseStringInSitu( &value, buffer, errorStringOut );
+			if ( *errorStringOut != NULL )
+			{
+				break;
+			}
+			tape->entries[index].value = (uint32_t)( value - tape->text );
+		}
+		else
+		{
+			// The number is only checked here and converted by ksJson_ParseNumber() when it is read.
+			buffer = (char *)ksJson_SkipNumber( buffer );
+		}
+
+		// The value is complete. Close the objects and arrays that end here and
+		// continue with the next member of the innermost one that is still open.
+		while ( depth > 0 )
+		{
+			ksJsonTapeFrame * parent = &stack[depth - 1];
+			const int parentType = tape->entries[parent->index].type;
+			parent->count++;
+			buffer = (char *)ksJson_ParseWhiteSpace( buffer );
+			if ( buffer[0] == ',' )
+			{
+				buffer = ksJsonTape_ParseMemberName( tape, parentType, buffer + 1, &name, errorStringOut );
+				break;
+			}
+			if ( buffer[0] != ( ( parentType == JSON_OBJECT ) ? '}' : ']' ) )
+			{
+				*errorStringOut = "missing comma";
+				break;
+			}
+			buffer++;
+			tape->entries[parent->index].count = (uint32_t)JSON_MIN( parent->count, JSON_TAPE_MAX_COUNT );
+			tape->entries[parent->index].value = (uint32_t)tape->entryCount;
+			depth--;
+		}
+		if ( depth == 0 || *errorStringOut != NULL )
+		{
+			break;
+		}
+	}
+
+	if ( stack != localStack )
+	{
+		free( stack );
+	}
+	return buffer;
+}
+
+// Parses a mutable buffer into the tape, replacing any previous document. The tape keeps
+// its memory for the next document.
+[[maybe_unused]] static bool ksJsonTape_Parse( ksJsonTape * tape, char * buffer, const char ** errorStringOut )
+{
+	if ( errorStringOut != NULL )
+	{
+		*errorStringOut = NULL;
+	}
+	if ( tape == NULL || buffer == NULL )
+	{
+		return false;
+	}
+	tape->text = buffer;
+	tape->entryCount = 0;
+
+	const char * error = NULL;
+	ksJsonTape_ParseValue( tape, ( tape->maxDepth != 0 ) ? tape->maxDepth : JSON_DEFAULT_MAX_DEPTH, buffer, &error );
+	if ( error != NULL )
+	{
+		if ( errorStringOut != NULL )
+		{
+			*errorStringOut = error;
+		}
+		tape->entryCount = 0;
+		return false;
+	}
+	return true;
+}
+
+[[maybe_unused]] static ksJsonCursor ksJsonTape_GetRoot( const ksJsonTape * tape )
+{
+	ksJsonCursor cursor;
+	cursor.tape = tape;
+	cursor.index = ( tape != NULL && tape->entryCount > 0 ) ? 0 : -1;
+	cursor.end = ( tape != NULL ) ? tape->entryCount : 0;
+	return cursor;
+}
+
+static inline const ksJsonTapeEntry * ksJsonCursor_GetEntry( const ksJsonCursor cursor )
+{
+	return ( cursor.index >= 0 ) ? &cursor.tape->entries[cursor.index] : NULL;
+}
+
+static inline bool ksJsonCursor_IsValid( const ksJsonCursor cursor )
+{
+	return ( cursor.index >= 0 );
+}
+
+// Returns the index of the entry after the value, skipping all members of an object or array.
+static inline int ksJsonCursor_SkipValue( const ksJsonTape * tape, const int index )
+{
+	const ksJsonTapeEntry * entry = &tape->entries[index];
+	return ( entry->type == JSON_OBJECT || entry->type == JSON_ARRAY ) ? (int)entry->value : index + 1;
+}
+
+static inline ksJsonCursor ksJsonCursor_Make( const ksJsonTape * tape, const int index, const int end )
+{
+	ksJsonCursor cursor;
+	cursor.tape = tape;
+	cursor.index = ( index < end ) ? index : -1;
+	cursor.end = end;
+	return cursor;
+}
+
+static int ksJsonCursor_GetMemberCount( const ksJsonCursor cursor )
+{
+	const ksJsonTapeEntry * entry = ksJsonCursor_GetEntry( cursor );
+	if ( entry == NULL || ( entry->type != JSON_OBJECT && entry->type != JSON_ARRAY ) )
+	{
+		return 0;
+	}
+	if ( entry->count < JSON_TAPE_MAX_COUNT )
+	{
+		return (int)entry->count;
+	}
+	int count = 0;
+	for ( int index = cursor.index + 1; index < (int)entry->value; index = ksJsonCursor_SkipValue( cursor.tape, index ) )
+	{
+		count++;
+	}
+	return count;
+}
+
+// Returns a cursor at the first member of an object or array.
+[[maybe_unused]] static ksJsonCursor ksJsonCursor_GetFirstMember( const ksJsonCursor cursor )
+{
+	const ksJsonTapeEntry * entry = ksJsonCursor_GetEntry( cursor );
+	if ( entry == NULL || ( entry->type != JSON_OBJECT && entry->type != JSON_ARRAY ) )
+	{
+		return ksJsonCursor_Make( cursor.tape, -1, 0 );
+	}
+	return ksJsonCursor_Make( cursor.tape, cursor.index + 1, (int)entry->value );
+}
+
+// Returns a cursor at the member that follows this member of an object or array.
+[[maybe_unused]] static ksJsonCursor ksJsonCursor_GetNextMember( const ksJsonCursor cursor )
+{
+	if ( cursor.index < 0 )
+	{
+		return cursor;
+	}
+	return ksJsonCursor_Make( cursor.tape, ksJsonCursor_SkipValue( cursor.tape, cursor.index ), cursor.end );
+}
+
+[[maybe_unused]] static ksJsonCursor ksJsonCursor_GetMemberByIndex( const ksJsonCursor cursor, const int index )
+{
+	const ksJsonTapeEntry * entry = ksJsonCursor_GetEntry( cursor );
+	if ( entry == NULL || ( entry->type != JSON_OBJECT && entry->type != JSON_ARRAY ) || index < 0 )
+	{
+		return ksJsonCursor_Make( cursor.tape, -1, 0 );
+	}
+	const int end = (int)entry->value;
+	// Without nested objects or arrays every member is a single entry.
+	if ( end - cursor.index - 1 == (int)entry->count )
+	{
+		return ksJsonCursor_Make( cursor.tape, ( index < end - cursor.index - 1 ) ? cursor.index + 1 + index : end, end );
+	}
+	int member = cursor.index + 1;
+	for ( int i = 0; i < index && member < end; i++ )
+	{
+		member = ksJsonCursor_SkipValue( cursor.tape, member );
+	}
+	return ksJsonCursor_Make( cursor.tape, member, end );
+}
+
+[[maybe_unused]] static ksJsonCursor ksJsonCursor_GetMemberByName( const ksJsonCursor cursor, const char * name )
+{
+	const ksJsonTapeEntry * entry = ksJsonCursor_GetEntry( cursor );
+	if ( entry == NULL || entry->type != JSON_OBJECT )
+	{
+		return ksJsonCursor_Make( cursor.tape, -1, 0 );
+	}
+	const int end = (int)entry->value;
+	for ( int member = cursor.index + 1; member < end; member = ksJsonCursor_SkipValue( cursor.tape, member ) )
+	{
+		if ( strcmp( cursor.tape->text + cursor.tape->entries[member].name, name ) == 0 )
+		{
+			return ksJsonCursor_Make( cursor.tape, member, end );
+		}
+	}
+	return ksJsonCursor_Make( cursor.tape, -1, 0 );
+}
+
+[[maybe_unused]] static const char * ksJsonCursor_GetMemberName( const ksJsonCursor cursor )
+{
+	const ksJsonTapeEntry * entry = ksJsonCursor_GetEntry( cursor );
+	return ( entry != NULL && entry->name != 0 ) ? cursor.tape->text + entry->name : "";
+}
+
+// Converts the value at the cursor into a node without members. Returns NULL if the cursor is not valid.
+static const ksJson * ksJsonCursor_GetValue( const ksJsonCursor cursor, ksJson * node )
+{
+	const ksJsonTapeEntry * entry = ksJsonCursor_GetEntry( cursor );
+	if ( entry == NULL )
+	{
+		return NULL;
+	}
+	memset( node, 0, sizeof( ksJson ) );
+	switch ( entry->type )
+	{
+		case JSON_NULL:
+			node->type = JSON_NULL;
+			node->valueString = (char *)"null";
+			break;
+		case JSON_BOOLEAN:
+			node->type = JSON_BOOLEAN;
+			node->valueString = (char *)( entry->value ? "true" : "false" );
+			break;
+		case JSON_STRING:
+			node->type = JSON_STRING;
+			node->valueString = cursor.tape->text + entry->value;
+			break;
+		case JSON_TAPE_NUMBER:
+		{
+			// ksJsonTape_Parse() already checked the number, so it reads the same value as from the DOM.
+			const char * error = NULL;
+			ksJson_ParseNumber( &node->type, &node->valueInt64, &node->valueUint64, &node->valueDouble,
+								cursor.tape->text + entry->value, &error );
+			break;
+		}
+		default:
+			node->type = entry->type;
+			node->memberCount = ksJsonCursor_GetMemberCount( cursor );
+			break;
+	}
+	return node;
+}
+
+[[maybe_unused]] static inline bool ksJsonCursor_IsNull( const ksJsonCursor cursor ) { ksJson node; return ksJson_IsNull( ksJsonCursor_GetValue( cursor, &node ) ); }
+[[maybe_unused]] static inline bool ksJsonCursor_IsBoolean( const ksJsonCursor cursor ) { ksJson node; return ksJson_IsBoolean( ksJsonCursor_GetValue( cursor, &node ) ); }
+[[maybe_unused]] static inline bool ksJsonCursor_IsNumber( const ksJsonCursor cursor ) { ksJson node; return ksJson_IsNumber( ksJsonCursor_GetValue( cursor, &node ) ); }
+[[maybe_unused]] static inline bool ksJsonCursor_IsInteger( const ksJsonCursor cursor ) { ksJson node; return ksJson_IsInteger( ksJsonCursor_GetValue( cursor, &node ) ); }
+[[maybe_unused]] static inline bool ksJsonCursor_IsUnsigned( const ksJsonCursor cursor ) { ksJson node; return ksJson_IsUnsigned( ksJsonCursor_GetValue( cursor, &node ) ); }
+[[maybe_unused]] static inline bool ksJsonCursor_IsFloatingPoint( const ksJsonCursor cursor ) { ksJson node; return ksJson_IsFloatingPoint( ksJsonCursor_GetValue( cursor, &node ) ); }
+[[maybe_unused]] static inline bool ksJsonCursor_IsString( const ksJsonCursor cursor ) { ksJson node; return ksJson_IsString( ksJsonCursor_GetValue( cursor, &node ) ); }
+[[maybe_unused]] static inline bool ksJsonCursor_IsObject( const ksJsonCursor cursor ) { ksJson node; return ksJson_IsObject( ksJsonCursor_GetValue( cursor, &node ) ); }
+[[maybe_unused]] static inline bool ksJsonCursor_IsArray( const ksJsonCursor cursor ) { ksJson node; return ksJson_IsArray( ksJsonCursor_GetValue( cursor, &node ) ); }
+
+[[maybe_unused]] static inline bool ksJsonCursor_GetBool( const ksJsonCursor cursor, const bool defaultValue ) { ksJson node; return ksJson_GetBool( ksJsonCursor_GetValue( cursor, &node ), defaultValue ); }
+[[maybe_unused]] static inline int8_t ksJsonCursor_GetInt8( const ksJsonCursor cursor, const int8_t defaultValue ) { ksJson node; return ksJson_GetInt8( ksJsonCursor_GetValue( cursor, &node ), defaultValue ); }
+[[maybe_unused]] static inline uint8_t ksJsonCursor_GetUint8( const ksJsonCursor cursor, const uint8_t defaultValue ) { ksJson node; return ksJson_GetUint8( ksJsonCursor_GetValue( cursor, &node ), defaultValue ); }
+[[maybe_unused]] static inline int16_t ksJsonCursor_GetInt16( const ksJsonCursor cursor, const int16_t defaultValue ) { ksJson node; return ksJson_GetInt16( ksJsonCursor_GetValue( cursor, &node ), defaultValue ); }
+[[maybe_unused]] static inline uint16_t ksJsonCursor_GetUint16( const ksJsonCursor cursor, const uint16_t defaultValue ) { ksJson node; return ksJson_GetUint16( ksJsonCursor_GetValue( cursor, &node ), defaultValue ); }
+[[maybe_unused]] static inline int32_t ksJsonCursor_GetInt32( const ksJsonCursor cursor, const int32_t defaultValue ) { ksJson node; return ksJson_GetInt32( ksJsonCursor_GetValue( cursor, &node ), defaultValue ); }
+[[maybe_unused]] static inline uint32_t ksJsonCursor_GetUint32( const ksJsonCursor cursor, const uint32_t defaultValue ) { ksJson node; return ksJson_GetUint32( ksJsonCursor_GetValue( cursor, &node ), defaultValue ); }
+[[maybe_unused]] static inline int64_t ksJsonCursor_GetInt64( const ksJsonCursor cursor, const int64_t defaultValue ) { ksJson node; return ksJson_GetInt64( ksJsonCursor_GetValue( cursor, &node ), defaultValue ); }
+[[maybe_unused]] static inline uint64_t ksJsonCursor_GetUint64( const ksJsonCursor cursor, const uint64_t defaultValue ) { ksJson node; return ksJson_GetUint64( ksJsonCursor_GetValue( cursor, &node ), defaultValue ); }
+[[maybe_unused]] static inline float ksJsonCursor_GetFloat( const ksJsonCursor cursor, const float defaultValue ) { ksJson node; return ksJson_GetFloat( ksJsonCursor_GetValue( cursor, &node ), defaultValue ); }
+[[maybe_unused]] static inline double ksJsonCursor_GetDouble( const ksJsonCursor cursor, const double defaultValue ) { ksJson node; return ksJson_GetDouble( ksJsonCursor_GetValue( cursor, &node ), defaultValue ); }
+[[maybe_unused]] static inline const char * ksJsonCursor_GetString( const ksJsonCursor cursor, const char * defaultValue ) { ksJson node; return ksJson_GetString( ksJsonCursor_GetValue( cursor, &node ), defaultValue ); }
+
+/*
+================================================================================================
+
+CBOR and MessagePack
+
+The same DOM can be read from and written to the binary Concise Binary Object Representation
+(RFC 8949) and MessagePack formats. Integers and floating-point numbers are stored with their
+binary representation instead of being formatted as text and parsed again, and strings and
+byte strings are copied as is. The usual ksJson_Get* and ksJson_Set* functions apply to a DOM
+that is read from either format.
+
+Numbers get the same types as when parsing text: non-negative integers are unsigned and
+negative integers are signed. Numbers set with ksJson_SetFloat() are written as 32-bit
+floats and every other floating-point number as a 64-bit float. A 32-bit float that is
+read back is written to text with float precision again. Infinity is clamped to the largest
+double and NaN becomes null, just like text cannot represent them.
+
+Byte strings are read into strings that are set with ksJson_SetBytes(), so they keep their
+length when they contain zeros. MessagePack extension types are read as byte strings without
+the extension type. CBOR tags are ignored and only the tagged value is read. CBOR map keys and
+MessagePack map keys must be strings. Indefinite-length CBOR strings, arrays and maps are read
+but never written.
+
+The input is never read past the given length and invalid input results in an error instead
+of undefined behavior. The maximum nesting depth is the same as for text.
+
+================================================================================================
+*/
+
+typedef struct ksJsonBinaryInput
+{
+	const uint8_t *	data;
+	const uint8_t *	end;
+	const char *	error;
+} ksJsonBinaryInput;
+
+// Reads a big-endian unsigned integer of 'bytes' bytes.
+static bool ksJsonBinaryInput_Read( ksJsonBinaryInput * input, const size_t bytes, uint64_t * value )
+{
+	if ( (size_t)( input->end - input->data ) < bytes )
+	{
+		input->error = "unexpected end of data";
+		return false;
+	}
+	uint64_t result = 0;
+	for ( size_t i = 0; i < bytes; i++ )
+	{
+		result = ( result << 8 ) | input->data[i];
+	}
+	input->data += bytes;
+	*value = result;
+	return true;
+}
+
+// Copies 'length' bytes into a zero terminated string, or a byte string if 'bytes' is set.
+static char * ksJsonBinaryInput_ReadString( ksJsonBinaryInput * input, ksJsonArena * arena, const uint64_t length, const bool bytes )
+{
+	if ( (uint64_t)( input->end - input->data ) < length )
+	{
+		input->error = "unexpected end of data";
+		return NULL;
+	}
+	char * string = bytes ? ksJson_AllocBytes( arena, (size_t)length ) : (char *) ksJson_Alloc( arena, (size_t)length + 1 );
+	memcpy( string, input->data, (size_t)length );
+	string[length] = '\0';
+	input->data += length;
+	return string;
+}
+
+// Sets a floating-point number, clamping infinity and turning NaN into null.
+static void ksJson_SetBinaryDouble( ksJson * node, const double value, const bool single )
+{
+	if ( value != value )
+	{
+		ksJson_SetNull( node );
+	}
+	else if ( single )
+	{
+		ksJson_SetFloat( node, (float)JSON_CLAMP( value, -FLT_MAX, FLT_MAX ) );
+	}
+	else
+	{
+		ksJson_SetDouble( node, JSON_CLAMP( value, -DBL_MAX, DBL_MAX ) );
+	}
+}
+
+static void ksJson_SetBinaryString( ksJson * node, char * string, const bool bytes )
+{
+	ksJson_FreeNode( node, false );
+	node->type = JSON_STRING;
+	node->valueString = string;
+	if ( bytes )
+	{
+		node->flags |= JSON_FLAG_BYTES;
+	}
+}
+
+static double ksJson_BitsToDouble( const uint64_t bits )
+{
+	double value;
+	memcpy( &value, &bits, sizeof( value ) );
+	return value;
+}
+
+// Converts a 16-bit float by moving its sign, exponent and mantissa to a 64-bit float.
+static double ksJson_HalfToDouble( const uint16_t half )
+{
+	const uint64_t sign = (uint64_t)( half >> 15 ) << 63;
+	const uint64_t exponent = ( half >> 10 ) & 0x1F;
+	const uint64_t mantissa = half & 0x3FF;
+	if ( exponent == 0 )
+	{
+		const double value = (double)mantissa / ( 1 << 24 );		// zero or subnormal
+		return sign ? -value : value;
+	}
+	const uint64_t biased = ( exponent == 0x1F ) ? 0x7FF : exponent - 15 + 1023;		// infinity and NaN keep all exponent bits set
+	return ksJson_BitsToDouble( sign | ( biased << 52 ) | ( mantissa << 42 ) );
+}
+
+static float ksJson_BitsToFloat( const uint32_t bits )
+{
+	float value;
+	memcpy( &value, &bits, sizeof( value ) );
+	return value;
+}
+
+// Each value takes at least one byte, which bounds the number of members that are allocated.
+static bool ksJsonBinaryInput_CheckCount( ksJsonBinaryInput * input, const uint64_t count )
+{
+	if ( count > (uint64_t)( input->end - input->data ) || count > INT32_MAX )
+	{
+		input->error = "invalid member count";
+		return false;
+	}
+	return true;
+}
+
+#define JSON_CBOR_INDEFINITE		31
+#define JSON_CBOR_BREAK				0xFF
+
+// Reads the initial byte and argument of a data item.
+static bool ksJson_ReadCborHead( ksJsonBinaryInput * input, int * major, int * info, uint64_t * argument )
+{
+	if ( input->data >= input->end )
+	{
+		input->error = "unexpected end of data";
+		return false;
+	}
+	const uint8_t initial = *input->data++;
+	*major = initial >> 5;
+	*info = initial & 31;
+	*argument = *info;
+	if ( *info >= 24 && *info <= 27 )
+	{
+		return ksJsonBinaryInput_Read( input, (size_t)1 << ( *info - 24 ), argument );
+	}
+	if ( *info >= 28 && !( *info == JSON_CBOR_INDEFINITE && *major >= 2 ) )
+	{
+		input->error = "invalid additional information";
+		return false;
+	}
+	return true;
+}
+
+// Reads a text or byte string, joining the chunks of an indefinite-length string.
+static char * ksJson_ReadCborString( ksJsonBinaryInput * input, ksJsonArena * arena, const int major, const int info, const uint64_t argument )
+{
+	if ( info != JSON_CBOR_INDEFINITE )
+	{
+		return ksJsonBinaryInput_ReadString( input, arena, argument, major == 2 );
+	}
+	// The first pass validates the chunks and adds up their lengths.
+	ksJsonBinaryInput scan = *input;
+	uint64_t length = 0;
+	while ( scan.data < scan.end && scan.data[0] != JSON_CBOR_BREAK )
+	{
+		int chunkMajor, chunkInfo;
+		uint64_t chunkLength;
+		if ( !ksJson_ReadCborHead( &scan, &chunkMajor, &chunkInfo, &chunkLength ) )
+		{
+			input->error = scan.error;
+			return NULL;
+		}
+		if ( chunkMajor != major || chunkInfo == JSON_CBOR_INDEFINITE || chunkLength > (uint64_t)( scan.end - scan.data ) )
+		{
+			input->error = "invalid string chunk";
+			return NULL;
+		}
+		scan.data += chunkLength;
+		length += chunkLength;
+	}
+	if ( scan.data >= scan.end )
+	{
+		input->error = "unexpected end of data";
+		return NULL;
+	}
+	char * string = ( major == 2 ) ? ksJson_AllocBytes( arena, (size_t)length ) : (char *) ksJson_Alloc( arena, (size_t)length + 1 );
+	size_t offset = 0;
+	while ( input->data[0] != JSON_CBOR_BREAK )
+	{
+		int chunkMajor = 0;
+		int chunkInfo = 0;
+		uint64_t chunkLength = 0;
+		const bool valid = ksJson_ReadCborHead( input, &chunkMajor, &chunkInfo, &chunkLength );
+		assert( valid );	// the first pass validated every chunk head
+		(void)valid;
+		memcpy( string + offset, input->data, (size_t)chunkLength );
+		input->data += chunkLength;
+		offset += (size_t)chunkLength;
+	}
+	input->data++;
+	string[length] = '\0';
+	return string;
+}
+
+static void ksJson_ReadCborValue( ksJson * node, const int recursion, ksJsonBinaryInput * input )
+{
+	if ( recursion > JSON_MAX_RECURSION )
+	{
+		input->error = "maximum recursion";
+		return;
+	}
+	int major, info;
+	uint64_t argument;
+	if ( !ksJson_ReadCborHead( input, &major, &info, &argument ) )
+	{
+		return;
+	}
+	switch ( major )
+	{
+		case 0:
+		{
+			ksJson_SetUint64( node, argument );
+			break;
+		}
+		case 1:
+		{
+			if ( argument <= INT64_MAX )
+			{
+				ksJson_SetInt64( node, -1 - (int64_t)argument );
+			}
+			else
+			{
+				ksJson_SetDouble( node, -1.0 - (double)argument );
+			}
+			break;
+		}
+		case 2:
+		case 3:
+		{
+			char * string = ksJson_ReadCborString( input, ksJson_GetArena( node ), major, info, argument );
+			if ( string != NULL )
+			{
+				ksJson_SetBinaryString( node, string, major == 2 );
+			}
+			break;
+		}
+		case 4:
+		case 5:
+		{
+			const bool isObject = ( major == 5 );
+			const bool indefinite = ( info == JSON_CBOR_INDEFINITE );
+			if ( !indefinite && !ksJsonBinaryInput_CheckCount( input, argument ) )
+			{
+				return;
+			}
+			isObject ? ksJson_SetObject( node ) : ksJson_SetArray( node );
+			for ( uint64_t i = 0; indefinite || i < argument; i++ )
+			{
+				if ( indefinite )
+				{
+					if ( input->data >= input->end )
+					{
+						input->error = "unexpected end of data";
+						return;
+					}
+					if ( input->data[0] == JSON_CBOR_BREAK )
+					{
+						input->data++;
+						break;
+					}
+				}
+				ksJson * member = ksJson_AllocMember( node );
+				if ( isObject )
+				{
+					int keyMajor, keyInfo;
+					uint64_t keyArgument;
+					if ( !ksJson_ReadCborHead( input, &keyMajor, &keyInfo, &keyArgument ) )
+					{
+						return;
+					}
+					if ( keyMajor != 3 )
+					{
+						input->error = "map key is not a string";
+						return;
+					}
+					member->name = ksJson_ReadCborString( input, ksJson_GetArena( node ), keyMajor, keyInfo, keyArgument );
+					if ( member->name == NULL )
+					{
+						return;
+					}
+					member->name = ksJson_InternName( ksJson_GetArena( node ), member->name );
+				}
+				ksJson_ReadCborValue( member, recursion + 1, input );
+				if ( input->error != NULL )
+				{
+					return;
+				}
+			}
+			break;
+		}
+		case 6:
+		{
+			ksJson_ReadCborValue( node, recursion + 1, input );
+			break;
+		}
+		default:
+		{
+			if ( info == 20 || info == 21 )
+			{
+				ksJson_SetBoolean( node, info == 21 );
+			}
+			else if ( info == 22 || info == 23 )
+			{
+				ksJson_SetNull( node );
+			}
+			else if ( info == 25 )
+			{
+				ksJson_SetBinaryDouble( node, ksJson_HalfToDouble( (uint16_t)argument ), true );
+			}
+			else if ( info == 26 )
+			{
+				ksJson_SetBinaryDouble( node, ksJson_BitsToFloat( (uint32_t)argument ), true );
+			}
+			else if ( info == 27 )
+			{
+				ksJson_SetBinaryDouble( node, ksJson_BitsToDouble( argument ), false );
+			}
+			else if ( info == JSON_CBOR_INDEFINITE )
+			{
+				input->error = "unexpected break";
+			}
+			else
+			{
+				input->error = "unsupported simple value";
+			}
+			break;
+		}
+	}
+}
+
+// Reads the MessagePack string, byte string or extension with a length of 'lengthBytes' bytes.
+static char * ksJson_ReadMsgPackString( ksJsonBinaryInput * input, ksJsonArena * arena, const size_t lengthBytes, const bool bytes, const bool extension )
+{
+	uint64_t length = 0;
+	uint64_t type = 0;
+	if ( !ksJsonBinaryInput_Read( input, lengthBytes, &length ) || ( extension && !ksJsonBinaryInput_Read( input, 1, &type ) ) )
+	{
+		return NULL;
+	}
+	return ksJsonBinaryInput_ReadString( input, arena, length, bytes );
+}
+
+static void ksJson_ReadMsgPackValue( ksJson * node, const int recursion, ksJsonBinaryInput * input )
+{
+	if ( recursion > JSON_MAX_RECURSION )
+	{
+		input->error = "maximum recursion";
+		return;
+	}
+	if ( input->data >= input->end )
+	{
+		input->error = "unexpected end of data";
+		return;
+	}
+	const uint8_t type = *input->data++;
+	ksJsonArena * arena = ksJson_GetArena( node );
+	uint64_t value = 0;
+	uint64_t count = 0;
+	bool isObject = false;
+	char * string = NULL;
+	bool bytes = false;
+
+	if ( type <= 0x7F )
+	{
+		ksJson_SetUint64( node, type );
+		return;
+	}
+	else if ( type >= 0xE0 )
+	{
+		ksJson_SetInt64( node, (int8_t)type );
+		return;
+	}
+	else if ( type <= 0x8F || ( type >= 0x90 && type <= 0x9F ) )
+	{
+		isObject = ( type <= 0x8F );
+		count = type & 0x0F;
+	}
+	else if ( type <= 0xBF )
+	{
+		string = ksJsonBinaryInput_ReadString( input, arena, type & 0x1F, false );
+	}
+	else
+	{
+		switch ( type )
+		{
+			case 0xC0: ksJson_SetNull( node ); return;
+			case 0xC2: ksJson_SetBoolean( node, false ); return;
+			case 0xC3: ksJson_SetBoolean( node, true ); return;
+			case 0xC4: case 0xC5: case 0xC6:
+				string = ksJson_ReadMsgPackString( input, arena, (size_t)1 << ( type - 0xC4 ), true, false );
+				bytes = true;
+				break;
+			case 0xC7: case 0xC8: case 0xC9:
+				string = ksJson_ReadMsgPackString( input, arena, (size_t)1 << ( type - 0xC7 ), true, true );
+				bytes = true;
+				break;
+			case 0xCA:
+				if ( ksJsonBinaryInput_Read( input, 4, &value ) )
+				{
+					ksJson_SetBinaryDouble( node, ksJson_BitsToFloat( (uint32_t)value ), true );
+				}
+				return;
+			case 0xCB:
+				if ( ksJsonBinaryInput_Read( input, 8, &value ) )
+				{
+					ksJson_SetBinaryDouble( node, ksJson_BitsToDouble( value ), false );
+				}
+				return;
+			case 0xCC: case 0xCD: case 0xCE: case 0xCF:
+				if ( ksJsonBinaryInput_Read( input, (size_t)1 << ( type - 0xCC ), &value ) )
+				{
+					ksJson_SetUint64( node, value );
+				}
+				return;
+			case 0xD0: case 0xD1: case 0xD2: case 0xD3:
+			{
+				const int bits = 8 << ( type - 0xD0 );
+				if ( ksJsonBinaryInput_Read( input, bits / 8, &value ) )
+				{
+					// Sign extend and store non-negative values as unsigned like the text parser.
+					const int64_t signedValue = ( bits == 64 ) ? (int64_t)value : (int64_t)( value << ( 64 - bits ) ) >> ( 64 - bits );
+					( signedValue >= 0 ) ? ksJson_SetUint64( node, (uint64_t)signedValue ) : ksJson_SetInt64( node, signedValue );
+				}
+				return;
+			}
+			case 0xD4: case 0xD5: case 0xD6: case 0xD7: case 0xD8:
+				if ( ksJsonBinaryInput_Read( input, 1, &value ) )
+				{
+					string = ksJsonBinaryInput_ReadString( input, arena, (uint64_t)1 << ( type - 0xD4 ), true );
+					bytes = true;
+				}
+				break;
+			case 0xD9: case 0xDA: case 0xDB:
+				string = ksJson_ReadMsgPackString( input, arena, (size_t)1 << ( type - 0xD9 ), false, false );
+				break;
+			case 0xDC: case 0xDD: case 0xDE: case 0xDF:
+				isObject = ( type >= 0xDE );
+				if ( !ksJsonBinaryInput_Read( input, ( type & 1 ) ? 4 : 2, &count ) )
+				{
+					return;
+				}
+				break;
+			default:
+				input->error = "invalid type";
+				return;
+		}
+	}
+
+	if ( string != NULL )
+	{
+		ksJson_SetBinaryString( node, string, bytes );
+		return;
+	}
+	if ( input->error != NULL || !ksJsonBinaryInput_CheckCount( input, count ) )
+	{
+		return;
+	}
+	isObject ? ksJson_SetObject( node ) : ksJson_SetArray( node );
+	for ( uint64_t i = 0; i < count; i++ )
+	{
+		ksJson * member = ksJson_AllocMember( node );
+		if ( isObject )
+		{
+			if ( input->data >= input->end )
+			{
+				input->error = "unexpected end of data";
+				return;
+			}
+			const uint8_t keyType = *input->data++;
+			if ( keyType >= 0xA0 && keyType <= 0xBF )
+			{
+				member->name = ksJsonBinaryInput_ReadString( input, arena, keyType & 0x1F, false );
+			}
+			else if ( keyType >= 0xD9 && keyType <= 0xDB )
+			{
+				member->name = ksJson_ReadMsgPackString( input, arena, (size_t)1 << ( keyType - 0xD9 ), false, false );
+			}
+			else
+			{
+				input->error = "map key is not a string";
+			}
+			if ( member->name == NULL )
+			{
+				return;
+			}
+			member->name = ksJson_InternName( arena, member->name );
+		}
+		ksJson_ReadMsgPackValue( member, recursion + 1, input );
+		if ( input->error != NULL )
+		{
+			return;
+		}
+	}
+}
+
+typedef void ( *ksJsonBinaryReadFunc )( ksJson * node, const int recursion, ksJsonBinaryInput * input );
+
+static bool ksJson_ReadFromBinary( ksJson * rootNode, const void * data, const size_t length, ksJsonBinaryReadFunc readFunc, const char ** errorStringOut )
+{
+	if ( rootNode == NULL || data == NULL )
+	{
+		return false;
+	}
+	if ( errorStringOut != NULL )
+	{
+		*errorStringOut = NULL;
+	}
+	ksJson_FreeNode( rootNode, true );
+
+	ksJsonBinaryInput input;
+	input.data = (const uint8_t *)data;
+	input.end = input.data + length;
+	input.error = NULL;
+	readFunc( rootNode, 0, &input );
+	if ( input.error != NULL )
+	{
+		if ( errorStringOut != NULL )
+		{
+			*errorStringOut = input.error;
+		}
+		ksJson_FreeNode( rootNode, true );
+		return false;
+	}
+	return true;
+}
+
+[[maybe_unused]] static bool ksJson_ReadFromCbor( ksJson * rootNode, const void * data, const size_t length, const char ** errorStringOut )
+{
+	return ksJson_ReadFromBinary( rootNode, data, length, ksJson_ReadCborValue, errorStringOut );
+}
+
+[[maybe_unused]] static bool ksJson_ReadFromMsgPack( ksJson * rootNode, const void * data, const size_t length, const char ** errorStringOut )
+{
+	return ksJson_ReadFromBinary( rootNode, data, length, ksJson_ReadMsgPackValue, errorStringOut );
+}
+
+// Writes a type byte followed by a big-endian unsigned integer of 'bytes' bytes.
+static void ksJsonWriter_BinaryHead( ksJsonWriter * writer, const uint8_t type, const uint64_t value, const int bytes )
+{
+	uint8_t * out = (uint8_t *)ksJsonWriter_Reserve( writer, 1 + bytes );
+	out[0] = type;
+	for ( int i = 0; i < bytes; i++ )
+	{
+		out[1 + i] = (uint8_t)( value >> ( 8 * ( bytes - 1 - i ) ) );
+	}
+	writer->length += 1 + bytes;
+}
+
+static uint64_t ksJson_DoubleToBits( const double value )
+{
+	uint64_t bits;
+	memcpy( &bits, &value, sizeof( bits ) );
+	return bits;
+}
+
+static uint32_t ksJson_FloatToBits( const float value )
+{
+	uint32_t bits;
+	memcpy( &bits, &value, sizeof( bits ) );
+	return bits;
+}
+
+// Writes a CBOR initial byte with the shortest encoding of the argument.
+static void ksJsonWriter_CborHead( ksJsonWriter * writer, const int major, const uint64_t argument )
+{
+	const uint8_t type = (uint8_t)( major << 5 );
+	if ( argument < 24 )
+	{
+		ksJsonWriter_BinaryHead( writer, (uint8_t)( type | argument ), 0, 0 );
+	}
+	else if ( argument <= UINT8_MAX )
+	{
+		ksJsonWriter_BinaryHead( writer, type | 24, argument, 1 );
+	}
+	else if ( argument <= UINT16_MAX )
+	{
+		ksJsonWriter_BinaryHead( writer, type | 25, argument, 2 );
+	}
+	else if ( argument <= UINT32_MAX )
+	{
+		ksJsonWriter_BinaryHead( writer, type | 26, argument, 4 );
+	}
+	else
+	{
+		ksJsonWriter_BinaryHead( writer, type | 27, argument, 8 );
+	}
+}
+
+static void ksJsonWriter_CborString( ksJsonWriter * writer, const int major, const char * string, const size_t length )
+{
+	ksJsonWriter_CborHead( writer, major, length );
+	ksJsonWriter_Append( writer, string, length );
+}
+
+// Writes a DOM node with all its members as CBOR.
+static void ksJsonWriter_CborNode( ksJsonWriter * writer, const ksJson * node, const int recursion )
+{
+	if ( node->type == JSON_NULL || ( ( node->type == JSON_OBJECT || node->type == JSON_ARRAY ) && recursion >= JSON_MAX_RECURSION ) )
+	{
+		ksJsonWriter_BinaryHead( writer, 0xF6, 0, 0 );
+	}
+	else if ( node->type == JSON_BOOLEAN )
+	{
+		ksJsonWriter_BinaryHead( writer, ( node->valueString[0] == 't' ) ? 0xF5 : 0xF4, 0, 0 );
+	}
+	else if ( node->type == JSON_INT && node->valueInt64 < 0 )
+	{
+		ksJsonWriter_CborHead( writer, 1, (uint64_t)( -1 - node->valueInt64 ) );
+	}
+	else if ( node->type == JSON_INT || node->type == JSON_UINT )
+	{
+		ksJsonWriter_CborHead( writer, 0, node->valueUint64 );
+	}
+	else if ( node->type == JSON_FLOAT && ( node->flags & JSON_FLAG_SINGLE ) != 0 )
+	{
+		ksJsonWriter_BinaryHead( writer, 0xFA, ksJson_FloatToBits( (float)node->valueDouble ), 4 );
+	}
+	else if ( node->type == JSON_FLOAT )
+	{
+		ksJsonWriter_BinaryHead( writer, 0xFB, ksJson_DoubleToBits( node->valueDouble ), 8 );
+	}
+	else if ( node->type == JSON_STRING && ( node->flags & JSON_FLAG_BYTES ) != 0 )
+	{
+		ksJsonWriter_CborString( writer, 2, node->valueString, ksJson_GetBytesLength( node ) );
+	}
+	else if ( node->type == JSON_STRING )
+	{
+		ksJsonWriter_CborString( writer, 3, node->valueString, strlen( node->valueString ) );
+	}
+	else
+	{
+		const bool isObject = ( node->type == JSON_OBJECT );
+		ksJsonWriter_CborHead( writer, isObject ? 5 : 4, node->memberCount );
+		for ( int i = 0; i < node->memberCount; i++ )
+		{
+			const ksJson * member = ksJson_GetMemberByIndex( node, i );
+			if ( isObject )
+			{
+				ksJsonWriter_CborString( writer, 3, member->name, strlen( member->name ) );
+			}
+			ksJsonWriter_CborNode( writer, member, recursion + 1 );
+		}
+	}
+}
+
+// Writes a MessagePack string, byte string, array or map header with the shortest length encoding.
+// A zero 'fixType' or 'type8' means there is no such encoding for the format.
+static void ksJsonWriter_MsgPackHead( ksJsonWriter * writer, const uint8_t fixType, const uint64_t fixMax, const uint8_t type8, const uint8_t type16, const uint8_t type32, const uint64_t length )
+{
+	if ( fixType != 0 && length <= fixMax )
+	{
+		ksJsonWriter_BinaryHead( writer, (uint8_t)( fixType | length ), 0, 0 );
+	}
+	else if ( length <= UINT8_MAX && type8 != 0 )
+	{
+		ksJsonWriter_BinaryHead( writer, type8, length, 1 );
+	}
+	else if ( length <= UINT16_MAX )
+	{
+		ksJsonWriter_BinaryHead( writer, type16, length, 2 );
+	}
+	else
+	{
+		ksJsonWriter_BinaryHead( writer, type32, length, 4 );
+	}
+}
+
+static void ksJsonWriter_MsgPackString( ksJsonWriter * writer, const char * string, const size_t length )
+{
+	ksJsonWriter_MsgPackHead( writer, 0xA0, 31, 0xD9, 0xDA, 0xDB, length );
+	ksJsonWriter_Append( writer, string, length );
+}
+
+// Writes a DOM node with all its members as MessagePack.
+static void ksJsonWriter_MsgPackNode( ksJsonWriter * writer, const ksJson * node, const int recursion )
+{
+	if ( node->type == JSON_NULL || ( ( node->type == JSON_OBJECT || node->type == JSON_ARRAY ) && recursion >= JSON_MAX_RECURSION ) )
+	{
+		ksJsonWriter_BinaryHead( writer, 0xC0, 0, 0 );
+	}
+	else if ( node->type == JSON_BOOLEAN )
+	{
+		ksJsonWriter_BinaryHead( writer, ( node->valueString[0] == 't' ) ? 0xC3 : 0xC2, 0, 0 );
+	}
+	else if ( node->type == JSON_INT && node->valueInt64 < 0 )
+	{
+		const int64_t value = node->valueInt64;
+		if ( value >= -32 )
+		{
+			ksJsonWriter_BinaryHead( writer, (uint8_t)value, 0, 0 );
+		}
+		else if ( value >= INT8_MIN )
+		{
+			ksJsonWriter_BinaryHead( writer, 0xD0, (uint64_t)value, 1 );
+		}
+		else if ( value >= INT16_MIN )
+		{
+			ksJsonWriter_BinaryHead( writer, 0xD1, (uint64_t)value, 2 );
+		}
+		else if ( value >= INT32_MIN )
+		{
+			ksJsonWriter_BinaryHead( writer, 0xD2, (uint64_t)value, 4 );
+		}
+		else
+		{
+			ksJsonWriter_BinaryHead( writer, 0xD3, (uint64_t)value, 8 );
+		}
+	}
+	else if ( node->type == JSON_INT || node->type == JSON_UINT )
+	{
+		const uint64_t value = node->valueUint64;
+		if ( value <= 0x7F )
+		{
+			ksJsonWriter_BinaryHead( writer, (uint8_t)value, 0, 0 );
+		}
+		else if ( value <= UINT8_MAX )
+		{
+			ksJsonWriter_BinaryHead( writer, 0xCC, value, 1 );
+		}
+		else if ( value <= UINT16_MAX )
+		{
+			ksJsonWriter_BinaryHead( writer, 0xCD, value, 2 );
+		}
+		else if ( value <= UINT32_MAX )
+		{
+			ksJsonWriter_BinaryHead( writer, 0xCE, value, 4 );
+		}
+		else
+		{
+			ksJsonWriter_BinaryHead( writer, 0xCF, value, 8 );
+		}
+	}
+	else if ( node->type == JSON_FLOAT && ( node->flags & JSON_FLAG_SINGLE ) != 0 )
+	{
+		ksJsonWriter_BinaryHead( writer, 0xCA, ksJson_FloatToBits( (float)node->valueDouble ), 4 );
+	}
+	else if ( node->type == JSON_FLOAT )
+	{
+		ksJsonWriter_BinaryHead( writer, 0xCB, ksJson_DoubleToBits( node->valueDouble ), 8 );
+	}
+	else if ( node->type == JSON_STRING && ( node->flags & JSON_FLAG_BYTES ) != 0 )
+	{
+		const size_t length = ksJson_GetBytesLength( node );
+		ksJsonWriter_MsgPackHead( writer, 0, 0, 0xC4, 0xC5, 0xC6, length );
+		ksJsonWriter_Append( writer, node->valueString, length );
+	}
+	else if ( node->type == JSON_STRING )
+	{
+		ksJsonWriter_MsgPackString( writer, node->valueString, strlen( node->valueString ) );
+	}
+	else
+	{
+		const bool isObject = ( node->type == JSON_OBJECT );
+		ksJsonWriter_MsgPackHead( writer, isObject ? 0x80 : 0x90, 15, 0, isObject ? 0xDE : 0xDC, isObject ? 0xDF : 0xDD, node->memberCount );
+		for ( int i = 0; i < node->memberCount; i++ )
+		{
+			const ksJson * member = ksJson_GetMemberByIndex( node, i );
+			if ( isObject )
+			{
+				ksJsonWriter_MsgPackString( writer, member->name, strlen( member->name ) );
+			}
+			ksJsonWriter_MsgPackNode( writer, member, recursion + 1 );
+		}
+	}
+}
+
+typedef void ( *ksJsonBinaryWriteFunc )( ksJsonWriter * writer, const ksJson * node, const int recursion );
+
+static bool ksJson_WriteToBinary( const ksJson * rootNode, char ** bufferOut, int * lengthOut, ksJsonBinaryWriteFunc writeFunc )
+{
+	if ( rootNode == NULL || bufferOut == NULL || lengthOut == NULL )
+	{
+		return false;
+	}
+	ksJsonWriter writer;
+	ksJsonWriter_Init( &writer, NULL, 0, NULL, NULL, 0 );
+	writeFunc( &writer, rootNode, 0 );
+	ksJsonWriter_Reserve( &writer, 1 );		// an empty buffer is still allocated
+	*bufferOut = writer.buffer;
+	*lengthOut = (int)writer.length;
+	return true;
+}
+
+// 'bufferOut' is allocated with malloc.
+[[maybe_unused]] static bool ksJson_WriteToCbor( const ksJson * rootNode, char ** bufferOut, int * lengthOut )
+{
+	return ksJson_WriteToBinary( rootNode, bufferOut, lengthOut, ksJsonWriter_CborNode );
+}
+
+// 'bufferOut' is allocated with malloc.
+[[maybe_unused]] static bool ksJson_WriteToMsgPack( const ksJson * rootNode, char ** bufferOut, int * lengthOut )
+{
+	return ksJson_WriteToBinary( rootNode, bufferOut, lengthOut, ksJsonWriter_MsgPackNode );
 }
 
 #endif // !KSJSON_H
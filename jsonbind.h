@@ -0,0 +1,189 @@
+#pragma once
+
+#include "json.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace lxd {
+	// 与 ksJson_HashName 相同的 FNV-1a, 字段名的哈希在编译期算好
+	constexpr uint32_t JsonNameHash(std::string_view name) {
+		uint32_t hash = 2166136261u;
+		for(const char c : name)
+			hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+		return hash;
+	}
+
+	// name 以 0 结尾, 直接作为写出时的键
+	template <typename T, typename M>
+	struct JsonField {
+		constexpr JsonField(const char* name, M T::*member) : name(name), member(member), hash(JsonNameHash(name)) {}
+		const char* name;
+		M T::*member;
+		uint32_t hash;
+	};
+
+	/// <summary>
+	/// 结构体与 JSON 对象的绑定表, 为每个结构体特化一次:
+	///   template <> struct lxd::JsonBinding<Point> {
+	///       static constexpr auto fields = std::make_tuple(JsonField("x", &Point::x), JsonField("y", &Point::y));
+	///   };
+	/// 字段可以是 bool, 整数, float, double, std::string, char[N], 已绑定的结构体及它们的 std::vector
+	/// </summary>
+	template <typename T>
+	struct JsonBinding;
+
+	template <typename T>
+	concept JsonBound = requires { JsonBinding<T>::fields; };
+
+	template <typename Node, typename T>
+	void ReadJson(Node node, T& out);
+
+	namespace detail {
+		// DOM 节点与 tape 游标的统一访问
+		inline const ksJson* JsonLeaf(const ksJson* node, ksJson*) { return node; }
+		inline const ksJson* JsonLeaf(ksJsonCursor cursor, ksJson* storage) { return ksJsonCursor_GetValue(cursor, storage); }
+
+		template <typename F>
+		void ForEachJsonMember(const ksJson* node, F&& f) {
+			const int count = ksJson_GetMemberCount(node);
+			for(int i = 0; i < count; i++) {
+				const ksJson* member = ksJson_GetMemberByIndex(node, i);
+				f(ksJson_GetMemberName(member), member);
+			}
+		}
+		template <typename F>
+		void ForEachJsonMember(ksJsonCursor cursor, F&& f) {
+			for(ksJsonCursor member = ksJsonCursor_GetFirstMember(cursor); ksJsonCursor_IsValid(member); member = ksJsonCursor_GetNextMember(member))
+				f(ksJsonCursor_GetMemberName(member), member);
+		}
+
+		template <typename T>
+		struct IsVector : std::false_type {};
+		template <typename T>
+		struct IsVector<std::vector<T>> : std::true_type {};
+
+		// 编译期按名字的哈希排序的字段表, 每个成员二分查找一次, 再经函数指针读入对应的字段
+		template <typename T, typename Node>
+		struct JsonFieldTable {
+			struct Entry {
+				uint32_t hash;
+				const char* name;
+				void (*read)(Node member, T& out);
+			};
+			static constexpr auto& fields = JsonBinding<T>::fields;
+			static constexpr size_t count = std::tuple_size_v<std::remove_cvref_t<decltype(fields)>>;
+
+			static constexpr std::array<Entry, count> entries = [] {
+				std::array<Entry, count> result{};
+				[&]<size_t... I>(std::index_sequence<I...>) {
+					((result[I] = Entry{std::get<I>(fields).hash, std::get<I>(fields).name,
+						[](Node member, T& out) { ReadJson(member, out.*std::get<I>(fields).member); }}), ...);
+				}(std::make_index_sequence<count>{});
+				// 插入排序是稳定的, 重名的字段与绑定表中的顺序相同, 前一个优先
+				for(size_t i = 1; i < count; i++)
+					for(size_t j = i; j > 0 && result[j - 1].hash > result[j].hash; j--)
+						std::swap(result[j - 1], result[j]);
+				return result;
+			}();
+
+			static const Entry* find(const char* name) {
+				const uint32_t hash = ksJson_HashName(name);
+				auto it = std::lower_bound(entries.begin(), entries.end(), hash, [](const Entry& entry, uint32_t h) { return entry.hash < h; });
+				for(; it != entries.end() && it->hash == hash; ++it) {
+					if(std::strcmp(it->name, name) == 0)
+						return &*it;
+				}
+				return nullptr;
+			}
+		};
+	}
+
+	// 缺少的字段, 类型不符的值保持原值
+	template <typename Node, typename T>
+	void ReadJson(Node node, T& out) {
+		ksJson storage;
+		const ksJson* leaf = detail::JsonLeaf(node, &storage);
+		if constexpr(JsonBound<T>) {
+			if(!ksJson_IsObject(leaf))
+				return;
+			// 只遍历一次成员, 每个成员在按哈希排序的字段表中查找一次
+			detail::ForEachJsonMember(node, [&](const char* name, auto member) {
+				if(const auto* entry = detail::JsonFieldTable<T, decltype(member)>::find(name))
+					entry->read(member, out);
+			});
+		} else if constexpr(detail::IsVector<T>::value) {
+			if(!ksJson_IsArray(leaf))
+				return;
+			out.clear();
+			out.reserve(leaf->memberCount);
+			detail::ForEachJsonMember(node, [&](const char*, auto member) {
+				ReadJson(member, out.emplace_back());
+			});
+		} else if constexpr(std::is_same_v<T, bool>) {
+			out = ksJson_GetBool(leaf, out);
+		} else if constexpr(std::is_integral_v<T> && std::is_signed_v<T>) {
+			// 与 ksJson_GetInt32 等相同, 超出范围的值被截断到 T 的范围
+			out = static_cast<T>(std::clamp<int64_t>(ksJson_GetInt64(leaf, out), std::numeric_limits<T>::min(), std::numeric_limits<T>::max()));
+		} else if constexpr(std::is_integral_v<T>) {
+			out = static_cast<T>(std::min<uint64_t>(ksJson_GetUint64(leaf, out), std::numeric_limits<T>::max()));
+		} else if constexpr(std::is_same_v<T, float>) {
+			out = ksJson_GetFloat(leaf, out);
+		} else if constexpr(std::is_same_v<T, double>) {
+			out = ksJson_GetDouble(leaf, out);
+		} else if constexpr(std::is_same_v<T, std::string>) {
+			size_t length = 0;
+			if(const void* data = ksJson_GetBytes(leaf, &length))
+				out.assign(static_cast<const char*>(data), length);
+		} else if constexpr(std::is_array_v<T> && std::is_same_v<std::remove_extent_t<T>, char>) {
+			// 超长的字符串被截断, 结果总以 0 结尾
+			if(const char* string = ksJson_GetString(leaf, nullptr)) {
+				const size_t length = std::min(std::strlen(string), std::extent_v<T> - 1);
+				std::memcpy(out, string, length);
+				out[length] = '\0';
+			}
+		} else {
+			static_assert(sizeof(T) == 0, "unsupported JSON field type");
+		}
+	}
+
+	template <typename T>
+	void WriteJson(ksJsonWriter* writer, const T& value) {
+		if constexpr(JsonBound<T>) {
+			ksJsonWriter_BeginObject(writer);
+			std::apply([&](const auto&... field) {
+				((ksJsonWriter_Key(writer, field.name), WriteJson(writer, value.*field.member)), ...);
+			}, JsonBinding<T>::fields);
+			ksJsonWriter_EndObject(writer);
+		} else if constexpr(detail::IsVector<T>::value) {
+			ksJsonWriter_BeginArray(writer);
+			for(const auto& element : value)
+				WriteJson(writer, element);
+			ksJsonWriter_EndArray(writer);
+		} else if constexpr(std::is_same_v<T, bool>) {
+			ksJsonWriter_Bool(writer, value);
+		} else if constexpr(std::is_integral_v<T> && std::is_signed_v<T>) {
+			ksJsonWriter_Int64(writer, value);
+		} else if constexpr(std::is_integral_v<T>) {
+			ksJsonWriter_Uint64(writer, value);
+		} else if constexpr(std::is_same_v<T, float>) {
+			ksJsonWriter_Float(writer, value);
+		} else if constexpr(std::is_same_v<T, double>) {
+			ksJsonWriter_Double(writer, value);
+		} else if constexpr(std::is_same_v<T, std::string>) {
+			ksJsonWriter_StringLength(writer, value.data(), value.size());
+		} else if constexpr(std::is_array_v<T> && std::is_same_v<std::remove_extent_t<T>, char>) {
+			ksJsonWriter_StringLength(writer, value, std::find(value, value + std::extent_v<T>, '\0') - value);
+		} else {
+			static_assert(sizeof(T) == 0, "unsupported JSON field type");
+		}
+	}
+}
@@ -0,0 +1,151 @@
+#include "ndjson.h"
+#include "fileio.h"
+#include "json.h"
+#include "utils.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+namespace lxd {
+	namespace {
+		constexpr size_t kMinChunk = 1 << 20;
+
+		// 按换行对齐切块, 第 i 块为 [bounds[i], bounds[i + 1])
+		std::vector<size_t> SplitLines(std::string_view text) {
+			const size_t nThread = std::max(1u, std::thread::hardware_concurrency());
+			const size_t nChunk = std::clamp<size_t>(text.size() / kMinChunk, 1, 4 * nThread);
+			std::vector<size_t> bounds{0};
+			for(size_t i = 1; i < nChunk; i++) {
+				const size_t pos = std::max(text.size() * i / nChunk, bounds.back());
+				const void* newline = std::memchr(text.data() + pos, '\n', text.size() - pos);
+				if(!newline)
+					break;
+				const size_t next = static_cast<const char*>(newline) - text.data() + 1;
+				if(next > bounds.back() && next < text.size())
+					bounds.push_back(next);
+			}
+			bounds.push_back(text.size());
+			return bounds;
+		}
+
+		// 逐行调用 func(offset, length), 空行被跳过. 行尾的 \r 是空白, 由解析器跳过
+		template <typename Func>
+		void ForEachLine(std::string_view text, size_t begin, size_t end, Func&& func) {
+			while(begin < end) {
+				const void* newline = std::memchr(text.data() + begin, '\n', end - begin);
+				const size_t lineEnd = newline ? static_cast<const char*>(newline) - text.data() : end;
+				const auto first = std::find_if(text.begin() + begin, text.begin() + lineEnd, [](char c) { return static_cast<unsigned char>(c) > ' '; });
+				if(first != text.begin() + lineEnd)
+					func(begin, lineEnd - begin);
+				begin = lineEnd + 1;
+			}
+		}
+
+		// 同时运行的块不超过线程数, 取用的 arena 在块之间复用, 数量即 worker 数
+		class ArenaPool {
+		public:
+			~ArenaPool() {
+				for(ksJson* rootNode : m_free)
+					ksJson_Destroy(rootNode);
+			}
+			ksJson* acquire() {
+				std::lock_guard lock(m_mutex);
+				if(m_free.empty())
+					return ksJson_CreateWithArena(0);
+				ksJson* rootNode = m_free.back();
+				m_free.pop_back();
+				return rootNode;
+			}
+			void release(ksJson* rootNode) {
+				std::lock_guard lock(m_mutex);
+				m_free.push_back(rootNode);
+			}
+
+		private:
+			std::mutex m_mutex;
+			std::vector<ksJson*> m_free;
+		};
+
+		void MergeErrors(std::vector<std::vector<NdjsonError>>& chunkErrors, std::vector<NdjsonError>& errors) {
+			for(auto& chunk : chunkErrors)
+				errors.insert(errors.end(), chunk.begin(), chunk.end());
+		}
+	}
+
+	size_t ForEachNdjson(std::string_view text, const NdjsonCallback& callback, std::vector<NdjsonError>* errors) {
+		const auto bounds = SplitLines(text);
+		const size_t nChunk = bounds.size() - 1;
+		std::vector<std::vector<NdjsonError>> chunkErrors(nChunk);
+		std::atomic<size_t> count = 0;
+		ArenaPool pool;
+		RunParallel(static_cast<uint32_t>(nChunk), [&](uint32_t chunk) {
+			ksJson* rootNode = pool.acquire();
+			size_t parsed = 0;
+			// 直接从 text 解析, 字符串复制到 arena 中, 读下一行时 arena 被回收, 所以只在回调期间有效
+			ForEachLine(text, bounds[chunk], bounds[chunk + 1], [&](size_t offset, size_t length) {
+				const char* error = nullptr;
+				if(ksJson_ReadFromBufferLength(rootNode, text.data() + offset, length, &error)) {
+					callback(offset, rootNode);
+					parsed++;
+				} else {
+					chunkErrors[chunk].push_back({offset, error});
+				}
+			});
+			ksJson_Reset(rootNode);
+			pool.release(rootNode);
+			count.fetch_add(parsed, std::memory_order_relaxed);
+		});
+		if(errors)
+			MergeErrors(chunkErrors, *errors);
+		return count.load();
+	}
+
+	size_t ForEachNdjsonFile(const Char* path, const NdjsonCallback& callback, std::vector<NdjsonError>* errors) {
+		MappedFile file(path);
+		if(!file.data())
+			return 0;
+		return ForEachNdjson({file.data(), file.size()}, callback, errors);
+	}
+
+	void NdjsonRecords::Deleter::operator()(ksJson* rootNode) const {
+		ksJson_Destroy(rootNode);
+	}
+
+	const ksJson* NdjsonRecords::operator[](size_t index) const {
+		if(index >= size())
+			return nullptr;
+		const size_t chunk = std::upper_bound(m_starts.begin(), m_starts.end(), index) - m_starts.begin() - 1;
+		return ksJson_GetMemberByIndex(m_chunks[chunk].get(), static_cast<int>(index - m_starts[chunk]));
+	}
+
+	NdjsonRecords ReadNdjson(std::string_view text) {
+		NdjsonRecords records;
+		const auto bounds = SplitLines(text);
+		const size_t nChunk = bounds.size() - 1;
+		std::vector<std::vector<NdjsonError>> chunkErrors(nChunk);
+		records.m_chunks.resize(nChunk);
+		RunParallel(static_cast<uint32_t>(nChunk), [&](uint32_t chunk) {
+			// 记录要保留, 每块一个 arena, 字符串复制到 arena 中
+			ksJson* rootNode = ksJson_SetArray(ksJson_CreateWithArena(0));
+			records.m_chunks[chunk].reset(rootNode);
+			ForEachLine(text, bounds[chunk], bounds[chunk + 1], [&](size_t offset, size_t length) {
+				const char* error = nullptr;
+				if(!ksJson_ReadFromBufferLength(ksJson_AddArrayElement(rootNode), text.data() + offset, length, &error))
+					chunkErrors[chunk].push_back({offset, error});
+			});
+		});
+		records.m_starts.resize(nChunk + 1);
+		records.m_starts[0] = 0;
+		for(size_t i = 0; i < nChunk; i++)
+			records.m_starts[i + 1] = records.m_starts[i] + ksJson_GetMemberCount(records.m_chunks[i].get());
+		MergeErrors(chunkErrors, records.m_errors);
+		return records;
+	}
+
+	NdjsonRecords ReadNdjsonFile(const Char* path) {
+		MappedFile file(path);
+		return ReadNdjson({file.data(), file.size()});
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "defines.h"
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+struct ksJson;
+
+namespace lxd {
+	struct NdjsonError {
+		size_t offset; // 出错行在文本中的字节偏移
+		const char* message;
+	};
+
+	// offset 为记录所在行的字节偏移. 回调在多个线程中并发执行, 同一块内按行的顺序;
+	// record 属于 worker 复用的 arena, 回调返回后不能再访问
+	using NdjsonCallback = std::function<void(size_t offset, const ksJson* record)>;
+
+	/// <summary>
+	/// 换行分隔的 JSON(NDJSON / JSON Lines) 的并行读取
+	/// 文本按换行对齐切成若干块, 在线程池中并行解析, 每个 worker 复用一个 arena, 空行被跳过
+	/// 每行直接从 text 中解析, 不复制; text 之后必须紧跟一个 0 字节(std::string 和 MappedFile 都满足)
+	/// </summary>
+	DLL_PUBLIC size_t ForEachNdjson(std::string_view text, const NdjsonCallback& callback, std::vector<NdjsonError>* errors = nullptr);
+	// 映射文件后并行解析, 返回成功解析的记录数; 文件无法打开时返回 0
+	DLL_PUBLIC size_t ForEachNdjsonFile(const Char* path, const NdjsonCallback& callback, std::vector<NdjsonError>* errors = nullptr);
+
+	// 按行的顺序收集全部记录, 解析失败的行记录在 NdjsonRecords::errors() 中; text 同样要以 0 结尾
+	class NdjsonRecords;
+	DLL_PUBLIC NdjsonRecords ReadNdjson(std::string_view text);
+	DLL_PUBLIC NdjsonRecords ReadNdjsonFile(const Char* path);
+
+	/// <summary>
+	/// 按行的顺序收集的全部记录, 每块的记录在一个 arena DOM 中
+	/// 解析失败的行保留为 null, 下标与非空行一一对应
+	/// </summary>
+	class DLL_PUBLIC NdjsonRecords {
+	public:
+		size_t size() const { return m_starts.empty() ? 0 : m_starts.back(); }
+		const ksJson* operator[](size_t index) const;
+		const std::vector<NdjsonError>& errors() const { return m_errors; }
+
+	private:
+		friend NdjsonRecords ReadNdjson(std::string_view text);
+		struct Deleter {
+			void operator()(ksJson* rootNode) const;
+		};
+
+	private:
+		std::vector<std::unique_ptr<ksJson, Deleter>> m_chunks; // 根节点为该块记录的数组
+		std::vector<size_t> m_starts; // 每块第一条记录的下标, 末尾为记录总数
+		std::vector<NdjsonError> m_errors;
+	};
+}
@@ -0,0 +1,192 @@
+#include "pointcloud.h"
+#include "utils.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace lxd {
+	namespace {
+		constexpr size_t kGrain = 1 << 14;
+
+		uint32_t ChunkCount(size_t count) {
+			return static_cast<uint32_t>(std::clamp<size_t>(count / kGrain, 1, 4 * std::max(1u, std::thread::hardware_concurrency())));
+		}
+
+		// 并行流压缩: 返回所有满足 pred(i) 的 i, 保持原有顺序
+		template <typename Pred>
+		std::vector<uint32_t> Compact(size_t count, Pred&& pred) {
+			const uint32_t nChunk = ChunkCount(count);
+			auto chunkBegin = [&](uint32_t chunk) { return count * chunk / nChunk; };
+			std::vector<uint32_t> offsets(nChunk + 1, 0);
+			RunParallel(nChunk, [&](uint32_t chunk) {
+				uint32_t n = 0;
+				for(size_t i = chunkBegin(chunk); i < chunkBegin(chunk + 1); i++)
+					n += pred(i);
+				offsets[chunk + 1] = n;
+			});
+			for(uint32_t chunk = 0; chunk < nChunk; chunk++)
+				offsets[chunk + 1] += offsets[chunk];
+			std::vector<uint32_t> result(offsets[nChunk]);
+			RunParallel(nChunk, [&](uint32_t chunk) {
+				uint32_t out = offsets[chunk];
+				for(size_t i = chunkBegin(chunk); i < chunkBegin(chunk + 1); i++) {
+					if(pred(i))
+						result[out++] = static_cast<uint32_t>(i);
+				}
+			});
+			return result;
+		}
+
+		// splitmix64, 用三角形序号做种子
+		struct Random {
+			uint64_t state;
+			uint64_t next() {
+				uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+				z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+				z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+				return z ^ (z >> 31);
+			}
+			float uniform() { return static_cast<float>(next() >> 40) * (1.0f / 16777216.0f); }
+		};
+
+		// 每个轴 32 位的体素坐标, x, y 合在 key 中, 加上 z 与点的序号共 16 字节
+		struct VoxelKey {
+			uint64_t key;
+			uint32_t z;
+			uint32_t index;
+			bool sameVoxel(const VoxelKey& other) const { return key == other.key && z == other.z; }
+			friend bool operator<(const VoxelKey& a, const VoxelKey& b) { return a.key < b.key || (a.key == b.key && a.z < b.z); }
+		};
+
+#pragma pack(push, 1)
+		struct StlFacet {
+			float normal[3];
+			float v[3][3];
+			uint16_t attribute;
+		};
+#pragma pack(pop)
+
+		float TriangleArea(const StlFacet& facet) {
+			const float ax = facet.v[1][0] - facet.v[0][0], ay = facet.v[1][1] - facet.v[0][1], az = facet.v[1][2] - facet.v[0][2];
+			const float bx = facet.v[2][0] - facet.v[0][0], by = facet.v[2][1] - facet.v[0][1], bz = facet.v[2][2] - facet.v[0][2];
+			const float cx = ay * bz - az * by, cy = az * bx - ax * bz, cz = ax * by - ay * bx;
+			return 0.5f * std::sqrt(cx * cx + cy * cy + cz * cz);
+		}
+	}
+
+	std::vector<MyVec3f> VoxelDownsample(std::span<const MyVec3f> points, float voxelSize) {
+		if(points.empty() || !(voxelSize > 0.0f))
+			return {};
+		// 1. 并行求包围盒
+		const uint32_t nChunk = ChunkCount(points.size());
+		std::vector<MyVec3f> mins(nChunk), maxs(nChunk);
+		RunParallel(nChunk, [&](uint32_t chunk) {
+			MyVec3f lo{{std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()}};
+			MyVec3f hi{{-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max()}};
+			for(size_t i = points.size() * chunk / nChunk; i < points.size() * (chunk + 1) / nChunk; i++) {
+				for(int k = 0; k < 3; k++) {
+					lo.v[k] = std::min(lo.v[k], points[i].v[k]);
+					hi.v[k] = std::max(hi.v[k], points[i].v[k]);
+				}
+			}
+			mins[chunk] = lo;
+			maxs[chunk] = hi;
+		});
+		MyVec3f lo = mins[0], hi = maxs[0];
+		for(uint32_t chunk = 1; chunk < nChunk; chunk++) {
+			for(int k = 0; k < 3; k++) {
+				lo.v[k] = std::min(lo.v[k], mins[chunk].v[k]);
+				hi.v[k] = std::max(hi.v[k], maxs[chunk].v[k]);
+			}
+		}
+		const float inv = 1.0f / voxelSize;
+		for(int k = 0; k < 3; k++) {
+			if(!(double(hi.v[k] - lo.v[k]) * inv < 4294967296.0))
+				return {};
+		}
+		// 2. 并行计算体素键, 排序后同一体素的点相邻
+		std::vector<VoxelKey> keys(points.size());
+		ParallelFor(points.size(), kGrain, [&](size_t begin, size_t end) {
+			for(size_t i = begin; i < end; i++) {
+				uint32_t cell[3];
+				for(int k = 0; k < 3; k++)
+					cell[k] = static_cast<uint32_t>(std::min(double(points[i].v[k] - lo.v[k]) * inv, 4294967295.0));
+				keys[i] = {uint64_t(cell[0]) << 32 | cell[1], cell[2], static_cast<uint32_t>(i)};
+			}
+		});
+		ParallelSort(keys.begin(), keys.end());
+		// 3. 找出每个体素的起始位置, 并行求质心
+		const auto starts = Compact(keys.size(), [&](size_t i) { return i == 0 || !keys[i - 1].sameVoxel(keys[i]); });
+		std::vector<MyVec3f> result(starts.size());
+		ParallelFor(starts.size(), kGrain / 8, [&](size_t begin, size_t end) {
+			for(size_t v = begin; v < end; v++) {
+				const size_t first = starts[v];
+				const size_t last = v + 1 < starts.size() ? starts[v + 1] : keys.size();
+				double sum[3] = {0.0, 0.0, 0.0};
+				for(size_t i = first; i < last; i++) {
+					for(int k = 0; k < 3; k++)
+						sum[k] += points[keys[i].index].v[k];
+				}
+				const double n = static_cast<double>(last - first);
+				result[v] = {{static_cast<float>(sum[0] / n), static_cast<float>(sum[1] / n), static_cast<float>(sum[2] / n)}};
+			}
+		});
+		return result;
+	}
+
+	std::vector<MyVec3f> SampleStl(std::string_view stlBuffer, float spacing, float samplesPerCell) {
+		if(stlBuffer.size() < 84 || !(spacing > 0.0f))
+			return {};
+		uint32_t nFacet;
+		std::memcpy(&nFacet, stlBuffer.data() + 80, sizeof(nFacet));
+		if(stlBuffer.size() != 84 + size_t(50) * nFacet)
+			return {};
+		auto facetAt = [&](size_t i) {
+			StlFacet facet;
+			std::memcpy(&facet, stlBuffer.data() + 84 + 50 * i, sizeof(facet));
+			return facet;
+		};
+		// 1. 每个三角形的采样数 = 面积 x 密度, 小数部分按概率取舍
+		// 单个三角形最多 2^32 个点, 所以 nFacet 个三角形的总数不会超出 64 位
+		const float density = samplesPerCell / (spacing * spacing);
+		std::vector<size_t> offsets(size_t(nFacet) + 1, 0);
+		std::atomic<bool> tooMany{false};
+		ParallelFor(nFacet, kGrain, [&](size_t begin, size_t end) {
+			for(size_t i = begin; i < end; i++) {
+				const float expected = TriangleArea(facetAt(i)) * density;
+				if(!(expected < 4294967296.0f)) {
+					tooMany = true;
+					continue;
+				}
+				Random random{i};
+				const float whole = std::floor(expected);
+				offsets[i + 1] = static_cast<size_t>(whole) + (random.uniform() < expected - whole ? 1 : 0);
+			}
+		});
+		if(tooMany)
+			return {};
+		for(size_t i = 0; i < nFacet; i++)
+			offsets[i + 1] += offsets[i];
+		// 2. 每个三角形写入自己的区间
+		std::vector<MyVec3f> result(offsets[nFacet]);
+		ParallelFor(nFacet, kGrain, [&](size_t begin, size_t end) {
+			for(size_t i = begin; i < end; i++) {
+				const StlFacet facet = facetAt(i);
+				Random random{i};
+				random.next(); // 跳过第 1 步用过的随机数
+				for(size_t j = offsets[i]; j < offsets[i + 1]; j++) {
+					float r1 = random.uniform(), r2 = random.uniform();
+					if(r1 + r2 > 1.0f) {
+						r1 = 1.0f - r1;
+						r2 = 1.0f - r2;
+					}
+					for(int k = 0; k < 3; k++)
+						result[j].v[k] = facet.v[0][k] + r1 * (facet.v[1][k] - facet.v[0][k]) + r2 * (facet.v[2][k] - facet.v[0][k]);
+				}
+			}
+		});
+		return result;
+	}
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "defines.h"
+#include "glb.h"
+#include <vector>
+#include <span>
+#include <string_view>
+
+namespace lxd {
+	/// <summary>
+	/// 体素网格降采样, 每个非空体素输出其中所有点的质心, 结果按体素坐标排序
+	/// 每个轴最多 2^32 个体素, 超出时返回空
+	/// </summary>
+	DLL_PUBLIC std::vector<MyVec3f> VoxelDownsample(std::span<const MyVec3f> points, float voxelSize);
+	/// <summary>
+	/// 在二进制 STL 的三角形表面按面积均匀采样, 平均每个 spacing x spacing 的面积上 samplesPerCell 个点
+	/// 每个三角形的随机序列只由三角形序号决定, 结果可复现
+	/// </summary>
+	DLL_PUBLIC std::vector<MyVec3f> SampleStl(std::string_view stlBuffer, float spacing, float samplesPerCell = 4.0f);
+	// 输出只有顶点的二进制 PLY
+	DLL_PUBLIC std::vector<char> PointCloudToPly(std::span<const MyVec3f> points);
+}
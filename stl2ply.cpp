@@ -1,7 +1,10 @@
 ﻿#include "stl2ply.h"
 #include "smallvector.h"
+#include "pointcloud.h"
 #include <vector>
 #include <unordered_map>
+#include <climits>
+#include <cstring>
 #include <span>
 
 // STL 二进制文件结构
@@ -45,6 +48,40 @@ namespace std {
 
 struct Face { uint8_t count; llvm::SmallVector<uint32_t, 3> indices; };
 
+// 写二进制 PLY 头, faceCount 为 0 时不输出 face 元素; 返回头长度, 失败返回 -1
+static int plyHeader(char* buffer, int bufferSize, size_t vertexCount, size_t faceCount) {
+    int length = snprintf(
+        buffer, bufferSize,
+        "ply\n"
+        "format binary_little_endian 1.0\n"
+        "element vertex %zu\n"
+        "property float x\nproperty float y\nproperty float z\n",
+        vertexCount
+    );
+    if (length >= 0 && length < bufferSize && faceCount > 0) {
+        length += snprintf(
+            buffer + length, bufferSize - length,
+            "element face %zu\n"
+            "property list uchar uint vertex_indices\n",
+            faceCount
+        );
+    }
+    if (length >= 0 && length < bufferSize)
+        length += snprintf(buffer + length, bufferSize - length, "end_header\n");
+    return (length >= 0 && length < bufferSize) ? length : -1;
+}
+
+// 只有顶点的 PLY 与 stl2ply 共用同一个头
+std::vector<char> lxd::PointCloudToPly(std::span<const lxd::MyVec3f> points) {
+    char header[256];
+    int header_len = plyHeader(header, sizeof(header), points.size(), 0);
+    if (header_len < 0) return {};
+    std::vector<char> result(header_len + points.size() * sizeof(lxd::MyVec3f));
+    std::memcpy(result.data(), header, header_len);
+    std::memcpy(result.data() + header_len, points.data(), points.size() * sizeof(lxd::MyVec3f));
+    return result;
+}
+
 int countTriangles(char* data, int size) {
 	if (size < 84)
 		return 0;
@@ -89,17 +126,8 @@ bool stl2ply(char* stlBuffer, int stlBufferSize, char** outBuffer, int* outBuffe
     // 3. 预计算PLY头长度
     constexpr size_t kMaxHeaderSize = 256;
     char header[kMaxHeaderSize];
-    int header_len = snprintf(
-        header, sizeof(header),
-        "ply\n"
-        "format binary_little_endian 1.0\n"
-        "element vertex %zu\n"
-        "property float x\nproperty float y\nproperty float z\n"
-        "element face %zu\n"
-        "property list uchar uint vertex_indices\n"
-        "end_header\n",
-        vertices.size(), faces.size()
-    );
+    int header_len = plyHeader(header, sizeof(header), vertices.size(), faces.size());
+    if (header_len < 0) return false;
 
     // 4. 计算总大小并一次性分配内存
     size_t total_size = header_len
@@ -129,5 +157,26 @@ bool stl2ply(char* stlBuffer, int stlBufferSize, char** outBuffer, int* outBuffe
         ptr += 3 * sizeof(uint32_t);
     }
 
+    return true;
+}
+
+bool stl2pointcloud(char* stlBuffer, int stlBufferSize, float voxelSize, char** outBuffer, int* outBufferSize) {
+    if (countTriangles(stlBuffer, stlBufferSize) == 0 || !(voxelSize > 0))
+        return false;
+
+    auto samples = lxd::SampleStl(std::string_view(stlBuffer, stlBufferSize), voxelSize);
+    auto points = lxd::VoxelDownsample(samples, voxelSize);
+    // 包围盒超出体素坐标的范围
+    if (points.empty() && !samples.empty())
+        return false;
+
+    auto ply = lxd::PointCloudToPly(points);
+    if (ply.empty() || ply.size() > INT_MAX) return false;
+    char* ply_data = static_cast<char*>(malloc(ply.size()));
+    if (!ply_data) return false;
+    std::memcpy(ply_data, ply.data(), ply.size());
+
+    *outBuffer = ply_data;
+    *outBufferSize = static_cast<int>(ply.size());
     return true;
 }
\ No newline at end of file
@@ -1,9 +1,13 @@
 #pragma once
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 	bool stl2ply(char* stlBuffer, int stlBufferSize, char** outBuffer, int* outBufferSize);
+	// 在 STL 表面按面积均匀采样, 再按 voxelSize 体素降采样, 输出只有顶点的 PLY
+	bool stl2pointcloud(char* stlBuffer, int stlBufferSize, float voxelSize, char** outBuffer, int* outBufferSize);
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
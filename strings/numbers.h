@@ -164,6 +164,40 @@ static const int kSixDigitsToBufferSize = 16;
 // Required buffer size is `kSixDigitsToBufferSize`.
 DLL_PUBLIC size_t SixDigitsToBuffer(double d, char* buffer);
 
+static const int kShortestToBufferSize = 32;
+
+// Shortest round-trip formatting of floating-point values (Schubfach, which
+// gives the same digits as Ryu). Writes the fewest significant digits that
+// convert back to exactly `d`, choosing the closest such digits on ties.
+// Like JavaScript's Number.prototype.toString(), plain notation is used for
+// magnitudes in [1e-6, 1e21) and scientific notation otherwise:
+//   0.1 -> "0.1", 100.0 -> "100", 1e21 -> "1e+21", 1.5e-7 -> "1.5e-7".
+// Non-finite values are written as "inf", "-inf" and "nan". The output is
+// null-terminated and the return value is its length.
+// Required buffer size is `kShortestToBufferSize`.
+DLL_PUBLIC size_t ShortestToBuffer(double d, char* buffer);
+DLL_PUBLIC size_t ShortestToBuffer(float f, char* buffer);
+
+// Exact decimal to binary conversion (Eisel-Lemire). Converts
+// `mantissa` * 10^`exponent10` to the nearest double or float, ties to even.
+// `mantissa` must hold all significant digits, so at most 19 of them. Results
+// that overflow are infinite and results that underflow are zero.
+DLL_PUBLIC double DecimalToDouble(uint64_t mantissa, int64_t exponent10,
+                                  bool negative);
+DLL_PUBLIC float DecimalToFloat(uint64_t mantissa, int64_t exponent10,
+                                bool negative);
+
+// Parses a decimal number from [begin, end): an optional '-', integer digits,
+// an optional '.' followed by digits and an optional exponent. Leading zeros
+// and a missing integer or fraction part are accepted. Any number of digits
+// is converted exactly, numbers with more than 19 significant digits rarely
+// take a slower path. Returns a pointer to the first character after the
+// number, or nullptr if [begin, end) does not start with a number.
+DLL_PUBLIC const char* ParseDouble(const char* begin, const char* end,
+                                   double* out);
+DLL_PUBLIC const char* ParseFloat(const char* begin, const char* end,
+                                  float* out);
+
 // These functions are intended for speed. All functions take an output buffer
 // as an argument and return a pointer to the last byte they wrote, which is the
 // terminating '\0'. At most `kFastToBufferSize` bytes are written.
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "threading.h"
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+namespace lxd {
+	/// <summary>
+	/// 工作窃取的任务调度器(ksTaskScheduler), 每个工作线程有自己的 Chase-Lev 双端队列, 空闲时从其它线程窃取任务
+	/// workerCount 为 TASK_WORKERS_DEFAULT 时每个硬件线程一个工作线程(创建者除外), priority 大于 0 时工作线程为实时优先级
+	/// </summary>
+	class TaskScheduler {
+	public:
+		explicit TaskScheduler(int workerCount = TASK_WORKERS_DEFAULT, int priority = 0) {
+			const ksTaskSchedulerConfig config{workerCount, priority};
+			ksTaskScheduler_Create(&m_scheduler, &config);
+		}
+		~TaskScheduler() { ksTaskScheduler_Destroy(&m_scheduler); }
+		TaskScheduler(const TaskScheduler&) = delete;
+		TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+		int workerCount() const { return ksTaskScheduler_GetWorkerCount(&m_scheduler); }
+		ksTaskScheduler* handle() { return &m_scheduler; }
+
+	private:
+		ksTaskScheduler m_scheduler;
+	};
+
+	/// <summary>
+	/// 一组任务(ksTaskGroup): run 提交任意可调用对象, async 返回 std::future
+	/// wait 时调用线程也执行任务, 因此任务中可以再创建 TaskGroup 并等待; 在任务中创建的组随外层的组一起取消
+	/// 任务抛出的第一个异常取消整组, 并由 wait 重新抛出. 析构时等待所有任务结束
+	/// </summary>
+	class TaskGroup {
+	public:
+		explicit TaskGroup(TaskScheduler& scheduler) { ksTaskGroup_Create(&m_group, scheduler.handle()); }
+		~TaskGroup() { ksTaskGroup_Destroy(&m_group); }
+		TaskGroup(const TaskGroup&) = delete;
+		TaskGroup& operator=(const TaskGroup&) = delete;
+
+		template <typename Func>
+		void run(Func&& func) {
+			using Task = std::pair<TaskGroup*, std::decay_t<Func>>;
+			ksTaskGroup_RunWithCleanup(&m_group, &Invoke<Task>, &Delete<Task>, new Task(this, std::forward<Func>(func)));
+		}
+
+		// 异常由 future 传递, 不取消任务组; 任务被取消时 future 得到 std::future_error(broken_promise)
+		// 在任务中不要阻塞在 future.get() 上, 应等待任务组, 等待的线程会继续执行任务
+		template <typename Func>
+		auto async(Func&& func) {
+			using Result = std::invoke_result_t<std::decay_t<Func>&>;
+			std::packaged_task<Result()> task(std::forward<Func>(func));
+			auto future = task.get_future();
+			run(std::move(task));
+			return future;
+		}
+
+		// 返回 false 表示任务组已被取消
+		bool wait() {
+			const bool completed = ksTaskGroup_Wait(&m_group);
+			if(m_exception)
+				std::rethrow_exception(std::exchange(m_exception, nullptr));
+			return completed;
+		}
+		void cancel() { ksTaskGroup_Cancel(&m_group); }
+		bool isCancelled() { return ksTaskGroup_IsCancelled(&m_group); }
+
+	private:
+		template <typename Task>
+		static void Invoke(void* data) {
+			auto task = static_cast<Task*>(data);
+			try {
+				task->second();
+			} catch(...) {
+				task->first->fail(std::current_exception());
+			}
+		}
+		template <typename Task>
+		static void Delete(void* data) {
+			delete static_cast<Task*>(data);
+		}
+		void fail(std::exception_ptr exception) {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if(!m_exception)
+				m_exception = std::move(exception);
+			ksTaskGroup_Cancel(&m_group);
+		}
+
+		ksTaskGroup m_group;
+		std::mutex m_mutex;
+		std::exception_ptr m_exception;
+	};
+}
@@ -68,13 +68,21 @@ limitations under the License.
 	#include <time.h>							// for timespec
 	#include <sys/time.h>						// for gettimeofday()
 	#include <pthread.h>						// for pthread_create() etc.
+	#include <sched.h>							// for sched_yield() and sched_getaffinity()
+	#include <unistd.h>							// for sysconf()
+	#include <errno.h>
 #elif defined( OS_APPLE )
 	#include <sys/time.h>
 	#include <pthread.h>
+	#include <sched.h>
+	#include <unistd.h>
+	#include <errno.h>
 #elif defined( OS_ANDROID )
 	#include <time.h>
 	#include <unistd.h>
 	#include <pthread.h>
+	#include <sched.h>
+	#include <errno.h>
 	#include <sys/prctl.h>						// for prctl( PR_SET_NAME )
 	#include <sys/stat.h>						// for gettid
 	#include <sys/syscall.h>					// for syscall
@@ -89,6 +97,11 @@ limitations under the License.
 #endif
 
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
 #include "nanoseconds.h"
 
 #if !defined( UNUSED_PARM )
@@ -134,6 +147,96 @@ static ksAtomicUint32 ksAtomicUint32_Decrement( ksAtomicUint32 * atomicUint32 )
 /*
 ================================================================================================================================
 
+Atomic 64-bit integer and pointer with acquire and release semantics, as needed by lock-free queues.
+Loads acquire, stores release, and read-modify-write operations and ksAtomic_Fence() are full barriers.
+
+ksAtomicInt64
+
+static int64_t ksAtomicInt64_Load( ksAtomicInt64 * atomicInt64 );
+static void ksAtomicInt64_Store( ksAtomicInt64 * atomicInt64, const int64_t value );
+static int64_t ksAtomicInt64_Add( ksAtomicInt64 * atomicInt64, const int64_t value );
+static bool ksAtomicInt64_CompareExchange( ksAtomicInt64 * atomicInt64, int64_t expected, const int64_t desired );
+static void * ksAtomicPointer_Load( void * volatile * atomicPointer );
+static void ksAtomicPointer_Store( void * volatile * atomicPointer, void * value );
+static void ksAtomic_Fence( void );
+
+================================================================================================================================
+*/
+
+#if defined( OS_WINDOWS )
+typedef volatile LONG64 ksAtomicInt64;
+#else
+typedef volatile int64_t ksAtomicInt64;
+#endif
+
+static int64_t ksAtomicInt64_Load( ksAtomicInt64 * atomicInt64 )
+{
+#if defined( OS_WINDOWS )
+	return ReadAcquire64( atomicInt64 );
+#else
+	return __atomic_load_n( atomicInt64, __ATOMIC_ACQUIRE );
+#endif
+}
+
+static void ksAtomicInt64_Store( ksAtomicInt64 * atomicInt64, const int64_t value )
+{
+#if defined( OS_WINDOWS )
+	WriteRelease64( atomicInt64, value );
+#else
+	__atomic_store_n( atomicInt64, value, __ATOMIC_RELEASE );
+#endif
+}
+
+// Returns the new value.
+static int64_t ksAtomicInt64_Add( ksAtomicInt64 * atomicInt64, const int64_t value )
+{
+#if defined( OS_WINDOWS )
+	return InterlockedAdd64( atomicInt64, value );
+#else
+	return __atomic_add_fetch( atomicInt64, value, __ATOMIC_SEQ_CST );
+#endif
+}
+
+// Replaces the value with 'desired' and returns true if the value equals 'expected'.
+static bool ksAtomicInt64_CompareExchange( ksAtomicInt64 * atomicInt64, int64_t expected, const int64_t desired )
+{
+#if defined( OS_WINDOWS )
+	return ( InterlockedCompareExchange64( atomicInt64, desired, expected ) == expected );
+#else
+	return __atomic_compare_exchange_n( atomicInt64, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED );
+#endif
+}
+
+static void * ksAtomicPointer_Load( void * volatile * atomicPointer )
+{
+#if defined( OS_WINDOWS )
+	return ReadPointerAcquire( atomicPointer );
+#else
+	return __atomic_load_n( atomicPointer, __ATOMIC_ACQUIRE );
+#endif
+}
+
+static void ksAtomicPointer_Store( void * volatile * atomicPointer, void * value )
+{
+#if defined( OS_WINDOWS )
+	WritePointerRelease( atomicPointer, value );
+#else
+	__atomic_store_n( atomicPointer, value, __ATOMIC_RELEASE );
+#endif
+}
+
+static void ksAtomic_Fence( void )
+{
+#if defined( OS_WINDOWS )
+	MemoryBarrier();
+#else
+	__atomic_thread_fence( __ATOMIC_SEQ_CST );
+#endif
+}
+
+/*
+================================================================================================================================
+
 Mutex for mutual exclusion on shared resources within a single process.
 
 Equivalent to a Windows Critical Section Object which allows recursive access. This mutex cannot be
@@ -409,7 +512,12 @@ static bool ksSignal_Wait( ksSignal * signal, const ksNanoseconds timeOutNanosec
 			gettimeofday( &tp, NULL );
 			struct timespec ts;
 			ts.tv_sec = (time_t)( tp.tv_sec + timeOutNanoseconds / ( 1000 * 1000 * 1000 ) );
-			ts.tv_nsec = (long)( tp.tv_usec + ( timeOutNanoseconds % ( 1000 * 1000 * 1000 ) ) );
+			ts.tv_nsec = (long)( tp.tv_usec * 1000 + timeOutNanoseconds % ( 1000 * 1000 * 1000 ) );
+			if ( ts.tv_nsec >= 1000 * 1000 * 1000 )
+			{
+				ts.tv_sec++;
+				ts.tv_nsec -= 1000 * 1000 * 1000;
+			}
 			do
 			{
 				if ( pthread_cond_timedwait( &signal->cond, &signal->mutex, &ts ) == ETIMEDOUT )
@@ -502,6 +610,9 @@ static void ksThread_Submit( ksThread * thread, ksThreadFunction threadFunction,
 static void ksThread_SetName( const char * name );
 static void ksThread_SetAffinity( int mask );
 static void ksThread_SetRealTimePriority( int priority );
+static void ksThread_Yield( void );
+static int ksThread_GetHardwareThreadCount( void );
+static void ksThread_SetProcessorGroup( int index );
 
 ================================================================================================================================
 */
@@ -781,6 +892,65 @@ static void ksThread_SetRealTimePriority( int priority )
 #endif
 }
 
+// Gives up the rest of the time slice of the calling thread.
+static void ksThread_Yield( void )
+{
+#if defined( OS_WINDOWS )
+	SwitchToThread();
+#elif defined( OS_LINUX ) || defined( OS_APPLE ) || defined( OS_ANDROID )
+	sched_yield();
+#endif
+}
+
+// Returns the number of hardware threads the process can run on.
+static int ksThread_GetHardwareThreadCount( void )
+{
+#if defined( OS_WINDOWS )
+	return (int)GetActiveProcessorCount( ALL_PROCESSOR_GROUPS );
+#elif defined( OS_HEXAGON )
+	qurt_sysenv_max_hthreads_t numThreads;
+	return ( qurt_sysenv_get_max_hw_threads( &numThreads ) == QURT_EOK ) ? (int)numThreads.max_hthreads : 1;
+#else
+#if defined( OS_LINUX )
+	cpu_set_t set;
+	if ( sched_getaffinity( 0, sizeof( set ), &set ) == 0 )
+	{
+		return CPU_COUNT( &set );
+	}
+#endif
+	const long count = sysconf( _SC_NPROCESSORS_ONLN );
+	return ( count > 0 ) ? (int)count : 1;
+#endif
+}
+
+// Before Windows 11 a thread only runs on the processors of a single group of at most 64.
+// Spread the threads with consecutive indices over the groups on hosts with more processors.
+static void ksThread_SetProcessorGroup( int index )
+{
+#if defined( OS_WINDOWS )
+	const WORD groupCount = GetActiveProcessorGroupCount();
+	if ( groupCount <= 1 )
+	{
+		return;
+	}
+	index %= (int)GetActiveProcessorCount( ALL_PROCESSOR_GROUPS );
+	WORD group = 0;
+	while ( group + 1 < groupCount && index >= (int)GetActiveProcessorCount( group ) )
+	{
+		index -= (int)GetActiveProcessorCount( group );
+		group++;
+	}
+	const DWORD count = GetActiveProcessorCount( group );
+	GROUP_AFFINITY affinity;
+	memset( &affinity, 0, sizeof( affinity ) );
+	affinity.Group = group;
+	affinity.Mask = ( count >= 64 ) ? ~(KAFFINITY)0 : ( ( (KAFFINITY)1 << count ) - 1 );
+	SetThreadGroupAffinity( GetCurrentThread(), &affinity, NULL );
+#else
+	UNUSED_PARM( index );
+#endif
+}
+
 static THREAD_RETURN_TYPE ThreadFunctionInternal( void * data )
 {
 	ksThread * thread = (ksThread *)data;
@@ -800,7 +970,11 @@ static THREAD_RETURN_TYPE ThreadFunctionInternal( void * data )
 			ksMutex_Unlock( &thread->workMutex );
 			ksSignal_Wait( &thread->workIsAvailable, SIGNAL_TIMEOUT_INFINITE );
 		}
-		if ( thread->terminate )
+		// ksThread_Destroy() sets 'terminate' while holding the mutex.
+		ksMutex_Lock( &thread->workMutex, true );
+		const bool terminate = thread->terminate;
+		ksMutex_Unlock( &thread->workMutex );
+		if ( terminate )
 		{
 			ksSignal_Raise( &thread->workIsDone );
 			break;
@@ -909,75 +1083,609 @@ static void ksThread_Submit( ksThread * thread, ksThreadFunction threadFunction,
 /*
 ================================================================================================================================
 
-Worker thread pool.
+Work-stealing task scheduler.
 
-ksThreadPool
+Tasks run on a fixed set of worker threads. Every worker owns a Chase-Lev deque ("Dynamic Circular
+Work-Stealing Deque", Chase and Lev, SPAA 2005, with the memory ordering of "Correct and Efficient
+Work-Stealing for Weak Memory Models", Le et al., PPoPP 2013). A worker pushes and pops tasks at the
+bottom of its own deque without locking, and a worker that runs out of tasks steals from the top of
+the deque of another worker. Tasks that are added by threads outside the scheduler go through a
+shared queue that is protected by a mutex. Workers that find no work for a while sleep until a task
+is added.
 
-static bool ksThreadPool_Create( ksThreadPool * pool, const int numWorkers );
-static void ksThreadPool_Destroy( ksThreadPool * pool );
-static void ksThreadPool_Submit( ksThreadPool * pool, ksThreadFunction threadFunction, void * threadData );
-static void ksThreadPool_Join( ksThreadPool * pool );
+Every task belongs to a task group. A thread that waits on a group does not block while the group
+has unfinished tasks, but runs tasks itself, starting with its own deque. A task can therefore
+create, fill and wait on a group of its own without tying up a worker (nested parallelism). A group
+that is created by a running task is a child of the group of that task. Cancelling a group skips
+the tasks of the group and of its children that did not start yet. Running tasks can poll
+ksTaskGroup_IsCancelled() to stop early.
+
+Tasks can be added to a group by any thread, including tasks of the group, until the group is waited
+on. While a thread waits on a group, only tasks of the group and the waiting thread may add tasks.
+
+By default there is one worker per hardware thread, except for the thread that creates the scheduler,
+and the workers keep the default priority.
+
+ksTaskScheduler
+
+static bool ksTaskScheduler_Create( ksTaskScheduler * scheduler, const ksTaskSchedulerConfig * config );
+static void ksTaskScheduler_Destroy( ksTaskScheduler * scheduler );
+static int ksTaskScheduler_GetWorkerCount( const ksTaskScheduler * scheduler );
+
+ksTaskGroup
+
+static void ksTaskGroup_Create( ksTaskGroup * group, ksTaskScheduler * scheduler );
+static void ksTaskGroup_Destroy( ksTaskGroup * group );
+static void ksTaskGroup_Run( ksTaskGroup * group, ksThreadFunction function, void * data );
+static void ksTaskGroup_RunWithCleanup( ksTaskGroup * group, ksThreadFunction function, ksThreadFunction cleanup, void * data );
+static bool ksTaskGroup_Wait( ksTaskGroup * group );
+static void ksTaskGroup_Cancel( ksTaskGroup * group );
+static bool ksTaskGroup_IsCancelled( ksTaskGroup * group );
 
 ================================================================================================================================
 */
 
-#define MAX_WORKERS		8
+#define TASK_WORKERS_DEFAULT		-1					// one worker per hardware thread, except for the creating thread
+#define TASK_DEQUE_INITIAL_SIZE		256					// power of two, a full deque doubles in size
+#define TASK_SPIN_COUNT				64					// rounds of looking for work before an idle thread sleeps
+#define TASK_FREE_LIST_SIZE			256					// finished tasks that a worker keeps for reuse
+#define TASK_WAIT_NANOSECONDS		( 1000 * 1000 )		// a waiting thread looks for new work at least this often
+#define TASK_CACHE_LINE_SIZE		64
+
+typedef struct ksTaskGroup ksTaskGroup;
+typedef struct ksTaskScheduler ksTaskScheduler;
+
+typedef struct ksTask
+{
+	ksThreadFunction	function;
+	ksThreadFunction	cleanup;			// called after 'function', or instead of it when the task is skipped
+	void *				data;
+	ksTaskGroup *		group;
+	struct ksTask *		next;				// in the shared queue or a free list
+} ksTask;
+
+typedef struct ksTaskArray
+{
+	int64_t					mask;
+	struct ksTaskArray *	previous;		// replaced arrays are freed with the scheduler, a thief may still read them
+	void * volatile			tasks[1];		// ksTask
+} ksTaskArray;
+
+// The owner pushes and pops at the bottom, other threads steal from the top.
+typedef struct
+{
+	ksAtomicInt64		top;
+	char				pad0[TASK_CACHE_LINE_SIZE];
+	ksAtomicInt64		bottom;
+	void * volatile		array;				// ksTaskArray
+	char				pad1[TASK_CACHE_LINE_SIZE];
+} ksTaskDeque;
 
 typedef struct
 {
-	ksThread	threads[MAX_WORKERS];
-	int			threadCount;
-} ksThreadPool;
+	ksTaskDeque			deque;
+	ksTaskScheduler *	scheduler;
+	ksTask *			freeTasks;
+	int					freeCount;
+	int					index;
+	uint32_t			random;				// for picking a worker to steal from
+	ksThread			thread;
+} ksTaskWorker;
+
+typedef struct
+{
+	int		workerCount;					// number of worker threads, which can be zero, or TASK_WORKERS_DEFAULT
+	int		priority;						// zero keeps the default priority, a higher value is a real-time priority
+} ksTaskSchedulerConfig;
+
+struct ksTaskScheduler
+{
+	ksTaskWorker *		workers;
+	int					workerCount;
+	int					priority;
+	ksMutex				queueMutex;
+	ksTask *			queueHead;			// tasks added by threads that are not workers
+	ksTask *			queueTail;
+	ksAtomicInt64		queueCount;
+	ksAtomicInt64		sleeping;			// number of workers that wait on 'workAvailable'
+	ksAtomicInt64		terminate;
+	ksSignal			workAvailable;
+};
+
+struct ksTaskGroup
+{
+	ksTaskScheduler *	scheduler;
+	ksTaskGroup *		parent;				// cancelling the parent cancels this group as well
+	ksAtomicInt64		pending;			// tasks that were added and did not finish yet
+	ksAtomicInt64		cancelled;
+	ksMutex				mutex;				// orders raising and clearing 'done' with changes of 'pending'
+	ksSignal			done;				// raised while 'pending' is zero
+};
+
+// In C++ there is one variable for the whole program. In C every source file has its own copy, and
+// tasks that are added from another source file than the one that created the scheduler go through
+// the shared queue.
+#if defined( __cplusplus )
+	#define TASK_THREAD_LOCAL	inline thread_local
+#elif defined( _MSC_VER )
+	#define TASK_THREAD_LOCAL	static __declspec( thread )
+#else
+	#define TASK_THREAD_LOCAL	static _Thread_local
+#endif
+
+TASK_THREAD_LOCAL ksTaskWorker * ksTaskWorker_current = NULL;	// worker that runs on this thread
+TASK_THREAD_LOCAL ksTaskGroup * ksTaskGroup_current = NULL;		// group of the task that runs on this thread
 
-static void PoolStartThread( void * data )
+static ksTaskArray * ksTaskArray_Create( const int64_t size, ksTaskArray * previous )
 {
-	UNUSED_PARM( data );
+	ksTaskArray * array = (ksTaskArray *) malloc( sizeof( ksTaskArray ) + ( size - 1 ) * sizeof( void * ) );
+	array->mask = size - 1;
+	array->previous = previous;
+	return array;
+}
 
-	ksThread_SetAffinity( THREAD_AFFINITY_BIG_CORES );
-	ksThread_SetRealTimePriority( 1 );
+static void ksTaskDeque_Create( ksTaskDeque * deque )
+{
+	memset( deque, 0, sizeof( ksTaskDeque ) );
+	deque->array = ksTaskArray_Create( TASK_DEQUE_INITIAL_SIZE, NULL );
 }
 
-static void ksThreadPool_Create( ksThreadPool * pool, const int numWorkers )
+static void ksTaskDeque_Destroy( ksTaskDeque * deque )
 {
-	pool->threadCount = ( numWorkers <= MAX_WORKERS ) ? numWorkers : MAX_WORKERS;
-#if defined( OS_HEXAGON )
-	qurt_sysenv_max_hthreads_t num_threads;
-	if ( qurt_sysenv_get_max_hw_threads( &num_threads ) == QURT_EOK )
+	for ( ksTaskArray * array = (ksTaskArray *) deque->array; array != NULL; )
 	{
-		pool->threadCount = num_threads.max_hthreads;
+		ksTaskArray * previous = array->previous;
+		free( array );
+		array = previous;
 	}
-#endif
+}
 
-	for ( int i = 0; i < pool->threadCount; i++ )
+// Only called by the owner.
+static void ksTaskDeque_Push( ksTaskDeque * deque, ksTask * task )
+{
+	const int64_t bottom = ksAtomicInt64_Load( &deque->bottom );
+	const int64_t top = ksAtomicInt64_Load( &deque->top );
+	ksTaskArray * array = (ksTaskArray *) ksAtomicPointer_Load( &deque->array );
+	if ( bottom - top > array->mask )
+	{
+		ksTaskArray * grown = ksTaskArray_Create( 2 * ( array->mask + 1 ), array );
+		for ( int64_t i = top; i < bottom; i++ )
+		{
+			grown->tasks[i & grown->mask] = ksAtomicPointer_Load( &array->tasks[i & array->mask] );
+		}
+		ksAtomicPointer_Store( &deque->array, grown );
+		array = grown;
+	}
+	ksAtomicPointer_Store( &array->tasks[bottom & array->mask], task );
+	ksAtomicInt64_Store( &deque->bottom, bottom + 1 );
+}
+
+// Only called by the owner.
+static ksTask * ksTaskDeque_Pop( ksTaskDeque * deque )
+{
+	const int64_t bottom = ksAtomicInt64_Load( &deque->bottom ) - 1;
+	ksTaskArray * array = (ksTaskArray *) ksAtomicPointer_Load( &deque->array );
+	ksAtomicInt64_Store( &deque->bottom, bottom );
+	ksAtomic_Fence();
+	const int64_t top = ksAtomicInt64_Load( &deque->top );
+	if ( top > bottom )
 	{
-		ksThread_Create( &pool->threads[i], "worker", PoolStartThread, NULL );
-		ksThread_Signal( &pool->threads[i] );
-		ksThread_Join( &pool->threads[i] );
+		ksAtomicInt64_Store( &deque->bottom, bottom + 1 );
+		return NULL;
 	}
+	ksTask * task = (ksTask *) ksAtomicPointer_Load( &array->tasks[bottom & array->mask] );
+	if ( top == bottom )
+	{
+		// The last task, thieves may be taking it as well.
+		if ( !ksAtomicInt64_CompareExchange( &deque->top, top, top + 1 ) )
+		{
+			task = NULL;
+		}
+		ksAtomicInt64_Store( &deque->bottom, bottom + 1 );
+	}
+	return task;
 }
 
-static void ksThreadPool_Destroy( ksThreadPool * pool )
+// Returns NULL if the deque is empty or another thread took the task first.
+static ksTask * ksTaskDeque_Steal( ksTaskDeque * deque )
 {
-	for ( int i = 0; i < pool->threadCount; i++ )
+	const int64_t top = ksAtomicInt64_Load( &deque->top );
+	ksAtomic_Fence();
+	const int64_t bottom = ksAtomicInt64_Load( &deque->bottom );
+	if ( top >= bottom )
 	{
-		ksThread_Destroy( &pool->threads[i] );
+		return NULL;
 	}
+	ksTaskArray * array = (ksTaskArray *) ksAtomicPointer_Load( &deque->array );
+	ksTask * task = (ksTask *) ksAtomicPointer_Load( &array->tasks[top & array->mask] );
+	if ( !ksAtomicInt64_CompareExchange( &deque->top, top, top + 1 ) )
+	{
+		return NULL;
+	}
+	return task;
+}
+
+static bool ksTaskDeque_IsEmpty( ksTaskDeque * deque )
+{
+	return ( ksAtomicInt64_Load( &deque->bottom ) <= ksAtomicInt64_Load( &deque->top ) );
 }
 
-static void ksThreadPool_Submit( ksThreadPool * pool, ksThreadFunction threadFunction, void * threadData )
+// 'worker' is NULL for threads outside the scheduler.
+static ksTask * ksTaskWorker_AllocTask( ksTaskWorker * worker )
 {
-	for ( int i = 0; i < pool->threadCount; i++ )
+	if ( worker != NULL && worker->freeTasks != NULL )
 	{
-		ksThread_Submit( &pool->threads[i], threadFunction, threadData );
+		ksTask * task = worker->freeTasks;
+		worker->freeTasks = task->next;
+		worker->freeCount--;
+		return task;
 	}
+	return (ksTask *) malloc( sizeof( ksTask ) );
 }
 
-static void ksThreadPool_Join( ksThreadPool * pool )
+static void ksTaskWorker_FreeTask( ksTaskWorker * worker, ksTask * task )
 {
-	for ( int i = 0; i < pool->threadCount; i++ )
+	if ( worker != NULL && worker->freeCount < TASK_FREE_LIST_SIZE )
 	{
-		ksThread_Join( &pool->threads[i] );
+		task->next = worker->freeTasks;
+		worker->freeTasks = task;
+		worker->freeCount++;
+		return;
 	}
+	free( task );
+}
+
+static ksTaskWorker * ksTaskScheduler_GetCurrentWorker( ksTaskScheduler * scheduler )
+{
+	ksTaskWorker * worker = ksTaskWorker_current;
+	return ( worker != NULL && worker->scheduler == scheduler ) ? worker : NULL;
+}
+
+static void ksTaskScheduler_Enqueue( ksTaskScheduler * scheduler, ksTask * task )
+{
+	task->next = NULL;
+	ksMutex_Lock( &scheduler->queueMutex, true );
+	if ( scheduler->queueTail != NULL )
+	{
+		scheduler->queueTail->next = task;
+	}
+	else
+	{
+		scheduler->queueHead = task;
+	}
+	scheduler->queueTail = task;
+	ksAtomicInt64_Add( &scheduler->queueCount, 1 );
+	ksMutex_Unlock( &scheduler->queueMutex );
+}
+
+static ksTask * ksTaskScheduler_Dequeue( ksTaskScheduler * scheduler )
+{
+	if ( ksAtomicInt64_Load( &scheduler->queueCount ) == 0 )
+	{
+		return NULL;
+	}
+	ksMutex_Lock( &scheduler->queueMutex, true );
+	ksTask * task = scheduler->queueHead;
+	if ( task != NULL )
+	{
+		scheduler->queueHead = task->next;
+		if ( scheduler->queueHead == NULL )
+		{
+			scheduler->queueTail = NULL;
+		}
+		ksAtomicInt64_Add( &scheduler->queueCount, -1 );
+	}
+	ksMutex_Unlock( &scheduler->queueMutex );
+	return task;
+}
+
+static bool ksTaskScheduler_HasWork( ksTaskScheduler * scheduler )
+{
+	if ( ksAtomicInt64_Load( &scheduler->queueCount ) > 0 )
+	{
+		return true;
+	}
+	for ( int i = 0; i < scheduler->workerCount; i++ )
+	{
+		if ( !ksTaskDeque_IsEmpty( &scheduler->workers[i].deque ) )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// Takes a task from the deque of 'worker', then from the shared queue, then from another worker.
+static ksTask * ksTaskScheduler_FindTask( ksTaskScheduler * scheduler, ksTaskWorker * worker )
+{
+	ksTask * task = NULL;
+	if ( worker != NULL && ( task = ksTaskDeque_Pop( &worker->deque ) ) != NULL )
+	{
+		return task;
+	}
+	if ( ( task = ksTaskScheduler_Dequeue( scheduler ) ) != NULL )
+	{
+		return task;
+	}
+	const int count = scheduler->workerCount;
+	int start = 0;
+	if ( worker != NULL )
+	{
+		worker->random ^= worker->random << 13;
+		worker->random ^= worker->random >> 17;
+		worker->random ^= worker->random << 5;
+		start = (int)( worker->random % (uint32_t)count );
+	}
+	for ( int i = 0; i < count; i++ )
+	{
+		ksTaskWorker * victim = &scheduler->workers[( start + i ) % count];
+		if ( victim != worker && ( task = ksTaskDeque_Steal( &victim->deque ) ) != NULL )
+		{
+			return task;
+		}
+	}
+	return NULL;
+}
+
+static void ksTaskScheduler_WakeWorker( ksTaskScheduler * scheduler )
+{
+	// Pairs with the fence of the atomic increment of 'sleeping' in ksTaskWorker_Thread().
+	ksAtomic_Fence();
+	if ( ksAtomicInt64_Load( &scheduler->sleeping ) > 0 )
+	{
+		ksSignal_Raise( &scheduler->workAvailable );
+	}
+}
+
+static bool ksTaskGroup_IsCancelled( ksTaskGroup * group )
+{
+	for ( ; group != NULL; group = group->parent )
+	{
+		if ( ksAtomicInt64_Load( &group->cancelled ) != 0 )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static void ksTaskGroup_Cancel( ksTaskGroup * group )
+{
+	ksAtomicInt64_Store( &group->cancelled, 1 );
+}
+
+static void ksTaskGroup_FinishTask( ksTaskGroup * group )
+{
+	if ( ksAtomicInt64_Add( &group->pending, -1 ) == 0 )
+	{
+		ksMutex_Lock( &group->mutex, true );
+		if ( ksAtomicInt64_Load( &group->pending ) == 0 )
+		{
+			ksSignal_Raise( &group->done );
+		}
+		ksMutex_Unlock( &group->mutex );
+	}
+}
+
+static void ksTaskScheduler_Execute( ksTaskWorker * worker, ksTask * task )
+{
+	ksTaskGroup * group = task->group;
+	if ( !ksTaskGroup_IsCancelled( group ) )
+	{
+		ksTaskGroup * outer = ksTaskGroup_current;
+		ksTaskGroup_current = group;
+		task->function( task->data );
+		ksTaskGroup_current = outer;
+	}
+	if ( task->cleanup != NULL )
+	{
+		task->cleanup( task->data );
+	}
+	ksTaskWorker_FreeTask( worker, task );
+	ksTaskGroup_FinishTask( group );
+}
+
+static void ksTaskWorker_Thread( void * data )
+{
+	ksTaskWorker * worker = (ksTaskWorker *)data;
+	ksTaskScheduler * scheduler = worker->scheduler;
+	ksTaskWorker_current = worker;
+	ksThread_SetProcessorGroup( worker->index );
+	if ( scheduler->priority > 0 )
+	{
+		ksThread_SetRealTimePriority( scheduler->priority );
+	}
+
+	for ( int idle = 0; ksAtomicInt64_Load( &scheduler->terminate ) == 0; )
+	{
+		ksTask * task = ksTaskScheduler_FindTask( scheduler, worker );
+		if ( task != NULL )
+		{
+			ksTaskScheduler_Execute( worker, task );
+			idle = 0;
+			continue;
+		}
+		if ( ++idle < TASK_SPIN_COUNT )
+		{
+			ksThread_Yield();
+			continue;
+		}
+		// Announce the sleep before looking for work once more, so that a task that is added in between raises the signal.
+		ksAtomicInt64_Add( &scheduler->sleeping, 1 );
+		if ( ksAtomicInt64_Load( &scheduler->terminate ) == 0 && !ksTaskScheduler_HasWork( scheduler ) )
+		{
+			ksSignal_Wait( &scheduler->workAvailable, SIGNAL_TIMEOUT_INFINITE );
+		}
+		ksAtomicInt64_Add( &scheduler->sleeping, -1 );
+		// Raising the signal more than once wakes a single worker, so pass the wake-up on while there is work.
+		if ( ksAtomicInt64_Load( &scheduler->sleeping ) > 0 && ksTaskScheduler_HasWork( scheduler ) )
+		{
+			ksSignal_Raise( &scheduler->workAvailable );
+		}
+		idle = 0;
+	}
+
+	ksTaskWorker_current = NULL;
+	// Pass the termination on to the next sleeping worker.
+	ksSignal_Raise( &scheduler->workAvailable );
+}
+
+// Returns false if not all workers could be started. The scheduler then runs with fewer workers.
+static bool ksTaskScheduler_Create( ksTaskScheduler * scheduler, const ksTaskSchedulerConfig * config )
+{
+	int workerCount = ( config != NULL ) ? config->workerCount : TASK_WORKERS_DEFAULT;
+	if ( workerCount < 0 )
+	{
+		workerCount = ksThread_GetHardwareThreadCount() - 1;
+	}
+	scheduler->workers = ( workerCount > 0 ) ? (ksTaskWorker *) calloc( workerCount, sizeof( ksTaskWorker ) ) : NULL;
+	scheduler->workerCount = workerCount;
+	scheduler->priority = ( config != NULL ) ? config->priority : 0;
+	ksMutex_Create( &scheduler->queueMutex );
+	scheduler->queueHead = NULL;
+	scheduler->queueTail = NULL;
+	scheduler->queueCount = 0;
+	scheduler->sleeping = 0;
+	scheduler->terminate = 0;
+	ksSignal_Create( &scheduler->workAvailable, true );
+
+	// The threads are created suspended and only started once every worker exists, because they steal from each other right away.
+	for ( int i = 0; i < workerCount; i++ )
+	{
+		ksTaskWorker * worker = &scheduler->workers[i];
+		ksTaskDeque_Create( &worker->deque );
+		worker->scheduler = scheduler;
+		worker->freeTasks = NULL;
+		worker->freeCount = 0;
+		worker->index = i;
+		worker->random = 2654435769u * (uint32_t)( i + 1 );
+		if ( !ksThread_Create( &worker->thread, "worker", ksTaskWorker_Thread, worker ) )
+		{
+			ksTaskDeque_Destroy( &worker->deque );
+			scheduler->workerCount = i;
+			break;
+		}
+	}
+	for ( int i = 0; i < scheduler->workerCount; i++ )
+	{
+		ksThread_Signal( &scheduler->workers[i].thread );
+	}
+	return ( scheduler->workerCount == workerCount );
+}
+
+// All task groups must have been waited on.
+static void ksTaskScheduler_Destroy( ksTaskScheduler * scheduler )
+{
+	ksAtomicInt64_Store( &scheduler->terminate, 1 );
+	ksAtomic_Fence();
+	ksSignal_Raise( &scheduler->workAvailable );
+	for ( int i = 0; i < scheduler->workerCount; i++ )
+	{
+		ksThread_Destroy( &scheduler->workers[i].thread );
+	}
+	for ( int i = 0; i < scheduler->workerCount; i++ )
+	{
+		ksTaskWorker * worker = &scheduler->workers[i];
+		ksTaskDeque_Destroy( &worker->deque );
+		while ( worker->freeTasks != NULL )
+		{
+			ksTask * next = worker->freeTasks->next;
+			free( worker->freeTasks );
+			worker->freeTasks = next;
+		}
+	}
+	assert( scheduler->queueHead == NULL );
+	free( scheduler->workers );
+	ksSignal_Destroy( &scheduler->workAvailable );
+	ksMutex_Destroy( &scheduler->queueMutex );
+}
+
+static int ksTaskScheduler_GetWorkerCount( const ksTaskScheduler * scheduler )
+{
+	return scheduler->workerCount;
+}
+
+static void ksTaskGroup_Create( ksTaskGroup * group, ksTaskScheduler * scheduler )
+{
+	group->scheduler = scheduler;
+	group->parent = ksTaskGroup_current;
+	group->pending = 0;
+	group->cancelled = 0;
+	ksMutex_Create( &group->mutex );
+	ksSignal_Create( &group->done, false );
+	ksSignal_Raise( &group->done );
+}
+
+// 'cleanup' can be NULL. Otherwise it is called with 'data' after 'function' returns, or instead of
+// 'function' when the group was cancelled before the task started, for instance to free 'data'.
+static void ksTaskGroup_RunWithCleanup( ksTaskGroup * group, ksThreadFunction function, ksThreadFunction cleanup, void * data )
+{
+	ksTaskScheduler * scheduler = group->scheduler;
+	ksTaskWorker * worker = ksTaskScheduler_GetCurrentWorker( scheduler );
+	ksTask * task = ksTaskWorker_AllocTask( worker );
+	task->function = function;
+	task->cleanup = cleanup;
+	task->data = data;
+	task->group = group;
+
+	if ( ksAtomicInt64_Add( &group->pending, 1 ) == 1 )
+	{
+		ksMutex_Lock( &group->mutex, true );
+		if ( ksAtomicInt64_Load( &group->pending ) > 0 )
+		{
+			ksSignal_Clear( &group->done );
+		}
+		ksMutex_Unlock( &group->mutex );
+	}
+
+	if ( worker != NULL )
+	{
+		ksTaskDeque_Push( &worker->deque, task );
+	}
+	else
+	{
+		ksTaskScheduler_Enqueue( scheduler, task );
+	}
+	ksTaskScheduler_WakeWorker( scheduler );
+}
+
+static void ksTaskGroup_Run( ksTaskGroup * group, ksThreadFunction function, void * data )
+{
+	ksTaskGroup_RunWithCleanup( group, function, NULL, data );
+}
+
+// Runs tasks until every task of the group finished. Returns false if the group was cancelled.
+static bool ksTaskGroup_Wait( ksTaskGroup * group )
+{
+	ksTaskScheduler * scheduler = group->scheduler;
+	ksTaskWorker * worker = ksTaskScheduler_GetCurrentWorker( scheduler );
+	for ( int idle = 0; ksAtomicInt64_Load( &group->pending ) > 0 || !ksSignal_Wait( &group->done, 0 ); )
+	{
+		ksTask * task = ksTaskScheduler_FindTask( scheduler, worker );
+		if ( task != NULL )
+		{
+			ksTaskScheduler_Execute( worker, task );
+			idle = 0;
+			continue;
+		}
+		if ( ++idle < TASK_SPIN_COUNT )
+		{
+			ksThread_Yield();
+			continue;
+		}
+		ksSignal_Wait( &group->done, TASK_WAIT_NANOSECONDS );
+	}
+	// The thread that raised 'done' may still hold the mutex, the group cannot be destroyed before it leaves.
+	ksMutex_Lock( &group->mutex, true );
+	ksMutex_Unlock( &group->mutex );
+	return !ksTaskGroup_IsCancelled( group );
+}
+
+static void ksTaskGroup_Destroy( ksTaskGroup * group )
+{
+	ksTaskGroup_Wait( group );
+	ksSignal_Destroy( &group->done );
+	ksMutex_Destroy( &group->mutex );
 }
 
 #endif // !KSTHREADING_H
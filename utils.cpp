@@ -1,14 +1,21 @@
 ﻿#include "utils.h"
 #include <cassert>
+#include <atomic>
 #ifdef _WIN32
 #include <Windows.h> // For Win32 API
 #include <Psapi.h>
 #include <shlobj_core.h>
-#include <atomic>
 #else
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
 #include <unistd.h>
+#if defined(__APPLE__)
 #include <libproc.h>
 #endif
+#endif
 
 namespace lxd {
     String GetDirOfExe() {
@@ -19,6 +26,14 @@ namespace lxd {
         String result = filename;
         result.resize(result.find_last_of(L'\\'));
         return result;
+#elif defined(__linux__)
+        char pathbuf[4096];
+        const ssize_t length = readlink("/proc/self/exe", pathbuf, sizeof(pathbuf) - 1);
+        if(length <= 0)
+            return String();
+        String result(pathbuf, length);
+        result.resize(result.find_last_of('/'));
+        return result;
 #else
         int ret;
         pid_t pid = getpid();
@@ -159,6 +174,135 @@ namespace lxd {
 	    const uint32_t id = ctxt->id.fetch_add(1, std::memory_order_relaxed);
 	    ctxt->func(id);
     }
+#else
+    // 常驻的工作线程池, 首次调用 RunParallel 时创建, 每个线程绑定一个 CPU, 调用线程也参与执行
+    class WorkerPool {
+    public:
+        static WorkerPool& Instance() {
+            static WorkerPool pool;
+            return pool;
+        }
+
+        void run(uint32_t times, const std::function<void(uint32_t)>& func) {
+            // 在 RunParallel 的任务中嵌套调用时, 外层任务已经分布在所有线程上, 直接在当前线程执行, 也避免等待自己
+            if(m_threads.empty() || t_inRun) {
+                for(uint32_t i = 0; i < times; ++i)
+                    func(i);
+                return;
+            }
+            t_inRun = true;
+            // 每次领取连续的一批, times 很大时没有逐项的原子操作
+            const uint32_t nThread = static_cast<uint32_t>(m_threads.size()) + 1;
+            Job job{&func, times, std::max<uint32_t>(1, times / (8 * nThread))};
+            const uint32_t nWake = std::min<uint32_t>((times + job.batch - 1) / job.batch - 1, nThread - 1);
+            // 其它线程同时调用时任务排队, 工作线程按顺序协助, 调用线程始终执行自己的任务
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_jobs.push_back(&job);
+            }
+            for(uint32_t i = 0; i < nWake; ++i)
+                m_wake.notify_one();
+            job.work();
+            // 所有批次已被领取, 移出队列后等待仍在执行的线程
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                retire(&job);
+                m_done.wait(lock, [&] { return job.active == 0; });
+            }
+            t_inRun = false;
+        }
+
+    private:
+        struct Job {
+            const std::function<void(uint32_t)>* func;
+            uint32_t times;
+            uint32_t batch;
+            std::atomic<uint64_t> next{0}; // 64 位, 多个线程越过 times 也不会回绕
+            uint32_t active = 0;           // 正在执行的工作线程, 由 m_mutex 保护
+
+            void work() {
+                for(;;) {
+                    const uint64_t begin = next.fetch_add(batch, std::memory_order_relaxed);
+                    if(begin >= times)
+                        return;
+                    const uint32_t end = static_cast<uint32_t>(std::min<uint64_t>(times, begin + batch));
+                    for(uint32_t i = static_cast<uint32_t>(begin); i < end; ++i)
+                        (*func)(i);
+                }
+            }
+        };
+
+        WorkerPool() {
+            std::vector<int> cpus;
+#if defined(__linux__)
+            cpu_set_t allowed;
+            if(sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+                for(int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                    if(CPU_ISSET(cpu, &allowed))
+                        cpus.push_back(cpu);
+                }
+            }
+#endif
+            const size_t nCpu = cpus.empty() ? std::max(1u, std::thread::hardware_concurrency()) : cpus.size();
+            // 第一个 CPU 留给调用线程
+            for(size_t i = 1; i < nCpu; ++i) {
+                m_threads.emplace_back([this] { workerLoop(); });
+#if defined(__linux__)
+                if(!cpus.empty()) {
+                    cpu_set_t set;
+                    CPU_ZERO(&set);
+                    CPU_SET(cpus[i], &set);
+                    pthread_setaffinity_np(m_threads.back().native_handle(), sizeof(set), &set);
+                }
+#endif
+            }
+        }
+
+        ~WorkerPool() {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+            }
+            m_wake.notify_all();
+            for(auto& thread : m_threads)
+                thread.join();
+        }
+
+        // 批次已领完的任务不再分给工作线程, 调用时持有 m_mutex
+        void retire(Job* job) {
+            auto it = std::find(m_jobs.begin(), m_jobs.end(), job);
+            if(it != m_jobs.end())
+                m_jobs.erase(it);
+        }
+
+        void workerLoop() {
+            t_inRun = true;
+            std::unique_lock<std::mutex> lock(m_mutex);
+            for(;;) {
+                m_wake.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+                if(m_stop)
+                    return;
+                Job* job = m_jobs.front();
+                job->active++;
+                lock.unlock();
+                job->work();
+                lock.lock();
+                retire(job);
+                if(--job->active == 0)
+                    m_done.notify_all();
+            }
+        }
+
+        static thread_local bool t_inRun; // 当前线程正在执行 RunParallel 的任务
+        std::vector<std::thread> m_threads;
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::condition_variable m_done;
+        std::vector<Job*> m_jobs; // 还有批次未领取的任务, 先到先协助
+        bool m_stop = false;
+    };
+
+    thread_local bool WorkerPool::t_inRun = false;
 #endif
 
     void RunParallel(uint32_t times, std::function<void(uint32_t)> func) noexcept {
@@ -188,7 +332,15 @@ namespace lxd {
 		    }
 	    }
 #else
-	    static_assert(false, "Not implemented!");
+	    if (times == 0) {
+		    return;
+	    }
+
+	    if (times == 1) {
+		    return func(0);
+	    }
+
+	    WorkerPool::Instance().run(times, func);
 #endif // _WIN32
     }
 
@@ -5,6 +5,9 @@
 #include <variant>
 #endif // _WIN32
 #include <functional>
+#include <algorithm>
+#include <thread>
+#include <cstdint>
 
 namespace lxd {
 	DLL_PUBLIC String GetDirOfExe();
@@ -23,4 +26,44 @@ namespace lxd {
 	DLL_PUBLIC std::variant<int, std::wstring> GetEnv(std::wstring_view name);
 #endif
     DLL_PUBLIC void RunParallel(uint32_t times, std::function<void(uint32_t)> func) noexcept;
+
+    // 将 [0, count) 切分成不小于 grain 的连续区间, 在线程池中执行 func(begin, end)
+    template <typename Func>
+    void ParallelFor(size_t count, size_t grain, Func&& func) {
+        if(count == 0)
+            return;
+        const size_t nThread = std::max(1u, std::thread::hardware_concurrency());
+        const size_t nChunk = std::clamp<size_t>(count / std::max<size_t>(grain, 1), 1, 4 * nThread);
+        if(nChunk == 1) {
+            func(size_t(0), count);
+            return;
+        }
+        RunParallel(static_cast<uint32_t>(nChunk), [&](uint32_t chunk) {
+            func(count * chunk / nChunk, count * (chunk + 1) / nChunk);
+        });
+    }
+
+    // 分段并行排序后两两归并, 结果与 std::sort 相同(不保证稳定)
+    template <typename RandomIt, typename Compare = std::less<>>
+    void ParallelSort(RandomIt first, RandomIt last, Compare comp = {}) {
+        constexpr size_t kMinChunk = 1 << 14;
+        const size_t count = static_cast<size_t>(last - first);
+        size_t nChunk = 1;
+        while(nChunk < std::thread::hardware_concurrency() && count / (nChunk * 2) >= kMinChunk)
+            nChunk *= 2;
+        if(nChunk == 1) {
+            std::sort(first, last, comp);
+            return;
+        }
+        auto bound = [&](size_t chunk) { return first + count * chunk / nChunk; };
+        RunParallel(static_cast<uint32_t>(nChunk), [&](uint32_t chunk) {
+            std::sort(bound(chunk), bound(chunk + 1), comp);
+        });
+        for(size_t width = 1; width < nChunk; width *= 2) {
+            RunParallel(static_cast<uint32_t>(nChunk / (2 * width)), [&](uint32_t pair) {
+                const size_t begin = 2 * width * pair;
+                std::inplace_merge(bound(begin), bound(begin + width), bound(begin + 2 * width), comp);
+            });
+        }
+    }
 }